@@ -0,0 +1,109 @@
+#! /usr/bin/env python3
+#
+# -----------------------------------------------------------------------------
+# Copyright (c) 2021, Arm Limited. All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# -----------------------------------------------------------------------------
+
+"""
+Compress a signed image into the format which the Firmware Update partition
+decompresses while the image is written into the staging area.
+
+The compressed image starts with a header of three 32-bit little endian words:
+magic, size of the image and a reserved word. It is followed by the image
+compressed as a single LZ4 block, without the block size.
+"""
+
+import argparse
+import struct
+
+LZ4_MAGIC = 0x345a4c46
+HEADER_FORMAT = '<III'
+
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+# The LZ4 block format requires the last bytes of the block to be literals.
+LAST_LITERALS = 5
+MATCH_LIMIT = 12
+LEN_MASK = 0xF
+
+
+def write_len(out, value):
+    while value >= 0xFF:
+        out.append(0xFF)
+        value -= 0xFF
+    out.append(value)
+
+
+def write_sequence(out, literals, offset=0, match_len=0):
+    lit_len = len(literals)
+    token = min(lit_len, LEN_MASK) << 4
+    if offset:
+        token |= min(match_len - MIN_MATCH, LEN_MASK)
+    out.append(token)
+    if lit_len >= LEN_MASK:
+        write_len(out, lit_len - LEN_MASK)
+    out += literals
+    if offset:
+        out += struct.pack('<H', offset)
+        if match_len - MIN_MATCH >= LEN_MASK:
+            write_len(out, match_len - MIN_MATCH - LEN_MASK)
+
+
+def lz4_compress(data):
+    out = bytearray()
+    table = {}
+    anchor = 0
+    pos = 0
+    end = len(data)
+    while pos < end - MATCH_LIMIT:
+        key = data[pos:pos + MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = pos
+        if candidate is None or pos - candidate > MAX_OFFSET:
+            pos += 1
+            continue
+        length = MIN_MATCH
+        max_len = end - LAST_LITERALS - pos
+        while (length < max_len and
+               data[candidate + length] == data[pos + length]):
+            length += 1
+        write_sequence(out, data[anchor:pos], pos - candidate, length)
+        pos += length
+        anchor = pos
+    write_sequence(out, data[anchor:])
+    return out
+
+
+def compress_image(data):
+    """Returns the compressed image of the given signed image."""
+    return (struct.pack(HEADER_FORMAT, LZ4_MAGIC, len(data), 0) +
+            lz4_compress(bytes(data)))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+
+    parser.add_argument('-i', '--input', required=True,
+            help='Signed image, without padding')
+    parser.add_argument('-o', '--output', required=True,
+            help='Filename to write the compressed image to')
+
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        image = f.read()
+
+    compressed = compress_image(image)
+
+    with open(args.output, 'wb') as f:
+        f.write(compressed)
+
+    print("Compressed image of {} bytes for a {} bytes image".format(
+          len(compressed), len(image)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,137 @@
+#! /usr/bin/env python3
+#
+# -----------------------------------------------------------------------------
+# Copyright (c) 2021, Arm Limited. All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# -----------------------------------------------------------------------------
+
+"""
+Generate a delta image which the Firmware Update partition reconstructs into
+the new signed image, using the image in the primary slot as the source.
+
+The delta image starts with a header of four 32-bit little endian words:
+magic, size of the new image, size of the old image and a reserved word. It is
+followed by records of three 32-bit little endian words: seek, copy length and
+insert length. A record moves the offset in the old image by seek (signed),
+copies copy length bytes from there and then appends the insert length bytes
+following the record.
+"""
+
+import argparse
+import struct
+
+DELTA_MAGIC = 0x544c4446
+HEADER_FORMAT = '<IIII'
+RECORD_FORMAT = '<iII'
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+
+# Length of the blocks of the old image indexed to find matches.
+BLOCK_SIZE = 16
+# Copies shorter than this are sent as inserted data instead.
+MIN_COPY_SIZE = 2 * RECORD_SIZE
+
+
+class Delta():
+    def __init__(self, old, new):
+        self.old = old
+        self.new = new
+        self.index = {}
+        for pos in range(len(old) - BLOCK_SIZE, -1, -1):
+            self.index[old[pos:pos + BLOCK_SIZE]] = pos
+
+    def match_len(self, old_pos, new_pos):
+        old = self.old
+        new = self.new
+        length = 0
+        limit = min(len(old) - old_pos, len(new) - new_pos)
+        step = 64
+        while length < limit:
+            size = min(step, limit - length)
+            if (old[old_pos + length:old_pos + length + size] ==
+                    new[new_pos + length:new_pos + length + size]):
+                length += size
+                step = 64
+                continue
+            if size == 1:
+                break
+            step = max(size // 4, 1)
+        return length
+
+    def find_match(self, new_pos, expected):
+        best_pos = None
+        best_len = 0
+        candidates = [expected]
+        block = self.new[new_pos:new_pos + BLOCK_SIZE]
+        if block in self.index:
+            candidates.append(self.index[block])
+        for pos in candidates:
+            if 0 <= pos < len(self.old):
+                length = self.match_len(pos, new_pos)
+                if length > best_len:
+                    best_pos = pos
+                    best_len = length
+        return best_pos, best_len
+
+    def generate(self):
+        records = []
+        source = 0
+        # The record being built: seek, copy length and inserted data.
+        seek, copy_len, insert = 0, 0, bytearray()
+        pos = 0
+        while pos < len(self.new):
+            # Prefer the data following the previous copy, as the unchanged
+            # parts of the image keep their relative position.
+            expected = source + len(insert)
+            match_pos, match_len = self.find_match(pos, expected)
+            if match_len >= MIN_COPY_SIZE:
+                records.append((seek, copy_len, bytes(insert)))
+                seek = match_pos - source
+                copy_len = match_len
+                insert = bytearray()
+                source = match_pos + match_len
+                pos += match_len
+            else:
+                insert.append(self.new[pos])
+                pos += 1
+        records.append((seek, copy_len, bytes(insert)))
+
+        out = bytearray(struct.pack(HEADER_FORMAT, DELTA_MAGIC, len(self.new),
+                                    len(self.old), 0))
+        for seek, copy_len, insert in records:
+            if copy_len == 0 and len(insert) == 0:
+                continue
+            out += struct.pack(RECORD_FORMAT, seek, copy_len, len(insert))
+            out += insert
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser()
+
+    parser.add_argument('-o', '--old', required=True,
+            help='Signed image installed in the primary slot')
+    parser.add_argument('-n', '--new', required=True,
+            help='New signed image, without padding')
+    parser.add_argument('-d', '--delta', required=True,
+            help='Filename to write the delta image to')
+
+    args = parser.parse_args()
+
+    with open(args.old, 'rb') as f:
+        old = f.read()
+    with open(args.new, 'rb') as f:
+        new = f.read()
+
+    delta = Delta(old, new).generate()
+
+    with open(args.delta, 'wb') as f:
+        f.write(delta)
+
+    print("Delta image of {} bytes for a {} bytes image".format(len(delta),
+                                                                  len(new)))
+
+
+if __name__ == '__main__':
+    main()
@@ -23,6 +23,7 @@ import imgtool.main
 parser_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '../'))
 sys.path.append(parser_path)
 import macro_parser
+import compress
 
 sign_bin_size_re = re.compile(r"^\s*RE_SIGN_BIN_SIZE\s*=\s*(.*)")
 load_addr_re = re.compile(r"^\s*RE_IMAGE_LOAD_ADDRESS\s*=\s*(.*)")
@@ -81,13 +82,16 @@ os.environ['LANG'] = 'C.UTF-8'
               default='hash', help='In what format to add the public key to '
               'the image manifest: full key or hash of the key.')
 @click.option('-k', '--key', metavar='filename')
+@click.option('-z', '--compressed', metavar='filename',
+              help='Also write the signed image, without padding, compressed '
+                   'for the Firmware Update partition to this file.')
 @click.command(help='''Create a signed or unsigned image\n
                INFILE and OUTFILE are parsed as Intel HEX if the params have
                .hex extension, otherwise binary format is used''')
 def wrap(key, align, version, header_size, pad_header, layout, pad, confirm,
          max_sectors, overwrite_only, endian, encrypt, infile, outfile,
          dependencies, hex_addr, erased_val, save_enctlv, public_key_format,
-         security_counter):
+         security_counter, compressed):
 
     slot_size = macro_parser.evaluate_macro(layout, sign_bin_size_re, 0, 1)
     load_addr = macro_parser.evaluate_macro(layout, load_addr_re, 0, 1)
@@ -119,6 +123,11 @@ def wrap(key, align, version, header_size, pad_header, layout, pad, confirm,
                                    "type of key")
 
     img.create(key, public_key_format, enckey, dependencies, boot_record)
+    # The padding is only added to the payload when the image is saved.
+    if compressed:
+        with open(compressed, 'wb') as f:
+            f.write(compress.compress_image(img.payload))
+
     img.save(outfile, hex_addr)
 
 
@@ -8,6 +8,7 @@
 #include "bootutil/boot_record.h"
 #include "bootutil/image.h"
 #include "flash_map/flash_map.h"
+#include "sysflash/sysflash.h"
 #include <string.h>
 
 /* Firmware Update specific macros */
@@ -106,6 +107,7 @@ int boot_save_shared_data(const struct image_header *hdr,
 {
     uint16_t fwu_minor;
     struct image_version image_ver;
+    uint8_t image_index;
 
     if (hdr == NULL || fap == NULL) {
         return -1;
@@ -113,10 +115,20 @@ int boot_save_shared_data(const struct image_header *hdr,
 
     image_ver = hdr->ih_ver;
 
-    //TODO: add the module identifier into the fwu_minor after the module
-    //arg is supported.
-    /* Currently hardcode it to 0 which indicates the full image. */
-    fwu_minor = SET_FWU_MINOR(0, SW_VERSION);
+    /* The module identifier is the index of the image, derived from the
+     * flash area the image is booted from.
+     */
+    for (image_index = 0; image_index < MCUBOOT_IMAGE_NUMBER; image_index++) {
+        if ((fap->fa_id == FLASH_AREA_IMAGE_PRIMARY(image_index)) ||
+            (fap->fa_id == FLASH_AREA_IMAGE_SECONDARY(image_index))) {
+            break;
+        }
+    }
+    if (image_index == MCUBOOT_IMAGE_NUMBER) {
+        return -1;
+    }
+
+    fwu_minor = SET_FWU_MINOR(image_index, SW_VERSION);
     return boot_add_data_to_shared_area(TLV_MAJOR_FWU,
                                         fwu_minor,
                                         sizeof(image_ver),
@@ -90,6 +90,7 @@ if (TFM_PARTITION_CRYPTO)
                         ${INTERFACE_INC_DIR}/psa/crypto_values.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_crypto_defs.h
+                        ${INTERFACE_INC_DIR}/tfm_crypto_batch_api.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
@@ -27,14 +27,26 @@ tfm_invalid_config(TFM_ISOLATION_LEVEL LESS 1 OR TFM_ISOLATION_LEVEL GREATER 3)
 tfm_invalid_config(TFM_ISOLATION_LEVEL EQUAL 3 AND NOT TFM_PLATFORM IN_LIST TFM_L3_PLATFORM_LISTS)
 tfm_invalid_config(TFM_ISOLATION_LEVEL GREATER 1 AND NOT TFM_PSA_API)
 
+tfm_invalid_config(PSA_FRAMEWORK_HAS_MM_IOVEC AND NOT TFM_PSA_API)
+
 tfm_invalid_config(TFM_MULTI_CORE_TOPOLOGY AND NOT TFM_PSA_API)
 tfm_invalid_config(TFM_MULTI_CORE_MULTI_CLIENT_CALL AND NOT TFM_MULTI_CORE_TOPOLOGY)
 
+tfm_invalid_config(TFM_NS_CONN_REUSE AND NOT TFM_PSA_API)
+tfm_invalid_config(TFM_NS_CONN_REUSE AND TFM_MULTI_CORE_TOPOLOGY)
+tfm_invalid_config(TFM_NS_CONN_REUSE AND TFM_NS_CLIENT_IDENTIFICATION)
+tfm_invalid_config(TFM_NS_CONN_REUSE AND TFM_NS_CONN_CACHE_SIZE LESS 1)
+
 tfm_invalid_config(TEST_S  AND TEST_PSA_API)
 tfm_invalid_config(TEST_NS AND TEST_PSA_API)
 
 tfm_invalid_config((TFM_PARTITION_PROTECTED_STORAGE AND PS_ROLLBACK_PROTECTION) AND NOT TFM_PARTITION_PLATFORM)
 tfm_invalid_config(PS_ROLLBACK_PROTECTION AND NOT PS_ENCRYPTION)
+tfm_invalid_config(PS_OBJ_TABLE_JOURNAL_RECORDS LESS 2)
+tfm_invalid_config(PS_TRANSACTION_MAX_OPS LESS 1)
+tfm_invalid_config(ITS_TRANSACTION_MAX_OPS LESS 1)
+tfm_invalid_config(ITS_WEAR_LEVEL_THRESHOLD LESS 0)
+tfm_invalid_config(ITS_METADATA_CACHE_ENTRIES LESS 0)
 
 tfm_invalid_config(TEST_PSA_API STREQUAL "IPC" AND NOT TFM_PSA_API)
 tfm_invalid_config(TEST_PSA_API STREQUAL "CRYPTO" AND NOT TFM_PARTITION_CRYPTO)
@@ -44,6 +56,15 @@ tfm_invalid_config(TEST_PSA_API STREQUAL "PROTECTED_STORAGE" AND NOT TFM_PARTITI
 tfm_invalid_config(TEST_PSA_API STREQUAL "STORAGE" AND NOT TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
 tfm_invalid_config(TEST_PSA_API STREQUAL "STORAGE" AND NOT TFM_PARTITION_PROTECTED_STORAGE)
 
+tfm_invalid_config(CRYPTO_CIPHER_OPER_NUM LESS 1 OR CRYPTO_CIPHER_OPER_NUM GREATER 255)
+tfm_invalid_config(CRYPTO_MAC_OPER_NUM LESS 1 OR CRYPTO_MAC_OPER_NUM GREATER 255)
+tfm_invalid_config(CRYPTO_HASH_OPER_NUM LESS 1 OR CRYPTO_HASH_OPER_NUM GREATER 255)
+tfm_invalid_config(CRYPTO_KEY_DERIVATION_OPER_NUM LESS 1 OR CRYPTO_KEY_DERIVATION_OPER_NUM GREATER 255)
+tfm_invalid_config(CRYPTO_OPER_CLIENT_QUOTA LESS 0)
+tfm_invalid_config(CRYPTO_MAX_KEY_HANDLES LESS 1 OR CRYPTO_MAX_KEY_HANDLES GREATER 1024)
+
+tfm_invalid_config(TFM_FWU_MAX_BLOCK_SIZE LESS 1)
+
 tfm_invalid_config(CRYPTO_HW_ACCELERATOR_OTP_STATE AND NOT CRYPTO_HW_ACCELERATOR)
 tfm_invalid_config(CRYPTO_HW_ACCELERATOR_OTP_STATE AND NOT (CRYPTO_HW_ACCELERATOR_OTP_STATE STREQUAL "ENABLED" OR CRYPTO_HW_ACCELERATOR_OTP_STATE STREQUAL "PROVISIONING"))
 
@@ -63,3 +84,4 @@ tfm_invalid_config(TFM_CODE_SHARING STREQUAL "OFF" AND TFM_CODE_SHARING_PATH)
 
 tfm_invalid_config((MCUBOOT_UPGRADE_STRATEGY STREQUAL "DIRECT_XIP" OR MCUBOOT_UPGRADE_STRATEGY STREQUAL "RAM_LOAD") AND TFM_PARTITION_FIRMWARE_UPDATE)
 tfm_invalid_config(TFM_PARTITION_FIRMWARE_UPDATE AND NOT MCUBOOT_DATA_SHARING)
+tfm_invalid_config(TFM_PARTITION_FIRMWARE_UPDATE AND NOT TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
@@ -19,8 +19,11 @@ set(TEST_PSA_API                        ""          CACHE STRING    "Which (if a
 set(TFM_PSA_API                         ON         CACHE BOOL      "Use PSA api (IPC mode) instead of secure library mode")
 set(TFM_ISOLATION_LEVEL                 1           CACHE STRING    "Isolation level")
 set(TFM_PROFILE                         ""          CACHE STRING    "Profile to use")
+set(PSA_FRAMEWORK_HAS_MM_IOVEC          OFF         CACHE BOOL      "Let RoT Services map the client iovecs instead of copying them")
 
 set(TFM_NS_CLIENT_IDENTIFICATION        OFF         CACHE BOOL      "Enable NS client identification")
+set(TFM_NS_CONN_REUSE                   OFF         CACHE BOOL      "Keep the connections of the NS service APIs open between calls")
+set(TFM_NS_CONN_CACHE_SIZE              4           CACHE STRING    "Number of connections kept open by the NS service APIs")
 
 set(TFM_EXTRA_CONFIG_PATH               ""          CACHE PATH      "Path to extra cmake config file")
 set(TFM_EXTRA_MANIFEST_LIST_PATH        ""          CACHE PATH      "Path to extra manifest file, used to declare extra partitions. Appended to standard TFM manifest")
@@ -94,6 +97,9 @@ set(PS_VALIDATE_METADATA_FROM_FLASH     ON          CACHE BOOL      "Validate fi
 set(PS_MAX_ASSET_SIZE                   "2048"      CACHE STRING    "The maximum asset size to be stored in the Protected Storage area")
 set(PS_NUM_ASSETS                       "10"        CACHE STRING    "The maximum number of assets to be stored in the Protected Storage area")
 set(PS_CRYPTO_AEAD_ALG                  PSA_ALG_GCM CACHE STRING    "The AEAD algorithm to use for authenticated encryption in Protected Storage")
+set(PS_CRYPTO_KEY_EPOCH                 "0"         CACHE STRING    "The number of uses of the Protected Storage key before it is derived again, 0 to derive it once per boot")
+set(PS_OBJ_TABLE_JOURNAL_RECORDS        "8"         CACHE STRING    "The number of Protected Storage object table changes recorded before the whole table is saved again")
+set(PS_TRANSACTION_MAX_OPS              "10"        CACHE STRING    "The maximum number of changes in a Protected Storage transaction")
 
 set(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE ON       CACHE BOOL      "Enable Internal Trusted Storage partition")
 set(ITS_CREATE_FLASH_LAYOUT             ON          CACHE BOOL      "Create flash FS if it doesn't exist for Internal Trusted Storage partition")
@@ -102,11 +108,19 @@ set(ITS_VALIDATE_METADATA_FROM_FLASH    ON          CACHE BOOL      "Validate fi
 set(ITS_MAX_ASSET_SIZE                  "512"       CACHE STRING    "The maximum asset size to be stored in the Internal Trusted Storage area")
 set(ITS_NUM_ASSETS                      "10"        CACHE STRING    "The maximum number of assets to be stored in the Internal Trusted Storage area")
 set(ITS_BUF_SIZE                        ""          CACHE STRING    "Size of the ITS internal data transfer buffer (defaults to ITS_MAX_ASSET_SIZE if not set)")
+set(ITS_TRANSACTION_MAX_OPS             "10"        CACHE STRING    "The maximum number of changes in an Internal Trusted Storage transaction")
+set(ITS_WEAR_LEVEL_THRESHOLD            "32"        CACHE STRING    "Erase count difference above which the flash filesystem moves a rarely written data block (0 to disable)")
+set(ITS_METADATA_CACHE_ENTRIES          "8"         CACHE STRING    "The number of flash filesystem metadata entries cached in RAM (0 to disable)")
 
 set(TFM_PARTITION_CRYPTO                ON          CACHE BOOL      "Enable Crypto partition")
 # CRYPTO_ENGINE_BUF_SIZE needs to be >8KB for EC signing by attest module.
 set(CRYPTO_ENGINE_BUF_SIZE              0x2080      CACHE STRING    "Heap size for the crypto backend")
-set(CRYPTO_CONC_OPER_NUM                8           CACHE STRING    "The max number of concurrent operations that can be active (allocated) at any time in Crypto")
+set(CRYPTO_CIPHER_OPER_NUM              4           CACHE STRING    "The max number of concurrent cipher operations that can be active (allocated) at any time in Crypto")
+set(CRYPTO_MAC_OPER_NUM                 4           CACHE STRING    "The max number of concurrent MAC operations that can be active (allocated) at any time in Crypto")
+set(CRYPTO_HASH_OPER_NUM                8           CACHE STRING    "The max number of concurrent hash operations that can be active (allocated) at any time in Crypto")
+set(CRYPTO_KEY_DERIVATION_OPER_NUM      2           CACHE STRING    "The max number of concurrent key derivation operations that can be active (allocated) at any time in Crypto")
+set(CRYPTO_MAX_KEY_HANDLES              16          CACHE STRING    "The max number of key handles that can be open at any time in Crypto")
+set(CRYPTO_OPER_CLIENT_QUOTA            0           CACHE STRING    "The max number of concurrent operations that a single client can have active at any time in Crypto (0 to disable)")
 set(CRYPTO_KEY_MODULE_DISABLED          FALSE       CACHE BOOL      "Disable PSA Crypto Key module")
 set(CRYPTO_AEAD_MODULE_DISABLED         FALSE       CACHE BOOL      "Disable PSA Crypto AEAD module")
 set(CRYPTO_MAC_MODULE_DISABLED          FALSE       CACHE BOOL      "Disable PSA Crypto MAC module")
@@ -129,6 +143,11 @@ set(FORWARD_PROT_MSG                    OFF         CACHE BOOL      "Whether to
 
 set(TFM_PARTITION_FIRMWARE_UPDATE       ON          CACHE BOOL      "Enable firmware update partition")
 set(TFM_FWU_BOOTLOADER_LIB             ${CMAKE_SOURCE_DIR}/secure_fw/partitions/firmware_update/bootloader/mcuboot/mcuboot_utilities.cmake CACHE FILEPATH    "Bootloader configure file for Firmware Update partition")
+set(TFM_FWU_MAX_BLOCK_SIZE              "4096"      CACHE STRING    "The maximum size of a block written by one tfm_fwu_write() call, shared by the secure and non-secure builds")
+set(TFM_FWU_BUF_SIZE                    ""          CACHE STRING    "Size of the FWU internal data transfer buffer (defaults to TFM_FWU_MAX_BLOCK_SIZE if not set)")
+set(TFM_FWU_STAGING_BUF_SIZE            ""          CACHE STRING    "Size of the FWU buffer gathering image data before it is programmed, a divisor of the image sector size (defaults to the image sector size if not set)")
+set(TFM_FWU_DELTA_UPDATE                OFF         CACHE BOOL      "Accept delta images reconstructed from the running image in the firmware update partition")
+set(TFM_FWU_COMPRESSED_UPDATE           OFF         CACHE BOOL      "Accept LZ4 compressed images decompressed while written in the firmware update partition")
 
 ################################## Tests #######################################
 
@@ -17,7 +17,16 @@
 extern "C" {
 #endif
 
-#define TFM_FWU_MAX_BLOCK_SIZE          1024
+/* The maximum size of a block passed to tfm_fwu_write() in one call. The
+ * secure side streams the block into flash in TFM_FWU_BUF_SIZE chunks, so a
+ * larger value only reduces the number of calls needed to stage an image.
+ * It is set by the TFM_FWU_MAX_BLOCK_SIZE build option, which is passed to
+ * both the secure and the non-secure builds through psa_interface, so that
+ * both sides agree on it.
+ */
+#ifndef TFM_FWU_MAX_BLOCK_SIZE
+#define TFM_FWU_MAX_BLOCK_SIZE          4096
+#endif
 #define TFM_FWU_INVALID_IMAGE_ID        0
 
 /* The maximum size of an image digest in bytes. This is dependent
@@ -65,6 +74,10 @@ typedef struct tfm_image_info_s {
     tfm_image_version_t version;
     uint8_t state;
     uint8_t digest[TFM_FWU_MAX_DIGEST_SIZE];
+    size_t resume_offset;   /* Offset in the staging area from which an
+                             * interrupted download can be continued, 0 if
+                             * there is none.
+                             */
 } tfm_image_info_t;
 
 /**
@@ -83,7 +96,7 @@ typedef struct tfm_image_info_s {
  * \param[in] block            A buffer containing a block of image data. This
  *                             might be a complete image or a subset.
  * \param[in] block_size       Size of block. The size must not be greater than
- *                             PSA_FWU_MAX_BLOCK_SIZE.
+ *                             TFM_FWU_MAX_BLOCK_SIZE.
  *
  * \return A status indicating the success/failure of the operation
  *
@@ -92,7 +105,7 @@ typedef struct tfm_image_info_s {
  * \retval PSA_ERROR_INVALID_ARGUMENT      One of the following error
  *                                         conditions occured:
  *                                         The parameter size is greater than
- *                                         PSA_FWU_MAX_BLOCK_SIZE;
+ *                                         TFM_FWU_MAX_BLOCK_SIZE;
  *                                         The parameter size is 0;
  *                                         The combination of offset and size
  *                                         is out of bounds.
@@ -164,6 +177,9 @@ psa_status_t tfm_fwu_abort(const tfm_image_id_t uuid);
 /**
  * \brief Returns information for an image of a particular UUID.
  *
+ * For an image in the staging area, the resume_offset of info tells where an
+ * interrupted download of the image can be continued after a reset.
+ *
  * \param[in] uuid             The UUID of the image to query
  *
  * \param[out] info            Output parameter for image information
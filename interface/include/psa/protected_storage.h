@@ -275,6 +275,110 @@ psa_status_t psa_ps_set_extended(psa_storage_uid_t uid,
  */
 uint32_t psa_ps_get_support(void);
 
+/**
+ * \brief Begin a transaction
+ *
+ * Groups the following calls to psa_ps_transaction_set and
+ * psa_ps_transaction_remove, which are applied atomically when the
+ * transaction is committed. Only one transaction can be in progress at a time.
+ * If the caller already has a transaction in progress, its staged changes are
+ * discarded and a new transaction begins.
+ *
+ * The transaction has no timeout: until the owner commits or aborts it, or
+ * begins a new one, this function fails for every other client. All the
+ * non-secure clients share one client ID unless TF-M identifies them, in which
+ * case they share one transaction.
+ *
+ * \note This is a TF-M extension to the PSA PS API.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS          The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE  The operation failed because another client has
+ *                              a transaction in progress
+ */
+psa_status_t psa_ps_transaction_begin(void);
+
+/**
+ * \brief Stage the creation or modification of a uid/value pair in the
+ *        transaction in progress
+ *
+ * The data is copied when this function is called, but is only visible once
+ * the transaction has been committed. The parameters and errors are those of
+ * psa_ps_set.
+ *
+ * \note This is a TF-M extension to the PSA PS API.
+ *
+ * \param[in] uid           The identifier for the data
+ * \param[in] data_length   The size in bytes of the data in `p_data`
+ * \param[in] p_data        A buffer containing the data
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_ERROR_BAD_STATE             The caller has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The transaction already changes the
+ *                                         maximum number of uids, or there is
+ *                                         no space to stage the data
+ */
+psa_status_t psa_ps_transaction_set(psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     const void *p_data,
+                                     psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Stage the removal of a uid in the transaction in progress
+ *
+ * The parameters and errors are those of psa_ps_remove.
+ *
+ * \note This is a TF-M extension to the PSA PS API.
+ *
+ * \param[in] uid  The `uid` value
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_ERROR_BAD_STATE             The caller has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The transaction already changes the
+ *                                         maximum number of uids
+ */
+psa_status_t psa_ps_transaction_remove(psa_storage_uid_t uid);
+
+/**
+ * \brief Apply all the changes staged in the transaction in progress and end
+ *        the transaction
+ *
+ * Either all or none of the changes are applied, even if power is lost.
+ *
+ * \note This is a TF-M extension to the PSA PS API.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The caller has no transaction in progress
+ * \retval PSA_ERROR_NOT_PERMITTED    The operation failed because one of the
+ *                                    uids has been created with
+ *                                    PSA_STORAGE_FLAG_WRITE_ONCE since its
+ *                                    change was staged
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ */
+psa_status_t psa_ps_transaction_commit(void);
+
+/**
+ * \brief Discard all the changes staged in the transaction in progress and end
+ *        the transaction
+ *
+ * \note This is a TF-M extension to the PSA PS API.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS          The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE  The caller has no transaction in progress
+ */
+psa_status_t psa_ps_transaction_abort(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -202,6 +202,104 @@ size_t psa_skip(psa_handle_t msg_handle, uint32_t invec_idx, size_t num_bytes);
 void psa_write(psa_handle_t msg_handle, uint32_t outvec_idx,
                const void *buffer, size_t num_bytes);
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+/**
+ * \brief Map a client input vector for direct access by the RoT Service.
+ *
+ * \param[in] msg_handle        Handle for the client's message.
+ * \param[in] invec_idx         Index of the input vector to map. Must be
+ *                              less than \ref PSA_MAX_IOVEC.
+ *
+ * \retval                      A pointer to the input vector data, which is
+ *                              valid until \ref psa_unmap_invec or
+ *                              \ref psa_reply is called for the message.
+ * \retval "PROGRAMMER ERROR"   The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           invec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The input vector has length zero.
+ * \arg                           The input vector has already been mapped
+ *                                or accessed with \ref psa_read or
+ *                                \ref psa_skip.
+ * \arg                           The Secure Partition cannot access the
+ *                                client memory directly.
+ */
+const void *psa_map_invec(psa_handle_t msg_handle, uint32_t invec_idx);
+
+/**
+ * \brief Unmap a client input vector mapped by \ref psa_map_invec.
+ *
+ * \param[in] msg_handle        Handle for the client's message.
+ * \param[in] invec_idx         Index of the input vector to unmap. Must be
+ *                              less than \ref PSA_MAX_IOVEC.
+ *
+ * \retval void                 Success.
+ * \retval "PROGRAMMER ERROR"   The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           invec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The input vector is not mapped, or has
+ *                                already been unmapped.
+ */
+void psa_unmap_invec(psa_handle_t msg_handle, uint32_t invec_idx);
+
+/**
+ * \brief Map a client output vector for direct access by the RoT Service.
+ *
+ * \param[in] msg_handle        Handle for the client's message.
+ * \param[in] outvec_idx        Index of the output vector to map. Must be
+ *                              less than \ref PSA_MAX_IOVEC.
+ *
+ * \retval                      A pointer to the output vector buffer, which
+ *                              is valid until \ref psa_unmap_outvec or
+ *                              \ref psa_reply is called for the message.
+ * \retval "PROGRAMMER ERROR"   The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           outvec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The output vector has length zero.
+ * \arg                           The output vector has already been mapped
+ *                                or written with \ref psa_write.
+ * \arg                           The Secure Partition cannot access the
+ *                                client memory directly.
+ */
+void *psa_map_outvec(psa_handle_t msg_handle, uint32_t outvec_idx);
+
+/**
+ * \brief Unmap a client output vector mapped by \ref psa_map_outvec and set
+ *        the number of bytes written to it.
+ *
+ * \param[in] msg_handle        Handle for the client's message.
+ * \param[in] outvec_idx        Index of the output vector to unmap. Must be
+ *                              less than \ref PSA_MAX_IOVEC.
+ * \param[in] len               Number of bytes written to the output vector.
+ *
+ * \retval void                 Success.
+ * \retval "PROGRAMMER ERROR"   The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           outvec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The output vector is not mapped, or has
+ *                                already been unmapped.
+ * \arg                           len is greater than the size of the output
+ *                                vector.
+ */
+void psa_unmap_outvec(psa_handle_t msg_handle, uint32_t outvec_idx,
+                      size_t len);
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
+
 /**
  * \brief Complete handling of a specific message and unblock the client.
  *
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_CRYPTO_BATCH_API_H__
+#define __TFM_CRYPTO_BATCH_API_H__
+
+#include <stddef.h>
+#include "tfm_crypto_defs.h"
+#include "psa/error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Executes several crypto requests with a single call to the Crypto
+ *        service
+ *
+ * \details The commands are executed in order, independently of each other:
+ *          a failing command does not stop the following ones. Each command
+ *          is a request of the PSA Crypto API, described by the IOV that the
+ *          corresponding function sends, e.g. with TFM_CRYPTO_MAC_COMPUTE_SID
+ *          for psa_mac_compute(). A command cannot use an operation handle
+ *          returned by an earlier command of the same batch.
+ *
+ * \note This is only supported in IPC mode. Each buffer must be aligned as
+ *       the structures it holds. Within in_data and the output data of out,
+ *       each vector starts at an offset rounded up to a multiple of
+ *       \ref TFM_CRYPTO_BATCH_VEC_ALIGNMENT, which
+ *       \ref TFM_CRYPTO_BATCH_VEC_NEXT computes. The padding before a vector
+ *       counts in in_size and out_size, the padding after the last one does
+ *       not.
+ *
+ * \param[in]  cmds     Commands to execute
+ * \param[in]  num_cmds Number of commands
+ * \param[in]  in_data  Input vectors of the commands, packed in order
+ * \param[in]  in_size  Size in bytes of in_data
+ * \param[out] out      Buffer receiving num_cmds results, one for each command,
+ *                      followed by the output vectors of the commands packed
+ *                      in order from \ref TFM_CRYPTO_BATCH_OUT_DATA
+ * \param[in]  out_size Size in bytes of out
+ *
+ * \retval PSA_SUCCESS                The commands have been executed, and
+ *                                    their statuses are in their results
+ * \retval PSA_ERROR_INVALID_ARGUMENT The vectors of a command do not fit in
+ *                                    in_data or out, this command and the
+ *                                    following ones have not been executed
+ * \retval PSA_ERROR_NOT_SUPPORTED    Batches are not supported
+ * \return Other return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_batch(const struct tfm_crypto_batch_cmd *cmds,
+                              size_t num_cmds,
+                              const void *in_data, size_t in_size,
+                              void *out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_CRYPTO_BATCH_API_H__ */
@@ -51,6 +51,65 @@ struct tfm_crypto_pack_iovec {
                                                 */
 };
 
+/**
+ * \brief Maximum number of input vectors, and of output vectors, of a batch
+ *        command in addition to its \ref tfm_crypto_pack_iovec
+ */
+#define TFM_CRYPTO_BATCH_MAX_VECS (PSA_MAX_IOVEC - 1)
+
+/**
+ * \brief Alignment of each vector in the input and output data of a batch
+ *        request. The offset of each vector, including an empty one, is
+ *        rounded up to a multiple of it.
+ */
+#define TFM_CRYPTO_BATCH_VEC_ALIGNMENT (4u)
+
+/**
+ * \brief Offset in the input or output data of a batch request of the vector
+ *        following the vector of the given offset and length.
+ */
+#define TFM_CRYPTO_BATCH_VEC_NEXT(offset, len) \
+    (((offset) + (len) + (TFM_CRYPTO_BATCH_VEC_ALIGNMENT - 1)) & \
+     ~(TFM_CRYPTO_BATCH_VEC_ALIGNMENT - 1))
+
+/**
+ * \brief Structure describing a command of a batch request
+ *
+ * \details The command is executed as a request made with the same IOV and
+ *          input and output vectors of the given lengths. The vectors of all
+ *          the commands are packed in order in the input and output data of
+ *          the batch, each at an offset aligned to
+ *          \ref TFM_CRYPTO_BATCH_VEC_ALIGNMENT. A length of 0 marks an unused
+ *          vector.
+ */
+struct tfm_crypto_batch_cmd {
+    struct tfm_crypto_pack_iovec iov;            /*!< IOV of the request */
+    uint32_t in_len[TFM_CRYPTO_BATCH_MAX_VECS];  /*!< Length of each input
+                                                  *   vector
+                                                  */
+    uint32_t out_len[TFM_CRYPTO_BATCH_MAX_VECS]; /*!< Size of each output
+                                                  *   vector
+                                                  */
+};
+
+/**
+ * \brief Structure holding the result of a command of a batch request
+ *
+ */
+struct tfm_crypto_batch_result {
+    psa_status_t status;                         /*!< Status of the command */
+    uint32_t out_len[TFM_CRYPTO_BATCH_MAX_VECS]; /*!< Number of bytes written
+                                                  *   to each output vector
+                                                  */
+};
+
+/**
+ * \brief Returns the start of the output vectors of the commands in the
+ *        output buffer of a batch request, which begins with their results.
+ */
+#define TFM_CRYPTO_BATCH_OUT_DATA(out, num_cmds) \
+    ((uint8_t *)(out) + ((num_cmds) * sizeof(struct tfm_crypto_batch_result)))
+
 /**
  * \brief Define a progressive numerical value for each SID which can be used
  *        when dispatching the requests to the service
@@ -129,6 +188,13 @@ enum {
  */
 #define TFM_CRYPTO_SID_INVALID (~0x0u)
 
+/**
+ * \brief Define the SID of a batch request, which carries several commands
+ *        instead of being dispatched to a single function
+ *
+ */
+#define TFM_CRYPTO_BATCH_SID (TFM_CRYPTO_SID_MAX)
+
 /**
  * \brief This value is used to mark an handle as invalid.
  *
@@ -8,6 +8,10 @@
 #ifndef __TFM_ITS_DEFS_H__
 #define __TFM_ITS_DEFS_H__
 
+#include <stdint.h>
+
+#include "psa/storage_common.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,6 +19,24 @@ extern "C" {
 /* Invalid UID */
 #define TFM_ITS_INVALID_UID 0
 
+/* Operations of the ITS transaction service */
+#define TFM_ITS_TRANSACTION_BEGIN   (1u)
+#define TFM_ITS_TRANSACTION_SET     (2u)
+#define TFM_ITS_TRANSACTION_REMOVE  (3u)
+#define TFM_ITS_TRANSACTION_COMMIT  (4u)
+#define TFM_ITS_TRANSACTION_ABORT   (5u)
+
+/**
+ * \brief Arguments of a request to the ITS transaction service, passed in the
+ *        first input vector. The data of a set operation is passed in the
+ *        second input vector.
+ */
+struct tfm_its_transaction_args_t {
+    psa_storage_uid_t uid;                   /*!< Asset to set or remove */
+    psa_storage_create_flags_t create_flags; /*!< Flags of the asset to set */
+    uint32_t op;                             /*!< Operation to perform */
+};
+
 #ifdef __cplusplus
 }
 #endif
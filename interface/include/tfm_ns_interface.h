@@ -47,6 +47,31 @@ int32_t tfm_ns_interface_dispatch(veneer_fn fn,
  * \return  A value according to \ref enum tfm_status_e
  */
 enum tfm_status_e tfm_ns_interface_init(void);
+
+/**
+ * \brief Call a RoT Service by SID
+ *
+ * \details This function makes a PSA_IPC_CALL request to the RoT Service with
+ *          the given SID. When TFM_NS_CONN_REUSE is defined, the connection is
+ *          kept open for the next call to the same RoT Service, otherwise it
+ *          is opened and closed around the request. A kept connection on
+ *          which the RoT Service returns PSA_ERROR_PROGRAMMER_ERROR is
+ *          closed, and the status is returned without making the request
+ *          again, as the RoT Service may have acted on it.
+ *
+ * \param[in]     sid     RoT Service identity
+ * \param[in]     version Version of the RoT Service
+ * \param[in]     in_vec  Array of input \ref psa_invec structures
+ * \param[in]     in_len  Number of input \ref psa_invec structures
+ * \param[in,out] out_vec Array of output \ref psa_outvec structures
+ * \param[in]     out_len Number of output \ref psa_outvec structures
+ *
+ * \retval PSA_ERROR_GENERIC_ERROR The connection could not be opened
+ * \return Otherwise, the status returned by the RoT Service
+ */
+psa_status_t tfm_ns_psa_sid_call(uint32_t sid, uint32_t version,
+                                 const psa_invec *in_vec, size_t in_len,
+                                 psa_outvec *out_vec, size_t out_len);
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,10 @@
 #ifndef __TFM_PS_DEFS_H__
 #define __TFM_PS_DEFS_H__
 
+#include <stdint.h>
+
+#include "psa/storage_common.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,6 +19,24 @@ extern "C" {
 /* Invalid UID */
 #define TFM_PS_INVALID_UID 0
 
+/* Operations of the PS transaction service */
+#define TFM_PS_TRANSACTION_BEGIN   (1u)
+#define TFM_PS_TRANSACTION_SET     (2u)
+#define TFM_PS_TRANSACTION_REMOVE  (3u)
+#define TFM_PS_TRANSACTION_COMMIT  (4u)
+#define TFM_PS_TRANSACTION_ABORT   (5u)
+
+/**
+ * \brief Arguments of a request to the PS transaction service, passed in the
+ *        first input vector. The data of a set operation is passed in the
+ *        second input vector.
+ */
+struct tfm_ps_transaction_args_t {
+    psa_storage_uid_t uid;                   /*!< Asset to set or remove */
+    psa_storage_create_flags_t create_flags; /*!< Flags of the asset to set */
+    uint32_t op;                             /*!< Operation to perform */
+};
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,7 @@
 
 #include "tfm_veneers.h"
 #include "tfm_crypto_defs.h"
+#include "tfm_crypto_batch_api.h"
 #include "psa/crypto.h"
 #include "tfm_ns_interface.h"
 
@@ -1499,3 +1500,16 @@ psa_status_t psa_aead_update(psa_aead_operation_t *operation,
 
     return status;
 }
+
+psa_status_t tfm_crypto_batch(const struct tfm_crypto_batch_cmd *cmds,
+                              size_t num_cmds,
+                              const void *in_data, size_t in_size,
+                              void *out, size_t out_size)
+{
+    psa_status_t status;
+
+    /* Batches are only supported by the IPC model */
+    status = PSA_ERROR_NOT_SUPPORTED;
+
+    return status;
+}
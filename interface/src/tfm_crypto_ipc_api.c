@@ -6,6 +6,7 @@
  */
 
 #include "tfm_crypto_defs.h"
+#include "tfm_crypto_batch_api.h"
 #include "psa/crypto.h"
 #include "tfm_ns_interface.h"
 #include "psa_manifest/sid.h"
@@ -13,22 +14,13 @@
 
 #define ARRAY_SIZE(arr) (sizeof(arr)/sizeof(arr[0]))
 
-#define PSA_CONNECT(service)                                    \
-    psa_handle_t ipc_handle;                                    \
-    ipc_handle = psa_connect(service##_SID, service##_VERSION); \
-    if (!PSA_HANDLE_IS_VALID(ipc_handle)) {                     \
-        return PSA_ERROR_GENERIC_ERROR;                         \
-    }                                                           \
-
-#define PSA_CLOSE() psa_close(ipc_handle)
-
 #define API_DISPATCH(sfn_name, sfn_id)                          \
-    psa_call(ipc_handle, PSA_IPC_CALL,                          \
+    tfm_ns_psa_sid_call(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION,     \
         in_vec, ARRAY_SIZE(in_vec),                             \
         out_vec, ARRAY_SIZE(out_vec))
 
 #define API_DISPATCH_NO_OUTVEC(sfn_name, sfn_id)                \
-    psa_call(ipc_handle, PSA_IPC_CALL,                          \
+    tfm_ns_psa_sid_call(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION,     \
         in_vec, ARRAY_SIZE(in_vec),                             \
         (psa_outvec *)NULL, 0)
 
@@ -55,13 +47,9 @@ psa_status_t psa_open_key(psa_key_id_t id,
         {.base = handle, .len = sizeof(psa_key_handle_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_open_key,
                           TFM_CRYPTO_OPEN_KEY);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -76,13 +64,9 @@ psa_status_t psa_close_key(psa_key_handle_t handle)
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_close_key,
                                     TFM_CRYPTO_CLOSE_KEY);;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -104,11 +88,8 @@ psa_status_t psa_import_key(const psa_key_attributes_t *attributes,
         {.base = handle, .len = sizeof(psa_key_handle_t)}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_import_key,
                           TFM_CRYPTO_IMPORT_KEY);
-    PSA_CLOSE();
 
     return status;
 }
@@ -124,11 +105,8 @@ psa_status_t psa_destroy_key(psa_key_handle_t handle)
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_destroy_key,
                                     TFM_CRYPTO_DESTROY_KEY);
-    PSA_CLOSE();
 
     return status;
 }
@@ -148,11 +126,8 @@ psa_status_t psa_get_key_attributes(psa_key_handle_t handle,
         {.base = attributes, .len = sizeof(psa_key_attributes_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_get_key_attributes,
                           TFM_CRYPTO_GET_KEY_ATTRIBUTES);
-    PSA_CLOSE();
 
     return status;
 }
@@ -169,15 +144,8 @@ void psa_reset_key_attributes(psa_key_attributes_t *attributes)
         {.base = attributes, .len = sizeof(psa_key_attributes_t)},
     };
 
-    psa_handle_t ipc_handle;
-    ipc_handle = psa_connect(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION);
-    if (!PSA_HANDLE_IS_VALID(ipc_handle)) {
-        return;
-    }
-
     (void)API_DISPATCH(tfm_crypto_reset_key_attributes,
                           TFM_CRYPTO_RESET_KEY_ATTRIBUTES);
-    PSA_CLOSE();
 
     return;
 }
@@ -199,15 +167,11 @@ psa_status_t psa_export_key(psa_key_handle_t handle,
         {.base = data, .len = data_size}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_export_key,
                           TFM_CRYPTO_EXPORT_KEY);
 
     *data_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -229,15 +193,11 @@ psa_status_t psa_export_public_key(psa_key_handle_t handle,
         {.base = data, .len = data_size}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_export_public_key,
                           TFM_CRYPTO_EXPORT_PUBLIC_KEY);
 
     *data_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -261,13 +221,9 @@ psa_status_t psa_copy_key(psa_key_handle_t source_handle,
         {.base = target_handle, .len = sizeof(psa_key_handle_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_copy_key,
                           TFM_CRYPTO_COPY_KEY);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -290,15 +246,11 @@ psa_status_t psa_cipher_generate_iv(psa_cipher_operation_t *operation,
         {.base = iv, .len = iv_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_generate_iv,
                           TFM_CRYPTO_CIPHER_GENERATE_IV);
 
     *iv_length = out_vec[1].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -320,13 +272,9 @@ psa_status_t psa_cipher_set_iv(psa_cipher_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_set_iv,
                           TFM_CRYPTO_CIPHER_SET_IV);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -349,13 +297,9 @@ psa_status_t psa_cipher_encrypt_setup(psa_cipher_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_encrypt_setup,
                           TFM_CRYPTO_CIPHER_ENCRYPT_SETUP);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -378,13 +322,9 @@ psa_status_t psa_cipher_decrypt_setup(psa_cipher_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_decrypt_setup,
                           TFM_CRYPTO_CIPHER_DECRYPT_SETUP);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -410,15 +350,11 @@ psa_status_t psa_cipher_update(psa_cipher_operation_t *operation,
         {.base = output, .len = output_size}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_update,
                           TFM_CRYPTO_CIPHER_UPDATE);
 
     *output_length = out_vec[1].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -437,13 +373,9 @@ psa_status_t psa_cipher_abort(psa_cipher_operation_t *operation)
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_abort,
                           TFM_CRYPTO_CIPHER_ABORT);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -466,15 +398,11 @@ psa_status_t psa_cipher_finish(psa_cipher_operation_t *operation,
         {.base = output, .len = output_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_cipher_finish,
                           TFM_CRYPTO_CIPHER_FINISH);
 
     *output_length = out_vec[1].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -495,13 +423,9 @@ psa_status_t psa_hash_setup(psa_hash_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_setup,
                           TFM_CRYPTO_HASH_SETUP);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -523,13 +447,9 @@ psa_status_t psa_hash_update(psa_hash_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_update,
                           TFM_CRYPTO_HASH_UPDATE);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -552,15 +472,11 @@ psa_status_t psa_hash_finish(psa_hash_operation_t *operation,
         {.base = hash, .len = hash_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_finish,
                           TFM_CRYPTO_HASH_FINISH);
 
     *hash_length = out_vec[1].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -582,13 +498,9 @@ psa_status_t psa_hash_verify(psa_hash_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_verify,
                           TFM_CRYPTO_HASH_VERIFY);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -607,13 +519,9 @@ psa_status_t psa_hash_abort(psa_hash_operation_t *operation)
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_abort,
                           TFM_CRYPTO_HASH_ABORT);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -637,13 +545,9 @@ psa_status_t psa_hash_clone(const psa_hash_operation_t *source_operation,
         return PSA_ERROR_BAD_STATE;
     }
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_clone,
                           TFM_CRYPTO_HASH_CLONE);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -669,15 +573,11 @@ psa_status_t psa_hash_compute(psa_algorithm_t alg,
         {.base = hash, .len = hash_size}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_hash_compute,
                           TFM_CRYPTO_HASH_COMPUTE);
 
     *hash_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -699,13 +599,9 @@ psa_status_t psa_hash_compare(psa_algorithm_t alg,
         {.base = hash, .len = hash_length},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_hash_compare,
                           TFM_CRYPTO_HASH_COMPARE);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -728,13 +624,9 @@ psa_status_t psa_mac_sign_setup(psa_mac_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_mac_sign_setup,
                           TFM_CRYPTO_MAC_SIGN_SETUP);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -757,13 +649,9 @@ psa_status_t psa_mac_verify_setup(psa_mac_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_mac_verify_setup,
                           TFM_CRYPTO_MAC_VERIFY_SETUP);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -785,13 +673,9 @@ psa_status_t psa_mac_update(psa_mac_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_mac_update,
                           TFM_CRYPTO_MAC_UPDATE);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -814,15 +698,11 @@ psa_status_t psa_mac_sign_finish(psa_mac_operation_t *operation,
         {.base = mac, .len = mac_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_mac_sign_finish,
                           TFM_CRYPTO_MAC_SIGN_FINISH);
 
     *mac_length = out_vec[1].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -844,13 +724,9 @@ psa_status_t psa_mac_verify_finish(psa_mac_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_mac_verify_finish,
                           TFM_CRYPTO_MAC_VERIFY_FINISH);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -869,13 +745,9 @@ psa_status_t psa_mac_abort(psa_mac_operation_t *operation)
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_mac_abort,
                           TFM_CRYPTO_MAC_ABORT);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -924,19 +796,16 @@ psa_status_t psa_aead_encrypt(psa_key_handle_t handle,
         }
     }
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     size_t in_len = ARRAY_SIZE(in_vec);
     if (additional_data == NULL) {
         in_len--;
     }
-    status = psa_call(ipc_handle, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_ns_psa_sid_call(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION,
+                                 in_vec, in_len,
+                                 out_vec, ARRAY_SIZE(out_vec));
 
     *ciphertext_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -985,19 +854,16 @@ psa_status_t psa_aead_decrypt(psa_key_handle_t handle,
         }
     }
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     size_t in_len = ARRAY_SIZE(in_vec);
     if (additional_data == NULL) {
         in_len--;
     }
-    status = psa_call(ipc_handle, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_ns_psa_sid_call(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION,
+                                 in_vec, in_len,
+                                 out_vec, ARRAY_SIZE(out_vec));
 
     *plaintext_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1035,15 +901,11 @@ psa_status_t psa_sign_hash(psa_key_handle_t handle,
         {.base = signature, .len = signature_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_sign_hash,
                           TFM_CRYPTO_SIGN_HASH);
 
     *signature_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1077,13 +939,9 @@ psa_status_t psa_verify_hash(psa_key_handle_t handle,
         {.base = signature, .len = signature_length}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_verify_hash,
                                     TFM_CRYPTO_VERIFY_HASH);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1119,19 +977,16 @@ psa_status_t psa_asymmetric_encrypt(psa_key_handle_t handle,
         {.base = output, .len = output_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     size_t in_len = ARRAY_SIZE(in_vec);
     if (salt == NULL) {
         in_len--;
     }
-    status = psa_call(ipc_handle, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_ns_psa_sid_call(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION,
+                                 in_vec, in_len,
+                                 out_vec, ARRAY_SIZE(out_vec));
 
     *output_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1167,19 +1022,16 @@ psa_status_t psa_asymmetric_decrypt(psa_key_handle_t handle,
         {.base = output, .len = output_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     size_t in_len = ARRAY_SIZE(in_vec);
     if (salt == NULL) {
         in_len--;
     }
-    status = psa_call(ipc_handle, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_ns_psa_sid_call(TFM_CRYPTO_SID, TFM_CRYPTO_VERSION,
+                                 in_vec, in_len,
+                                 out_vec, ARRAY_SIZE(out_vec));
 
     *output_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1201,13 +1053,9 @@ psa_status_t psa_key_derivation_get_capacity(
         {.base = capacity, .len = sizeof(size_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_key_derivation_get_capacity,
                           TFM_CRYPTO_KEY_DERIVATION_GET_CAPACITY);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1230,13 +1078,9 @@ psa_status_t psa_key_derivation_output_bytes(
         {.base = output, .len = output_length},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_key_derivation_output_bytes,
                           TFM_CRYPTO_KEY_DERIVATION_OUTPUT_BYTES);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1257,13 +1101,9 @@ psa_status_t psa_key_derivation_input_key(
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_key_derivation_input_key,
                                     TFM_CRYPTO_KEY_DERIVATION_INPUT_KEY);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1284,13 +1124,9 @@ psa_status_t psa_key_derivation_abort(
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_key_derivation_abort,
                           TFM_CRYPTO_KEY_DERIVATION_ABORT);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1314,13 +1150,9 @@ psa_status_t psa_key_derivation_key_agreement(
         {.base = peer_key, .len = peer_key_length},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_key_derivation_key_agreement,
                                     TFM_CRYPTO_KEY_DERIVATION_KEY_AGREEMENT);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1344,13 +1176,9 @@ psa_status_t psa_generate_random(uint8_t *output,
         return PSA_SUCCESS;
     }
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_generate_random,
                           TFM_CRYPTO_GENERATE_RANDOM);
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1371,11 +1199,8 @@ psa_status_t psa_generate_key(const psa_key_attributes_t *attributes,
         {.base = handle, .len = sizeof(psa_key_handle_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_generate_key,
                           TFM_CRYPTO_GENERATE_KEY);
-    PSA_CLOSE();
 
     return status;
 }
@@ -1537,15 +1362,11 @@ psa_status_t psa_raw_key_agreement(psa_algorithm_t alg,
         {.base = output, .len = output_size},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_raw_key_agreement,
                           TFM_CRYPTO_RAW_KEY_AGREEMENT);
 
     *output_length = out_vec[0].len;
 
-    PSA_CLOSE();
-
     return status;
 }
 
@@ -1566,11 +1387,8 @@ psa_status_t psa_key_derivation_setup(psa_key_derivation_operation_t *operation,
         {.base = &(operation->handle), .len = sizeof(uint32_t)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_key_derivation_setup,
                           TFM_CRYPTO_KEY_DERIVATION_SETUP);
-    PSA_CLOSE();
 
     return status;
 }
@@ -1590,11 +1408,8 @@ psa_status_t psa_key_derivation_set_capacity(
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_key_derivation_set_capacity,
                                     TFM_CRYPTO_KEY_DERIVATION_SET_CAPACITY);
-    PSA_CLOSE();
 
     return status;
 }
@@ -1617,11 +1432,8 @@ psa_status_t psa_key_derivation_input_bytes(
         {.base = data, .len = data_length},
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH_NO_OUTVEC(tfm_crypto_key_derivation_input_bytes,
                                     TFM_CRYPTO_KEY_DERIVATION_INPUT_BYTES);
-    PSA_CLOSE();
 
     return status;
 }
@@ -1646,11 +1458,8 @@ psa_status_t psa_key_derivation_output_key(
         {.base = handle, .len = sizeof(psa_key_handle_t)}
     };
 
-    PSA_CONNECT(TFM_CRYPTO);
-
     status = API_DISPATCH(tfm_crypto_key_derivation_output_key,
                           TFM_CRYPTO_KEY_DERIVATION_OUTPUT_KEY);
-    PSA_CLOSE();
 
     return status;
 }
@@ -1724,3 +1533,24 @@ psa_status_t psa_aead_update(psa_aead_operation_t *operation,
 
     return status;
 }
+
+psa_status_t tfm_crypto_batch(const struct tfm_crypto_batch_cmd *cmds,
+                              size_t num_cmds,
+                              const void *in_data, size_t in_size,
+                              void *out, size_t out_size)
+{
+    const struct tfm_crypto_pack_iovec iov = {
+        .sfn_id = TFM_CRYPTO_BATCH_SID,
+    };
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
+        {.base = cmds, .len = num_cmds * sizeof(struct tfm_crypto_batch_cmd)},
+        {.base = in_data, .len = in_size},
+    };
+    psa_outvec out_vec[] = {
+        {.base = out, .len = out_size},
+    };
+
+    return API_DISPATCH(tfm_crypto_batch,
+                        TFM_CRYPTO_BATCH);
+}
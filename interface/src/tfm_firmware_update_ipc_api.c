@@ -7,6 +7,7 @@
 
 #include "firmware_update.h"
 #include "tfm_api.h"
+#include "tfm_ns_interface.h"
 
 #include "psa/client.h"
 #include "psa_manifest/sid.h"
@@ -19,7 +20,6 @@ psa_status_t tfm_fwu_write(const tfm_image_id_t uuid,
                            size_t block_size)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uuid, .len = sizeof(uuid) },
@@ -27,15 +27,8 @@ psa_status_t tfm_fwu_write(const tfm_image_id_t uuid,
         { .base = block, .len = block_size }
     };
 
-    handle = psa_connect(TFM_FWU_WRITE_SID, TFM_FWU_WRITE_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), NULL,
-                      0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_FWU_WRITE_SID, TFM_FWU_WRITE_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), NULL, 0);
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -49,7 +42,6 @@ psa_status_t tfm_fwu_install(const tfm_image_id_t uuid,
                              tfm_image_version_t *dependency_version)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uuid, .len = sizeof(uuid) }
@@ -64,15 +56,9 @@ psa_status_t tfm_fwu_install(const tfm_image_id_t uuid,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    handle = psa_connect(TFM_FWU_INSTALL_SID, TFM_FWU_INSTALL_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec),
-                      out_vec, IOVEC_LEN(out_vec));
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_FWU_INSTALL_SID, TFM_FWU_INSTALL_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), out_vec,
+                                 IOVEC_LEN(out_vec));
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -84,21 +70,13 @@ psa_status_t tfm_fwu_install(const tfm_image_id_t uuid,
 psa_status_t tfm_fwu_abort(const tfm_image_id_t uuid)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uuid, .len = sizeof(uuid) }
     };
 
-    handle = psa_connect(TFM_FWU_ABORT_SID, TFM_FWU_ABORT_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), NULL,
-                      0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_FWU_ABORT_SID, TFM_FWU_ABORT_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), NULL, 0);
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -110,7 +88,6 @@ psa_status_t tfm_fwu_abort(const tfm_image_id_t uuid)
 psa_status_t tfm_fwu_query(const tfm_image_id_t uuid, tfm_image_info_t *info)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uuid, .len = sizeof(uuid) }
@@ -119,15 +96,9 @@ psa_status_t tfm_fwu_query(const tfm_image_id_t uuid, tfm_image_info_t *info)
         { .base = info, .len = sizeof(*info)}
     };
 
-    handle = psa_connect(TFM_FWU_ABORT_SID, TFM_FWU_ABORT_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), out_vec,
-                      IOVEC_LEN(out_vec));
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_FWU_ABORT_SID, TFM_FWU_ABORT_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), out_vec,
+                                 IOVEC_LEN(out_vec));
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -138,18 +109,11 @@ psa_status_t tfm_fwu_query(const tfm_image_id_t uuid, tfm_image_info_t *info)
 
 psa_status_t tfm_fwu_request_reboot(void)
 {
-    psa_handle_t handle;
     psa_status_t status;
 
-    handle = psa_connect(TFM_FWU_REQUEST_REBOOT_SID,
-                         TFM_FWU_REQUEST_REBOOT_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, NULL, 0, NULL, 0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_FWU_REQUEST_REBOOT_SID,
+                                 TFM_FWU_REQUEST_REBOOT_VERSION,
+                                 NULL, 0, NULL, 0);
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -160,18 +124,10 @@ psa_status_t tfm_fwu_request_reboot(void)
 
 psa_status_t tfm_fwu_accept(void)
 {
-    psa_handle_t handle;
     psa_status_t status;
 
-    handle = psa_connect(TFM_FWU_ACCEPT_SID,
-                         TFM_FWU_ACCEPT_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, NULL, 0, NULL, 0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_FWU_ACCEPT_SID, TFM_FWU_ACCEPT_VERSION,
+                                 NULL, 0, NULL, 0);
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
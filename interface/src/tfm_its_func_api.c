@@ -6,6 +6,7 @@
  */
 
 #include "psa/internal_trusted_storage.h"
+#include "tfm_its_defs.h"
 #include "tfm_api.h"
 
 #include "tfm_ns_interface.h"
@@ -106,3 +107,81 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
                                      (uint32_t)in_vec, IOVEC_LEN(in_vec),
                                      (uint32_t)NULL, 0);
 }
+
+/**
+ * \brief Sends a request to the ITS transaction service.
+ *
+ * \param[in] op            Transaction operation
+ * \param[in] uid           Asset to set or remove
+ * \param[in] data_length   Size of the data of a set operation
+ * \param[in] p_data        Data of a set operation
+ * \param[in] create_flags  Flags of the asset to set
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+static psa_status_t its_transaction(uint32_t op,
+                                    psa_storage_uid_t uid,
+                                    size_t data_length,
+                                    const void *p_data,
+                                    psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+
+    struct tfm_its_transaction_args_t args = {
+        .uid = uid,
+        .create_flags = create_flags,
+        .op = op
+    };
+
+    psa_invec in_vec[] = {
+        { .base = &args, .len = sizeof(args) },
+        { .base = p_data, .len = data_length }
+    };
+
+    /* Only a set operation passes data */
+    uint32_t in_len = (op == TFM_ITS_TRANSACTION_SET) ? IOVEC_LEN(in_vec) : 1;
+
+    status = tfm_ns_interface_dispatch(
+                                (veneer_fn)tfm_tfm_its_transaction_req_veneer,
+                                (uint32_t)in_vec, in_len,
+                                (uint32_t)NULL, 0);
+
+    if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return status;
+}
+
+psa_status_t psa_its_transaction_begin(void)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_BEGIN, TFM_ITS_INVALID_UID, 0,
+                           NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_its_transaction_set(psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     const void *p_data,
+                                     psa_storage_create_flags_t create_flags)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_SET, uid, data_length, p_data,
+                           create_flags);
+}
+
+psa_status_t psa_its_transaction_remove(psa_storage_uid_t uid)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_REMOVE, uid, 0, NULL,
+                           PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_its_transaction_commit(void)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_COMMIT, TFM_ITS_INVALID_UID, 0,
+                           NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_its_transaction_abort(void)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_ABORT, TFM_ITS_INVALID_UID, 0,
+                           NULL, PSA_STORAGE_FLAG_NONE);
+}
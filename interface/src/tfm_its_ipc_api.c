@@ -6,7 +6,9 @@
  */
 
 #include "psa/internal_trusted_storage.h"
+#include "tfm_its_defs.h"
 #include "tfm_api.h"
+#include "tfm_ns_interface.h"
 
 #include "psa/client.h"
 #include "psa_manifest/sid.h"
@@ -19,7 +21,6 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
                          psa_storage_create_flags_t create_flags)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) },
@@ -27,14 +28,8 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
         { .base = &create_flags, .len = sizeof(create_flags) }
     };
 
-    handle = psa_connect(TFM_ITS_SET_SID, TFM_ITS_SET_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), NULL, 0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_ITS_SET_SID, TFM_ITS_SET_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), NULL, 0);
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -50,7 +45,6 @@ psa_status_t psa_its_get(psa_storage_uid_t uid,
                          size_t *p_data_length)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) },
@@ -65,15 +59,9 @@ psa_status_t psa_its_get(psa_storage_uid_t uid,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    handle = psa_connect(TFM_ITS_GET_SID, TFM_ITS_GET_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), out_vec,
-                      IOVEC_LEN(out_vec));
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_ITS_GET_SID, TFM_ITS_GET_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), out_vec,
+                                 IOVEC_LEN(out_vec));
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -88,7 +76,6 @@ psa_status_t psa_its_get_info(psa_storage_uid_t uid,
                               struct psa_storage_info_t *p_info)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) }
@@ -98,15 +85,9 @@ psa_status_t psa_its_get_info(psa_storage_uid_t uid,
         { .base = p_info, .len = sizeof(*p_info) }
     };
 
-    handle = psa_connect(TFM_ITS_GET_INFO_SID, TFM_ITS_GET_INFO_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), out_vec,
-                      IOVEC_LEN(out_vec));
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_ITS_GET_INFO_SID, TFM_ITS_GET_INFO_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), out_vec,
+                                 IOVEC_LEN(out_vec));
 
     if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -118,20 +99,90 @@ psa_status_t psa_its_get_info(psa_storage_uid_t uid,
 psa_status_t psa_its_remove(psa_storage_uid_t uid)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) }
     };
 
-    handle = psa_connect(TFM_ITS_REMOVE_SID, TFM_ITS_REMOVE_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
+    status = tfm_ns_psa_sid_call(TFM_ITS_REMOVE_SID, TFM_ITS_REMOVE_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), NULL, 0);
+
+    return status;
+}
 
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), NULL, 0);
+/**
+ * \brief Sends a request to the ITS transaction service.
+ *
+ * \param[in] op            Transaction operation
+ * \param[in] uid           Asset to set or remove
+ * \param[in] data_length   Size of the data of a set operation
+ * \param[in] p_data        Data of a set operation
+ * \param[in] create_flags  Flags of the asset to set
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+static psa_status_t its_transaction(uint32_t op,
+                                    psa_storage_uid_t uid,
+                                    size_t data_length,
+                                    const void *p_data,
+                                    psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+
+    struct tfm_its_transaction_args_t args = {
+        .uid = uid,
+        .create_flags = create_flags,
+        .op = op
+    };
 
-    psa_close(handle);
+    psa_invec in_vec[] = {
+        { .base = &args, .len = sizeof(args) },
+        { .base = p_data, .len = data_length }
+    };
+
+    /* Only a set operation passes data */
+    uint32_t in_len = (op == TFM_ITS_TRANSACTION_SET) ? IOVEC_LEN(in_vec) : 1;
+
+    status = tfm_ns_psa_sid_call(TFM_ITS_TRANSACTION_SID,
+                                 TFM_ITS_TRANSACTION_VERSION,
+                                 in_vec, in_len, NULL, 0);
+
+    if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
 
     return status;
 }
+
+psa_status_t psa_its_transaction_begin(void)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_BEGIN, TFM_ITS_INVALID_UID, 0,
+                           NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_its_transaction_set(psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     const void *p_data,
+                                     psa_storage_create_flags_t create_flags)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_SET, uid, data_length, p_data,
+                           create_flags);
+}
+
+psa_status_t psa_its_transaction_remove(psa_storage_uid_t uid)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_REMOVE, uid, 0, NULL,
+                           PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_its_transaction_commit(void)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_COMMIT, TFM_ITS_INVALID_UID, 0,
+                           NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_its_transaction_abort(void)
+{
+    return its_transaction(TFM_ITS_TRANSACTION_ABORT, TFM_ITS_INVALID_UID, 0,
+                           NULL, PSA_STORAGE_FLAG_NONE);
+}
@@ -14,6 +14,7 @@
 #include "psa/error.h"
 #include "tfm_api.h"
 #include "tfm_multi_core_api.h"
+#include "tfm_ns_interface.h"
 #include "tfm_ns_mailbox.h"
 
 /*
@@ -224,3 +225,22 @@ void psa_close(psa_handle_t handle)
 
     tfm_ns_multi_core_lock_release();
 }
+
+psa_status_t tfm_ns_psa_sid_call(uint32_t sid, uint32_t version,
+                                 const psa_invec *in_vec, size_t in_len,
+                                 psa_outvec *out_vec, size_t out_len)
+{
+    psa_handle_t handle;
+    psa_status_t status;
+
+    handle = psa_connect(sid, version);
+    if (!PSA_HANDLE_IS_VALID(handle)) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    status = psa_call(handle, PSA_IPC_CALL, in_vec, in_len, out_vec, out_len);
+
+    psa_close(handle);
+
+    return status;
+}
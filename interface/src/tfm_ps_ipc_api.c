@@ -6,6 +6,7 @@
  */
 
 #include "psa/protected_storage.h"
+#include "tfm_ps_defs.h"
 
 #include "tfm_ns_interface.h"
 #include "psa_manifest/sid.h"
@@ -18,7 +19,6 @@ psa_status_t psa_ps_set(psa_storage_uid_t uid,
                         psa_storage_create_flags_t create_flags)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid,   .len = sizeof(uid) },
@@ -26,15 +26,8 @@ psa_status_t psa_ps_set(psa_storage_uid_t uid,
         { .base = &create_flags, .len = sizeof(create_flags) }
     };
 
-    handle = psa_connect(TFM_PS_SET_SID, TFM_PS_SET_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec),
-                      NULL, 0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_PS_SET_SID, TFM_PS_SET_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), NULL, 0);
 
     /* A parameter with a buffer pointer pointer that has data length longer
      * than maximum permitted is treated as a secure violation.
@@ -54,7 +47,6 @@ psa_status_t psa_ps_get(psa_storage_uid_t uid,
                         size_t *p_data_length)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) },
@@ -69,15 +61,9 @@ psa_status_t psa_ps_get(psa_storage_uid_t uid,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    handle = psa_connect(TFM_PS_GET_SID, TFM_PS_GET_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), out_vec,
-                      IOVEC_LEN(out_vec));
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_PS_GET_SID, TFM_PS_GET_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), out_vec,
+                                 IOVEC_LEN(out_vec));
 
     *p_data_length = out_vec[0].len;
 
@@ -88,7 +74,6 @@ psa_status_t psa_ps_get_info(psa_storage_uid_t uid,
                              struct psa_storage_info_t *p_info)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) }
@@ -98,15 +83,9 @@ psa_status_t psa_ps_get_info(psa_storage_uid_t uid,
         { .base = p_info, .len = sizeof(*p_info) }
     };
 
-    handle = psa_connect(TFM_PS_GET_INFO_SID, TFM_PS_GET_INFO_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec), out_vec,
-                      IOVEC_LEN(out_vec));
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_PS_GET_INFO_SID, TFM_PS_GET_INFO_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), out_vec,
+                                 IOVEC_LEN(out_vec));
 
     return status;
 }
@@ -114,22 +93,14 @@ psa_status_t psa_ps_get_info(psa_storage_uid_t uid,
 psa_status_t psa_ps_remove(psa_storage_uid_t uid)
 {
     psa_status_t status;
-    psa_handle_t handle;
 
     psa_invec in_vec[] = {
         { .base = &uid, .len = sizeof(uid) }
     };
 
 
-    handle = psa_connect(TFM_PS_REMOVE_SID, TFM_PS_REMOVE_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    status = psa_call(handle, PSA_IPC_CALL, in_vec, IOVEC_LEN(in_vec),
-                      NULL, 0);
-
-    psa_close(handle);
+    status = tfm_ns_psa_sid_call(TFM_PS_REMOVE_SID, TFM_PS_REMOVE_VERSION,
+                                 in_vec, IOVEC_LEN(in_vec), NULL, 0);
 
     return status;
 }
@@ -161,7 +132,6 @@ uint32_t psa_ps_get_support(void)
      * uninitialised value in case the secure function fails.
      */
     uint32_t support_flags = 0;
-    psa_handle_t handle;
 
     psa_outvec out_vec[] = {
         { .base = &support_flags, .len = sizeof(support_flags) }
@@ -170,14 +140,86 @@ uint32_t psa_ps_get_support(void)
     /* The PSA API does not return an error, so any error from TF-M is
      * ignored.
      */
-    handle = psa_connect(TFM_PS_GET_SUPPORT_SID, TFM_PS_GET_SUPPORT_VERSION);
-    if (!PSA_HANDLE_IS_VALID(handle)) {
-        return support_flags;
+    (void)tfm_ns_psa_sid_call(TFM_PS_GET_SUPPORT_SID,
+                              TFM_PS_GET_SUPPORT_VERSION,
+                              NULL, 0, out_vec, IOVEC_LEN(out_vec));
+
+    return support_flags;
+}
+
+/**
+ * \brief Sends a request to the PS transaction service.
+ *
+ * \param[in] op            Transaction operation
+ * \param[in] uid           Asset to set or remove
+ * \param[in] data_length   Size of the data of a set operation
+ * \param[in] p_data        Data of a set operation
+ * \param[in] create_flags  Flags of the asset to set
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+static psa_status_t ps_transaction(uint32_t op,
+                                   psa_storage_uid_t uid,
+                                   size_t data_length,
+                                   const void *p_data,
+                                   psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+
+    struct tfm_ps_transaction_args_t args = {
+        .uid = uid,
+        .create_flags = create_flags,
+        .op = op
+    };
+
+    psa_invec in_vec[] = {
+        { .base = &args, .len = sizeof(args) },
+        { .base = p_data, .len = data_length }
+    };
+
+    /* Only a set operation passes data */
+    uint32_t in_len = (op == TFM_PS_TRANSACTION_SET) ? IOVEC_LEN(in_vec) : 1;
+
+    status = tfm_ns_psa_sid_call(TFM_PS_TRANSACTION_SID,
+                                 TFM_PS_TRANSACTION_VERSION,
+                                 in_vec, in_len, NULL, 0);
+
+    if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    (void)psa_call(handle, PSA_IPC_CALL, NULL, 0, out_vec, IOVEC_LEN(out_vec));
+    return status;
+}
 
-    psa_close(handle);
+psa_status_t psa_ps_transaction_begin(void)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_BEGIN, TFM_PS_INVALID_UID, 0,
+                          NULL, PSA_STORAGE_FLAG_NONE);
+}
 
-    return support_flags;
+psa_status_t psa_ps_transaction_set(psa_storage_uid_t uid,
+                                    size_t data_length,
+                                    const void *p_data,
+                                    psa_storage_create_flags_t create_flags)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_SET, uid, data_length, p_data,
+                          create_flags);
+}
+
+psa_status_t psa_ps_transaction_remove(psa_storage_uid_t uid)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_REMOVE, uid, 0, NULL,
+                          PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_ps_transaction_commit(void)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_COMMIT, TFM_PS_INVALID_UID, 0,
+                          NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_ps_transaction_abort(void)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_ABORT, TFM_PS_INVALID_UID, 0,
+                          NULL, PSA_STORAGE_FLAG_NONE);
 }
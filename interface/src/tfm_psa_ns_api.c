@@ -5,6 +5,8 @@
  *
  */
 
+#include <stdint.h>
+
 #include "psa/client.h"
 #include "tfm_ns_interface.h"
 #include "tfm_api.h"
@@ -77,3 +79,158 @@ void psa_close(psa_handle_t handle)
                          0,
                          0);
 }
+
+/**** Calls by SID ****/
+
+/* Request to a RoT Service by SID, passed to the function dispatched */
+struct ns_sid_call_t {
+    uint32_t sid;
+    uint32_t version;
+    const struct tfm_control_parameter_t *ctrl_param;
+    const psa_invec *in_vec;
+    psa_outvec *out_vec;
+};
+
+#ifdef TFM_NS_CONN_REUSE
+
+/* A connection kept open for the next calls to a RoT Service */
+struct ns_conn_t {
+    uint32_t sid;            /* RoT Service identity                   */
+    uint32_t version;        /* Version the connection was opened with */
+    psa_handle_t handle;     /* Connection handle, or PSA_NULL_HANDLE  */
+    uint32_t last_use;       /* Value of ns_conn_clock at last use     */
+};
+
+/*
+ * The connections are only accessed by ns_sid_call(), which the NS interface
+ * dispatcher serializes with the other NS calls to TF-M.
+ */
+static struct ns_conn_t ns_conn_cache[TFM_NS_CONN_CACHE_SIZE];
+static uint32_t ns_conn_clock;
+
+/*
+ * Returns the cache entry of the connection to the RoT Service if there is
+ * one. Otherwise, returns a free entry, or the least recently used one.
+ */
+static struct ns_conn_t *ns_conn_lookup(uint32_t sid, uint32_t version)
+{
+    struct ns_conn_t *conn, *victim = NULL;
+    uint32_t i;
+
+    for (i = 0; i < TFM_NS_CONN_CACHE_SIZE; i++) {
+        conn = &ns_conn_cache[i];
+        if (conn->handle == PSA_NULL_HANDLE) {
+            if (!victim || (victim->handle != PSA_NULL_HANDLE)) {
+                victim = conn;
+            }
+        } else if ((conn->sid == sid) && (conn->version == version)) {
+            return conn;
+        } else if (!victim ||
+                   ((victim->handle != PSA_NULL_HANDLE) &&
+                    ((ns_conn_clock - conn->last_use) >
+                     (ns_conn_clock - victim->last_use)))) {
+            victim = conn;
+        }
+    }
+
+    return victim;
+}
+
+static void ns_conn_close(struct ns_conn_t *conn)
+{
+    tfm_psa_close_veneer(conn->handle);
+    conn->handle = PSA_NULL_HANDLE;
+}
+
+static int32_t ns_sid_call(uint32_t arg0, uint32_t arg1,
+                           uint32_t arg2, uint32_t arg3)
+{
+    const struct ns_sid_call_t *req = (const struct ns_sid_call_t *)arg0;
+    struct ns_conn_t *conn;
+    psa_status_t status;
+
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+
+    conn = ns_conn_lookup(req->sid, req->version);
+
+    if ((conn->handle == PSA_NULL_HANDLE) || (conn->sid != req->sid) ||
+        (conn->version != req->version)) {
+        if (conn->handle != PSA_NULL_HANDLE) {
+            /* Evict the least recently used connection */
+            ns_conn_close(conn);
+        }
+
+        conn->handle = tfm_psa_connect_veneer(req->sid, req->version);
+        if (!PSA_HANDLE_IS_VALID(conn->handle)) {
+            conn->handle = PSA_NULL_HANDLE;
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+        conn->sid = req->sid;
+        conn->version = req->version;
+    }
+    conn->last_use = ++ns_conn_clock;
+
+    status = tfm_psa_call_veneer(conn->handle, req->ctrl_param,
+                                 req->in_vec, req->out_vec);
+    if (status == PSA_ERROR_PROGRAMMER_ERROR) {
+        /*
+         * The RoT Service terminated the connection, and may have done so
+         * after acting on the request, so the request is not made again.
+         * The connection is dropped, the next call opens a new one.
+         */
+        ns_conn_close(conn);
+    }
+
+    return status;
+}
+
+#else /* TFM_NS_CONN_REUSE */
+
+static int32_t ns_sid_call(uint32_t arg0, uint32_t arg1,
+                           uint32_t arg2, uint32_t arg3)
+{
+    const struct ns_sid_call_t *req = (const struct ns_sid_call_t *)arg0;
+    psa_handle_t handle;
+    psa_status_t status;
+
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+
+    handle = tfm_psa_connect_veneer(req->sid, req->version);
+    if (!PSA_HANDLE_IS_VALID(handle)) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    status = tfm_psa_call_veneer(handle, req->ctrl_param, req->in_vec,
+                                 req->out_vec);
+
+    tfm_psa_close_veneer(handle);
+
+    return status;
+}
+
+#endif /* TFM_NS_CONN_REUSE */
+
+psa_status_t tfm_ns_psa_sid_call(uint32_t sid, uint32_t version,
+                                 const psa_invec *in_vec, size_t in_len,
+                                 psa_outvec *out_vec, size_t out_len)
+{
+    const struct tfm_control_parameter_t ctrl_param = {
+        .type = PSA_IPC_CALL,
+        .in_len = in_len,
+        .out_len = out_len,
+    };
+    const struct ns_sid_call_t req = {
+        .sid = sid,
+        .version = version,
+        .ctrl_param = &ctrl_param,
+        .in_vec = in_vec,
+        .out_vec = out_vec,
+    };
+
+    /* Connect, call and close in one NS call, to be serialized as a whole */
+    return tfm_ns_interface_dispatch(ns_sid_call, (uint32_t)&req, 0, 0, 0);
+}
@@ -41,6 +41,12 @@ typedef enum {
     TFM_SVC_PSA_CLEAR,
     TFM_SVC_PSA_PANIC,
     TFM_SVC_PSA_LIFECYCLE,
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    TFM_SVC_PSA_MAP_INVEC,
+    TFM_SVC_PSA_UNMAP_INVEC,
+    TFM_SVC_PSA_MAP_OUTVEC,
+    TFM_SVC_PSA_UNMAP_OUTVEC,
+#endif
 #endif
     TFM_SVC_PLATFORM_BASE = 50 /* leave room for additional Core handlers */
 } tfm_svc_number_t;
@@ -52,7 +52,7 @@ psa_status_t tfm_crypto_aead_encrypt(psa_invec in_vec[],
     /* Initialise ciphertext_length to zero. */
     out_vec[0].len = 0;
 
-    status = tfm_crypto_check_handle_owner(key_handle, NULL);
+    status = tfm_crypto_check_handle_owner(&key_handle, NULL);
     if (status == PSA_SUCCESS) {
 
         status = psa_aead_encrypt(key_handle, alg, nonce, nonce_length,
@@ -97,7 +97,7 @@ psa_status_t tfm_crypto_aead_decrypt(psa_invec in_vec[],
     /* Initialise plaintext_length to zero. */
     out_vec[0].len = 0;
 
-    status = tfm_crypto_check_handle_owner(key_handle, NULL);
+    status = tfm_crypto_check_handle_owner(&key_handle, NULL);
     if (status == PSA_SUCCESS) {
 
         status = psa_aead_decrypt(key_handle, alg, nonce, nonce_length,
@@ -15,68 +15,239 @@
 #include "tfm_memory_utils.h"
 
 /**
- * \def TFM_CRYPTO_CONC_OPER_NUM
+ * \def TFM_CRYPTO_CIPHER_OPER_NUM
+ * \def TFM_CRYPTO_MAC_OPER_NUM
+ * \def TFM_CRYPTO_HASH_OPER_NUM
+ * \def TFM_CRYPTO_KEY_DERIVATION_OPER_NUM
  *
- * \brief This is the default value for the maximum number of concurrent
- *        operations that can be active (allocated) at any time, supported
- *        by the implementation
+ * \brief These are the default values for the maximum number of concurrent
+ *        operations of each type that can be active (allocated) at any time,
+ *        supported by the implementation
  */
-#ifndef TFM_CRYPTO_CONC_OPER_NUM
-#define TFM_CRYPTO_CONC_OPER_NUM (8)
+#ifndef TFM_CRYPTO_CIPHER_OPER_NUM
+#define TFM_CRYPTO_CIPHER_OPER_NUM (4)
 #endif
+#ifndef TFM_CRYPTO_MAC_OPER_NUM
+#define TFM_CRYPTO_MAC_OPER_NUM (4)
+#endif
+#ifndef TFM_CRYPTO_HASH_OPER_NUM
+#define TFM_CRYPTO_HASH_OPER_NUM (8)
+#endif
+#ifndef TFM_CRYPTO_KEY_DERIVATION_OPER_NUM
+#define TFM_CRYPTO_KEY_DERIVATION_OPER_NUM (2)
+#endif
+
+/**
+ * \def TFM_CRYPTO_OPER_CLIENT_QUOTA
+ *
+ * \brief This is the default value for the maximum number of operations that
+ *        a single client can have active at any time, over all the types. The
+ *        value 0 means that a client is only limited by the pool sizes.
+ */
+#ifndef TFM_CRYPTO_OPER_CLIENT_QUOTA
+#define TFM_CRYPTO_OPER_CLIENT_QUOTA (0)
+#endif
+
+#if (TFM_CRYPTO_CIPHER_OPER_NUM < 1) || (TFM_CRYPTO_CIPHER_OPER_NUM > 255) || \
+    (TFM_CRYPTO_MAC_OPER_NUM < 1) || (TFM_CRYPTO_MAC_OPER_NUM > 255) ||       \
+    (TFM_CRYPTO_HASH_OPER_NUM < 1) || (TFM_CRYPTO_HASH_OPER_NUM > 255) ||     \
+    (TFM_CRYPTO_KEY_DERIVATION_OPER_NUM < 1) ||                               \
+    (TFM_CRYPTO_KEY_DERIVATION_OPER_NUM > 255)
+#error "The number of operations of each type must be between 1 and 255"
+#endif
+
+#define TFM_CRYPTO_OPER_TOTAL_NUM (TFM_CRYPTO_CIPHER_OPER_NUM +         \
+                                   TFM_CRYPTO_MAC_OPER_NUM +            \
+                                   TFM_CRYPTO_HASH_OPER_NUM +           \
+                                   TFM_CRYPTO_KEY_DERIVATION_OPER_NUM)
+
+/*
+ * An operation handle is made of the index of the context in its pool in
+ * bits [7:0], the type of the operation in bits [15:8] and the generation of
+ * the context in bits [31:16]. The generation is never 0, so a handle never
+ * matches TFM_CRYPTO_INVALID_HANDLE, and is changed each time the context is
+ * released, so a stale handle does not match a context allocated again.
+ */
+#define TFM_CRYPTO_OPER_INDEX_MASK  (0xFFu)
+#define TFM_CRYPTO_OPER_TYPE_SHIFT  (8)
+#define TFM_CRYPTO_OPER_TYPE_MASK   (0xFFu)
+#define TFM_CRYPTO_OPER_GEN_SHIFT   (16)
+#define TFM_CRYPTO_OPER_GEN_MASK    (0xFFFFu)
+
+#define TFM_CRYPTO_OPER_HANDLE(type, index, gen)                    \
+    (((uint32_t)(gen) << TFM_CRYPTO_OPER_GEN_SHIFT) |               \
+     ((uint32_t)(type) << TFM_CRYPTO_OPER_TYPE_SHIFT) |             \
+     (uint32_t)(index))
 
-struct tfm_crypto_operation_s {
-    uint32_t in_use;                /*!< Indicates if the operation is in use */
+/* Index of the end of a free list */
+#define TFM_CRYPTO_OPER_INDEX_NONE  (0xFFu)
+
+struct tfm_crypto_oper_slot_s {
     int32_t owner;                  /*!< Indicates an ID of the owner of
                                      *   the context
                                      */
-    enum tfm_crypto_operation_type type; /*!< Type of the operation */
-    union {
-        psa_cipher_operation_t cipher;    /*!< Cipher operation context */
-        psa_mac_operation_t mac;          /*!< MAC operation context */
-        psa_hash_operation_t hash;        /*!< Hash operation context */
-        psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
-    } operation;
+    uint16_t generation;            /*!< Generation of the context */
+    uint8_t in_use;                 /*!< Indicates if the operation is in use */
+    uint8_t next_free;              /*!< Index of the next free context */
 };
 
-static struct tfm_crypto_operation_s operation[TFM_CRYPTO_CONC_OPER_NUM] ={{0}};
+struct tfm_crypto_oper_pool_s {
+    struct tfm_crypto_oper_slot_s *slots; /*!< Slots of the contexts */
+    uint8_t *contexts;              /*!< Backend contexts of the pool */
+    size_t context_size;            /*!< Size of a backend context */
+    uint32_t num;                   /*!< Number of contexts in the pool */
+    uint32_t free_head;             /*!< Index of the first free context */
+    uint32_t in_use;                /*!< Contexts currently allocated */
+    uint32_t max_in_use;            /*!< High-water mark of in_use */
+    uint32_t alloc_failures;        /*!< Allocations which have failed */
+};
+
+static struct tfm_crypto_oper_slot_s cipher_slots[TFM_CRYPTO_CIPHER_OPER_NUM];
+static psa_cipher_operation_t cipher_contexts[TFM_CRYPTO_CIPHER_OPER_NUM];
+static struct tfm_crypto_oper_slot_s mac_slots[TFM_CRYPTO_MAC_OPER_NUM];
+static psa_mac_operation_t mac_contexts[TFM_CRYPTO_MAC_OPER_NUM];
+static struct tfm_crypto_oper_slot_s hash_slots[TFM_CRYPTO_HASH_OPER_NUM];
+static psa_hash_operation_t hash_contexts[TFM_CRYPTO_HASH_OPER_NUM];
+static struct tfm_crypto_oper_slot_s
+    key_deriv_slots[TFM_CRYPTO_KEY_DERIVATION_OPER_NUM];
+static psa_key_derivation_operation_t
+    key_deriv_contexts[TFM_CRYPTO_KEY_DERIVATION_OPER_NUM];
+
+/* Pools of the operation types, in the order of the type values */
+static struct tfm_crypto_oper_pool_s pools[] = {
+    {cipher_slots, (uint8_t *)cipher_contexts,
+     sizeof(psa_cipher_operation_t), TFM_CRYPTO_CIPHER_OPER_NUM, 0, 0, 0, 0},
+    {mac_slots, (uint8_t *)mac_contexts,
+     sizeof(psa_mac_operation_t), TFM_CRYPTO_MAC_OPER_NUM, 0, 0, 0, 0},
+    {hash_slots, (uint8_t *)hash_contexts,
+     sizeof(psa_hash_operation_t), TFM_CRYPTO_HASH_OPER_NUM, 0, 0, 0, 0},
+    {key_deriv_slots, (uint8_t *)key_deriv_contexts,
+     sizeof(psa_key_derivation_operation_t),
+     TFM_CRYPTO_KEY_DERIVATION_OPER_NUM, 0, 0, 0, 0},
+};
+
+#if TFM_CRYPTO_OPER_CLIENT_QUOTA > 0
+struct tfm_crypto_oper_client_s {
+    int32_t owner;                  /*!< ID of the client */
+    uint32_t count;                 /*!< Number of operations of the client,
+                                     *   0 if the entry is free
+                                     */
+};
+
+/* A client holds at least one context, so there is an entry for each */
+static struct tfm_crypto_oper_client_s clients[TFM_CRYPTO_OPER_TOTAL_NUM];
+#endif
 
 /*
- * \brief Function used to clear the memory associated to a backend context
+ * \brief Function used to get the pool of an operation type
  *
- * \param[in] index Numerical index in the database of the backend contexts
+ * \param[in] type Type of the operation
  *
- * \return None
+ * \return Pointer to the pool, or NULL if the type is not valid
  *
  */
-static void memset_operation_context(uint32_t index)
+static struct tfm_crypto_oper_pool_s *get_pool(uint32_t type)
 {
-    uint32_t mem_size;
-
-    uint8_t *mem_ptr = (uint8_t *) &(operation[index].operation);
-
-    switch(operation[index].type) {
-    case TFM_CRYPTO_CIPHER_OPERATION:
-        mem_size = sizeof(psa_cipher_operation_t);
-        break;
-    case TFM_CRYPTO_MAC_OPERATION:
-        mem_size = sizeof(psa_mac_operation_t);
-        break;
-    case TFM_CRYPTO_HASH_OPERATION:
-        mem_size = sizeof(psa_hash_operation_t);
-        break;
-    case TFM_CRYPTO_KEY_DERIVATION_OPERATION:
-        mem_size = sizeof(psa_key_derivation_operation_t);
-        break;
-    case TFM_CRYPTO_OPERATION_NONE:
-    default:
-        mem_size = 0;
-        break;
+    if ((type < TFM_CRYPTO_CIPHER_OPERATION) ||
+        (type > TFM_CRYPTO_KEY_DERIVATION_OPERATION)) {
+        return NULL;
     }
 
-    /* Clear the contents of the backend context */
-    (void)tfm_memset(mem_ptr, 0, mem_size);
+    return &pools[type - TFM_CRYPTO_CIPHER_OPERATION];
+}
+
+/*
+ * \brief Function used to get the pool and the index of the context that a
+ *        handle refers to
+ *
+ * \param[in]  handle       Handle of the context
+ * \param[in]  partition_id ID of the caller
+ * \param[out] index        Index of the context in the pool
+ *
+ * \return Pointer to the pool, or NULL if the handle does not refer to a
+ *         context of the caller
+ *
+ */
+static struct tfm_crypto_oper_pool_s *get_handle_pool(uint32_t handle,
+                                                      int32_t partition_id,
+                                                      uint32_t *index)
+{
+    struct tfm_crypto_oper_pool_s *pool;
+    struct tfm_crypto_oper_slot_s *slot;
+    uint32_t idx = handle & TFM_CRYPTO_OPER_INDEX_MASK;
+
+    pool = get_pool((handle >> TFM_CRYPTO_OPER_TYPE_SHIFT) &
+                    TFM_CRYPTO_OPER_TYPE_MASK);
+    if ((pool == NULL) || (idx >= pool->num)) {
+        return NULL;
+    }
+
+    slot = &pool->slots[idx];
+    if ((slot->in_use != TFM_CRYPTO_IN_USE) ||
+        (slot->generation != (handle >> TFM_CRYPTO_OPER_GEN_SHIFT)) ||
+        (slot->owner != partition_id)) {
+        return NULL;
+    }
+
+    *index = idx;
+    return pool;
+}
+
+#if TFM_CRYPTO_OPER_CLIENT_QUOTA > 0
+/*
+ * \brief Function used to charge a new operation to a client
+ *
+ * \param[in] owner ID of the client
+ *
+ * \return PSA_SUCCESS, or PSA_ERROR_NOT_PERMITTED if the client has reached
+ *         its quota
+ *
+ */
+static psa_status_t client_charge(int32_t owner)
+{
+    struct tfm_crypto_oper_client_s *entry = NULL;
+    uint32_t i;
+
+    for (i = 0; i < TFM_CRYPTO_OPER_TOTAL_NUM; i++) {
+        if (clients[i].count == 0) {
+            if (entry == NULL) {
+                entry = &clients[i];
+            }
+        } else if (clients[i].owner == owner) {
+            entry = &clients[i];
+            break;
+        }
+    }
+
+    if ((entry == NULL) || (entry->count >= TFM_CRYPTO_OPER_CLIENT_QUOTA)) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    entry->owner = owner;
+    entry->count++;
+    return PSA_SUCCESS;
+}
+
+/*
+ * \brief Function used to discharge a released operation from a client
+ *
+ * \param[in] owner ID of the client
+ *
+ * \return None
+ *
+ */
+static void client_discharge(int32_t owner)
+{
+    uint32_t i;
+
+    for (i = 0; i < TFM_CRYPTO_OPER_TOTAL_NUM; i++) {
+        if ((clients[i].count != 0) && (clients[i].owner == owner)) {
+            clients[i].count--;
+            return;
+        }
+    }
 }
+#endif /* TFM_CRYPTO_OPER_CLIENT_QUOTA > 0 */
 
 /*!
  * \defgroup public Public functions
@@ -86,8 +257,34 @@ static void memset_operation_context(uint32_t index)
 /*!@{*/
 psa_status_t tfm_crypto_init_alloc(void)
 {
-    /* Clear the contents of the local contexts */
-    (void)tfm_memset(operation, 0, sizeof(operation));
+    struct tfm_crypto_oper_pool_s *pool;
+    uint32_t i, j;
+
+    for (i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        pool = &pools[i];
+
+        /* Clear the contents of the local contexts */
+        (void)tfm_memset(pool->contexts, 0, pool->num * pool->context_size);
+
+        /* Chain all the contexts in the free list */
+        for (j = 0; j < pool->num; j++) {
+            pool->slots[j].owner = 0;
+            pool->slots[j].generation = 1;
+            pool->slots[j].in_use = TFM_CRYPTO_NOT_IN_USE;
+            pool->slots[j].next_free = (j + 1 < pool->num) ?
+                                       (uint8_t)(j + 1) :
+                                       TFM_CRYPTO_OPER_INDEX_NONE;
+        }
+        pool->free_head = 0;
+        pool->in_use = 0;
+        pool->max_in_use = 0;
+        pool->alloc_failures = 0;
+    }
+
+#if TFM_CRYPTO_OPER_CLIENT_QUOTA > 0
+    (void)tfm_memset(clients, 0, sizeof(clients));
+#endif
+
     return PSA_SUCCESS;
 }
 
@@ -95,7 +292,9 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
                                         uint32_t *handle,
                                         void **ctx)
 {
-    uint32_t i = 0;
+    struct tfm_crypto_oper_pool_s *pool;
+    struct tfm_crypto_oper_slot_s *slot;
+    uint32_t index;
     int32_t partition_id = 0;
     psa_status_t status;
 
@@ -115,23 +314,45 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
     }
     *ctx = NULL;
 
-    for (i=0; i<TFM_CRYPTO_CONC_OPER_NUM; i++) {
-        if (operation[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            operation[i].in_use = TFM_CRYPTO_IN_USE;
-            operation[i].owner = partition_id;
-            operation[i].type = type;
-            *handle = i + 1;
-            *ctx = (void *) &(operation[i].operation);
-            return PSA_SUCCESS;
-        }
+    pool = get_pool(type);
+    if (pool == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (pool->free_head == TFM_CRYPTO_OPER_INDEX_NONE) {
+        pool->alloc_failures++;
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+#if TFM_CRYPTO_OPER_CLIENT_QUOTA > 0
+    if (client_charge(partition_id) != PSA_SUCCESS) {
+        pool->alloc_failures++;
+        return PSA_ERROR_NOT_PERMITTED;
     }
+#endif
 
-    return PSA_ERROR_NOT_PERMITTED;
+    index = pool->free_head;
+    slot = &pool->slots[index];
+    pool->free_head = slot->next_free;
+
+    slot->in_use = TFM_CRYPTO_IN_USE;
+    slot->owner = partition_id;
+
+    pool->in_use++;
+    if (pool->in_use > pool->max_in_use) {
+        pool->max_in_use = pool->in_use;
+    }
+
+    *handle = TFM_CRYPTO_OPER_HANDLE(type, index, slot->generation);
+    *ctx = (void *)&pool->contexts[index * pool->context_size];
+    return PSA_SUCCESS;
 }
 
 psa_status_t tfm_crypto_operation_release(uint32_t *handle)
 {
-    uint32_t h_val = *handle;
+    struct tfm_crypto_oper_pool_s *pool;
+    struct tfm_crypto_oper_slot_s *slot;
+    uint32_t index = 0;
     int32_t partition_id = 0;
     psa_status_t status;
 
@@ -140,26 +361,38 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
         return status;
     }
 
-    if ( (h_val != TFM_CRYPTO_INVALID_HANDLE) &&
-         (h_val <= TFM_CRYPTO_CONC_OPER_NUM) &&
-         (operation[h_val - 1].in_use == TFM_CRYPTO_IN_USE) &&
-         (operation[h_val - 1].owner == partition_id)) {
-
-        memset_operation_context(h_val - 1);
-        operation[h_val - 1].in_use = TFM_CRYPTO_NOT_IN_USE;
-        operation[h_val - 1].type = TFM_CRYPTO_OPERATION_NONE;
-        operation[h_val - 1].owner = 0;
-        *handle = TFM_CRYPTO_INVALID_HANDLE;
-        return PSA_SUCCESS;
+    pool = get_handle_pool(*handle, partition_id, &index);
+    if (pool == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
+    slot = &pool->slots[index];
+
+    /* Clear the contents of the backend context */
+    (void)tfm_memset(&pool->contexts[index * pool->context_size], 0,
+                     pool->context_size);
 
-    return PSA_ERROR_INVALID_ARGUMENT;
+#if TFM_CRYPTO_OPER_CLIENT_QUOTA > 0
+    client_discharge(slot->owner);
+#endif
+
+    slot->in_use = TFM_CRYPTO_NOT_IN_USE;
+    slot->owner = 0;
+    slot->generation = (slot->generation == TFM_CRYPTO_OPER_GEN_MASK) ?
+                       1 : (slot->generation + 1);
+    slot->next_free = (uint8_t)pool->free_head;
+    pool->free_head = index;
+    pool->in_use--;
+
+    *handle = TFM_CRYPTO_INVALID_HANDLE;
+    return PSA_SUCCESS;
 }
 
 psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx)
 {
+    struct tfm_crypto_oper_pool_s *pool;
+    uint32_t index = 0;
     int32_t partition_id = 0;
     psa_status_t status;
 
@@ -168,16 +401,29 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
         return status;
     }
 
-    if ( (handle != TFM_CRYPTO_INVALID_HANDLE) &&
-         (handle <= TFM_CRYPTO_CONC_OPER_NUM) &&
-         (operation[handle - 1].in_use == TFM_CRYPTO_IN_USE) &&
-         (operation[handle - 1].type == type) &&
-         (operation[handle - 1].owner == partition_id)) {
+    pool = get_handle_pool(handle, partition_id, &index);
+    if ((pool == NULL) || (pool != get_pool(type))) {
+        return PSA_ERROR_BAD_STATE;
+    }
 
-        *ctx = (void *) &(operation[handle - 1].operation);
-        return PSA_SUCCESS;
+    *ctx = (void *)&pool->contexts[index * pool->context_size];
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_crypto_operation_get_stats(
+                                    enum tfm_crypto_operation_type type,
+                                    struct tfm_crypto_operation_stats *stats)
+{
+    struct tfm_crypto_oper_pool_s *pool = get_pool(type);
+
+    if ((pool == NULL) || (stats == NULL)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    return PSA_ERROR_BAD_STATE;
+    stats->num = pool->num;
+    stats->in_use = pool->in_use;
+    stats->max_in_use = pool->max_in_use;
+    stats->alloc_failures = pool->alloc_failures;
+    return PSA_SUCCESS;
 }
 /*!@}*/
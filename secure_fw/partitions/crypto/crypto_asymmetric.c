@@ -41,7 +41,7 @@ psa_status_t tfm_crypto_sign_hash(psa_invec in_vec[],
     size_t hash_length = in_vec[1].len;
     uint8_t *signature = out_vec[0].base;
     size_t signature_size = out_vec[0].len;
-    psa_status_t status = tfm_crypto_check_handle_owner(handle, NULL);
+    psa_status_t status = tfm_crypto_check_handle_owner(&handle, NULL);
 
     if (status != PSA_SUCCESS) {
         return status;
@@ -74,7 +74,7 @@ psa_status_t tfm_crypto_verify_hash(psa_invec in_vec[],
     size_t hash_length = in_vec[1].len;
     const uint8_t *signature = in_vec[2].base;
     size_t signature_length = in_vec[2].len;
-    psa_status_t status = tfm_crypto_check_handle_owner(handle, NULL);
+    psa_status_t status = tfm_crypto_check_handle_owner(&handle, NULL);
 
     if (status != PSA_SUCCESS) {
         return status;
@@ -114,7 +114,7 @@ psa_status_t tfm_crypto_asymmetric_encrypt(psa_invec in_vec[],
     size_t key_bits;
     psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
 
-    status = tfm_crypto_check_handle_owner(handle, NULL);
+    status = tfm_crypto_check_handle_owner(&handle, NULL);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -166,7 +166,7 @@ psa_status_t tfm_crypto_asymmetric_decrypt(psa_invec in_vec[],
     size_t output_size = out_vec[0].len;
     psa_status_t status;
 
-    status = tfm_crypto_check_handle_owner(handle, NULL);
+    status = tfm_crypto_check_handle_owner(&handle, NULL);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -51,6 +51,11 @@ LIST_TFM_CRYPTO_UNIFORM_SIGNATURE_API
  */
 #define TFM_CRYPTO_IOVEC_ALIGNMENT (4u)
 
+#if (TFM_CRYPTO_BATCH_VEC_ALIGNMENT % TFM_CRYPTO_IOVEC_ALIGNMENT) != 0
+#error "The vectors of a batch must be aligned as any other iovec"
+#endif
+
+#ifndef PSA_FRAMEWORK_HAS_MM_IOVEC
 /**
  * \brief Default size of the internal scratch buffer used for IOVec allocations
  *        in bytes
@@ -58,17 +63,41 @@ LIST_TFM_CRYPTO_UNIFORM_SIGNATURE_API
 #ifndef TFM_CRYPTO_IOVEC_BUFFER_SIZE
 #error TFM_CRYPTO_IOVEC_BUFFER_SIZE is not defined
 #endif
+#else
+/**
+ * \brief Size up to which a client vector is copied rather than mapped. This
+ *        covers the control parameters, such as key attributes and handles,
+ *        so that the client cannot change them after they are validated, nor
+ *        make them alias the other vectors. Larger vectors hold bulk data and
+ *        are mapped.
+ */
+#define TFM_CRYPTO_CTRL_VEC_SIZE \
+    ALIGN(sizeof(struct psa_client_key_attributes_s), TFM_CRYPTO_IOVEC_ALIGNMENT)
+
+/**
+ * \brief Whether a client vector of the given size is copied
+ */
+#define TFM_CRYPTO_CTRL_VEC(size) \
+    (((size) != 0) && ((size) <= TFM_CRYPTO_CTRL_VEC_SIZE))
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
 
 /**
  * \brief Internal scratch used for IOVec allocations
  *
  */
 static struct tfm_crypto_scratch {
+#ifndef PSA_FRAMEWORK_HAS_MM_IOVEC
     __attribute__((__aligned__(TFM_CRYPTO_IOVEC_ALIGNMENT)))
     uint8_t buf[TFM_CRYPTO_IOVEC_BUFFER_SIZE];
+#else
+    __attribute__((__aligned__(TFM_CRYPTO_IOVEC_ALIGNMENT)))
+    uint8_t in_ctrl[PSA_MAX_IOVEC][TFM_CRYPTO_CTRL_VEC_SIZE];
+    __attribute__((__aligned__(TFM_CRYPTO_IOVEC_ALIGNMENT)))
+    uint8_t out_ctrl[PSA_MAX_IOVEC][TFM_CRYPTO_CTRL_VEC_SIZE];
+#endif
     uint32_t alloc_index;
     int32_t owner;
-} scratch = {.buf = {0}, .alloc_index = 0};
+} scratch = {.alloc_index = 0};
 
 static psa_status_t tfm_crypto_set_scratch_owner(int32_t id)
 {
@@ -82,6 +111,7 @@ static psa_status_t tfm_crypto_get_scratch_owner(int32_t *id)
     return PSA_SUCCESS;
 }
 
+#ifndef PSA_FRAMEWORK_HAS_MM_IOVEC
 static psa_status_t tfm_crypto_alloc_scratch(size_t requested_size, void **buf)
 {
     /* Ensure alloc_index remains aligned to the required iovec alignment */
@@ -99,39 +129,78 @@ static psa_status_t tfm_crypto_alloc_scratch(size_t requested_size, void **buf)
 
     return PSA_SUCCESS;
 }
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
 
 void tfm_crypto_clear_scratch(void)
 {
     scratch.owner = 0;
+#ifndef PSA_FRAMEWORK_HAS_MM_IOVEC
     (void)tfm_memset(scratch.buf, 0, scratch.alloc_index);
+#else
+    (void)tfm_memset(scratch.in_ctrl, 0, sizeof(scratch.in_ctrl));
+    (void)tfm_memset(scratch.out_ctrl, 0, sizeof(scratch.out_ctrl));
+#endif
     scratch.alloc_index = 0;
 }
 
-static psa_status_t tfm_crypto_call_sfn(psa_msg_t *msg,
-                                        struct tfm_crypto_pack_iovec *iov,
-                                        const uint32_t sfn_id)
+/**
+ * \brief Gets the client vectors of a request for the secure functions
+ *
+ * \details The first input vector is the IOV read when parsing. If
+ *          PSA_FRAMEWORK_HAS_MM_IOVEC is defined, the other vectors holding
+ *          bulk data are mapped, so the size of a request is not bounded by
+ *          the scratch size, while the control vectors up to
+ *          TFM_CRYPTO_CTRL_VEC_SIZE are copied into the internal scratch.
+ *          Otherwise, all the vectors are allocated in the internal scratch
+ *          and the inputs are read into it.
+ *
+ * \param[in]  msg     Request message
+ * \param[in]  iov     IOV read when parsing the message
+ * \param[out] in_vec  Input vectors for the secure function
+ * \param[out] in_len  Number of input vectors
+ * \param[out] out_vec Output vectors for the secure function
+ * \param[out] out_len Number of output vectors
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+static psa_status_t tfm_crypto_get_iovecs(psa_msg_t *msg,
+                                          struct tfm_crypto_pack_iovec *iov,
+                                          psa_invec in_vec[], size_t *in_len,
+                                          psa_outvec out_vec[], size_t *out_len)
 {
-    psa_status_t status = PSA_SUCCESS;
-    size_t in_len = PSA_MAX_IOVEC, out_len = PSA_MAX_IOVEC, i;
-    psa_invec in_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
-    psa_outvec out_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+    size_t i;
+#ifndef PSA_FRAMEWORK_HAS_MM_IOVEC
+    psa_status_t status;
     void *alloc_buf_ptr = NULL;
+#endif
+
+    *in_len = PSA_MAX_IOVEC;
+    *out_len = PSA_MAX_IOVEC;
 
     /* Check the number of in_vec filled */
-    while ((in_len > 0) && (msg->in_size[in_len - 1] == 0)) {
-        in_len--;
+    while ((*in_len > 0) && (msg->in_size[*in_len - 1] == 0)) {
+        (*in_len)--;
     }
 
     /* There will always be a tfm_crypto_pack_iovec in the first iovec */
-    if (in_len < 1) {
+    if (*in_len < 1) {
         return PSA_ERROR_GENERIC_ERROR;
     }
     /* Initialise the first iovec with the IOV read when parsing */
     in_vec[0].base = iov;
     in_vec[0].len = sizeof(struct tfm_crypto_pack_iovec);
 
-    /* Alloc/read from the second element as the first is read when parsing */
-    for (i = 1; i < in_len; i++) {
+    /* Map/read from the second element as the first is read when parsing */
+    for (i = 1; i < *in_len; i++) {
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+        if (TFM_CRYPTO_CTRL_VEC(msg->in_size[i])) {
+            (void)psa_read(msg->handle, i, scratch.in_ctrl[i],
+                           msg->in_size[i]);
+            in_vec[i].base = scratch.in_ctrl[i];
+        } else if (msg->in_size[i] != 0) {
+            in_vec[i].base = psa_map_invec(msg->handle, i);
+        }
+#else
         /* Allocate necessary space in the internal scratch */
         status = tfm_crypto_alloc_scratch(msg->in_size[i], &alloc_buf_ptr);
         if (status != PSA_SUCCESS) {
@@ -140,41 +209,252 @@ static psa_status_t tfm_crypto_call_sfn(psa_msg_t *msg,
         }
         /* Read from the IPC framework inputs into the scratch */
         (void) psa_read(msg->handle, i, alloc_buf_ptr, msg->in_size[i]);
-        /* Populate the fields of the input to the secure function */
         in_vec[i].base = alloc_buf_ptr;
+#endif
         in_vec[i].len = msg->in_size[i];
     }
 
     /* Check the number of out_vec filled */
-    while ((out_len > 0) && (msg->out_size[out_len - 1] == 0)) {
-        out_len--;
+    while ((*out_len > 0) && (msg->out_size[*out_len - 1] == 0)) {
+        (*out_len)--;
     }
 
-    for (i = 0; i < out_len; i++) {
+    for (i = 0; i < *out_len; i++) {
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+        if (TFM_CRYPTO_CTRL_VEC(msg->out_size[i])) {
+            out_vec[i].base = scratch.out_ctrl[i];
+        } else if (msg->out_size[i] != 0) {
+            out_vec[i].base = psa_map_outvec(msg->handle, i);
+        }
+#else
         /* Allocate necessary space for the output in the internal scratch */
         status = tfm_crypto_alloc_scratch(msg->out_size[i], &alloc_buf_ptr);
         if (status != PSA_SUCCESS) {
             tfm_crypto_clear_scratch();
             return status;
         }
-        /* Populate the fields of the output to the secure function */
         out_vec[i].base = alloc_buf_ptr;
+#endif
         out_vec[i].len = msg->out_size[i];
     }
 
-    /* Set the owner of the data in the scratch */
+    /* Set the owner of the request */
     (void)tfm_crypto_set_scratch_owner(msg->client_id);
 
-    /* Call the uniform signature API */
-    status = sfid_func_table[sfn_id](in_vec, in_len, out_vec, out_len);
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Releases the client vectors got by \ref tfm_crypto_get_iovecs,
+ *        reporting the length of the outputs to the client
+ *
+ * \param[in] msg     Request message
+ * \param[in] in_len  Number of input vectors
+ * \param[in] out_vec Output vectors of the secure function
+ * \param[in] out_len Number of output vectors
+ */
+static void tfm_crypto_put_iovecs(psa_msg_t *msg, size_t in_len,
+                                  psa_outvec out_vec[], size_t out_len)
+{
+    size_t i;
+
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    for (i = 1; i < in_len; i++) {
+        if (!TFM_CRYPTO_CTRL_VEC(msg->in_size[i]) && (msg->in_size[i] != 0)) {
+            psa_unmap_invec(msg->handle, i);
+        }
+    }
+    for (i = 0; i < out_len; i++) {
+        if (TFM_CRYPTO_CTRL_VEC(msg->out_size[i])) {
+            psa_write(msg->handle, i, out_vec[i].base, out_vec[i].len);
+        } else if (msg->out_size[i] != 0) {
+            psa_unmap_outvec(msg->handle, i, out_vec[i].len);
+        }
+    }
+#else
+    (void)in_len;
 
     /* Write into the IPC framework outputs from the scratch */
     for (i = 0; i < out_len; i++) {
         psa_write(msg->handle, i, out_vec[i].base, out_vec[i].len);
     }
+#endif
 
     /* Clear the allocated internal scratch before returning */
     tfm_crypto_clear_scratch();
+}
+
+static psa_status_t tfm_crypto_call_sfn(psa_msg_t *msg,
+                                        struct tfm_crypto_pack_iovec *iov,
+                                        const uint32_t sfn_id)
+{
+    psa_status_t status = PSA_SUCCESS;
+    size_t in_len, out_len;
+    psa_invec in_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+    psa_outvec out_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+
+    status = tfm_crypto_get_iovecs(msg, iov, in_vec, &in_len,
+                                   out_vec, &out_len);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Call the uniform signature API */
+    status = sfid_func_table[sfn_id](in_vec, in_len, out_vec, out_len);
+
+    tfm_crypto_put_iovecs(msg, in_len, out_vec, out_len);
+
+    return status;
+}
+
+/**
+ * \brief Executes the commands of a batch request
+ *
+ * \details The request has the commands in the second input vector and their
+ *          packed input vectors in the optional third one. The output vector
+ *          receives the results of the commands followed by their packed
+ *          output vectors. The commands and the results are copied through
+ *          the stack, as the client buffers may be unaligned. If the client
+ *          vectors are mapped, so are the packed vectors, except the control
+ *          vectors of a command which are copied through the stack as well.
+ *
+ * \param[in] msg Request message
+ * \param[in] iov IOV read when parsing the message
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+static psa_status_t tfm_crypto_call_batch(psa_msg_t *msg,
+                                          struct tfm_crypto_pack_iovec *iov)
+{
+    psa_status_t status = PSA_SUCCESS;
+    size_t in_len, out_len, num_cmds, i, j;
+    psa_invec in_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+    psa_outvec out_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+    psa_invec cmd_in_vec[PSA_MAX_IOVEC];
+    psa_outvec cmd_out_vec[PSA_MAX_IOVEC];
+    size_t cmd_in_len, cmd_out_len;
+    struct tfm_crypto_batch_cmd cmd;
+    struct tfm_crypto_batch_result result;
+    const uint8_t *in_data = NULL;
+    uint8_t *out_data;
+    size_t in_size = 0, out_size, in_used = 0, out_used = 0;
+    size_t in_offset, out_offset;
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    __attribute__((__aligned__(TFM_CRYPTO_IOVEC_ALIGNMENT)))
+    uint8_t cmd_in_ctrl[TFM_CRYPTO_BATCH_MAX_VECS][TFM_CRYPTO_CTRL_VEC_SIZE];
+    __attribute__((__aligned__(TFM_CRYPTO_IOVEC_ALIGNMENT)))
+    uint8_t cmd_out_ctrl[TFM_CRYPTO_BATCH_MAX_VECS][TFM_CRYPTO_CTRL_VEC_SIZE];
+    uint8_t *cmd_out_base[TFM_CRYPTO_BATCH_MAX_VECS];
+#endif
+
+    status = tfm_crypto_get_iovecs(msg, iov, in_vec, &in_len,
+                                   out_vec, &out_len);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    num_cmds = in_vec[1].len / sizeof(struct tfm_crypto_batch_cmd);
+    if ((in_len < 2) || (out_len != 1) ||
+        ((in_vec[1].len % sizeof(struct tfm_crypto_batch_cmd)) != 0) ||
+        (out_vec[0].len < num_cmds * sizeof(struct tfm_crypto_batch_result))) {
+        out_vec[0].len = 0;
+        tfm_crypto_put_iovecs(msg, in_len, out_vec, out_len);
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    if (in_len > 2) {
+        in_data = in_vec[2].base;
+        in_size = in_vec[2].len;
+    }
+    out_data = TFM_CRYPTO_BATCH_OUT_DATA(out_vec[0].base, num_cmds);
+    out_size = out_vec[0].len -
+               (num_cmds * sizeof(struct tfm_crypto_batch_result));
+
+    for (i = 0; i < num_cmds; i++) {
+        (void)tfm_memcpy(&cmd, (const uint8_t *)in_vec[1].base +
+                               (i * sizeof(struct tfm_crypto_batch_cmd)),
+                         sizeof(struct tfm_crypto_batch_cmd));
+        (void)tfm_memset(&result, 0, sizeof(result));
+
+        /* The vectors of the commands following one which does not fit
+         * cannot be located, so these commands are not executed either.
+         */
+        cmd_in_vec[0].base = &cmd.iov;
+        cmd_in_vec[0].len = sizeof(struct tfm_crypto_pack_iovec);
+        cmd_in_len = 1;
+        cmd_out_len = 0;
+        for (j = 0; (status == PSA_SUCCESS) &&
+                    (j < TFM_CRYPTO_BATCH_MAX_VECS); j++) {
+            /* Each vector starts at an aligned offset, the padding before it
+             * must fit in the data as well.
+             */
+            in_offset = TFM_CRYPTO_BATCH_VEC_NEXT(in_used, 0);
+            out_offset = TFM_CRYPTO_BATCH_VEC_NEXT(out_used, 0);
+            if ((in_offset > in_size) ||
+                (cmd.in_len[j] > in_size - in_offset) ||
+                (out_offset > out_size) ||
+                (cmd.out_len[j] > out_size - out_offset)) {
+                status = PSA_ERROR_INVALID_ARGUMENT;
+                break;
+            }
+
+            cmd_in_vec[j + 1].base = in_data + in_offset;
+            cmd_in_vec[j + 1].len = cmd.in_len[j];
+            in_used = in_offset + cmd.in_len[j];
+            if (cmd.in_len[j] != 0) {
+                cmd_in_len = j + 2;
+            }
+
+            cmd_out_vec[j].base = out_data + out_offset;
+            cmd_out_vec[j].len = cmd.out_len[j];
+            out_used = out_offset + cmd.out_len[j];
+            if (cmd.out_len[j] != 0) {
+                cmd_out_len = j + 1;
+            }
+
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+            if (TFM_CRYPTO_CTRL_VEC(cmd.in_len[j])) {
+                (void)tfm_memcpy(cmd_in_ctrl[j], cmd_in_vec[j + 1].base,
+                                 cmd.in_len[j]);
+                cmd_in_vec[j + 1].base = cmd_in_ctrl[j];
+            }
+            cmd_out_base[j] = cmd_out_vec[j].base;
+            if (TFM_CRYPTO_CTRL_VEC(cmd.out_len[j])) {
+                cmd_out_vec[j].base = cmd_out_ctrl[j];
+            }
+#endif
+        }
+
+        if (status != PSA_SUCCESS) {
+            result.status = status;
+        } else if (cmd.iov.sfn_id >= TFM_CRYPTO_SID_MAX) {
+            result.status = PSA_ERROR_NOT_SUPPORTED;
+        } else {
+            result.status = sfid_func_table[cmd.iov.sfn_id](cmd_in_vec,
+                                                            cmd_in_len,
+                                                            cmd_out_vec,
+                                                            cmd_out_len);
+            for (j = 0; j < cmd_out_len; j++) {
+                result.out_len[j] = cmd_out_vec[j].len;
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+                if (TFM_CRYPTO_CTRL_VEC(cmd.out_len[j])) {
+                    (void)tfm_memcpy(cmd_out_base[j], cmd_out_ctrl[j],
+                                     cmd_out_vec[j].len);
+                }
+#endif
+            }
+        }
+
+        (void)tfm_memcpy((uint8_t *)out_vec[0].base +
+                         (i * sizeof(struct tfm_crypto_batch_result)),
+                         &result, sizeof(result));
+    }
+
+    /* Report the results and the space used by the outputs */
+    out_vec[0].len = (num_cmds * sizeof(struct tfm_crypto_batch_result)) +
+                     out_used;
+
+    tfm_crypto_put_iovecs(msg, in_len, out_vec, out_len);
 
     return status;
 }
@@ -195,7 +475,8 @@ static psa_status_t tfm_crypto_parse_msg(psa_msg_t *msg,
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    if (iov->sfn_id >= TFM_CRYPTO_SID_MAX) {
+    if ((iov->sfn_id >= TFM_CRYPTO_SID_MAX) &&
+        (iov->sfn_id != TFM_CRYPTO_BATCH_SID)) {
         *sfn_id_p = TFM_CRYPTO_SID_INVALID;
         return PSA_ERROR_GENERIC_ERROR;
     }
@@ -234,7 +515,9 @@ static void tfm_crypto_ipc_handler(void)
                 /* Parse the message */
                 status = tfm_crypto_parse_msg(&msg, &iov, &sfn_id);
                 /* Call the dispatcher based on the SID passed as type */
-                if (sfn_id != TFM_CRYPTO_SID_INVALID) {
+                if (sfn_id == TFM_CRYPTO_BATCH_SID) {
+                    status = tfm_crypto_call_batch(&msg, &iov);
+                } else if (sfn_id != TFM_CRYPTO_SID_INVALID) {
                     status = tfm_crypto_call_sfn(&msg, &iov, sfn_id);
                 } else {
                     status = PSA_ERROR_GENERIC_ERROR;
@@ -13,20 +13,65 @@
 #include "tfm_crypto_api.h"
 #include "tfm_crypto_defs.h"
 #include "tfm_crypto_private.h"
-#include <stdbool.h>
 
 #ifndef TFM_CRYPTO_MAX_KEY_HANDLES
 #define TFM_CRYPTO_MAX_KEY_HANDLES (16)
 #endif
+
+/*
+ * The handle returned to a client is made of the index of its entry in the
+ * handle_owner table in bits [9:0] and the generation of the entry in bits
+ * [15:10]. The generation is never 0, so a handle is never null, and is
+ * changed each time the entry is released, so a stale handle is rejected
+ * until the entry has been reused 63 times.
+ */
+#define TFM_CRYPTO_KEY_INDEX_BITS  (10)
+#define TFM_CRYPTO_KEY_INDEX_MASK  ((1u << TFM_CRYPTO_KEY_INDEX_BITS) - 1)
+#define TFM_CRYPTO_KEY_GEN_MASK    (0x3Fu)
+#define TFM_CRYPTO_KEY_HANDLE_MASK (0xFFFFu)
+
+/* Index of the end of the free list */
+#define TFM_CRYPTO_KEY_INDEX_NONE  (0xFFFFu)
+
+#if (TFM_CRYPTO_MAX_KEY_HANDLES < 1) || \
+    (TFM_CRYPTO_MAX_KEY_HANDLES > (TFM_CRYPTO_KEY_INDEX_MASK + 1))
+#error "TFM_CRYPTO_MAX_KEY_HANDLES must be between 1 and 1024"
+#endif
+
 struct tfm_crypto_handle_owner_s {
     int32_t owner;           /*!< Owner of the allocated handle */
-    psa_key_handle_t handle; /*!< Allocated handle */
+    psa_key_handle_t handle; /*!< Handle of the key in the backend */
+    uint16_t generation;     /*!< Generation of the entry */
+    uint16_t next_free;      /*!< Index of the next free entry */
     uint8_t in_use;          /*!< Flag to indicate if this in use */
 };
 
 #ifndef TFM_CRYPTO_KEY_MODULE_DISABLED
 static struct tfm_crypto_handle_owner_s
                                  handle_owner[TFM_CRYPTO_MAX_KEY_HANDLES] = {0};
+
+/* Released entries, and the first entry which has never been used */
+static uint32_t handle_free_head = TFM_CRYPTO_KEY_INDEX_NONE;
+static uint32_t handle_unused;
+
+/*
+ * \brief Function used to release an entry of the handle_owner table
+ *
+ * \param[in] index Index of the entry
+ *
+ * \return None
+ *
+ */
+static void release_key_storage(uint32_t index)
+{
+    handle_owner[index].owner = 0;
+    handle_owner[index].handle = 0;
+    handle_owner[index].in_use = TFM_CRYPTO_NOT_IN_USE;
+    handle_owner[index].generation =
+                (handle_owner[index].generation + 1) & TFM_CRYPTO_KEY_GEN_MASK;
+    handle_owner[index].next_free = (uint16_t)handle_free_head;
+    handle_free_head = index;
+}
 #endif
 
 /*!
@@ -83,14 +128,16 @@ psa_status_t tfm_crypto_key_attributes_to_client(
     return PSA_SUCCESS;
 }
 
-psa_status_t tfm_crypto_check_handle_owner(psa_key_handle_t handle,
+psa_status_t tfm_crypto_check_handle_owner(psa_key_handle_t *handle,
                                            uint32_t *index)
 {
 #ifdef TFM_CRYPTO_KEY_MODULE_DISABLED
     return PSA_ERROR_NOT_SUPPORTED;
 #else
     int32_t partition_id = 0;
-    uint32_t i = 0;
+    uint32_t i = (uint32_t)*handle & TFM_CRYPTO_KEY_INDEX_MASK;
+    uint32_t generation = ((uint32_t)*handle >> TFM_CRYPTO_KEY_INDEX_BITS) &
+                          TFM_CRYPTO_KEY_GEN_MASK;
     psa_status_t status;
 
     status = tfm_crypto_get_caller_id(&partition_id);
@@ -98,20 +145,23 @@ psa_status_t tfm_crypto_check_handle_owner(psa_key_handle_t handle,
         return status;
     }
 
-    for (i = 0; i < TFM_CRYPTO_MAX_KEY_HANDLES; i++) {
-        if (handle_owner[i].in_use && handle_owner[i].handle == handle) {
-            if (handle_owner[i].owner == partition_id) {
-                if (index != NULL) {
-                    *index = i;
-                }
-                return PSA_SUCCESS;
-            } else {
-                return PSA_ERROR_NOT_PERMITTED;
-            }
-        }
+    if ((((uint32_t)*handle & ~TFM_CRYPTO_KEY_HANDLE_MASK) != 0) ||
+        (i >= TFM_CRYPTO_MAX_KEY_HANDLES) ||
+        (handle_owner[i].in_use == TFM_CRYPTO_NOT_IN_USE) ||
+        (handle_owner[i].generation != generation)) {
+        return PSA_ERROR_INVALID_HANDLE;
+    }
+
+    if (handle_owner[i].owner != partition_id) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    if (index != NULL) {
+        *index = i;
     }
+    *handle = handle_owner[i].handle;
 
-    return PSA_ERROR_INVALID_HANDLE;
+    return PSA_SUCCESS;
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
 }
 
@@ -120,13 +170,14 @@ psa_status_t tfm_crypto_check_key_storage(uint32_t *index)
 #ifdef TFM_CRYPTO_KEY_MODULE_DISABLED
     return PSA_ERROR_NOT_SUPPORTED;
 #else
-    uint32_t i;
+    if (handle_free_head != TFM_CRYPTO_KEY_INDEX_NONE) {
+        *index = handle_free_head;
+        return PSA_SUCCESS;
+    }
 
-    for (i = 0; i < TFM_CRYPTO_MAX_KEY_HANDLES; i++) {
-        if (handle_owner[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            *index = i;
-            return PSA_SUCCESS;
-        }
+    if (handle_unused < TFM_CRYPTO_MAX_KEY_HANDLES) {
+        *index = handle_unused;
+        return PSA_SUCCESS;
     }
 
     return PSA_ERROR_INSUFFICIENT_MEMORY;
@@ -134,7 +185,7 @@ psa_status_t tfm_crypto_check_key_storage(uint32_t *index)
 }
 
 psa_status_t tfm_crypto_set_key_storage(uint32_t index,
-                                        psa_key_handle_t key_handle)
+                                        psa_key_handle_t *key_handle)
 {
 #ifdef TFM_CRYPTO_KEY_MODULE_DISABLED
     return PSA_ERROR_NOT_SUPPORTED;
@@ -147,10 +198,29 @@ psa_status_t tfm_crypto_set_key_storage(uint32_t index,
         return status;
     }
 
+    /* The index must be the one returned by tfm_crypto_check_key_storage */
+    if ((handle_free_head != TFM_CRYPTO_KEY_INDEX_NONE) &&
+        (index == handle_free_head)) {
+        handle_free_head = handle_owner[index].next_free;
+    } else if ((handle_free_head == TFM_CRYPTO_KEY_INDEX_NONE) &&
+               (index == handle_unused) &&
+               (index < TFM_CRYPTO_MAX_KEY_HANDLES)) {
+        handle_unused++;
+    } else {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (handle_owner[index].generation == 0) {
+        handle_owner[index].generation = 1;
+    }
     handle_owner[index].owner = partition_id;
-    handle_owner[index].handle = key_handle;
+    handle_owner[index].handle = *key_handle;
     handle_owner[index].in_use = TFM_CRYPTO_IN_USE;
 
+    *key_handle = (psa_key_handle_t)
+                  (((uint32_t)handle_owner[index].generation <<
+                    TFM_CRYPTO_KEY_INDEX_BITS) | index);
+
     return PSA_SUCCESS;
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
 }
@@ -205,17 +275,10 @@ psa_status_t tfm_crypto_import_key(psa_invec in_vec[],
     psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
     uint32_t i = 0;
     int32_t partition_id = 0;
-    bool empty_found = false;
-
-    for (i = 0; i < TFM_CRYPTO_MAX_KEY_HANDLES; i++) {
-        if (handle_owner[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            empty_found = true;
-            break;
-        }
-    }
 
-    if (!empty_found) {
-        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    status = tfm_crypto_check_key_storage(&i);
+    if (status != PSA_SUCCESS) {
+        return status;
     }
 
     status = tfm_crypto_get_caller_id(&partition_id);
@@ -233,9 +296,11 @@ psa_status_t tfm_crypto_import_key(psa_invec in_vec[],
     status = psa_import_key(&key_attributes, data, data_length, key_handle);
 
     if (status == PSA_SUCCESS) {
-        handle_owner[i].owner = partition_id;
-        handle_owner[i].handle = *key_handle;
-        handle_owner[i].in_use = TFM_CRYPTO_IN_USE;
+        status = tfm_crypto_set_key_storage(i, key_handle);
+        if (status != PSA_SUCCESS) {
+            /* The client cannot reach the new key, so do not leak it */
+            (void)psa_destroy_key(*key_handle);
+        }
     }
 
     return status;
@@ -266,14 +331,9 @@ psa_status_t tfm_crypto_open_key(psa_invec in_vec[],
     int32_t partition_id;
     uint32_t i;
 
-    for (i = 0; i < TFM_CRYPTO_MAX_KEY_HANDLES; i++) {
-        if (handle_owner[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            break;
-        }
-    }
-
-    if (i == TFM_CRYPTO_MAX_KEY_HANDLES) {
-        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    status = tfm_crypto_check_key_storage(&i);
+    if (status != PSA_SUCCESS) {
+        return status;
     }
 
     status = tfm_crypto_get_caller_id(&partition_id);
@@ -287,9 +347,11 @@ psa_status_t tfm_crypto_open_key(psa_invec in_vec[],
     status = psa_open_key(id, key_handle);
 
     if (status == PSA_SUCCESS) {
-        handle_owner[i].owner = partition_id;
-        handle_owner[i].handle = *key_handle;
-        handle_owner[i].in_use = TFM_CRYPTO_IN_USE;
+        status = tfm_crypto_set_key_storage(i, key_handle);
+        if (status != PSA_SUCCESS) {
+            /* The client cannot reach the key, so do not keep it open */
+            (void)psa_close_key(*key_handle);
+        }
     }
 
     return status;
@@ -315,7 +377,7 @@ psa_status_t tfm_crypto_close_key(psa_invec in_vec[],
 
     psa_key_handle_t key = iov->key_handle;
     uint32_t index;
-    psa_status_t status = tfm_crypto_check_handle_owner(key, &index);
+    psa_status_t status = tfm_crypto_check_handle_owner(&key, &index);
 
     if (status != PSA_SUCCESS) {
         return status;
@@ -324,9 +386,7 @@ psa_status_t tfm_crypto_close_key(psa_invec in_vec[],
     status = psa_close_key(key);
 
     if (status == PSA_SUCCESS) {
-        handle_owner[index].owner = 0;
-        handle_owner[index].handle = 0;
-        handle_owner[index].in_use = TFM_CRYPTO_NOT_IN_USE;
+        release_key_storage(index);
     }
 
     return status;
@@ -352,7 +412,7 @@ psa_status_t tfm_crypto_destroy_key(psa_invec in_vec[],
 
     psa_key_handle_t key = iov->key_handle;
     uint32_t index;
-    psa_status_t status = tfm_crypto_check_handle_owner(key, &index);
+    psa_status_t status = tfm_crypto_check_handle_owner(&key, &index);
 
     if (status != PSA_SUCCESS) {
         return status;
@@ -361,9 +421,7 @@ psa_status_t tfm_crypto_destroy_key(psa_invec in_vec[],
     status = psa_destroy_key(key);
 
     if (status == PSA_SUCCESS) {
-        handle_owner[index].owner = 0;
-        handle_owner[index].handle = 0;
-        handle_owner[index].in_use = TFM_CRYPTO_NOT_IN_USE;
+        release_key_storage(index);
     }
 
     return status;
@@ -392,7 +450,7 @@ psa_status_t tfm_crypto_get_key_attributes(psa_invec in_vec[],
     psa_status_t status;
     psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
 
-    status = tfm_crypto_check_handle_owner(key, NULL);
+    status = tfm_crypto_check_handle_owner(&key, NULL);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -467,6 +525,11 @@ psa_status_t tfm_crypto_export_key(psa_invec in_vec[],
     psa_key_handle_t key = iov->key_handle;
     uint8_t *data = out_vec[0].base;
     size_t data_size = out_vec[0].len;
+    psa_status_t status = tfm_crypto_check_handle_owner(&key, NULL);
+
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
 
     return psa_export_key(key, data, data_size, &(out_vec[0].len));
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
@@ -491,6 +554,11 @@ psa_status_t tfm_crypto_export_public_key(psa_invec in_vec[],
     psa_key_handle_t key = iov->key_handle;
     uint8_t *data = out_vec[0].base;
     size_t data_size = out_vec[0].len;
+    psa_status_t status = tfm_crypto_check_handle_owner(&key, NULL);
+
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
 
     return psa_export_public_key(key, data, data_size, &(out_vec[0].len));
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
@@ -521,17 +589,10 @@ psa_status_t tfm_crypto_copy_key(psa_invec in_vec[],
     psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
     uint32_t i = 0;
     int32_t partition_id = 0;
-    bool empty_found = false;
 
-    for (i = 0; i < TFM_CRYPTO_MAX_KEY_HANDLES; i++) {
-        if (handle_owner[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            empty_found = true;
-            break;
-        }
-    }
-
-    if (!empty_found) {
-        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    status = tfm_crypto_check_key_storage(&i);
+    if (status != PSA_SUCCESS) {
+        return status;
     }
 
     status = tfm_crypto_get_caller_id(&partition_id);
@@ -546,12 +607,19 @@ psa_status_t tfm_crypto_copy_key(psa_invec in_vec[],
         return status;
     }
 
+    status = tfm_crypto_check_handle_owner(&source_handle, NULL);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
     status = psa_copy_key(source_handle, &key_attributes, target_handle);
 
     if (status == PSA_SUCCESS) {
-        handle_owner[i].owner = partition_id;
-        handle_owner[i].handle = *target_handle;
-        handle_owner[i].in_use = TFM_CRYPTO_IN_USE;
+        status = tfm_crypto_set_key_storage(i, target_handle);
+        if (status != PSA_SUCCESS) {
+            /* The client cannot reach the new key, so do not leak it */
+            (void)psa_destroy_key(*target_handle);
+        }
     }
 
     return status;
@@ -580,17 +648,10 @@ psa_status_t tfm_crypto_generate_key(psa_invec in_vec[],
     psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
     uint32_t i = 0;
     int32_t partition_id = 0;
-    bool empty_found = false;
-
-    for (i = 0; i < TFM_CRYPTO_MAX_KEY_HANDLES; i++) {
-        if (handle_owner[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            empty_found = true;
-            break;
-        }
-    }
 
-    if (!empty_found) {
-        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    status = tfm_crypto_check_key_storage(&i);
+    if (status != PSA_SUCCESS) {
+        return status;
     }
 
     status = tfm_crypto_get_caller_id(&partition_id);
@@ -608,9 +669,11 @@ psa_status_t tfm_crypto_generate_key(psa_invec in_vec[],
     status = psa_generate_key(&key_attributes, key_handle);
 
     if (status == PSA_SUCCESS) {
-        handle_owner[i].owner = partition_id;
-        handle_owner[i].handle = *key_handle;
-        handle_owner[i].in_use = TFM_CRYPTO_IN_USE;
+        status = tfm_crypto_set_key_storage(i, key_handle);
+        if (status != PSA_SUCCESS) {
+            /* The client cannot reach the new key, so do not leak it */
+            (void)psa_destroy_key(*key_handle);
+        }
     }
 
     return status;
@@ -339,7 +339,7 @@ psa_status_t tfm_crypto_key_derivation_input_key(psa_invec in_vec[],
     psa_key_derivation_step_t step = iov->step;
     psa_key_derivation_operation_t *operation = NULL;
 
-    status = tfm_crypto_check_handle_owner(key_handle, NULL);
+    status = tfm_crypto_check_handle_owner(&key_handle, NULL);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -416,7 +416,11 @@ psa_status_t tfm_crypto_key_derivation_output_key(psa_invec in_vec[],
                                                key_handle);
     }
     if (status == PSA_SUCCESS) {
-        status = tfm_crypto_set_key_storage(index, *key_handle);
+        status = tfm_crypto_set_key_storage(index, key_handle);
+        if (status != PSA_SUCCESS) {
+            /* The client cannot reach the new key, so do not leak it */
+            (void)psa_destroy_key(*key_handle);
+        }
     }
 
     return status;
@@ -500,7 +504,7 @@ psa_status_t tfm_crypto_key_derivation_key_agreement(psa_invec in_vec[],
     psa_key_derivation_operation_t *operation = NULL;
     psa_key_derivation_step_t step = iov->step;
 
-    status = tfm_crypto_check_handle_owner(private_key, NULL);
+    status = tfm_crypto_check_handle_owner(&private_key, NULL);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -562,6 +566,11 @@ psa_status_t tfm_crypto_raw_key_agreement(psa_invec in_vec[],
     psa_key_handle_t private_key = iov->key_handle;
     const uint8_t *peer_key = in_vec[1].base;
     size_t peer_key_length = in_vec[1].len;
+    psa_status_t status = tfm_crypto_check_handle_owner(&private_key, NULL);
+
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
 
     return psa_raw_key_agreement(alg, private_key, peer_key, peer_key_length,
                                  output, output_size, &out_vec[0].len);
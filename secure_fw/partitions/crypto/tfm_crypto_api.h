@@ -46,6 +46,16 @@ enum tfm_crypto_operation_type {
     TFM_CRYPTO_OPERATION_TYPE_MAX = INT_MAX
 };
 
+/**
+ * \brief Usage statistics of the operation contexts of a type
+ */
+struct tfm_crypto_operation_stats {
+    uint32_t num;            /*!< Number of contexts */
+    uint32_t in_use;         /*!< Contexts currently allocated */
+    uint32_t max_in_use;     /*!< High-water mark of in_use */
+    uint32_t alloc_failures; /*!< Allocations which have failed */
+};
+
 /**
  * \brief Initialise the service
  *
@@ -97,17 +107,20 @@ psa_status_t tfm_crypto_key_attributes_to_client(
 
 /**
  * \brief Checks that the requested handle belongs to the requesting
- *        partition
+ *        partition, and translates it to the handle of the key in the
+ *        backend
  *
- * \param[in]  handle Handle given as input
- * \param[out] index  Optionally, pointer to hold the internal index
- *                    corresponding to the input handle. Valid only
- *                    on PSA_SUCCESS, it's returned only if the input
- *                    parameter is not NULL.
+ * \param[in,out] handle Handle given as input by the client. On
+ *                       PSA_SUCCESS, it is replaced by the corresponding
+ *                       handle of the key in the backend.
+ * \param[out]    index  Optionally, pointer to hold the internal index
+ *                       corresponding to the input handle. Valid only
+ *                       on PSA_SUCCESS, it's returned only if the input
+ *                       parameter is not NULL.
  *
  * \return Return values as described in \ref psa_status_t
  */
-psa_status_t tfm_crypto_check_handle_owner(psa_key_handle_t handle,
+psa_status_t tfm_crypto_check_handle_owner(psa_key_handle_t *handle,
                                            uint32_t *index);
 
 /**
@@ -124,13 +137,19 @@ psa_status_t tfm_crypto_check_key_storage(uint32_t *index);
  * \brief Sets the index of the local storage in use with a key requested by the
  *        calling partition, and stores the corresponding key_handle.
  *
- * \param[in] index       Index of the local storage to use
- * \param[in] key_handle  Corresponding key handle to associate
+ * \param[in]     index       Index returned by
+ *                            \ref tfm_crypto_check_key_storage
+ * \param[in,out] key_handle  Handle of the key in the backend to associate.
+ *                            On PSA_SUCCESS, it is replaced by the handle to
+ *                            return to the client.
+ *
+ * \note On failure, the client has no handle to the key, so the caller must
+ *       destroy or close it in the backend.
  *
  * \return Return values as described in \ref psa_status_t
  */
 psa_status_t tfm_crypto_set_key_storage(uint32_t index,
-                                        psa_key_handle_t key_handle);
+                                        psa_key_handle_t *key_handle);
 /**
  * \brief Allocate an operation context in the backend
  *
@@ -164,6 +183,17 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle);
 psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx);
+/**
+ * \brief Get the usage statistics of the operation contexts of a type
+ *
+ * \param[in]  type  Type of the operation contexts
+ * \param[out] stats Statistics of the operation contexts
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_operation_get_stats(
+                                    enum tfm_crypto_operation_type type,
+                                    struct tfm_crypto_operation_stats *stats);
 
 #define LIST_TFM_CRYPTO_UNIFORM_SIGNATURE_API \
     X(tfm_crypto_get_key_attributes)          \
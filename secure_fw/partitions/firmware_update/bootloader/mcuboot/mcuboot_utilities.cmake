@@ -37,4 +37,6 @@ target_link_libraries(tfm_partition_fwu
 target_compile_definitions(tfm_partition_fwu
     PRIVATE
         MCUBOOT_${MCUBOOT_UPGRADE_STRATEGY}
+        $<$<BOOL:${TFM_FWU_DELTA_UPDATE}>:TFM_FWU_DELTA_UPDATE>
+        $<$<BOOL:${TFM_FWU_COMPRESSED_UPDATE}>:TFM_FWU_COMPRESSED_UPDATE>
 )
@@ -17,9 +17,35 @@
 #include "service_api.h"
 #include "tfm_memory_utils.h"
 
-#define MAX_IMAGE_INFO_LENGTH    (sizeof(struct image_version) + \
-                                  SHARED_DATA_ENTRY_HEADER_SIZE)
+#define MAX_IMAGE_INFO_LENGTH    (MCUBOOT_IMAGE_NUMBER * \
+                                  (sizeof(struct image_version) + \
+                                   SHARED_DATA_ENTRY_HEADER_SIZE))
 #define TFM_MCUBOOT_FWU_INVALD_IMAGE_ID    0xFF
+
+/*
+ * Image data is gathered into blocks of TFM_FWU_STAGING_BUF_SIZE bytes, whole
+ * flash sectors by default, before being programmed.
+ */
+#ifdef TFM_FWU_STAGING_BUF_SIZE
+#define FWU_STAGING_BUF_SIZE               TFM_FWU_STAGING_BUF_SIZE
+#else
+#define FWU_STAGING_BUF_SIZE               FLASH_AREA_IMAGE_SECTOR_SIZE
+#endif
+
+#if (FLASH_AREA_IMAGE_SECTOR_SIZE % FWU_STAGING_BUF_SIZE) != 0
+#error "TFM_FWU_STAGING_BUF_SIZE must divide FLASH_AREA_IMAGE_SECTOR_SIZE"
+#endif
+
+#ifndef MCUBOOT_MAX_IMG_SECTORS
+#error "MCUBOOT_MAX_IMG_SECTORS must be defined by the target"
+#endif
+
+/* Maximum size of the data passed to the crypto service in one hash update. */
+#define FWU_HASH_CHUNK_SIZE                1024
+
+/* Number of words in a bitmap with one bit per sector of the staging area. */
+#define FWU_SECTOR_MAP_WORDS               ((MCUBOOT_MAX_IMG_SECTORS + 31) / 32)
+
 /*
  * \struct fwu_image_info_data
  *
@@ -33,160 +59,1508 @@ typedef struct fwu_image_info_data_s {
     uint8_t data[MAX_IMAGE_INFO_LENGTH];
 } fwu_image_info_data_t;
 
-static fwu_image_info_data_t boot_shared_data;
+static fwu_image_info_data_t boot_shared_data;
+
+#ifdef TFM_FWU_DELTA_UPDATE
+/* Magic number at the start of a delta image: "FDLT" in little endian. */
+#define FWU_DELTA_MAGIC                    0x544c4446
+#define FWU_DELTA_HEADER_SIZE              16
+#define FWU_DELTA_RECORD_SIZE              12
+
+/* Size of the buffer used to copy data from the primary slot. */
+#define FWU_DELTA_COPY_BUF_SIZE            256
+
+typedef enum {
+    FWU_DELTA_STATE_HEADER = 0,
+    FWU_DELTA_STATE_RECORD,
+    FWU_DELTA_STATE_INSERT,
+    FWU_DELTA_STATE_DONE
+} fwu_delta_state_t;
+
+/*
+ * \struct fwu_delta_ctx_t
+ *
+ * \brief Decoding state of a delta image.
+ *
+ * \details A delta image starts with a header:
+ *          magic, target size, source size and a reserved word,
+ *          followed by records of:
+ *          seek, copy length and insert length,
+ *          each record being followed by insert length bytes of new data.
+ *          All the fields are 32-bit little endian words. A record moves the
+ *          source offset in the primary slot by seek, copies copy length
+ *          bytes from there and then appends the inserted bytes to the image
+ *          reconstructed in the staging area.
+ */
+typedef struct fwu_delta_ctx_s {
+    bool enabled;                      /* The active image is a delta */
+    fwu_delta_state_t state;
+    const struct flash_area *source;   /* Primary slot of the active image */
+    uint32_t patch_offset;             /* Expected offset of the next block */
+    uint32_t source_size;
+    uint32_t source_offset;
+    uint32_t target_size;
+    uint32_t target_offset;
+    uint32_t insert_len;               /* Bytes left to insert */
+    uint32_t field_len;                /* Valid bytes in fields */
+    uint8_t fields[FWU_DELTA_HEADER_SIZE];
+} fwu_delta_ctx_t;
+
+#endif /* TFM_FWU_DELTA_UPDATE */
+
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+/* Magic number at the start of a compressed image: "FLZ4" in little endian. */
+#define FWU_LZ4_MAGIC                      0x345a4c46
+#define FWU_LZ4_HEADER_SIZE                12
+#define FWU_LZ4_OFFSET_SIZE                2
+#define FWU_LZ4_MIN_MATCH                  4
+#define FWU_LZ4_LEN_MASK                   0xF
+
+/* Size of the buffer used to copy the matches from the staging area. */
+#define FWU_LZ4_COPY_BUF_SIZE              256
+
+typedef enum {
+    FWU_LZ4_STATE_HEADER = 0,
+    FWU_LZ4_STATE_TOKEN,
+    FWU_LZ4_STATE_LITERAL_LEN,
+    FWU_LZ4_STATE_LITERALS,
+    FWU_LZ4_STATE_OFFSET,
+    FWU_LZ4_STATE_MATCH_LEN,
+    FWU_LZ4_STATE_MATCH,
+    FWU_LZ4_STATE_DONE
+} fwu_lz4_state_t;
+
+/*
+ * \struct fwu_lz4_ctx_t
+ *
+ * \brief Decoding state of a compressed image.
+ *
+ * \details A compressed image starts with a header:
+ *          magic, image size and a reserved word,
+ *          all 32-bit little endian words, followed by the image compressed
+ *          as a single LZ4 block (LZ4 sequences without the block size). The
+ *          matches are copied from the image data already written, so no
+ *          window is kept in RAM.
+ */
+typedef struct fwu_lz4_ctx_s {
+    bool enabled;                      /* The active image is compressed */
+    fwu_lz4_state_t state;
+    uint32_t input_offset;             /* Expected offset of the next block */
+    uint32_t image_size;
+    uint32_t out_offset;               /* Size of the decompressed data */
+    uint32_t literal_len;              /* Literal bytes left to write */
+    uint32_t match_len;
+    uint32_t match_offset;
+    uint32_t field_len;                /* Valid bytes in fields */
+    uint8_t fields[FWU_LZ4_HEADER_SIZE];
+} fwu_lz4_ctx_t;
+
+#endif /* TFM_FWU_COMPRESSED_UPDATE */
+
+/*
+ * \struct fwu_staging_ctx_t
+ *
+ * \brief The download of an image into its staging area: the image data which
+ *        is received but not yet programmed, the download statistics and the
+ *        state of the staging area sectors.
+ *
+ * \details The running hash covers the data programmed contiguously from the
+ *          start of the staging area, which is what a download can be resumed
+ *          from after a reset.
+ *
+ *          The staging area is erased sector by sector just before a sector is
+ *          first programmed. The sector bitmaps track the sectors which have
+ *          been erased, and which of those have been programmed since the
+ *          current download started. Sectors which are erased but not
+ *          programmed are still blank when a download is restarted, so they
+ *          are not erased again.
+ */
+typedef struct fwu_staging_ctx_s {
+    const struct flash_area *fap; /* Staging area, NULL if no download */
+    uint8_t image_id;           /* The image in MCUboot */
+    bool pending;               /* Marked as a candidate for the bootloader */
+    uint32_t offset;            /* Offset in the flash area of staging_buf[0] */
+    uint32_t len;               /* Bytes of the image in staging_buf */
+    uint32_t bytes_received;    /* Image bytes received since area init */
+    uint32_t written_end;       /* End of the image data written so far */
+    uint32_t hashed_len;        /* Length of the contiguous programmed data */
+    psa_hash_operation_t hash;  /* Running hash of the first hashed_len bytes */
+    uint32_t erased_sectors[FWU_SECTOR_MAP_WORDS];
+    uint32_t written_sectors[FWU_SECTOR_MAP_WORDS];
+#ifdef TFM_FWU_DELTA_UPDATE
+    fwu_delta_ctx_t delta;
+#endif
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    fwu_lz4_ctx_t lz4;
+#endif
+} fwu_staging_ctx_t;
+
+/* The images can be downloaded concurrently, each into its staging area. */
+static fwu_staging_ctx_t staging_ctx[MCUBOOT_IMAGE_NUMBER];
+
+/* The download of the image being operated on. */
+static fwu_staging_ctx_t *staging = &staging_ctx[0];
+
+/*
+ * Image data gathered into a sector before it is programmed. The buffer is
+ * shared by the images and holds the data of at most one of them.
+ */
+static uint8_t staging_buf[FWU_STAGING_BUF_SIZE];
+
+static int convert_id_from_bl_to_mcuboot(bl_image_id_t bl_image_id,
+                                         uint8_t *mcuboot_image_id)
+{
+#if (MCUBOOT_IMAGE_NUMBER == 1)
+    /* Only full image upgrade is supported in this case. */
+    if (bl_image_id != FWU_IMAGE_TYPE_FULL) {
+        LOG_MSG("TFM FWU: multi-image is not supported in current mcuboot configuration.");
+        return -1;
+    }
+
+    /* The image id in mcuboot. 0: the full image. */
+    *mcuboot_image_id = 0;
+#else
+    if (bl_image_id == FWU_IMAGE_TYPE_SECURE) {
+        /* The image id in mcuboot. 0: the secure image. */
+        *mcuboot_image_id = 0;
+    } else if (bl_image_id == FWU_IMAGE_TYPE_NONSECURE) {
+        /* The image id in mcuboot. 1: the non-secure image. */
+        *mcuboot_image_id = 1;
+    }  else {
+        LOG_MSG("TFM FWU: invalid image_type: %d", bl_image_id);
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+static int convert_id_from_mcuboot_to_bl(uint8_t mcuboot_image_id,
+                                         bl_image_id_t *bl_image_id)
+{
+    uint8_t image_type;
+
+    if (bl_image_id == NULL) {
+        return -1;
+    }
+
+#if (MCUBOOT_IMAGE_NUMBER == 1)
+    /* Only full image upgrade is supported in this case. */
+    if (mcuboot_image_id != 0) {
+        LOG_MSG("TFM FWU: multi-image is not supported in current mcuboot \
+                configuration.\n\r");
+        return -1;
+    }
+
+    /* The image id in mcuboot. 0: the full image. */
+    image_type = FWU_IMAGE_TYPE_FULL;
+#else
+    if (mcuboot_image_id == 0) {
+        /* The image id in mcuboot. 0: the secure image. */
+        image_type = FWU_IMAGE_TYPE_SECURE;
+    } else if (mcuboot_image_id == 1) {
+        /* The image id in mcuboot. 1: the non-secure image. */
+        image_type = FWU_IMAGE_TYPE_NONSECURE;
+    }  else {
+        LOG_MSG("TFM FWU: invalid mcuboot image id\n\r: %d",
+                mcuboot_image_id);
+        return -1;
+    }
+#endif
+    *bl_image_id = image_type;
+    return 0;
+}
+
+static int fwu_bootloader_get_shared_data(void)
+{
+    return tfm_core_get_boot_data(TLV_MAJOR_FWU,
+                                  (struct tfm_boot_data *)&boot_shared_data,
+                                  sizeof(boot_shared_data));
+}
+
+static bool sector_map_test(const uint32_t *map, uint32_t sector)
+{
+    return (map[sector / 32] & (1UL << (sector % 32))) != 0;
+}
+
+static void sector_map_set(uint32_t *map, uint32_t sector)
+{
+    map[sector / 32] |= (1UL << (sector % 32));
+}
+
+/* Reset the sector maps at the start of a download. */
+static void sector_map_reset(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < FWU_SECTOR_MAP_WORDS; i++) {
+        staging->erased_sectors[i] &= ~staging->written_sectors[i];
+    }
+
+    tfm_memset(staging->written_sectors, 0, sizeof(staging->written_sectors));
+}
+
+/*
+ * Erase the sectors of the staging area covering the given range which have
+ * not been erased yet.
+ */
+static int fwu_staging_erase_sectors(uint32_t offset, uint32_t len)
+{
+    uint32_t sector;
+    uint32_t last_sector;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    sector = offset / FLASH_AREA_IMAGE_SECTOR_SIZE;
+    last_sector = (offset + len - 1) / FLASH_AREA_IMAGE_SECTOR_SIZE;
+
+    for (; sector <= last_sector; sector++) {
+        if (!sector_map_test(staging->erased_sectors, sector)) {
+            if (flash_area_erase(staging->fap,
+                                 sector * FLASH_AREA_IMAGE_SECTOR_SIZE,
+                                 FLASH_AREA_IMAGE_SECTOR_SIZE) != 0) {
+                LOG_MSG("TFM FWU: erasing flash failed.\r\n");
+                return BOOT_EFLASH;
+            }
+            sector_map_set(staging->erased_sectors, sector);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Erase the sectors of the staging area covering the given range which have
+ * not been erased yet, and mark them as programmed.
+ */
+static int fwu_staging_prepare_sectors(uint32_t offset, uint32_t len)
+{
+    uint32_t sector;
+    uint32_t last_sector;
+    int ret;
+
+    ret = fwu_staging_erase_sectors(offset, len);
+    if ((ret != 0) || (len == 0)) {
+        return ret;
+    }
+
+    sector = offset / FLASH_AREA_IMAGE_SECTOR_SIZE;
+    last_sector = (offset + len - 1) / FLASH_AREA_IMAGE_SECTOR_SIZE;
+
+    for (; sector <= last_sector; sector++) {
+        sector_map_set(staging->written_sectors, sector);
+    }
+
+    return 0;
+}
+
+static int fwu_staging_hash_update(const uint8_t *data, uint32_t len)
+{
+    uint32_t chunk;
+
+    while (len > 0) {
+        chunk = (len < FWU_HASH_CHUNK_SIZE) ? len : FWU_HASH_CHUNK_SIZE;
+        if (psa_hash_update(&staging->hash, data, chunk) != PSA_SUCCESS) {
+            return -1;
+        }
+        staging->hashed_len += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/* Get the digest of the first hashed_len bytes of the staging area. */
+static int fwu_staging_digest(uint8_t *digest)
+{
+    psa_hash_operation_t digest_op = psa_hash_operation_init();
+    size_t hash_size;
+
+    if (psa_hash_clone(&staging->hash, &digest_op) != PSA_SUCCESS) {
+        return -1;
+    }
+
+    if ((psa_hash_finish(&digest_op, digest, TFM_FWU_MAX_DIGEST_SIZE,
+                         &hash_size) != PSA_SUCCESS) ||
+        (hash_size != TFM_FWU_MAX_DIGEST_SIZE)) {
+        (void)psa_hash_abort(&digest_op);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int fwu_staging_program(uint32_t offset, const void *data,
+                               uint32_t len)
+{
+    int ret;
+
+    ret = fwu_staging_prepare_sectors(offset, len);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (flash_area_write(staging->fap, offset, data, len) != 0) {
+        LOG_MSG("TFM FWU: write flash failed.\r\n");
+        return BOOT_EFLASH;
+    }
+
+    if (offset == staging->hashed_len) {
+        return fwu_staging_hash_update(data, len);
+    }
+
+    return 0;
+}
+
+/* Program the gathered data of the image into the staging area. */
+static int fwu_staging_flush(void)
+{
+    int ret;
+
+    if (staging->len == 0) {
+        return 0;
+    }
+
+    ret = fwu_staging_program(staging->offset, staging_buf, staging->len);
+    staging->len = 0;
+
+    return ret;
+}
+
+/* Select the download of the given image. */
+static void fwu_staging_select(uint8_t mcuboot_image_id)
+{
+    staging = &staging_ctx[mcuboot_image_id];
+    staging->image_id = mcuboot_image_id;
+}
+
+/*
+ * Take the staging buffer for the selected image, programming the data of
+ * another image left in it.
+ */
+static int fwu_staging_buf_claim(void)
+{
+    fwu_staging_ctx_t *owner = staging;
+    uint8_t i;
+    int ret = 0;
+
+    for (i = 0; i < MCUBOOT_IMAGE_NUMBER; i++) {
+        if ((&staging_ctx[i] != owner) && (staging_ctx[i].len != 0)) {
+            staging = &staging_ctx[i];
+            ret = fwu_staging_flush();
+            break;
+        }
+    }
+
+    staging = owner;
+    return ret;
+}
+
+/*
+ * Write image data of the image at the given offset of the staging area. The
+ * data is gathered into whole sectors before it is programmed.
+ */
+static int fwu_staging_write(uint32_t offset, const uint8_t *data,
+                             uint32_t len)
+{
+    uint32_t chunk;
+    int ret;
+
+    while (len > 0) {
+        /* A non-sequential write ends the current gathering. */
+        if ((staging->len != 0) && (offset != staging->offset + staging->len)) {
+            ret = fwu_staging_flush();
+            if (ret != 0) {
+                return ret;
+            }
+        }
+
+        if (staging->len == 0) {
+            /* Whole sectors are programmed directly from the caller's
+             * buffer, without going through the staging buffer.
+             */
+            if (((offset % FWU_STAGING_BUF_SIZE) == 0) &&
+                (len >= FWU_STAGING_BUF_SIZE)) {
+                chunk = len - (len % FWU_STAGING_BUF_SIZE);
+                ret = fwu_staging_program(offset, data, chunk);
+                if (ret != 0) {
+                    return ret;
+                }
+                offset += chunk;
+                data += chunk;
+                len -= chunk;
+                continue;
+            }
+
+            ret = fwu_staging_buf_claim();
+            if (ret != 0) {
+                return ret;
+            }
+            staging->offset = offset;
+        }
+
+        /* Gather the data up to the end of the current sector. */
+        chunk = FWU_STAGING_BUF_SIZE -
+                ((staging->offset + staging->len) % FWU_STAGING_BUF_SIZE);
+        if (chunk > len) {
+            chunk = len;
+        }
+        tfm_memcpy(staging_buf + staging->len, data, chunk);
+        staging->len += chunk;
+        offset += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (((staging->offset + staging->len) % FWU_STAGING_BUF_SIZE) == 0) {
+            ret = fwu_staging_flush();
+            if (ret != 0) {
+                return ret;
+            }
+        }
+    }
+
+    if (offset > staging->written_end) {
+        staging->written_end = offset;
+    }
+
+    return 0;
+}
+
+#if defined(TFM_FWU_DELTA_UPDATE) || defined(TFM_FWU_COMPRESSED_UPDATE)
+static uint32_t get_le32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/*
+ * Gather the fixed size fields of a header or record of an encoded image from
+ * the input. Returns true when all the fields are available.
+ */
+static bool fwu_stream_gather(uint8_t *fields, uint32_t *field_len,
+                              const uint8_t **data, uint32_t *len,
+                              uint32_t size)
+{
+    uint32_t chunk = size - *field_len;
+
+    if (chunk > *len) {
+        chunk = *len;
+    }
+
+    tfm_memcpy(fields + *field_len, *data, chunk);
+    *field_len += chunk;
+    *data += chunk;
+    *len -= chunk;
+
+    if (*field_len < size) {
+        return false;
+    }
+
+    *field_len = 0;
+    return true;
+}
+#endif
+
+#ifdef TFM_FWU_DELTA_UPDATE
+static void fwu_delta_reset(void)
+{
+    if (staging->delta.source != NULL) {
+        flash_area_close(staging->delta.source);
+    }
+
+    tfm_memset(&staging->delta, 0, sizeof(staging->delta));
+}
+
+/* Start decoding a delta image of the active image. */
+static int fwu_delta_start(void)
+{
+    fwu_delta_reset();
+
+    if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(staging->image_id),
+                        &staging->delta.source) != 0) {
+        LOG_MSG("TFM FWU: opening flash failed.\r\n");
+        staging->delta.source = NULL;
+        return BOOT_EFLASH;
+    }
+
+    staging->delta.enabled = true;
+    staging->delta.state = FWU_DELTA_STATE_HEADER;
+
+    return 0;
+}
+
+static int fwu_delta_parse_header(void)
+{
+    if ((get_le32(staging->delta.fields) != FWU_DELTA_MAGIC) ||
+        (get_le32(staging->delta.fields + 12) != 0)) {
+        return -1;
+    }
+
+    staging->delta.target_size = get_le32(staging->delta.fields + 4);
+    staging->delta.source_size = get_le32(staging->delta.fields + 8);
+
+    if ((staging->delta.target_size == 0) ||
+        (staging->delta.target_size > staging->fap->fa_size) ||
+        (staging->delta.source_size > staging->delta.source->fa_size)) {
+        LOG_MSG("TFM FWU: invalid delta image header.\r\n");
+        return -1;
+    }
+
+    staging->delta.state = FWU_DELTA_STATE_RECORD;
+    return 0;
+}
+
+/* Copy data of the running image into the staging area. */
+static int fwu_delta_copy(uint32_t len)
+{
+    uint8_t buf[FWU_DELTA_COPY_BUF_SIZE];
+    uint32_t chunk;
+    int ret;
+
+    while (len > 0) {
+        chunk = (len < sizeof(buf)) ? len : sizeof(buf);
+        if (flash_area_read(staging->delta.source,
+                            staging->delta.source_offset, buf, chunk) != 0) {
+            LOG_MSG("TFM FWU: reading flash failed.\r\n");
+            return BOOT_EFLASH;
+        }
+
+        ret = fwu_staging_write(staging->delta.target_offset, buf, chunk);
+        if (ret != 0) {
+            return ret;
+        }
+
+        staging->delta.source_offset += chunk;
+        staging->delta.target_offset += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+static int fwu_delta_apply_record(void)
+{
+    int32_t seek = (int32_t)get_le32(staging->delta.fields);
+    uint32_t copy_len = get_le32(staging->delta.fields + 4);
+    uint32_t target_left = staging->delta.target_size -
+                           staging->delta.target_offset;
+    int64_t source_offset = (int64_t)staging->delta.source_offset + seek;
+
+    staging->delta.insert_len = get_le32(staging->delta.fields + 8);
+
+    if ((source_offset < 0) || (source_offset > staging->delta.source_size) ||
+        (copy_len > staging->delta.source_size - (uint32_t)source_offset) ||
+        (copy_len > target_left) ||
+        (staging->delta.insert_len > target_left - copy_len)) {
+        LOG_MSG("TFM FWU: invalid delta image record.\r\n");
+        return -1;
+    }
+
+    staging->delta.source_offset = (uint32_t)source_offset;
+    staging->delta.state = FWU_DELTA_STATE_INSERT;
+
+    return fwu_delta_copy(copy_len);
+}
+
+/* Decode a block of a delta image into the staging area. */
+static int fwu_delta_apply(const uint8_t *data, uint32_t len)
+{
+    uint32_t chunk;
+    int ret;
+
+    while (len > 0) {
+        switch (staging->delta.state) {
+        case FWU_DELTA_STATE_HEADER:
+            if (fwu_stream_gather(staging->delta.fields,
+                                  &staging->delta.field_len, &data, &len,
+                                  FWU_DELTA_HEADER_SIZE)) {
+                ret = fwu_delta_parse_header();
+                if (ret != 0) {
+                    return ret;
+                }
+            }
+            break;
+        case FWU_DELTA_STATE_RECORD:
+            if (fwu_stream_gather(staging->delta.fields,
+                                  &staging->delta.field_len, &data, &len,
+                                  FWU_DELTA_RECORD_SIZE)) {
+                ret = fwu_delta_apply_record();
+                if (ret != 0) {
+                    return ret;
+                }
+            }
+            break;
+        case FWU_DELTA_STATE_INSERT:
+            chunk = (len < staging->delta.insert_len) ?
+                    len : staging->delta.insert_len;
+            ret = fwu_staging_write(staging->delta.target_offset, data, chunk);
+            if (ret != 0) {
+                return ret;
+            }
+            staging->delta.target_offset += chunk;
+            staging->delta.insert_len -= chunk;
+            data += chunk;
+            len -= chunk;
+            break;
+        default:
+            /* No data is expected after the end of the image. */
+            return -1;
+        }
+
+        if ((staging->delta.state == FWU_DELTA_STATE_INSERT) &&
+            (staging->delta.insert_len == 0)) {
+            staging->delta.state =
+                (staging->delta.target_offset == staging->delta.target_size) ?
+                FWU_DELTA_STATE_DONE : FWU_DELTA_STATE_RECORD;
+        }
+    }
+
+    return 0;
+}
+#endif /* TFM_FWU_DELTA_UPDATE */
+
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+/*
+ * Read back image data of the active image, either from the staging buffer or
+ * from the staging area.
+ */
+static int fwu_staging_read(uint32_t offset, uint8_t *data, uint32_t len)
+{
+    uint32_t chunk;
+
+    if (offset < staging->offset) {
+        chunk = staging->offset - offset;
+        if ((staging->len == 0) || (chunk > len)) {
+            chunk = len;
+        }
+        if (flash_area_read(staging->fap, offset, data, chunk) != 0) {
+            LOG_MSG("TFM FWU: reading flash failed.\r\n");
+            return BOOT_EFLASH;
+        }
+        offset += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+
+    if (len > 0) {
+        if ((staging->len == 0) ||
+            (offset - staging->offset + len > staging->len)) {
+            if (flash_area_read(staging->fap, offset, data, len) != 0) {
+                LOG_MSG("TFM FWU: reading flash failed.\r\n");
+                return BOOT_EFLASH;
+            }
+        } else {
+            tfm_memcpy(data, staging_buf + (offset - staging->offset), len);
+        }
+    }
+
+    return 0;
+}
+
+static void fwu_lz4_reset(void)
+{
+    tfm_memset(&staging->lz4, 0, sizeof(staging->lz4));
+}
+
+static int fwu_lz4_parse_header(void)
+{
+    if ((get_le32(staging->lz4.fields) != FWU_LZ4_MAGIC) ||
+        (get_le32(staging->lz4.fields + 8) != 0)) {
+        return -1;
+    }
+
+    staging->lz4.image_size = get_le32(staging->lz4.fields + 4);
+    if ((staging->lz4.image_size == 0) ||
+        (staging->lz4.image_size > staging->fap->fa_size)) {
+        LOG_MSG("TFM FWU: invalid compressed image header.\r\n");
+        return -1;
+    }
+
+    staging->lz4.state = FWU_LZ4_STATE_TOKEN;
+    return 0;
+}
+
+/*
+ * Add the extension bytes of a literal or match length. Returns true when the
+ * last byte of the length is reached.
+ */
+static bool fwu_lz4_add_len(uint32_t *value, uint8_t byte)
+{
+    /* Saturate instead of overflowing, the length is checked when used. */
+    if (*value <= UINT32_MAX - byte) {
+        *value += byte;
+    } else {
+        *value = UINT32_MAX;
+    }
+
+    return byte != 0xFF;
+}
+
+/* Copy a match from the decompressed data into the staging area. */
+static int fwu_lz4_copy_match(void)
+{
+    uint8_t buf[FWU_LZ4_COPY_BUF_SIZE];
+    uint32_t match_offset = staging->lz4.match_offset;
+    uint32_t chunk;
+    int ret;
+
+    staging->lz4.match_len += FWU_LZ4_MIN_MATCH;
+
+    if ((match_offset == 0) || (match_offset > staging->lz4.out_offset) ||
+        (staging->lz4.match_len >
+         staging->lz4.image_size - staging->lz4.out_offset)) {
+        LOG_MSG("TFM FWU: invalid compressed image data.\r\n");
+        return -1;
+    }
+
+    /* The match may overlap the data it produces, so it is copied by chunks
+     * of at most match_offset bytes.
+     */
+    while (staging->lz4.match_len > 0) {
+        chunk = (staging->lz4.match_len < sizeof(buf)) ?
+                staging->lz4.match_len : sizeof(buf);
+        if (chunk > match_offset) {
+            chunk = match_offset;
+        }
+
+        ret = fwu_staging_read(staging->lz4.out_offset - match_offset,
+                               buf, chunk);
+        if (ret != 0) {
+            return ret;
+        }
+        ret = fwu_staging_write(staging->lz4.out_offset, buf, chunk);
+        if (ret != 0) {
+            return ret;
+        }
+
+        staging->lz4.out_offset += chunk;
+        staging->lz4.match_len -= chunk;
+    }
+
+    return 0;
+}
+
+/* Decompress a block of a compressed image into the staging area. */
+static int fwu_lz4_apply(const uint8_t *data, uint32_t len)
+{
+    uint32_t chunk;
+    uint8_t byte;
+    int ret;
+
+    while (len > 0) {
+        switch (staging->lz4.state) {
+        case FWU_LZ4_STATE_HEADER:
+            if (fwu_stream_gather(staging->lz4.fields,
+                                  &staging->lz4.field_len, &data, &len,
+                                  FWU_LZ4_HEADER_SIZE)) {
+                ret = fwu_lz4_parse_header();
+                if (ret != 0) {
+                    return ret;
+                }
+            }
+            break;
+        case FWU_LZ4_STATE_TOKEN:
+            byte = *data++;
+            len--;
+            staging->lz4.literal_len = byte >> 4;
+            staging->lz4.match_len = byte & FWU_LZ4_LEN_MASK;
+            staging->lz4.state =
+                (staging->lz4.literal_len == FWU_LZ4_LEN_MASK) ?
+                FWU_LZ4_STATE_LITERAL_LEN : FWU_LZ4_STATE_LITERALS;
+            break;
+        case FWU_LZ4_STATE_LITERAL_LEN:
+            byte = *data++;
+            len--;
+            if (fwu_lz4_add_len(&staging->lz4.literal_len, byte)) {
+                staging->lz4.state = FWU_LZ4_STATE_LITERALS;
+            }
+            break;
+        case FWU_LZ4_STATE_LITERALS:
+            if (staging->lz4.literal_len >
+                staging->lz4.image_size - staging->lz4.out_offset) {
+                LOG_MSG("TFM FWU: invalid compressed image data.\r\n");
+                return -1;
+            }
+            chunk = (len < staging->lz4.literal_len) ?
+                    len : staging->lz4.literal_len;
+            ret = fwu_staging_write(staging->lz4.out_offset, data, chunk);
+            if (ret != 0) {
+                return ret;
+            }
+            staging->lz4.out_offset += chunk;
+            staging->lz4.literal_len -= chunk;
+            data += chunk;
+            len -= chunk;
+            break;
+        case FWU_LZ4_STATE_OFFSET:
+            if (fwu_stream_gather(staging->lz4.fields,
+                                  &staging->lz4.field_len, &data, &len,
+                                  FWU_LZ4_OFFSET_SIZE)) {
+                staging->lz4.match_offset =
+                    (uint32_t)staging->lz4.fields[0] |
+                    ((uint32_t)staging->lz4.fields[1] << 8);
+                staging->lz4.state =
+                    (staging->lz4.match_len == FWU_LZ4_LEN_MASK) ?
+                    FWU_LZ4_STATE_MATCH_LEN : FWU_LZ4_STATE_MATCH;
+            }
+            break;
+        case FWU_LZ4_STATE_MATCH_LEN:
+            byte = *data++;
+            len--;
+            if (fwu_lz4_add_len(&staging->lz4.match_len, byte)) {
+                staging->lz4.state = FWU_LZ4_STATE_MATCH;
+            }
+            break;
+        default:
+            /* No data is expected after the end of the image. */
+            return -1;
+        }
+
+        /* The last sequence of the image ends with its literals. */
+        if ((staging->lz4.state == FWU_LZ4_STATE_LITERALS) &&
+            (staging->lz4.literal_len == 0)) {
+            staging->lz4.state =
+                (staging->lz4.out_offset == staging->lz4.image_size) ?
+                FWU_LZ4_STATE_DONE : FWU_LZ4_STATE_OFFSET;
+        }
+
+        /* The match is copied once its offset and length are complete. */
+        if (staging->lz4.state == FWU_LZ4_STATE_MATCH) {
+            ret = fwu_lz4_copy_match();
+            if (ret != 0) {
+                return ret;
+            }
+            staging->lz4.state =
+                (staging->lz4.out_offset == staging->lz4.image_size) ?
+                FWU_LZ4_STATE_DONE : FWU_LZ4_STATE_TOKEN;
+        }
+    }
+
+    return 0;
+}
+#endif /* TFM_FWU_COMPRESSED_UPDATE */
+
+/* Start the download of the active image from the beginning. */
+static int fwu_staging_restart(void)
+{
+    sector_map_reset();
+
+    staging->len = 0;
+    staging->bytes_received = 0;
+    staging->written_end = 0;
+    staging->hashed_len = 0;
+    staging->pending = false;
+
+#ifdef TFM_FWU_DELTA_UPDATE
+    fwu_delta_reset();
+#endif
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    fwu_lz4_reset();
+#endif
+
+    (void)psa_hash_abort(&staging->hash);
+    staging->hash = psa_hash_operation_init();
+    if (psa_hash_setup(&staging->hash, PSA_ALG_SHA_256) != PSA_SUCCESS) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int fwu_staging_area_open(uint8_t mcuboot_image_id)
+{
+    fwu_staging_select(mcuboot_image_id);
+
+    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(mcuboot_image_id),
+                        &staging->fap) != 0) {
+        LOG_MSG("TFM FWU: opening flash failed.\r\n");
+        staging->fap = NULL;
+        return BOOT_EFLASH;
+    }
+
+    if (staging->fap->fa_size >
+        (uint32_t)MCUBOOT_MAX_IMG_SECTORS * FLASH_AREA_IMAGE_SECTOR_SIZE) {
+        LOG_MSG("TFM FWU: staging area has too many sectors.\r\n");
+        flash_area_close(staging->fap);
+        staging->fap = NULL;
+        return -1;
+    }
+
+    /* The sectors are erased on demand when the image is written. */
+    if (fwu_staging_restart() != 0) {
+        flash_area_close(staging->fap);
+        staging->fap = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int fwu_bootloader_init(void)
+{
+    return fwu_bootloader_get_shared_data();
+}
+
+int fwu_bootloader_staging_area_init(bl_image_id_t bootloader_image_id)
+{
+    uint8_t mcuboot_image_id = 0;
+
+    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
+        != 0) {
+        return -1;
+    }
+
+    return fwu_staging_area_open(mcuboot_image_id);
+}
+
+int fwu_bootloader_staging_area_resume(bl_image_id_t bootloader_image_id,
+                                       size_t staged_size,
+                                       const uint8_t *digest)
+{
+    uint8_t mcuboot_image_id = 0;
+    uint8_t hash[TFM_FWU_MAX_DIGEST_SIZE];
+    uint32_t sector;
+    uint32_t off;
+    uint32_t len;
+    int ret;
+
+    if (digest == NULL) {
+        return -1;
+    }
+
+    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
+        != 0) {
+        return -1;
+    }
+
+    ret = fwu_staging_area_open(mcuboot_image_id);
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Only whole sectors are resumed, the rest is erased on demand. */
+    if ((staged_size == 0) || (staged_size > staging->fap->fa_size) ||
+        ((staged_size % FLASH_AREA_IMAGE_SECTOR_SIZE) != 0)) {
+        ret = -1;
+        goto fail;
+    }
+
+    /* Rebuild the running hash from the staged data, reusing the staging
+     * buffer as the bounce buffer.
+     */
+    ret = fwu_staging_buf_claim();
+    if (ret != 0) {
+        goto fail;
+    }
+
+    for (off = 0; off < staged_size; off += len) {
+        len = staged_size - off;
+        if (len > sizeof(staging_buf)) {
+            len = sizeof(staging_buf);
+        }
+        if (flash_area_read(staging->fap, off, staging_buf, len) != 0) {
+            ret = BOOT_EFLASH;
+            goto fail;
+        }
+        if (fwu_staging_hash_update(staging_buf, len) != 0) {
+            ret = -1;
+            goto fail;
+        }
+    }
+
+    if ((fwu_staging_digest(hash) != 0) ||
+        (tfm_memcmp(hash, digest, sizeof(hash)) != 0)) {
+        LOG_MSG("TFM FWU: staged data does not match the journal.\r\n");
+        ret = -3;
+        goto fail;
+    }
+
+    staging->written_end = (uint32_t)staged_size;
+
+    /* The staged sectors must not be erased by the resumed download. */
+    for (sector = 0; sector < staged_size / FLASH_AREA_IMAGE_SECTOR_SIZE;
+         sector++) {
+        sector_map_set(staging->erased_sectors, sector);
+        sector_map_set(staging->written_sectors, sector);
+    }
+
+    return 0;
+
+fail:
+    (void)psa_hash_abort(&staging->hash);
+    flash_area_close(staging->fap);
+    staging->fap = NULL;
+    return ret;
+}
+
+int fwu_bootloader_get_checkpoint(bl_image_id_t bootloader_image_id,
+                                  size_t *staged_size,
+                                  uint8_t *digest)
+{
+    uint8_t mcuboot_image_id = 0;
+
+    if (staged_size == NULL) {
+        return -1;
+    }
+
+    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
+        != 0) {
+        return -1;
+    }
+
+    fwu_staging_select(mcuboot_image_id);
+    if (staging->fap == NULL) {
+        return -2;
+    }
+
+#ifdef TFM_FWU_DELTA_UPDATE
+    /* A delta image is decoded as a stream and must be sent again. */
+    if (staging->delta.enabled) {
+        return 1;
+    }
+#endif
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    /* So is a compressed image. */
+    if (staging->lz4.enabled) {
+        return 1;
+    }
+#endif
+
+    /* A download is resumed from a sector boundary. */
+    if ((staging->hashed_len == 0) ||
+        ((staging->hashed_len % FLASH_AREA_IMAGE_SECTOR_SIZE) != 0)) {
+        return 1;
+    }
+
+    *staged_size = staging->hashed_len;
+
+    if (digest == NULL) {
+        return 0;
+    }
+
+    if (fwu_staging_digest(digest) != 0) {
+        return -3;
+    }
+
+    return 0;
+}
+
+int fwu_bootloader_load_image(bl_image_id_t bootloader_image_id,
+                              size_t image_offset,
+                              const void * block,
+                              size_t block_size)
+{
+    uint8_t mcuboot_image_id = 0;
+    int ret;
+
+    if (block == NULL) {
+        return -1;
+    }
+
+    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
+        != 0) {
+        return -1;
+    }
 
-/* The target area of the active image in firmware update. */
-static const struct flash_area *fap = NULL;
+    fwu_staging_select(mcuboot_image_id);
+    if (staging->fap == NULL) {
+        return -2;
+    }
 
-/* The active image in firmware update. */
-static bl_image_id_t active_image_id = TFM_MCUBOOT_FWU_INVALD_IMAGE_ID;
+    /* Writing the start of the image again restarts the download. */
+    if ((image_offset == 0) && ((staging->bytes_received != 0) ||
+                                (staging->written_end != 0))) {
+        if (fwu_staging_restart() != 0) {
+            return -1;
+        }
+    }
 
-static int convert_id_from_bl_to_mcuboot(bl_image_id_t bl_image_id,
-                                         uint8_t *mcuboot_image_id)
-{
-#if (MCUBOOT_IMAGE_NUMBER == 1)
-    /* Only full image upgrade is supported in this case. */
-    if (bl_image_id != FWU_IMAGE_TYPE_FULL) {
-        LOG_MSG("TFM FWU: multi-image is not supported in current mcuboot configuration.");
-        return -1;
+#ifdef TFM_FWU_DELTA_UPDATE
+    /* A delta image is recognised by the magic at its start. */
+    if ((image_offset == 0) && (block_size >= sizeof(uint32_t)) &&
+        (get_le32((const uint8_t *)block) == FWU_DELTA_MAGIC)) {
+        ret = fwu_delta_start();
+        if (ret != 0) {
+            return ret;
+        }
     }
 
-    /* The image id in mcuboot. 0: the full image. */
-    *mcuboot_image_id = 0;
-#else
-    if (bl_image_id == FWU_IMAGE_TYPE_SECURE) {
-        /* The image id in mcuboot. 0: the secure image. */
-        *mcuboot_image_id = 0;
-    } else if (bl_image_id == FWU_IMAGE_TYPE_NONSECURE) {
-        /* The image id in mcuboot. 1: the non-secure image. */
-        *mcuboot_image_id = 1;
-    }  else {
-        LOG_MSG("TFM FWU: invalid image_type: %d", bl_image_id);
+    if (staging->delta.enabled) {
+        /* The delta image is decoded as a stream. */
+        if ((image_offset != staging->delta.patch_offset) ||
+            (block_size > UINT32_MAX - staging->delta.patch_offset)) {
+            return -1;
+        }
+
+        ret = fwu_delta_apply(block, (uint32_t)block_size);
+        if (ret != 0) {
+            return ret;
+        }
+
+        staging->delta.patch_offset += (uint32_t)block_size;
+        staging->bytes_received += (uint32_t)block_size;
+        return 0;
+    }
+#endif /* TFM_FWU_DELTA_UPDATE */
+
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    /* A compressed image is recognised by the magic at its start. */
+    if ((image_offset == 0) && (block_size >= sizeof(uint32_t)) &&
+        (get_le32((const uint8_t *)block) == FWU_LZ4_MAGIC)) {
+        fwu_lz4_reset();
+        staging->lz4.enabled = true;
+    }
+
+    if (staging->lz4.enabled) {
+        /* The compressed image is decompressed as a stream. */
+        if ((image_offset != staging->lz4.input_offset) ||
+            (block_size > UINT32_MAX - staging->lz4.input_offset)) {
+            return -1;
+        }
+
+        ret = fwu_lz4_apply(block, (uint32_t)block_size);
+        if (ret != 0) {
+            return ret;
+        }
+
+        staging->lz4.input_offset += (uint32_t)block_size;
+        staging->bytes_received += (uint32_t)block_size;
+        return 0;
+    }
+#endif /* TFM_FWU_COMPRESSED_UPDATE */
+
+    if ((image_offset > staging->fap->fa_size) ||
+        (block_size > staging->fap->fa_size - image_offset)) {
         return -1;
     }
-#endif
+
+    ret = fwu_staging_write((uint32_t)image_offset, block,
+                            (uint32_t)block_size);
+    if (ret != 0) {
+        return ret;
+    }
+
+    staging->bytes_received += (uint32_t)block_size;
     return 0;
 }
 
-static int convert_id_from_mcuboot_to_bl(uint8_t mcuboot_image_id,
-                                         bl_image_id_t *bl_image_id)
+/*
+ * Get the size of the image in the given area from its header and TLV area:
+ * the data written into the staging area for an image without padding.
+ */
+static uint32_t get_image_size(const struct flash_area *fap,
+                               const struct image_header *hdr)
 {
-    uint8_t image_type;
+    struct image_tlv_info tlv_info;
+    uint32_t off;
 
-    if (bl_image_id == NULL) {
-        return -1;
+    off = (uint32_t)hdr->ih_hdr_size + hdr->ih_img_size +
+          hdr->ih_protect_tlv_size;
+    if ((off < hdr->ih_img_size) ||
+        (off > fap->fa_size - sizeof(tlv_info))) {
+        return fap->fa_size;
     }
 
-#if (MCUBOOT_IMAGE_NUMBER == 1)
-    /* Only full image upgrade is supported in this case. */
-    if (mcuboot_image_id != 0) {
-        LOG_MSG("TFM FWU: multi-image is not supported in current mcuboot \
-                configuration.\n\r");
-        return -1;
+    if ((flash_area_read(fap, off, &tlv_info, sizeof(tlv_info)) != 0) ||
+        (tlv_info.it_magic != IMAGE_TLV_INFO_MAGIC) ||
+        (tlv_info.it_tlv_tot > fap->fa_size - off)) {
+        return off;
     }
 
-    /* The image id in mcuboot. 0: the full image. */
-    image_type = FWU_IMAGE_TYPE_FULL;
-#else
-    if (mcuboot_image_id == 0) {
-        /* The image id in mcuboot. 0: the secure image. */
-        image_type = FWU_IMAGE_TYPE_SECURE;
-    } else if (mcuboot_image_id == 1) {
-        /* The image id in mcuboot. 1: the non-secure image. */
-        image_type = FWU_IMAGE_TYPE_NONSECURE;
-    }  else {
-        LOG_MSG("TFM FWU: invalid mcuboot image id\n\r: %d",
-                mcuboot_image_id);
-        return -1;
-    }
-#endif
-    *bl_image_id = image_type;
-    return 0;
+    return off + tlv_info.it_tlv_tot;
 }
 
-static int fwu_bootloader_get_shared_data(void)
+/*
+ * Get the version of the running image from the boot data shared by the
+ * bootloader.
+ */
+static int get_active_image_version(uint8_t mcuboot_image_id,
+                                    struct image_version *version)
 {
-    return tfm_core_get_boot_data(TLV_MAJOR_FWU,
-                                  (struct tfm_boot_data *)&boot_shared_data,
-                                  sizeof(boot_shared_data));
+    struct shared_data_tlv_entry tlv_entry;
+    uint8_t *tlv_end;
+    uint8_t *tlv_curr;
+
+    if (boot_shared_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
+        return -2;
+    }
+
+    tlv_end = (uint8_t *)&boot_shared_data + \
+              boot_shared_data.header.tlv_tot_len;
+    tlv_curr = boot_shared_data.data;
+
+    while (tlv_curr < tlv_end) {
+        (void)memcpy(&tlv_entry, tlv_curr, SHARED_DATA_ENTRY_HEADER_SIZE);
+        if ((GET_FWU_CLAIM(tlv_entry.tlv_type) == SW_VERSION) &&
+            (GET_FWU_MODULE(tlv_entry.tlv_type) == mcuboot_image_id)) {
+            if (tlv_entry.tlv_len != sizeof(struct image_version)) {
+                return -3;
+            }
+            memcpy(version, tlv_curr + SHARED_DATA_ENTRY_HEADER_SIZE,
+                   tlv_entry.tlv_len);
+            return 0;
+        }
+        tlv_curr += SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
+    }
+
+    return 1;
 }
 
-int fwu_bootloader_init(void)
+/*
+ * Compare two image versions. As in MCUboot, the build number is not taken
+ * into account for the dependencies.
+ */
+static int compare_image_version(const struct image_version *ver1,
+                                 const struct image_version *ver2)
 {
-    return fwu_bootloader_get_shared_data();
+    if (ver1->iv_major != ver2->iv_major) {
+        return (ver1->iv_major > ver2->iv_major) ? 1 : -1;
+    }
+    if (ver1->iv_minor != ver2->iv_minor) {
+        return (ver1->iv_minor > ver2->iv_minor) ? 1 : -1;
+    }
+    if (ver1->iv_revision != ver2->iv_revision) {
+        return (ver1->iv_revision > ver2->iv_revision) ? 1 : -1;
+    }
+
+    return 0;
 }
 
-int fwu_bootloader_staging_area_init(bl_image_id_t bootloader_image_id)
+/*
+ * Get the dependencies of the image in the given area from the dependency
+ * TLVs of its protected TLV area.
+ */
+static int get_image_dependencies(const struct flash_area *fap,
+                                  const struct image_header *hdr,
+                                  struct image_dependency *deps,
+                                  uint32_t *num)
 {
-    uint8_t mcuboot_image_id = 0;
+    struct image_tlv_info tlv_info;
+    struct image_tlv tlv;
+    uint32_t off;
+    uint32_t end;
 
-    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
-        != 0) {
+    *num = 0;
+
+    if (hdr->ih_protect_tlv_size == 0) {
+        return 0;
+    }
+
+    off = (uint32_t)hdr->ih_hdr_size + hdr->ih_img_size;
+    if ((off < hdr->ih_img_size) ||
+        (off > fap->fa_size - hdr->ih_protect_tlv_size)) {
         return -1;
     }
 
-    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(mcuboot_image_id), &fap) !=
-        0) {
-        LOG_MSG("TFM FWU: opening flash failed.\r\n");
-        fap = NULL;
+    if (flash_area_read(fap, off, &tlv_info, sizeof(tlv_info)) != 0) {
         return BOOT_EFLASH;
     }
 
-    if (flash_area_erase(fap, 0, fap->fa_size) != 0)
-    {
-        LOG_MSG("TFM FWU: erasing flash failed.\r\n");
-        return BOOT_EFLASH;
+    if ((tlv_info.it_magic != IMAGE_TLV_PROT_INFO_MAGIC) ||
+        (tlv_info.it_tlv_tot != hdr->ih_protect_tlv_size)) {
+        return -1;
+    }
+
+    end = off + tlv_info.it_tlv_tot;
+    off += sizeof(tlv_info);
+
+    while (off + sizeof(tlv) <= end) {
+        if (flash_area_read(fap, off, &tlv, sizeof(tlv)) != 0) {
+            return BOOT_EFLASH;
+        }
+        off += sizeof(tlv);
+        if (tlv.it_len > end - off) {
+            return -1;
+        }
+
+        if (tlv.it_type == IMAGE_TLV_DEPENDENCY) {
+            if ((tlv.it_len != sizeof(struct image_dependency)) ||
+                (*num >= MCUBOOT_IMAGE_NUMBER)) {
+                return -1;
+            }
+            if (flash_area_read(fap, off, &deps[*num], tlv.it_len) != 0) {
+                return BOOT_EFLASH;
+            }
+            (*num)++;
+        }
+
+        off += tlv.it_len;
     }
 
-    active_image_id = mcuboot_image_id;
     return 0;
 }
 
-int fwu_bootloader_load_image(bl_image_id_t bootloader_image_id,
-                              size_t image_offset,
-                              const void * block,
-                              size_t block_size)
+/*
+ * Check that the download of the selected image is complete, and get the
+ * header of the image.
+ */
+static int fwu_staging_check_image(struct image_header *hdr)
 {
-    uint8_t mcuboot_image_id = 0;
-
-    if (block == NULL) {
+#ifdef TFM_FWU_DELTA_UPDATE
+    if (staging->delta.enabled &&
+        (staging->delta.state != FWU_DELTA_STATE_DONE)) {
+        LOG_MSG("TFM FWU: delta image is incomplete.\r\n");
+        return -1;
+    }
+#endif
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    if (staging->lz4.enabled &&
+        (staging->lz4.state != FWU_LZ4_STATE_DONE)) {
+        LOG_MSG("TFM FWU: compressed image is incomplete.\r\n");
         return -1;
     }
+#endif
 
-    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
-        != 0) {
+    /* Program the tail of the image before the image is handed over to the
+     * bootloader.
+     */
+    if (fwu_staging_flush() != 0) {
+        return -3;
+    }
+
+    if (flash_area_read(staging->fap, 0, hdr, sizeof(*hdr)) != 0) {
+        return -3;
+    }
+
+    if ((hdr->ih_magic != IMAGE_MAGIC) ||
+        (staging->written_end < get_image_size(staging->fap, hdr))) {
+        LOG_MSG("TFM FWU: image %d is incomplete.\r\n", staging->image_id);
         return -1;
     }
 
-    if ((fap == NULL) || (active_image_id != mcuboot_image_id)) {
+    return 0;
+}
+
+/*
+ * Resolve the dependencies of the image to install. The images in the staging
+ * areas which satisfy a dependency are installed together with it, the other
+ * dependencies must be satisfied by the running images. This follows the
+ * check done by MCUboot at boot, where the dependencies of an image are
+ * checked against the images to install if any, or else the running images.
+ *
+ * Images already marked as candidates are installed by the same reboot, so they
+ * satisfy the dependencies too.
+ *
+ * Returns 0 with the images to install marked in batch, 1 if a dependency is
+ * not satisfied with the image and the minimum version required, or an error.
+ */
+static int check_image_dependency(uint8_t mcuboot_image_id,
+                                  bool *batch,
+                                  uint8_t *dependency,
+                                  struct image_version *version)
+{
+    struct image_dependency deps[MCUBOOT_IMAGE_NUMBER][MCUBOOT_IMAGE_NUMBER];
+    uint32_t num_deps[MCUBOOT_IMAGE_NUMBER] = {0};
+    struct image_header hdr[MCUBOOT_IMAGE_NUMBER];
+    bool staged[MCUBOOT_IMAGE_NUMBER] = {false};
+    struct image_version active_ver;
+    const struct image_version *min_ver;
+    bool added;
+    uint8_t i;
+    uint8_t dep_id;
+    uint32_t d;
+    int ret;
+
+    /* Find the images which are completely downloaded, including the ones
+     * already marked as candidates.
+     */
+    for (i = 0; i < MCUBOOT_IMAGE_NUMBER; i++) {
+        batch[i] = false;
+        fwu_staging_select(i);
+        if (staging->fap == NULL) {
+            continue;
+        }
+
+        ret = fwu_staging_check_image(&hdr[i]);
+        if (ret == 0) {
+            ret = get_image_dependencies(staging->fap, &hdr[i], deps[i],
+                                         &num_deps[i]);
+        }
+        if ((ret != 0) && (i == mcuboot_image_id)) {
+            return ret;
+        }
+        staged[i] = (ret == 0);
+    }
+
+    if (!staged[mcuboot_image_id]) {
         return -2;
     }
 
-    if (flash_area_write(fap, image_offset, block, block_size) != 0) {
-        LOG_MSG("TFM FWU: write flash failed.\r\n");
-        return BOOT_EFLASH;
+    /* Add the staged images which satisfy a dependency to the batch. */
+    batch[mcuboot_image_id] = true;
+    do {
+        added = false;
+        for (i = 0; i < MCUBOOT_IMAGE_NUMBER; i++) {
+            for (d = 0; batch[i] && (d < num_deps[i]); d++) {
+                dep_id = deps[i][d].image_id;
+                if ((dep_id < MCUBOOT_IMAGE_NUMBER) && !batch[dep_id] &&
+                    staged[dep_id] &&
+                    (compare_image_version(&hdr[dep_id].ih_ver,
+                                 &deps[i][d].image_min_version) >= 0)) {
+                    batch[dep_id] = true;
+                    added = true;
+                }
+            }
+        }
+    } while (added);
+
+    /* Check the dependencies of the whole batch. */
+    for (i = 0; i < MCUBOOT_IMAGE_NUMBER; i++) {
+        for (d = 0; batch[i] && (d < num_deps[i]); d++) {
+            dep_id = deps[i][d].image_id;
+            min_ver = &deps[i][d].image_min_version;
+            if (dep_id >= MCUBOOT_IMAGE_NUMBER) {
+                return -1;
+            }
+
+            if (batch[dep_id]) {
+                if (compare_image_version(&hdr[dep_id].ih_ver, min_ver) >= 0) {
+                    continue;
+                }
+            } else if ((get_active_image_version(dep_id, &active_ver) == 0) &&
+                       (compare_image_version(&active_ver, min_ver) >= 0)) {
+                continue;
+            }
+
+            *dependency = dep_id;
+            *version = *min_ver;
+            return 1;
+        }
     }
+
+    return 0;
 }
 
-static bool check_image_dependency(uint8_t mcuboot_image_id,
-                                uint8_t *dependency,
-                                tfm_image_version_t *version)
+/* Mark the selected image as a candidate for the bootloader. */
+static int fwu_staging_mark_pending(void)
 {
-    bool found = false;
+    uint32_t trailer_sz;
 
-    if ((dependency == NULL || version == NULL)) {
-        return found;
+    /* The image trailer must be blank before the magic is written. */
+    trailer_sz = boot_trailer_sz(flash_area_align(staging->fap));
+    if (fwu_staging_prepare_sectors(staging->fap->fa_size - trailer_sz,
+                                    trailer_sz) != 0) {
+        return -3;
     }
 
-    /* Currently only single image update is supported. So no dependency is
-     * required.
+    /* Write the magic in the image trailer so that this image will be set
+     * taken as a candidate.
      */
-    //TODO: Add the dependency check to support multiple image update.
-    *dependency = TFM_MCUBOOT_FWU_INVALD_IMAGE_ID;
-    *version = (tfm_image_version_t){.iv_major = 0, .iv_minor = 0,
-                           .iv_revision = 0, .iv_build_num = 0};
+    if (boot_write_magic(staging->fap) != 0) {
+        return -3;
+    }
+
+#ifdef TFM_FWU_DELTA_UPDATE
+    fwu_delta_reset();
+#endif
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    fwu_lz4_reset();
+#endif
+    staging->pending = true;
 
-    return found;
+    return 0;
 }
 
 int fwu_bootloader_mark_image_candidate(bl_image_id_t bootloader_image_id,
@@ -196,7 +1570,10 @@ int fwu_bootloader_mark_image_candidate(bl_image_id_t bootloader_image_id,
     uint8_t mcuboot_image_id = 0;
     uint8_t dependency_mcuboot;
     bl_image_id_t dependency_bl;
-    tfm_image_version_t version;
+    struct image_version version;
+    bool batch[MCUBOOT_IMAGE_NUMBER];
+    uint8_t i;
+    int ret;
 
     if ((dependency == NULL || dependency_version == NULL)) {
         return -1;
@@ -207,35 +1584,58 @@ int fwu_bootloader_mark_image_candidate(bl_image_id_t bootloader_image_id,
         return -1;
     }
 
-    if ((fap == NULL) || (active_image_id != mcuboot_image_id)) {
+    fwu_staging_select(mcuboot_image_id);
+    if ((staging->fap == NULL) || staging->pending) {
         return -2;
     }
 
-    if (check_image_dependency(mcuboot_image_id,
-                               &dependency_mcuboot,
-                               &version)) {
+    ret = check_image_dependency(mcuboot_image_id, batch,
+                                 &dependency_mcuboot, &version);
+    if (ret == 1) {
         if (convert_id_from_mcuboot_to_bl(dependency_mcuboot,
                                           &dependency_bl) != 0) {
             return -1;
         }
 
         *dependency = dependency_bl;
-        *dependency_version = version;
+        dependency_version->iv_major = version.iv_major;
+        dependency_version->iv_minor = version.iv_minor;
+        dependency_version->iv_revision = version.iv_revision;
+        dependency_version->iv_build_num = version.iv_build_num;
 
-        /* '1' indicates that a dependency is required. See the function
+        /* '2' indicates that a dependency is required. See the function
          * description in tfm_bootloader_fwu_abstraction.h. */
-        return 1;
-    } else {
-        /* Write the magic in the image trailer so that this image will be set
-         * taken as a candidate.
-         */
-        if (boot_write_magic(fap) != 0) {
-            return -3;
-        } else {
-            /* Sytem reboot is always required. */
-            return 1;
+        return 2;
+    } else if (ret != 0) {
+        return ret;
+    }
+
+    /* All the images of the batch are checked before any is marked, so that
+     * they are installed by the same reboot.
+     */
+    for (i = 0; i < MCUBOOT_IMAGE_NUMBER; i++) {
+        if (batch[i] && !staging_ctx[i].pending) {
+            fwu_staging_select(i);
+            if (fwu_staging_mark_pending() != 0) {
+                return -3;
+            }
         }
     }
+
+    /* Sytem reboot is always required. */
+    return 1;
+}
+
+bool fwu_bootloader_is_image_pending(bl_image_id_t bootloader_image_id)
+{
+    uint8_t mcuboot_image_id = 0;
+
+    if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
+        != 0) {
+        return false;
+    }
+
+    return staging_ctx[mcuboot_image_id].pending;
 }
 
 int fwu_bootloader_mark_image_accepted(void)
@@ -258,43 +1658,63 @@ int fwu_bootloader_mark_image_accepted(void)
 int fwu_bootloader_abort(bl_image_id_t bootloader_image_id)
 {
     uint8_t mcuboot_image_id = 0;
+    uint32_t trailer_off;
 
     if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
         != 0) {
         return -1;
     }
 
-    if ((fap == NULL) || (active_image_id != mcuboot_image_id)) {
+    fwu_staging_select(mcuboot_image_id);
+    if (staging->fap == NULL) {
         return -2;
     }
 
-    if (fap != NULL) {
-        flash_area_close(fap);
+    /* Erase the magic of an image already marked as a candidate, so that the
+     * bootloader does not install it.
+     */
+    if (staging->pending) {
+        trailer_off = staging->fap->fa_size -
+                      boot_trailer_sz(flash_area_align(staging->fap));
+        trailer_off -= trailer_off % FLASH_AREA_IMAGE_SECTOR_SIZE;
+        if (flash_area_erase(staging->fap, trailer_off,
+                             staging->fap->fa_size - trailer_off) != 0) {
+            return -3;
+        }
+        staging->pending = false;
     }
 
-    fap = NULL;
-    active_image_id = TFM_MCUBOOT_FWU_INVALD_IMAGE_ID;
+    flash_area_close(staging->fap);
+
+    staging->fap = NULL;
+    staging->len = 0;
+    staging->written_end = 0;
+    staging->hashed_len = 0;
+    (void)psa_hash_abort(&staging->hash);
+#ifdef TFM_FWU_DELTA_UPDATE
+    fwu_delta_reset();
+#endif
+#ifdef TFM_FWU_COMPRESSED_UPDATE
+    fwu_lz4_reset();
+#endif
+    return 0;
 }
 
 static int
 util_img_hash(struct image_header *hdr,
-              const struct flash_area *fap,
+              const struct flash_area *fap, uint32_t size,
               uint8_t *hash_result, size_t buf_size, size_t *hash_size)
 {
     psa_hash_operation_t handle = psa_hash_operation_init();
     psa_status_t status;
     uint8_t tmpbuf[BOOT_TMPBUF_SZ];
     uint32_t tmp_buf_sz = BOOT_TMPBUF_SZ;
-    uint32_t size;
 #ifndef MCUBOOT_RAM_LOAD
     uint32_t blk_sz;
     uint32_t off;
     int rc;
 #endif /* MCUBOOT_RAM_LOAD */
 
-    /* The whole flash area are hashed. */
-    size = fap->fa_size;
-
     /* Setup the hash object for the desired hash. */
     status = psa_hash_setup(&handle, PSA_ALG_SHA_256);
     if (status != PSA_SUCCESS) {
@@ -311,12 +1731,17 @@ util_img_hash(struct image_header *hdr,
         }
         rc = flash_area_read(fap, off, tmpbuf, blk_sz);
         if (rc) {
+            (void)psa_hash_abort(&handle);
             return rc;
         }
         status = psa_hash_update(&handle, tmpbuf, blk_sz);
+        if (status != PSA_SUCCESS) {
+            break;
+        }
     }
 #endif
     if (status != PSA_SUCCESS) {
+        (void)psa_hash_abort(&handle);
         return status;
     }
     status = psa_hash_finish(&handle, hash_result, buf_size, hash_size);
@@ -331,12 +1756,23 @@ static int get_secondary_image_info(uint8_t image_id, tfm_image_info_t * info)
     struct image_header hdr = {0};
     uint8_t hash[TFM_FWU_MAX_DIGEST_SIZE] = {0};
     size_t hash_size = 0;
+    uint32_t image_size;
     int ret;
 
     if (info == NULL) {
         return -1;
     }
 
+    /* Data of the image being downloaded may still be in the staging
+     * buffer.
+     */
+    fwu_staging_select(image_id);
+    if (staging->fap != NULL) {
+        if (fwu_staging_flush() != 0) {
+            return -3;
+        }
+    }
+
     area_id = flash_area_id_from_multi_image_slot(image_id, 1);
 
     /* The image version in the primary slot should be returned. */
@@ -369,7 +1805,30 @@ static int get_secondary_image_info(uint8_t image_id, tfm_image_info_t * info)
             info->version.iv_revision,
             info->version.iv_build_num);
 
-    if (util_img_hash(&hdr, fap, hash, (size_t)TFM_FWU_MAX_DIGEST_SIZE,
+    /* The digest covers the image data written into the staging area. While
+     * the image is being downloaded, it is taken from the running hash if
+     * that covers all the written data. Otherwise, the sectors skipped by
+     * the download are erased first, so that their stale content is not
+     * hashed. After a reset, the image is rehashed from flash up to the end
+     * of its TLV area.
+     */
+    if ((staging->fap != NULL) && (staging->written_end != 0)) {
+        if (staging->hashed_len == staging->written_end) {
+            ret = fwu_staging_digest(info->digest);
+            flash_area_close(fap);
+            return (ret == 0) ? 0 : -4;
+        }
+        if (fwu_staging_erase_sectors(0, staging->written_end) != 0) {
+            flash_area_close(fap);
+            return -3;
+        }
+        image_size = staging->written_end;
+    } else {
+        image_size = get_image_size(fap, &hdr);
+    }
+
+    if (util_img_hash(&hdr, fap, image_size, hash,
+                      (size_t)TFM_FWU_MAX_DIGEST_SIZE,
                       &hash_size) == PSA_SUCCESS) {
         tfm_memcpy(info->digest, hash, hash_size);
         ret = 0;
@@ -386,19 +1845,15 @@ int fwu_bootloader_get_image_info(bl_image_id_t bootloader_image_id,
                                   tfm_image_info_t * info)
 {
     struct image_version image_ver = { 0 };
-    struct shared_data_tlv_entry tlv_entry;
-    uint8_t *tlv_end;
-    uint8_t *tlv_curr;
-    bool found = false;
     uint8_t mcuboot_image_id = 0;
+    int ret;
 
     if (convert_id_from_bl_to_mcuboot(bootloader_image_id, &mcuboot_image_id)
         != 0) {
         return -1;
     }
 
-    //TODO: Add the module identity when adding the image version into the shared memory.
-    if ((info == NULL) || (mcuboot_image_id != 0)) {
+    if (info == NULL) {
         return -1;
     }
 
@@ -408,42 +1863,21 @@ int fwu_bootloader_get_image_info(bl_image_id_t bootloader_image_id,
     /* When getting the primary image information, read it from the
      * shared memory. */
     if (active_image) {
-        if (boot_shared_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
-            return -2;
+        ret = get_active_image_version(mcuboot_image_id, &image_ver);
+        if (ret != 0) {
+            return ret;
         }
 
-        tlv_end = (uint8_t *)&boot_shared_data + \
-                  boot_shared_data.header.tlv_tot_len;
-        tlv_curr = boot_shared_data.data;
-
-        while (tlv_curr < tlv_end) {
-            (void)memcpy(&tlv_entry, tlv_curr, SHARED_DATA_ENTRY_HEADER_SIZE);
-            if (GET_FWU_CLAIM(tlv_entry.tlv_type) == SW_VERSION) {
-                if (tlv_entry.tlv_len != sizeof(struct image_version)) {
-                    return -3;
-                }
-                memcpy(&image_ver,
-                    tlv_curr + SHARED_DATA_ENTRY_HEADER_SIZE,
-                    tlv_entry.tlv_len );
-                found = true;
-                break;
-            }
-            tlv_curr += SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
-        }
-        if (found) {
-            info->version.iv_major = image_ver.iv_major;
-            info->version.iv_minor = image_ver.iv_minor;
-            info->version.iv_revision = image_ver.iv_revision;
-            info->version.iv_build_num = image_ver.iv_build_num;
+        info->version.iv_major = image_ver.iv_major;
+        info->version.iv_minor = image_ver.iv_minor;
+        info->version.iv_revision = image_ver.iv_revision;
+        info->version.iv_build_num = image_ver.iv_build_num;
 
-            /* The image in the primary slot is verified by the bootloader.
-             * The image digest in the primary slot should not be exposed to
-             * nonsecure.
-             */
-            return 0;
-        } else {
-            return 1;
-        }
+        /* The image in the primary slot is verified by the bootloader.
+         * The image digest in the primary slot should not be exposed to
+         * nonsecure.
+         */
+        return 0;
     } else {
         return get_secondary_image_info(mcuboot_image_id, info);
     }
@@ -42,6 +42,47 @@ int fwu_bootloader_init(void);
  */
 int fwu_bootloader_staging_area_init(bl_image_id_t bootloader_image_id);
 
+/**
+ * \brief Resume the download of the image with given ID.
+ *
+ * Prepare the staging area of the image with given ID for the download to
+ * continue after a reset. The data already in the staging area is checked
+ * against the digest and kept, so the image is written from staged_size on.
+ *
+ * \param[in] bootloader_image_id The identifier of the target image in
+ *                                bootloader
+ * \param[in] staged_size         Size of the image data at the start of the
+ *                                staging area, as returned by
+ *                                \ref fwu_bootloader_get_checkpoint
+ * \param[in] digest              Digest of the staged data, as returned by
+ *                                \ref fwu_bootloader_get_checkpoint
+ *
+ * \return 0            On success
+ *         error_code   Implementation defined error code on failure
+ */
+int fwu_bootloader_staging_area_resume(bl_image_id_t bootloader_image_id,
+                                       size_t staged_size,
+                                       const uint8_t *digest);
+
+/**
+ * \brief Get the point the image download can be resumed from.
+ *
+ * \param[in]  bootloader_image_id The identifier of the target image in
+ *                                 bootloader
+ * \param[out] staged_size         Size of the image data at the start of the
+ *                                 staging area which is in the staging area
+ * \param[out] digest              Buffer of TFM_FWU_MAX_DIGEST_SIZE bytes to
+ *                                 return the digest of the staged data. NULL
+ *                                 if only staged_size is needed.
+ *
+ * \return 0            On success
+ *         1            The download cannot be resumed from its current state
+ *         error_code   Implementation defined error code on failure
+ */
+int fwu_bootloader_get_checkpoint(bl_image_id_t bootloader_image_id,
+                                  size_t *staged_size,
+                                  uint8_t *digest);
+
 /**
  * \brief Load the image into the target device.
  *
@@ -71,7 +112,8 @@ int fwu_bootloader_load_image(bl_image_id_t bootloader_image_id,
  *
  * Mark the image in staging area as a candidate for bootloader so that the
  * next time bootloader runs, it will take this image as a candidate one to
- * bootup.
+ * bootup. The staged images which satisfy the dependencies of this image are
+ * marked as candidates too, so that they are installed by the same reboot.
  * \param[in] bootloader_image_id The identifier of the target image in
  *                                bootloader
  * \param[out] dependency         Bootloader image ID of dependency if needed
@@ -87,6 +129,17 @@ int fwu_bootloader_mark_image_candidate(bl_image_id_t bootloader_image_id,
                                         bl_image_id_t *dependency,
                                       tfm_image_version_t *dependency_version);
 
+/**
+ * \brief Check whether the staging image is marked as a candidate.
+ *
+ * \param[in] bootloader_image_id The identifier of the target image in
+ *                                bootloader
+ *
+ * \return true if the image will be taken as a candidate by the bootloader
+ *         at the next reboot, false otherwise
+ */
+bool fwu_bootloader_is_image_pending(bl_image_id_t bootloader_image_id);
+
 /**
  * \brief Marks the image in the primary slot as confirmed.
  *
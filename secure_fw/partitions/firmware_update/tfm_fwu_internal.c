@@ -7,9 +7,107 @@
 
 #include <stdint.h>
 #include "log/tfm_log.h"
+#include "psa/internal_trusted_storage.h"
 #include "tfm_hal_platform.h"
+#include "tfm_memory_utils.h"
 #include "tfm_fwu_internal.h"
 
+/* The UID of the download progress journal of the first image in ITS. The
+ * journals of the other images follow it.
+ */
+#define TFM_FWU_JOURNAL_UID         1U
+
+#ifndef TFM_FWU_JOURNAL_INTERVAL
+/* The minimum download progress, in bytes, between two journal updates. */
+#define TFM_FWU_JOURNAL_INTERVAL    (32 * 1024)
+#endif
+
+/*
+ * \struct tfm_fwu_journal_t
+ *
+ * \brief The progress of the image download, persisted in ITS so that the
+ *        download can be resumed after a reset.
+ */
+typedef struct tfm_fwu_journal_s {
+    tfm_image_id_t image_id;
+    uint32_t staged_size;
+    uint8_t digest[TFM_FWU_MAX_DIGEST_SIZE];
+} tfm_fwu_journal_t;
+
+static tfm_fwu_journal_t journals[TFM_FWU_MAX_IMAGES];
+
+static void fwu_journal_clear(uint8_t image_type)
+{
+    tfm_memset(&journals[TFM_FWU_IMAGE_INDEX(image_type)], 0,
+               sizeof(tfm_fwu_journal_t));
+    (void)psa_its_remove(TFM_FWU_JOURNAL_UID +
+                         TFM_FWU_IMAGE_INDEX(image_type));
+}
+
+static void fwu_journal_update(tfm_image_id_t image_id, uint8_t image_type)
+{
+    tfm_fwu_journal_t *journal = &journals[TFM_FWU_IMAGE_INDEX(image_type)];
+    size_t staged_size;
+
+    if (fwu_bootloader_get_checkpoint(image_type, &staged_size, NULL) != 0) {
+        return;
+    }
+
+    if ((journal->image_id == image_id) &&
+        (staged_size < journal->staged_size + TFM_FWU_JOURNAL_INTERVAL)) {
+        return;
+    }
+
+    if (fwu_bootloader_get_checkpoint(image_type, &staged_size,
+                                      journal->digest) != 0) {
+        return;
+    }
+
+    journal->image_id = image_id;
+    journal->staged_size = (uint32_t)staged_size;
+
+    /* The journal is best effort, the download goes on without it. */
+    if (psa_its_set(TFM_FWU_JOURNAL_UID + TFM_FWU_IMAGE_INDEX(image_type),
+                    sizeof(*journal), journal,
+                    PSA_STORAGE_FLAG_NONE) != PSA_SUCCESS) {
+        LOG_MSG("TFM FWU: saving the journal failed.\r\n");
+    }
+}
+
+int tfm_internal_fwu_resume(uint8_t image_type, tfm_image_id_t *image_id)
+{
+    tfm_fwu_journal_t *journal;
+    size_t data_length = 0;
+
+    if ((image_id == NULL) || !TFM_FWU_IMAGE_TYPE_VALID(image_type)) {
+        return -1;
+    }
+
+    journal = &journals[TFM_FWU_IMAGE_INDEX(image_type)];
+    if ((psa_its_get(TFM_FWU_JOURNAL_UID + TFM_FWU_IMAGE_INDEX(image_type), 0,
+                     sizeof(*journal), journal,
+                     &data_length) != PSA_SUCCESS) ||
+        (data_length != sizeof(*journal))) {
+        tfm_memset(journal, 0, sizeof(*journal));
+        return 1;
+    }
+
+    if ((FWU_IMAGE_ID_GET_TYPE(journal->image_id) != image_type) ||
+        (FWU_IMAGE_ID_GET_SLOT(journal->image_id) != FWU_IMAGE_ID_SLOT_1) ||
+        (fwu_bootloader_staging_area_resume(image_type,
+                                            journal->staged_size,
+                                            journal->digest) != 0)) {
+        fwu_journal_clear(image_type);
+        return 1;
+    }
+
+    LOG_MSG("TFM FWU: download of image type %d resumed at offset %d.\r\n",
+            image_type, journal->staged_size);
+
+    *image_id = journal->image_id;
+    return 0;
+}
+
 int tfm_internal_fwu_initialize(tfm_image_id_t image_id)
 {
     uint8_t image_type = (uint8_t)FWU_IMAGE_ID_GET_TYPE(image_id);
@@ -36,10 +134,18 @@ int tfm_internal_fwu_write(tfm_image_id_t image_id,
     uint8_t image_type = (uint8_t)FWU_IMAGE_ID_GET_TYPE(image_id);
     uint8_t slot_id = (uint8_t)FWU_IMAGE_ID_GET_SLOT(image_id);
 
-    if ((block == NULL) || (slot_id != FWU_IMAGE_ID_SLOT_1)) {
+    if ((block == NULL) || (slot_id != FWU_IMAGE_ID_SLOT_1) ||
+        !TFM_FWU_IMAGE_TYPE_VALID(image_type)) {
         return -1;
     }
 
+    /* Writing the start of the image restarts the download. */
+    if ((image_offset == 0) &&
+        (journals[TFM_FWU_IMAGE_INDEX(image_type)].image_id !=
+         TFM_FWU_INVALID_IMAGE_ID)) {
+        fwu_journal_clear(image_type);
+    }
+
     if (fwu_bootloader_load_image(image_type,
                                   image_offset,
                                   block,
@@ -47,6 +153,8 @@ int tfm_internal_fwu_write(tfm_image_id_t image_id,
         return 1;
     }
 
+    fwu_journal_update(image_id, image_type);
+
     return 0;
 }
 
@@ -58,6 +166,7 @@ int tfm_internal_fwu_install(tfm_image_id_t image_id,
     uint8_t slot_id = (uint8_t)FWU_IMAGE_ID_GET_SLOT(image_id);
     bl_image_id_t dependency_bl;
     tfm_image_version_t version;
+    uint8_t type;
     int result;
 
     /* Check the image slot, the target should be the staging slot. */
@@ -74,6 +183,19 @@ int tfm_internal_fwu_install(tfm_image_id_t image_id,
                                                  &dependency_bl,
                                                  &version);
     if (result == 1) {
+        /* The downloads of the images marked as candidates, which may include
+         * staged dependencies of this image, are complete so there is nothing
+         * left to resume.
+         */
+        for (type = FWU_IMAGE_TYPE_NONSECURE; type <= TFM_FWU_MAX_IMAGES;
+             type++) {
+            if ((journals[TFM_FWU_IMAGE_INDEX(type)].image_id !=
+                 TFM_FWU_INVALID_IMAGE_ID) &&
+                fwu_bootloader_is_image_pending(type)) {
+                fwu_journal_clear(type);
+            }
+        }
+    } else if (result == 2) {
         *dependency = (tfm_image_id_t)FWU_CALCULATE_IMAGE_ID(FWU_IMAGE_ID_SLOT_1, \
                                                             dependency_bl);
         *dependency_version = version;
@@ -87,10 +209,12 @@ void tfm_internal_fwu_abort(tfm_image_id_t image_id)
     uint8_t image_type = (uint8_t)FWU_IMAGE_ID_GET_TYPE(image_id);
     uint8_t slot_id = (uint8_t)FWU_IMAGE_ID_GET_SLOT(image_id);
 
-    if (slot_id != FWU_IMAGE_ID_SLOT_1) {
-        return -1;
+    if ((slot_id != FWU_IMAGE_ID_SLOT_1) ||
+        !TFM_FWU_IMAGE_TYPE_VALID(image_type)) {
+        return;
     }
 
+    fwu_journal_clear(image_type);
     fwu_bootloader_abort(image_type);
 }
 
@@ -101,6 +225,7 @@ int tfm_internal_fwu_query(tfm_image_id_t uuid,
     uint8_t image_type = (uint8_t)FWU_IMAGE_ID_GET_TYPE(uuid);
     uint8_t slot_id = (uint8_t)FWU_IMAGE_ID_GET_SLOT(uuid);
     bool active_image = 0;
+    int result;
 
     if (slot_id == FWU_IMAGE_ID_SLOT_1) {
         active_image = false;
@@ -111,7 +236,23 @@ int tfm_internal_fwu_query(tfm_image_id_t uuid,
         return -1;
     }
 
-    return fwu_bootloader_get_image_info(image_type, active_image, info);
+    result = fwu_bootloader_get_image_info(image_type, active_image, info);
+    if ((result == 0) && !active_image &&
+        TFM_FWU_IMAGE_TYPE_VALID(image_type) &&
+        (journals[TFM_FWU_IMAGE_INDEX(image_type)].image_id !=
+         TFM_FWU_INVALID_IMAGE_ID)) {
+        info->resume_offset =
+                    journals[TFM_FWU_IMAGE_INDEX(image_type)].staged_size;
+    }
+
+    return result;
+}
+
+bool tfm_internal_fwu_is_pending(tfm_image_id_t image_id)
+{
+    uint8_t image_type = (uint8_t)FWU_IMAGE_ID_GET_TYPE(image_id);
+
+    return fwu_bootloader_is_image_pending(image_type);
 }
 
 void tfm_internal_fwu_request_reboot(void)
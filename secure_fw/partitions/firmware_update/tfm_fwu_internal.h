@@ -8,6 +8,7 @@
 #ifndef __TFM_FWU_INTERNAL_H__
 #define __TFM_FWU_INTERNAL_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "firmware_update.h"
@@ -17,8 +18,25 @@
 extern "C" {
 #endif
 
+/* The number of image types which can be updated, one context per type. */
+#define TFM_FWU_MAX_IMAGES              FWU_IMAGE_TYPE_FULL
+#define TFM_FWU_IMAGE_TYPE_VALID(type)  (((type) >= FWU_IMAGE_TYPE_NONSECURE) \
+                                         && ((type) <= TFM_FWU_MAX_IMAGES))
+#define TFM_FWU_IMAGE_INDEX(type)       ((type) - FWU_IMAGE_TYPE_NONSECURE)
+
 int tfm_internal_fwu_initialize(tfm_image_id_t image_id);
 
+/**
+ * \brief Resume the download of the given image type interrupted by a reset,
+ *        if any.
+ *
+ * \param[in]  image_type  The type of the image
+ * \param[out] image_id    The identifier of the image being downloaded
+ *
+ * \return 0 if a download is resumed, non-zero otherwise
+ */
+int tfm_internal_fwu_resume(uint8_t image_type, tfm_image_id_t *image_id);
+
 int tfm_internal_fwu_write(tfm_image_id_t image_id,
                            size_t image_offset,
                            const void * block,
@@ -33,6 +51,16 @@ void tfm_internal_fwu_abort(tfm_image_id_t image_id);
 int tfm_internal_fwu_query(tfm_image_id_t uuid,
                            tfm_image_info_t *info);
 
+/**
+ * \brief Check whether the image is marked as a candidate for the next reboot,
+ *        by its own install or by the install of an image depending on it.
+ *
+ * \param[in] image_id  The identifier of the image
+ *
+ * \return true if the image is marked as a candidate, false otherwise
+ */
+bool tfm_internal_fwu_is_pending(tfm_image_id_t image_id);
+
 void tfm_internal_fwu_request_reboot(void);
 
 int tfm_internal_fwu_accept(void);
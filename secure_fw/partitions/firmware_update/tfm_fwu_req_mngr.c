@@ -19,6 +19,13 @@
 #include "tfm_memory_utils.h"
 #endif
 
+#ifndef TFM_FWU_BUF_SIZE
+/* By default, set the FWU buffer size to the max block size so that all
+ * requests can be handled in one iteration.
+ */
+#define TFM_FWU_BUF_SIZE TFM_FWU_MAX_BLOCK_SIZE
+#endif
+
 typedef enum {
     FWU_IMAGE_STATE_INVALID = 0,
     FWU_IMAGE_STATE_CANDIDATE,
@@ -34,9 +41,68 @@ typedef struct tfm_fwu_ctx_s {
 } tfm_fwu_ctx_t;
 
 /**
- * \brief The context of FWU service.
+ * \brief The contexts of FWU service, one per image type.
  */
-static tfm_fwu_ctx_t fwu_ctx;
+static tfm_fwu_ctx_t fwu_ctx[TFM_FWU_MAX_IMAGES];
+
+/* Get the context of the type of the given image. */
+static tfm_fwu_ctx_t *fwu_get_ctx(tfm_image_id_t image_id)
+{
+    uint8_t image_type = (uint8_t)FWU_IMAGE_ID_GET_TYPE(image_id);
+
+    if (!TFM_FWU_IMAGE_TYPE_VALID(image_type)) {
+        return NULL;
+    }
+
+    return &fwu_ctx[TFM_FWU_IMAGE_INDEX(image_type)];
+}
+
+/*
+ * Update the image states after an install request. The install of an image
+ * also marks its staged dependencies as candidates, so their contexts move to
+ * INSTALL with it. The image can be installed again if the install failed or
+ * a dependency is needed.
+ */
+static void fwu_install_done(tfm_fwu_ctx_t *ctx, int result)
+{
+    uint8_t i;
+
+    if (result == 0 || result == 1) {
+        for (i = 0; i < TFM_FWU_MAX_IMAGES; i++) {
+            if ((fwu_ctx[i].image_state == FWU_IMAGE_STATE_CANDIDATE) &&
+                tfm_internal_fwu_is_pending(fwu_ctx[i].image_id)) {
+                fwu_ctx[i].image_state = FWU_IMAGE_STATE_INSTALL;
+            }
+        }
+    } else {
+        ctx->image_state = FWU_IMAGE_STATE_CANDIDATE;
+    }
+}
+
+/* Accept the running images, after the reboot which installed them. */
+static psa_status_t fwu_accept(void)
+{
+    uint8_t i;
+
+    /* The accept should after a reboot, so the image states should be
+     * INVALID.
+     */
+    for (i = 0; i < TFM_FWU_MAX_IMAGES; i++) {
+        if (fwu_ctx[i].image_state != FWU_IMAGE_STATE_INVALID) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    if (tfm_internal_fwu_accept() != 0) {
+        return PSA_ERROR_SERVICE_FAILURE;
+    }
+
+    for (i = 0; i < TFM_FWU_MAX_IMAGES; i++) {
+        fwu_ctx[i].image_state = FWU_IMAGE_STATE_ACCEPTED;
+    }
+
+    return PSA_SUCCESS;
+}
 
 #ifndef TFM_PSA_API
 psa_status_t tfm_fwu_write_req(psa_invec *in_vec, size_t in_len,
@@ -46,6 +112,7 @@ psa_status_t tfm_fwu_write_req(psa_invec *in_vec, size_t in_len,
     size_t image_offset;
     uint8_t * p_data;
     size_t data_length;
+    tfm_fwu_ctx_t *ctx;
     int error;
     bool accept_new_image = false;
     psa_status_t status = PSA_SUCCESS;
@@ -69,7 +136,16 @@ psa_status_t tfm_fwu_write_req(psa_invec *in_vec, size_t in_len,
     data_length = in_vec[2].len;
     image_id = *((tfm_image_id_t *)in_vec[0].base);
 
-    if (!fwu_ctx.initialized) {
+    if ((data_length == 0) || (data_length > TFM_FWU_MAX_BLOCK_SIZE)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    ctx = fwu_get_ctx(image_id);
+    if (ctx == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!ctx->initialized) {
         error = tfm_internal_fwu_initialize(image_id);
         if (error == 0) {
             accept_new_image = true;
@@ -79,11 +155,11 @@ psa_status_t tfm_fwu_write_req(psa_invec *in_vec, size_t in_len,
             status = PSA_ERROR_STORAGE_FAILURE;
         }
     } else {
-        if (fwu_ctx.image_id != image_id) {
+        if (ctx->image_id != image_id) {
             accept_new_image = true;
         } else {
-            if ((fwu_ctx.image_state == FWU_IMAGE_STATE_CANDIDATE) ||
-                (fwu_ctx.image_state == FWU_IMAGE_STATE_REJECTED)) {
+            if ((ctx->image_state == FWU_IMAGE_STATE_CANDIDATE) ||
+                (ctx->image_state == FWU_IMAGE_STATE_REJECTED)) {
                 accept_new_image = true;
             } else {
                 status = TFM_ERROR_WRITE_FAILURE;
@@ -92,9 +168,9 @@ psa_status_t tfm_fwu_write_req(psa_invec *in_vec, size_t in_len,
     }
 
     if (accept_new_image) {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_CANDIDATE;
-        fwu_ctx.image_id = image_id;
-        fwu_ctx.initialized = true;
+        ctx->image_state = FWU_IMAGE_STATE_CANDIDATE;
+        ctx->image_id = image_id;
+        ctx->initialized = true;
     } else {
         return status;
     }
@@ -116,6 +192,7 @@ psa_status_t tfm_fwu_install_req(psa_invec *in_vec, size_t in_len,
     tfm_image_id_t image_id;
     tfm_image_id_t * dependency_id;
     tfm_image_version_t * dependency_version;
+    tfm_fwu_ctx_t *ctx;
     int result;
 
     /* Check input/output parameters. */
@@ -130,14 +207,16 @@ psa_status_t tfm_fwu_install_req(psa_invec *in_vec, size_t in_len,
     dependency_id = out_vec[0].base;
     dependency_version = out_vec[1].base;
 
-    if ((fwu_ctx.image_id != image_id) ||
-       (fwu_ctx.image_state != FWU_IMAGE_STATE_CANDIDATE)) {
+    ctx = fwu_get_ctx(image_id);
+    if ((ctx == NULL) || (ctx->image_id != image_id) ||
+       (ctx->image_state != FWU_IMAGE_STATE_CANDIDATE)) {
         return PSA_ERROR_INVALID_ARGUMENT;
     } else {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_INSTALL;
+        ctx->image_state = FWU_IMAGE_STATE_INSTALL;
         result = tfm_internal_fwu_install(image_id,
                                           dependency_id,
                                           dependency_version);
+        fwu_install_done(ctx, result);
         if (result == 0) {
             return PSA_SUCCESS;
         } else if (result == 1) {
@@ -195,20 +274,7 @@ psa_status_t tfm_fwu_accept_req(psa_invec *in_vec, size_t in_len,
     (void)in_len;
     (void)out_len;
 
-    /* The accept should after a reboot, so the image state should be
-     * INVALID.
-     */
-    if(fwu_ctx.image_state != FWU_IMAGE_STATE_INVALID) {
-        return PSA_ERROR_INVALID_ARGUMENT;
-    }
-
-    if(tfm_internal_fwu_accept() == 0) {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_ACCEPTED;
-    } else {
-        return PSA_ERROR_SERVICE_FAILURE;
-    }
-
-    return PSA_SUCCESS;
+    return fwu_accept();
 }
 
 /* Abort the currently running FWU. */
@@ -216,6 +282,7 @@ psa_status_t tfm_fwu_abort_req(psa_invec *in_vec, size_t in_len,
                                psa_outvec *out_vec, size_t out_len)
 {
     tfm_image_id_t image_id;
+    tfm_fwu_ctx_t *ctx;
 
     (void)out_vec;
 
@@ -224,12 +291,17 @@ psa_status_t tfm_fwu_abort_req(psa_invec *in_vec, size_t in_len,
     }
 
     image_id = *((tfm_image_id_t *)in_vec[0].base);
-    if (((fwu_ctx.image_state == FWU_IMAGE_STATE_CANDIDATE) ||
-        (fwu_ctx.image_state == FWU_IMAGE_STATE_INSTALL)) &&
-        (fwu_ctx.image_id == image_id)) {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_INVALID;
-        fwu_ctx.image_id = TFM_FWU_INVALID_IMAGE_ID;
-        fwu_ctx.initialized = false;
+    ctx = fwu_get_ctx(image_id);
+    if (ctx == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (((ctx->image_state == FWU_IMAGE_STATE_CANDIDATE) ||
+        (ctx->image_state == FWU_IMAGE_STATE_INSTALL)) &&
+        (ctx->image_id == image_id)) {
+        ctx->image_state = FWU_IMAGE_STATE_INVALID;
+        ctx->image_id = TFM_FWU_INVALID_IMAGE_ID;
+        ctx->initialized = false;
         tfm_internal_fwu_abort(image_id);
         return PSA_SUCCESS;
     } else {
@@ -241,15 +313,21 @@ psa_status_t tfm_fwu_abort_req(psa_invec *in_vec, size_t in_len,
 typedef psa_status_t (*fwu_func_t)(void);
 static psa_msg_t msg;
 
+/* Buffer to receive image data from the caller. Sizing it to a multiple of
+ * the flash sector size lets the bootloader layer program whole sectors
+ * straight from this buffer.
+ */
+static uint8_t data_block[TFM_FWU_BUF_SIZE];
+
 static psa_status_t tfm_fwu_write_ipc(void)
 {
     tfm_image_id_t image_id;
     size_t image_offset;
-    size_t data_length, num;
+    size_t data_length, read_size, num;
+    tfm_fwu_ctx_t *ctx;
     int error;
     bool accept_new_image = false;
     psa_status_t status = PSA_SUCCESS;
-    uint8_t data_block[TFM_FWU_MAX_BLOCK_SIZE];
 
     /* Check input parameters. */
     if (msg.in_size[0] != sizeof(image_id) ||
@@ -257,6 +335,11 @@ static psa_status_t tfm_fwu_write_ipc(void)
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
+    data_length = msg.in_size[2];
+    if ((data_length == 0) || (data_length > TFM_FWU_MAX_BLOCK_SIZE)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
     num = psa_read(msg.handle, 0, &image_id, sizeof(image_id));
     if (num != sizeof(image_id)) {
         return PSA_ERROR_PROGRAMMER_ERROR;
@@ -267,14 +350,12 @@ static psa_status_t tfm_fwu_write_ipc(void)
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
-    tfm_memset(data_block, 0, sizeof(data_block));
-    data_length = msg.in_size[2];
-    num = psa_read(msg.handle, 2, data_block, data_length);
-    if (num != data_length) {
-        return PSA_ERROR_PROGRAMMER_ERROR;
+    ctx = fwu_get_ctx(image_id);
+    if (ctx == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    if (!fwu_ctx.initialized) {
+    if (!ctx->initialized) {
         error = tfm_internal_fwu_initialize(image_id);
         if (error == 0) {
             accept_new_image = true;
@@ -284,11 +365,11 @@ static psa_status_t tfm_fwu_write_ipc(void)
             status = PSA_ERROR_STORAGE_FAILURE;
         }
     } else {
-        if (fwu_ctx.image_id != image_id) {
+        if (ctx->image_id != image_id) {
             accept_new_image = true;
         } else {
-            if ((fwu_ctx.image_state == FWU_IMAGE_STATE_CANDIDATE) ||
-                (fwu_ctx.image_state == FWU_IMAGE_STATE_REJECTED)) {
+            if ((ctx->image_state == FWU_IMAGE_STATE_CANDIDATE) ||
+                (ctx->image_state == FWU_IMAGE_STATE_REJECTED)) {
                 accept_new_image = true;
             } else {
                 status = TFM_ERROR_WRITE_FAILURE;
@@ -297,22 +378,38 @@ static psa_status_t tfm_fwu_write_ipc(void)
     }
 
     if (accept_new_image) {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_CANDIDATE;
-        fwu_ctx.image_id = image_id;
-        fwu_ctx.initialized = true;
+        ctx->image_state = FWU_IMAGE_STATE_CANDIDATE;
+        ctx->image_id = image_id;
+        ctx->initialized = true;
     } else {
         return status;
     }
 
-    error = tfm_internal_fwu_write(image_id,
-                                   image_offset,
-                                   data_block,
-                                   data_length);
-    if (error == 0) {
-        return PSA_SUCCESS;
-    } else {
-        return PSA_ERROR_STORAGE_FAILURE;
+    /* Stream the block into the staging area through the transfer buffer.
+     * Consecutive psa_read() calls continue from where the previous one
+     * stopped, so the block is never copied as a whole.
+     */
+    while (data_length > 0) {
+        read_size = (data_length < sizeof(data_block)) ? data_length :
+                                                         sizeof(data_block);
+        num = psa_read(msg.handle, 2, data_block, read_size);
+        if (num != read_size) {
+            return PSA_ERROR_PROGRAMMER_ERROR;
+        }
+
+        error = tfm_internal_fwu_write(image_id,
+                                       image_offset,
+                                       data_block,
+                                       read_size);
+        if (error != 0) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+
+        image_offset += read_size;
+        data_length -= read_size;
     }
+
+    return PSA_SUCCESS;
 }
 
 static psa_status_t tfm_fwu_install_ipc(void)
@@ -320,6 +417,7 @@ static psa_status_t tfm_fwu_install_ipc(void)
     tfm_image_id_t image_id;
     tfm_image_id_t dependency_id;
     tfm_image_version_t dependency_version;
+    tfm_fwu_ctx_t *ctx;
     size_t num;
     int result;
 
@@ -335,14 +433,16 @@ static psa_status_t tfm_fwu_install_ipc(void)
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
-    if ((fwu_ctx.image_id != image_id) ||
-       (fwu_ctx.image_state != FWU_IMAGE_STATE_CANDIDATE)) {
+    ctx = fwu_get_ctx(image_id);
+    if ((ctx == NULL) || (ctx->image_id != image_id) ||
+       (ctx->image_state != FWU_IMAGE_STATE_CANDIDATE)) {
         return PSA_ERROR_INVALID_ARGUMENT;
     } else {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_INSTALL;
+        ctx->image_state = FWU_IMAGE_STATE_INSTALL;
         result = tfm_internal_fwu_install(image_id,
                                           &dependency_id,
                                           &dependency_version);
+        fwu_install_done(ctx, result);
         if (result == 0) {
             return PSA_SUCCESS;
         } else if (result == 1) {
@@ -393,25 +493,13 @@ static psa_status_t tfm_fwu_request_reboot_ipc(void)
 
 static psa_status_t tfm_fwu_accept_ipc(void)
 {
-    /* The accept should after a reboot, so the image state should be
-     * INVALID.
-     */
-    if(fwu_ctx.image_state != FWU_IMAGE_STATE_INVALID) {
-        return PSA_ERROR_INVALID_ARGUMENT;
-    }
-
-    if(tfm_internal_fwu_accept() == 0) {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_ACCEPTED;
-    } else {
-        return PSA_ERROR_SERVICE_FAILURE;
-    }
-
-    return PSA_SUCCESS;
+    return fwu_accept();
 }
 
 static psa_status_t tfm_fwu_abort_ipc(void)
 {
     tfm_image_id_t image_id;
+    tfm_fwu_ctx_t *ctx;
     size_t num;
 
     if (msg.in_size[0] != sizeof(image_id)) {
@@ -423,13 +511,18 @@ static psa_status_t tfm_fwu_abort_ipc(void)
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
-    if (fwu_ctx.image_state == FWU_IMAGE_STATE_INVALID) {
+    ctx = fwu_get_ctx(image_id);
+    if (ctx == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (ctx->image_state == FWU_IMAGE_STATE_INVALID) {
         return PSA_SUCCESS;
-    } else if ((fwu_ctx.image_state == FWU_IMAGE_STATE_CANDIDATE) ||
-       (fwu_ctx.image_state == FWU_IMAGE_STATE_INSTALL)) {
-        fwu_ctx.image_state = FWU_IMAGE_STATE_INVALID;
-        fwu_ctx.image_id = TFM_FWU_INVALID_IMAGE_ID;
-        fwu_ctx.initialized = false;
+    } else if ((ctx->image_state == FWU_IMAGE_STATE_CANDIDATE) ||
+       (ctx->image_state == FWU_IMAGE_STATE_INSTALL)) {
+        ctx->image_state = FWU_IMAGE_STATE_INVALID;
+        ctx->image_id = TFM_FWU_INVALID_IMAGE_ID;
+        ctx->initialized = false;
         tfm_internal_fwu_abort(image_id);
         return PSA_SUCCESS;
     } else {
@@ -474,6 +567,24 @@ static void fwu_signal_handle(psa_signal_t signal, fwu_func_t pfn)
 }
 #endif
 
+/* Continue the image downloads which were interrupted by a reset, if any. */
+static void tfm_fwu_resume(void)
+{
+    tfm_image_id_t image_id;
+    uint8_t image_type;
+    tfm_fwu_ctx_t *ctx;
+
+    for (image_type = FWU_IMAGE_TYPE_NONSECURE;
+         image_type <= TFM_FWU_MAX_IMAGES; image_type++) {
+        if (tfm_internal_fwu_resume(image_type, &image_id) == 0) {
+            ctx = &fwu_ctx[TFM_FWU_IMAGE_INDEX(image_type)];
+            ctx->image_state = FWU_IMAGE_STATE_CANDIDATE;
+            ctx->image_id = image_id;
+            ctx->initialized = true;
+        }
+    }
+}
+
 psa_status_t tfm_fwu_init(void)
 {
 #ifdef TFM_PSA_API
@@ -483,6 +594,8 @@ psa_status_t tfm_fwu_init(void)
         tfm_abort();
     }
 
+    tfm_fwu_resume();
+
     while (1) {
         signals = psa_wait(PSA_WAIT_ANY, PSA_BLOCK);
         if (signals & TFM_FWU_WRITE_SIGNAL) {
@@ -505,8 +618,10 @@ psa_status_t tfm_fwu_init(void)
 #else
     if (fwu_bootloader_init() != 0) {
         return PSA_ERROR_SERVICE_FAILURE;
-    } else {
-        return PSA_SUCCESS;
     }
+
+    tfm_fwu_resume();
+
+    return PSA_SUCCESS;
 #endif
 }
@@ -44,8 +44,15 @@ const struct its_flash_info_t *its_flash_get_info(enum its_flash_id_t id)
         return NULL;
     }
 
-    /* Derive num_blocks */
+    /* Derive num_blocks, excluding the blocks reserved by the flash
+     * interface
+     */
     ret->num_blocks = ret->fs_info.flash_area_size / ret->block_size;
+    if (ret->num_blocks > ret->num_reserved_blocks) {
+        ret->num_blocks -= ret->num_reserved_blocks;
+    } else {
+        ret->num_blocks = 0;
+    }
 
     /* Check that the parameters are compatible */
     if (its_flash_fs_validate_params(ret) != PSA_SUCCESS) {
@@ -95,8 +95,10 @@ struct its_flash_info_t {
      *       address range, based on block_id, offset and size, is a valid range
      *       in flash.
      *
-     * \return Returns PSA_SUCCESS if the function is executed correctly.
-     *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+     * \return Returns PSA_SUCCESS if the function is executed correctly,
+     *         PSA_ERROR_DATA_CORRUPT if the device reports an uncorrectable
+     *         error in the data read. Otherwise, it returns
+     *         PSA_ERROR_STORAGE_FAILURE.
      */
     psa_status_t (*read)(const struct its_flash_info_t *info, uint32_t block_id,
                          uint8_t *buff, size_t offset, size_t size);
@@ -115,7 +117,8 @@ struct its_flash_info_t {
      *       address range, based on block_id, offset and size, is a valid range
      *       in flash.
      *
-     * \return Returns PSA_SUCCESS if the function is executed correctly.
+     * \return Returns PSA_SUCCESS if the function is executed correctly,
+     *         PSA_ERROR_INSUFFICIENT_MEMORY if the write cannot be buffered.
      *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
      */
     psa_status_t (*write)(const struct its_flash_info_t *info,
@@ -123,16 +126,22 @@ struct its_flash_info_t {
                           size_t size);
 
     /**
-     * \brief Flushes modifications to a block to flash. Must be called after a
+     * \brief Flushes modifications to blocks to flash. Must be called after a
      *        sequence of calls to write() (including via
-     *        its_flash_block_to_block_move()) for one block ID, before any call
-     *        to the same functions for a different block ID.
+     *        its_flash_block_to_block_move()), once the data is required to be
+     *        in flash.
      *
      * \param[in] info  Flash device information
      *
      * \note It is permitted for write() to commit block updates immediately, in
      *       which case this function is a no-op.
      *
+     * \note An implementation which buffers writes may keep them until the
+     *       first byte of a block is written, as the filesystem commits each
+     *       update by writing the metadata block header last. It must then
+     *       program the first page of each block after the rest of the
+     *       buffered data.
+     *
      * \return Returns PSA_SUCCESS if the function is executed correctly.
      *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
      */
@@ -162,6 +171,11 @@ struct its_flash_info_t {
                                      *   sector_size.
                                      */
     uint16_t num_blocks;            /**< Number of logical erase blocks */
+    uint16_t num_reserved_blocks;   /**< Number of blocks at the end of the
+                                     *   flash area reserved by the flash
+                                     *   interface, not included in
+                                     *   num_blocks
+                                     */
     uint16_t program_unit;          /**< Minimum size of a program operation */
     uint16_t max_file_size;         /**< Maximum file size */
     uint16_t max_num_files;         /**< Maximum number of files */
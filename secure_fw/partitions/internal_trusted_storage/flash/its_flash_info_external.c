@@ -47,6 +47,7 @@
 #define FLASH_INFO_WRITE its_flash_ram_write
 #define FLASH_INFO_FLUSH its_flash_ram_flush
 #define FLASH_INFO_ERASE its_flash_ram_erase
+#define FLASH_INFO_RESERVED_BLOCKS 0
 
 #elif (PS_FLASH_PROGRAM_UNIT <= 16)
 #include "its_flash_nor.h"
@@ -55,6 +56,7 @@
 #define FLASH_INFO_WRITE its_flash_nor_write
 #define FLASH_INFO_FLUSH its_flash_nor_flush
 #define FLASH_INFO_ERASE its_flash_nor_erase
+#define FLASH_INFO_RESERVED_BLOCKS 0
 
 /* Require each file in the filesystem to be aligned to the program unit */
 #define PS_FLASH_ALIGNMENT PS_FLASH_PROGRAM_UNIT
@@ -67,10 +69,39 @@
 #define FLASH_INFO_FLUSH its_flash_nand_flush
 #define FLASH_INFO_ERASE its_flash_nand_erase
 
-/* The flash block is programmed in one shot, so no filesystem alignment is
- * required.
+/* Pages are programmed from the write-back cache, so no filesystem alignment
+ * is required.
  */
 #define PS_FLASH_ALIGNMENT 1
+
+/* Number of pages of the write-back cache, which can be set by the target in
+ * flash_layout.h. It must be large enough to hold the pages which are partly
+ * written during a filesystem update.
+ */
+#ifdef PS_FLASH_NAND_CACHE_PAGES
+#define FLASH_INFO_NAND_CACHE_PAGES PS_FLASH_NAND_CACHE_PAGES
+#else
+#define FLASH_INFO_NAND_CACHE_PAGES 8U
+#endif
+
+/* Number of spare blocks reserved to replace bad blocks, which can be set by
+ * the target in flash_layout.h
+ */
+#ifdef PS_FLASH_NAND_SPARE_BLOCKS
+#define FLASH_INFO_NAND_SPARE_BLOCKS PS_FLASH_NAND_SPARE_BLOCKS
+#else
+#define FLASH_INFO_NAND_SPARE_BLOCKS 2U
+#endif
+
+#if (FLASH_INFO_NAND_CACHE_PAGES < 1)
+#error "PS_FLASH_NAND_CACHE_PAGES must be at least 1"
+#endif
+#if (FLASH_INFO_NAND_SPARE_BLOCKS < 1)
+#error "PS_FLASH_NAND_SPARE_BLOCKS must be at least 1"
+#endif
+
+/* The spare blocks and the bad block table are at the end of the flash area */
+#define FLASH_INFO_RESERVED_BLOCKS (FLASH_INFO_NAND_SPARE_BLOCKS + 1)
 #endif
 
 /* Calculate the block layout */
@@ -93,7 +124,31 @@ static uint8_t ps_block_data[PS_RAM_FS_SIZE];
 #else
 /* Import the CMSIS flash device driver */
 extern ARM_DRIVER_FLASH PS_FLASH_DEV_NAME;
+#if (PS_FLASH_PROGRAM_UNIT <= 16)
 #define FLASH_INFO_DEV &PS_FLASH_DEV_NAME
+#else
+/* Allocate the write-back cache and the bad block map of the NAND device */
+static struct its_flash_nand_page_t
+    ps_nand_cache[FLASH_INFO_NAND_CACHE_PAGES];
+static uint8_t ps_nand_cache_buf[FLASH_INFO_NAND_CACHE_PAGES *
+                                 PS_FLASH_PROGRAM_UNIT];
+static uint8_t ps_nand_page_buf[PS_FLASH_PROGRAM_UNIT];
+static uint32_t ps_nand_spare_map[FLASH_INFO_NAND_SPARE_BLOCKS];
+
+static struct its_flash_nand_dev_t ps_nand_dev = {
+    .driver = &PS_FLASH_DEV_NAME,
+    .page_size = PS_FLASH_PROGRAM_UNIT,
+    .num_cache_pages = FLASH_INFO_NAND_CACHE_PAGES,
+    .cache = ps_nand_cache,
+    .cache_buf = ps_nand_cache_buf,
+    .page_buf = ps_nand_page_buf,
+    .num_spare_blocks = FLASH_INFO_NAND_SPARE_BLOCKS,
+    .spare_map = ps_nand_spare_map,
+    .num_used_spares = 0, /* Filled by its_flash_nand_init() */
+    .bbt_next_page = 0,   /* Filled by its_flash_nand_init() */
+};
+#define FLASH_INFO_DEV &ps_nand_dev
+#endif
 #endif
 
 struct its_flash_info_t its_flash_info_external = {
@@ -107,6 +162,7 @@ struct its_flash_info_t its_flash_info_external = {
     .sector_size = PS_SECTOR_SIZE,
     .block_size = FLASH_INFO_BLOCK_SIZE,
     .num_blocks = 0, /* Filled by its_flash_get_info() */
+    .num_reserved_blocks = FLASH_INFO_RESERVED_BLOCKS,
     .program_unit = PS_FLASH_ALIGNMENT,
     .max_file_size = FLASH_INFO_MAX_FILE_SIZE,
     .max_num_files = FLASH_INFO_MAX_NUM_FILES,
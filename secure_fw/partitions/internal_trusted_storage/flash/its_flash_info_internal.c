@@ -46,6 +46,7 @@
 #define FLASH_INFO_WRITE its_flash_ram_write
 #define FLASH_INFO_FLUSH its_flash_ram_flush
 #define FLASH_INFO_ERASE its_flash_ram_erase
+#define FLASH_INFO_RESERVED_BLOCKS 0
 
 #elif (ITS_FLASH_PROGRAM_UNIT <= 16)
 #include "its_flash_nor.h"
@@ -54,6 +55,7 @@
 #define FLASH_INFO_WRITE its_flash_nor_write
 #define FLASH_INFO_FLUSH its_flash_nor_flush
 #define FLASH_INFO_ERASE its_flash_nor_erase
+#define FLASH_INFO_RESERVED_BLOCKS 0
 
 /* Require each file in the filesystem to be aligned to the program unit */
 #define ITS_FLASH_ALIGNMENT ITS_FLASH_PROGRAM_UNIT
@@ -66,10 +68,39 @@
 #define FLASH_INFO_FLUSH its_flash_nand_flush
 #define FLASH_INFO_ERASE its_flash_nand_erase
 
-/* The flash block is programmed in one shot, so no filesystem alignment is
- * required.
+/* Pages are programmed from the write-back cache, so no filesystem alignment
+ * is required.
  */
 #define ITS_FLASH_ALIGNMENT 1
+
+/* Number of pages of the write-back cache, which can be set by the target in
+ * flash_layout.h. It must be large enough to hold the pages which are partly
+ * written during a filesystem update.
+ */
+#ifdef ITS_FLASH_NAND_CACHE_PAGES
+#define FLASH_INFO_NAND_CACHE_PAGES ITS_FLASH_NAND_CACHE_PAGES
+#else
+#define FLASH_INFO_NAND_CACHE_PAGES 8U
+#endif
+
+/* Number of spare blocks reserved to replace bad blocks, which can be set by
+ * the target in flash_layout.h
+ */
+#ifdef ITS_FLASH_NAND_SPARE_BLOCKS
+#define FLASH_INFO_NAND_SPARE_BLOCKS ITS_FLASH_NAND_SPARE_BLOCKS
+#else
+#define FLASH_INFO_NAND_SPARE_BLOCKS 2U
+#endif
+
+#if (FLASH_INFO_NAND_CACHE_PAGES < 1)
+#error "ITS_FLASH_NAND_CACHE_PAGES must be at least 1"
+#endif
+#if (FLASH_INFO_NAND_SPARE_BLOCKS < 1)
+#error "ITS_FLASH_NAND_SPARE_BLOCKS must be at least 1"
+#endif
+
+/* The spare blocks and the bad block table are at the end of the flash area */
+#define FLASH_INFO_RESERVED_BLOCKS (FLASH_INFO_NAND_SPARE_BLOCKS + 1)
 #endif
 
 /* Calculate the block layout */
@@ -92,7 +123,31 @@ static uint8_t its_block_data[ITS_RAM_FS_SIZE];
 #else
 /* Import the CMSIS flash device driver */
 extern ARM_DRIVER_FLASH ITS_FLASH_DEV_NAME;
+#if (ITS_FLASH_PROGRAM_UNIT <= 16)
 #define FLASH_INFO_DEV &ITS_FLASH_DEV_NAME
+#else
+/* Allocate the write-back cache and the bad block map of the NAND device */
+static struct its_flash_nand_page_t
+    its_nand_cache[FLASH_INFO_NAND_CACHE_PAGES];
+static uint8_t its_nand_cache_buf[FLASH_INFO_NAND_CACHE_PAGES *
+                                  ITS_FLASH_PROGRAM_UNIT];
+static uint8_t its_nand_page_buf[ITS_FLASH_PROGRAM_UNIT];
+static uint32_t its_nand_spare_map[FLASH_INFO_NAND_SPARE_BLOCKS];
+
+static struct its_flash_nand_dev_t its_nand_dev = {
+    .driver = &ITS_FLASH_DEV_NAME,
+    .page_size = ITS_FLASH_PROGRAM_UNIT,
+    .num_cache_pages = FLASH_INFO_NAND_CACHE_PAGES,
+    .cache = its_nand_cache,
+    .cache_buf = its_nand_cache_buf,
+    .page_buf = its_nand_page_buf,
+    .num_spare_blocks = FLASH_INFO_NAND_SPARE_BLOCKS,
+    .spare_map = its_nand_spare_map,
+    .num_used_spares = 0, /* Filled by its_flash_nand_init() */
+    .bbt_next_page = 0,   /* Filled by its_flash_nand_init() */
+};
+#define FLASH_INFO_DEV &its_nand_dev
+#endif
 #endif
 
 struct its_flash_info_t its_flash_info_internal = {
@@ -106,6 +161,7 @@ struct its_flash_info_t its_flash_info_internal = {
     .sector_size = ITS_SECTOR_SIZE,
     .block_size = FLASH_INFO_BLOCK_SIZE,
     .num_blocks = 0, /* Filled by its_flash_get_info() */
+    .num_reserved_blocks = FLASH_INFO_RESERVED_BLOCKS,
     .program_unit = ITS_FLASH_ALIGNMENT,
     .max_file_size = FLASH_INFO_MAX_FILE_SIZE,
     .max_num_files = FLASH_INFO_MAX_NUM_FILES,
@@ -7,53 +7,531 @@
  */
 
 #include "its_flash_nand.h"
-#include "driver/Driver_Flash.h"
+#include "psa/storage_common.h"
 #include "tfm_memory_utils.h"
 
-static uint32_t buf_block_id = ITS_BLOCK_INVALID_ID;
-/* FIXME: calculation duplicated from flash info */
-static uint8_t write_buf[ITS_SECTOR_SIZE * ITS_SECTORS_PER_BLOCK];
+/* Magic number of a bad block table entry */
+#define ITS_FLASH_NAND_BBT_MAGIC 0x4E424254U
+
+/* Entry of the bad block table. The table is stored in the last block of the
+ * flash area, after the spare blocks, with one entry at the start of each
+ * page. Entries are only appended, in the order the spare blocks are used.
+ */
+struct its_flash_nand_bbt_entry_t {
+    uint32_t magic;    /* ITS_FLASH_NAND_BBT_MAGIC */
+    uint32_t block_id; /* Block ID replaced by the spare block, or
+                        * ITS_BLOCK_INVALID_ID if the spare block is bad
+                        */
+    uint32_t spare;    /* Index of the spare block */
+    uint32_t check;    /* Bitwise inverse of block_id XOR spare */
+};
 
 /**
- * \brief Gets physical address of the given block ID.
+ * \brief Gets the NAND device state of the given flash device.
  *
- * \param[in] info      Flash device information
- * \param[in] block_id  Block ID
- * \param[in] offset    Offset position from the init of the block
+ * \param[in] info  Flash device information
  *
- * \returns Returns physical address for the given block ID.
+ * \returns Returns a pointer to the NAND device state.
+ */
+static struct its_flash_nand_dev_t *get_dev(const struct its_flash_info_t *info)
+{
+    return (struct its_flash_nand_dev_t *)info->flash_dev;
+}
+
+/**
+ * \brief Gets physical address of the given physical block.
+ *
+ * \param[in] info        Flash device information
+ * \param[in] phys_block  Physical block number
+ * \param[in] offset      Offset position from the init of the block
+ *
+ * \returns Returns physical address for the given block.
  */
 static uint32_t get_phys_address(const struct its_flash_info_t *info,
-                                 uint32_t block_id, size_t offset)
+                                 uint32_t phys_block, size_t offset)
 {
-    return info->fs_info.flash_area_addr + (block_id * info->block_size)
+    return info->fs_info.flash_area_addr + (phys_block * info->block_size)
             + offset;
 }
 
+/**
+ * \brief Gets the physical block which stores the given block ID, taking into
+ *        account the bad blocks replaced by spare blocks.
+ *
+ * \param[in] info      Flash device information
+ * \param[in] block_id  Block ID
+ *
+ * \returns Returns the physical block number.
+ */
+static uint32_t get_phys_block(const struct its_flash_info_t *info,
+                               uint32_t block_id)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t phys_block = block_id;
+    uint32_t i;
+
+    /* Spare blocks are used in order, so the last one which replaces the
+     * block is the current one.
+     */
+    for (i = 0; i < dev->num_used_spares; i++) {
+        if (dev->spare_map[i] == block_id) {
+            phys_block = info->num_blocks + i;
+        }
+    }
+
+    return phys_block;
+}
+
+/**
+ * \brief Checks if all bytes of the buffer have the erase value.
+ *
+ * \param[in] info  Flash device information
+ * \param[in] buff  Buffer to check
+ * \param[in] size  Size of the buffer
+ *
+ * \returns Returns true if the buffer is erased, false otherwise.
+ */
+static bool is_erased(const struct its_flash_info_t *info, const uint8_t *buff,
+                      size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        if (buff[i] != info->erase_val) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Erases a physical block.
+ *
+ * \param[in] info        Flash device information
+ * \param[in] phys_block  Physical block number
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t erase_phys_block(const struct its_flash_info_t *info,
+                                     uint32_t phys_block)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    int32_t err;
+    uint32_t addr;
+    size_t offset;
+
+    for (offset = 0; offset < info->block_size; offset += info->sector_size) {
+        addr = get_phys_address(info, phys_block, offset);
+
+        err = dev->driver->EraseSector(addr);
+        if (err != ARM_DRIVER_OK) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Loads the bad block table from flash.
+ *
+ * \param[in] info  Flash device information
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t load_bbt(const struct its_flash_info_t *info)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t bbt_block = info->num_blocks + dev->num_spare_blocks;
+    uint32_t pages_per_block = info->block_size / dev->page_size;
+    struct its_flash_nand_bbt_entry_t entry;
+    bool has_entries = false;
+    int32_t err;
+    uint32_t page;
+    uint32_t i;
+
+    for (i = 0; i < dev->num_spare_blocks; i++) {
+        dev->spare_map[i] = ITS_BLOCK_INVALID_ID;
+    }
+    dev->num_used_spares = 0;
+    dev->bbt_next_page = 0;
+
+    for (page = 0; page < pages_per_block; page++) {
+        err = dev->driver->ReadData(get_phys_address(info, bbt_block,
+                                                     page * dev->page_size),
+                                    dev->page_buf, dev->page_size);
+        if (err == ARM_DRIVER_OK) {
+            /* The first erased page is the end of the table */
+            if (is_erased(info, dev->page_buf, dev->page_size)) {
+                break;
+            }
+
+            (void)tfm_memcpy(&entry, dev->page_buf, sizeof(entry));
+
+            if ((entry.magic == ITS_FLASH_NAND_BBT_MAGIC) &&
+                (entry.check == ~(entry.block_id ^ entry.spare)) &&
+                (entry.spare < dev->num_spare_blocks) &&
+                ((entry.block_id < info->num_blocks) ||
+                 (entry.block_id == ITS_BLOCK_INVALID_ID))) {
+                dev->spare_map[entry.spare] = entry.block_id;
+                if (entry.spare >= dev->num_used_spares) {
+                    dev->num_used_spares = entry.spare + 1;
+                }
+                has_entries = true;
+            }
+        }
+
+        /* A page which is unreadable or does not hold a valid entry, for
+         * example because of a power failure while it was programmed, is
+         * skipped.
+         */
+        dev->bbt_next_page = page + 1;
+    }
+
+    /* Erase a table which does not hold any valid entry, so that entries can
+     * be appended to it.
+     */
+    if (!has_entries && (dev->bbt_next_page != 0)) {
+        dev->bbt_next_page = 0;
+        return erase_phys_block(info, bbt_block);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Appends an entry to the bad block table.
+ *
+ * \param[in] info      Flash device information
+ * \param[in] block_id  Block ID replaced by the spare block, or
+ *                      ITS_BLOCK_INVALID_ID if the spare block is bad
+ * \param[in] spare     Index of the spare block
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t append_bbt_entry(const struct its_flash_info_t *info,
+                                     uint32_t block_id, uint32_t spare)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t bbt_block = info->num_blocks + dev->num_spare_blocks;
+    uint32_t pages_per_block = info->block_size / dev->page_size;
+    struct its_flash_nand_bbt_entry_t entry;
+    uint32_t addr;
+    int32_t err;
+
+    entry.magic = ITS_FLASH_NAND_BBT_MAGIC;
+    entry.block_id = block_id;
+    entry.spare = spare;
+    entry.check = ~(block_id ^ spare);
+
+    (void)tfm_memset(dev->page_buf, info->erase_val, dev->page_size);
+    (void)tfm_memcpy(dev->page_buf, &entry, sizeof(entry));
+
+    while (dev->bbt_next_page < pages_per_block) {
+        addr = get_phys_address(info, bbt_block,
+                                dev->bbt_next_page * dev->page_size);
+
+        /* A page which fails to program is not programmed again */
+        dev->bbt_next_page++;
+
+        err = dev->driver->ProgramData(addr, dev->page_buf, dev->page_size);
+        if (err == ARM_DRIVER_OK) {
+            return PSA_SUCCESS;
+        }
+    }
+
+    return PSA_ERROR_STORAGE_FAILURE;
+}
+
+/**
+ * \brief Copies the programmed pages of a physical block to another one.
+ *
+ * \param[in] info       Flash device information
+ * \param[in] dst_block  Destination physical block, already erased
+ * \param[in] src_block  Source physical block
+ * \param[in] skip_page  Page which is not copied
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly,
+ *         PSA_ERROR_DATA_CORRUPT if the source block cannot be read.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t copy_phys_block(const struct its_flash_info_t *info,
+                                    uint32_t dst_block, uint32_t src_block,
+                                    uint32_t skip_page)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t pages_per_block = info->block_size / dev->page_size;
+    size_t offset;
+    uint32_t page;
+    int32_t err;
+
+    for (page = 0; page < pages_per_block; page++) {
+        if (page == skip_page) {
+            continue;
+        }
+
+        offset = page * dev->page_size;
+
+        err = dev->driver->ReadData(get_phys_address(info, src_block, offset),
+                                    dev->page_buf, dev->page_size);
+        if (err != ARM_DRIVER_OK) {
+            return PSA_ERROR_DATA_CORRUPT;
+        }
+
+        /* Pages which have not been programmed are left erased */
+        if (is_erased(info, dev->page_buf, dev->page_size)) {
+            continue;
+        }
+
+        err = dev->driver->ProgramData(get_phys_address(info, dst_block,
+                                                        offset),
+                                       dev->page_buf, dev->page_size);
+        if (err != ARM_DRIVER_OK) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Replaces the physical block which stores the given block ID with the
+ *        next free spare block, and records it in the bad block table.
+ *
+ * \param[in] info       Flash device information
+ * \param[in] block_id   Block ID
+ * \param[in] copy       Indicates that the programmed pages of the block
+ *                       must be copied to the spare block
+ * \param[in] skip_page  Page which is not copied, because it failed to
+ *                       program
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t replace_block(const struct its_flash_info_t *info,
+                                  uint32_t block_id, bool copy,
+                                  uint32_t skip_page)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t src_block = get_phys_block(info, block_id);
+    uint32_t dst_block;
+    uint32_t spare;
+    psa_status_t err;
+
+    while (dev->num_used_spares < dev->num_spare_blocks) {
+        spare = dev->num_used_spares;
+        dst_block = info->num_blocks + spare;
+
+        err = erase_phys_block(info, dst_block);
+        if ((err == PSA_SUCCESS) && copy) {
+            err = copy_phys_block(info, dst_block, src_block, skip_page);
+            if (err == PSA_ERROR_DATA_CORRUPT) {
+                /* The data of the bad block is lost, so it cannot be
+                 * replaced. The spare block is still free, as it is not
+                 * recorded in the bad block table.
+                 */
+                return PSA_ERROR_STORAGE_FAILURE;
+            }
+        }
+
+        dev->num_used_spares++;
+
+        /* Record the spare block as bad if it failed to erase or program, so
+         * that it is not used again after a reboot.
+         */
+        if (append_bbt_entry(info,
+                             (err == PSA_SUCCESS) ? block_id
+                                                  : ITS_BLOCK_INVALID_ID,
+                             spare) != PSA_SUCCESS) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+
+        if (err == PSA_SUCCESS) {
+            dev->spare_map[spare] = block_id;
+            return PSA_SUCCESS;
+        }
+    }
+
+    /* All spare blocks are used */
+    return PSA_ERROR_STORAGE_FAILURE;
+}
+
+/**
+ * \brief Programs a page of the given block ID. If the program operation
+ *        fails, the block is replaced by a spare block and the page is
+ *        programmed again.
+ *
+ * \param[in] info      Flash device information
+ * \param[in] block_id  Block ID
+ * \param[in] page      Page number in the block
+ * \param[in] buff      Data of the page
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t program_page(const struct its_flash_info_t *info,
+                                 uint32_t block_id, uint32_t page,
+                                 const uint8_t *buff)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t addr;
+    int32_t err;
+
+    for (;;) {
+        addr = get_phys_address(info, get_phys_block(info, block_id),
+                                page * dev->page_size);
+
+        err = dev->driver->ProgramData(addr, buff, dev->page_size);
+        if (err == ARM_DRIVER_OK) {
+            return PSA_SUCCESS;
+        }
+
+        if (replace_block(info, block_id, true, page) != PSA_SUCCESS) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+    }
+}
+
+/**
+ * \brief Gets the data buffer of a write-back cache entry.
+ *
+ * \param[in] dev  NAND device state
+ * \param[in] idx  Index of the cache entry
+ *
+ * \returns Returns a pointer to the data of the cached page.
+ */
+static uint8_t *get_cache_data(const struct its_flash_nand_dev_t *dev,
+                               uint32_t idx)
+{
+    return dev->cache_buf + (idx * dev->page_size);
+}
+
+/**
+ * \brief Gets the write-back cache entry of the given page, allocating a free
+ *        entry if the page is not in the cache.
+ *
+ * \param[in] info      Flash device information
+ * \param[in] block_id  Block ID
+ * \param[in] page      Page number in the block
+ *
+ * \returns Returns the index of the cache entry, or the number of cache pages
+ *          if the cache is full.
+ */
+static uint32_t get_cache_page(const struct its_flash_info_t *info,
+                               uint32_t block_id, uint32_t page)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t free_idx = dev->num_cache_pages;
+    uint32_t idx;
+
+    for (idx = 0; idx < dev->num_cache_pages; idx++) {
+        if (dev->cache[idx].block_id == block_id &&
+            dev->cache[idx].page == page) {
+            return idx;
+        }
+
+        if (dev->cache[idx].block_id == ITS_BLOCK_INVALID_ID &&
+            free_idx == dev->num_cache_pages) {
+            free_idx = idx;
+        }
+    }
+
+    if (free_idx < dev->num_cache_pages) {
+        dev->cache[free_idx].block_id = block_id;
+        dev->cache[free_idx].page = page;
+        dev->cache[free_idx].num_written = 0;
+        dev->cache[free_idx].has_start = false;
+        (void)tfm_memset(get_cache_data(dev, free_idx), info->erase_val,
+                         dev->page_size);
+    }
+
+    return free_idx;
+}
+
+/**
+ * \brief Programs a page of the write-back cache to flash and frees its
+ *        cache entry.
+ *
+ * \param[in] info  Flash device information
+ * \param[in] idx   Index of the cache entry
+ *
+ * \return Returns PSA_SUCCESS if the function is executed correctly.
+ *         Otherwise, it returns PSA_ERROR_STORAGE_FAILURE.
+ */
+static psa_status_t program_cache_page(const struct its_flash_info_t *info,
+                                       uint32_t idx)
+{
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    psa_status_t err;
+
+    err = program_page(info, dev->cache[idx].block_id, dev->cache[idx].page,
+                       get_cache_data(dev, idx));
+
+    dev->cache[idx].block_id = ITS_BLOCK_INVALID_ID;
+
+    return err;
+}
+
 psa_status_t its_flash_nand_init(const struct its_flash_info_t *info)
 {
+    struct its_flash_nand_dev_t *dev = get_dev(info);
     int32_t err;
+    uint32_t idx;
 
-    err = ((ARM_DRIVER_FLASH *)info->flash_dev)->Initialize(NULL);
+    err = dev->driver->Initialize(NULL);
     if (err != ARM_DRIVER_OK) {
         return PSA_ERROR_STORAGE_FAILURE;
     }
 
-    return PSA_SUCCESS;
+    for (idx = 0; idx < dev->num_cache_pages; idx++) {
+        dev->cache[idx].block_id = ITS_BLOCK_INVALID_ID;
+    }
+
+    return load_bbt(info);
 }
 
 psa_status_t its_flash_nand_read(const struct its_flash_info_t *info,
                                  uint32_t block_id, uint8_t *buff,
                                  size_t offset, size_t size)
 {
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t addr = get_phys_address(info, get_phys_block(info, block_id),
+                                     offset);
+    size_t page_start;
+    size_t start;
+    size_t end;
     int32_t err;
-    uint32_t addr = get_phys_address(info, block_id, offset);
+    uint32_t idx;
 
-    err = ((ARM_DRIVER_FLASH *)info->flash_dev)->ReadData(addr, buff, size);
-    if (err != ARM_DRIVER_OK) {
+    err = dev->driver->ReadData(addr, buff, size);
+    if (err == ITS_FLASH_NAND_ERROR_ECC) {
+        return PSA_ERROR_DATA_CORRUPT;
+    } else if (err != ARM_DRIVER_OK) {
         return PSA_ERROR_STORAGE_FAILURE;
     }
 
+    /* Overlay the data which is written but not programmed yet */
+    for (idx = 0; idx < dev->num_cache_pages; idx++) {
+        if (dev->cache[idx].block_id != block_id) {
+            continue;
+        }
+
+        page_start = dev->cache[idx].page * dev->page_size;
+        start = (offset > page_start) ? offset : page_start;
+        end = ((offset + size) < (page_start + dev->page_size)) ?
+              (offset + size) : (page_start + dev->page_size);
+
+        if (start < end) {
+            (void)tfm_memcpy(buff + (start - offset),
+                             get_cache_data(dev, idx) + (start - page_start),
+                             end - start);
+        }
+    }
+
     return PSA_SUCCESS;
 }
 
@@ -61,35 +539,106 @@ psa_status_t its_flash_nand_write(const struct its_flash_info_t *info,
                                   uint32_t block_id, const uint8_t *buff,
                                   size_t offset, size_t size)
 {
-    (void)info;
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    struct its_flash_nand_page_t *entry;
+    size_t page_offset;
+    size_t len;
+    uint32_t page;
+    uint32_t idx;
+    psa_status_t err;
 
-    if (buf_block_id == ITS_BLOCK_INVALID_ID) {
-        buf_block_id = block_id;
-    } else if (buf_block_id != block_id) {
-        return PSA_ERROR_PROGRAMMER_ERROR;
-    }
+    while (size > 0) {
+        page = offset / dev->page_size;
+        page_offset = offset % dev->page_size;
+        len = dev->page_size - page_offset;
+        if (len > size) {
+            len = size;
+        }
 
-    /* Buffer the write data */
-    (void)tfm_memcpy(write_buf + offset, buff, size);
+        idx = get_cache_page(info, block_id, page);
+        if (idx == dev->num_cache_pages) {
+            /* A page cannot be programmed before all its data is written,
+             * so the cache must be large enough for all the pages written
+             * by a filesystem update.
+             */
+            return PSA_ERROR_INSUFFICIENT_MEMORY;
+        }
+
+        entry = &dev->cache[idx];
+
+        (void)tfm_memcpy(get_cache_data(dev, idx) + page_offset, buff, len);
+        entry->num_written += len;
+        if (offset == 0) {
+            entry->has_start = true;
+        }
+
+        /* The filesystem writes each byte at most once between erases, so a
+         * complete page can be programmed straight away. The first page of a
+         * block is kept until the flush, as it holds the metadata block
+         * header which commits the update.
+         */
+        if ((entry->num_written == dev->page_size) && (page != 0)) {
+            err = program_cache_page(info, idx);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+
+        buff += len;
+        offset += len;
+        size -= len;
+    }
 
     return PSA_SUCCESS;
 }
 
 psa_status_t its_flash_nand_flush(const struct its_flash_info_t *info)
 {
-    int32_t err;
-    uint32_t addr = get_phys_address(info, buf_block_id, 0);
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    psa_status_t err = PSA_SUCCESS;
+    bool has_start = false;
+    uint32_t pass;
+    uint32_t idx;
 
-    /* Flush the buffered write data to flash*/
-    err = ((ARM_DRIVER_FLASH *)info->flash_dev)->ProgramData(addr, write_buf,
-                                                             info->block_size);
-    if (err != ARM_DRIVER_OK) {
-        return PSA_ERROR_STORAGE_FAILURE;
+    /* The filesystem commits an update by writing the metadata block header,
+     * at the start of the block, last. Until then, the cached pages may still
+     * be written by the update, so they are kept in the cache.
+     */
+    for (idx = 0; idx < dev->num_cache_pages; idx++) {
+        if (dev->cache[idx].block_id != ITS_BLOCK_INVALID_ID &&
+            dev->cache[idx].has_start) {
+            has_start = true;
+        }
+    }
+
+    if (!has_start) {
+        return PSA_SUCCESS;
     }
 
-    /* Clear the write buffer */
-    (void)tfm_memset(write_buf, 0, sizeof(write_buf));
-    buf_block_id = ITS_BLOCK_INVALID_ID;
+    /* Program the pages in three passes: the pages other than the first page
+     * of a block, then the first pages which do not hold a metadata block
+     * header, and finally the first page which commits the update.
+     */
+    for (pass = 0; pass < 3; pass++) {
+        for (idx = 0; idx < dev->num_cache_pages; idx++) {
+            if (dev->cache[idx].block_id == ITS_BLOCK_INVALID_ID) {
+                continue;
+            }
+
+            if ((pass == 0 && dev->cache[idx].page != 0) ||
+                (pass == 1 && dev->cache[idx].page == 0 &&
+                 !dev->cache[idx].has_start) ||
+                (pass == 2)) {
+                if (program_cache_page(info, idx) != PSA_SUCCESS) {
+                    err = PSA_ERROR_STORAGE_FAILURE;
+                }
+            }
+        }
+
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
 
     return PSA_SUCCESS;
 }
@@ -97,18 +646,20 @@ psa_status_t its_flash_nand_flush(const struct its_flash_info_t *info)
 psa_status_t its_flash_nand_erase(const struct its_flash_info_t *info,
                                   uint32_t block_id)
 {
-    int32_t err;
-    uint32_t addr;
-    size_t offset;
-
-    for (offset = 0; offset < info->block_size; offset += info->sector_size) {
-        addr = get_phys_address(info, block_id, offset);
+    struct its_flash_nand_dev_t *dev = get_dev(info);
+    uint32_t idx;
 
-        err = ((ARM_DRIVER_FLASH *)info->flash_dev)->EraseSector(addr);
-        if (err != ARM_DRIVER_OK) {
-            return PSA_ERROR_STORAGE_FAILURE;
+    /* Discard the writes to the block which are not programmed yet */
+    for (idx = 0; idx < dev->num_cache_pages; idx++) {
+        if (dev->cache[idx].block_id == block_id) {
+            dev->cache[idx].block_id = ITS_BLOCK_INVALID_ID;
         }
     }
 
+    if (erase_phys_block(info, get_phys_block(info, block_id)) != PSA_SUCCESS) {
+        /* Replace the bad block with an erased spare block */
+        return replace_block(info, block_id, false, 0);
+    }
+
     return PSA_SUCCESS;
 }
@@ -12,7 +12,64 @@
  *        device. See its_flash.h for full documentation of functions.
  */
 
+#include <stdbool.h>
+
 #include "its_flash.h"
+#include "driver/Driver_Flash.h"
+
+/**
+ * \brief Driver specific error code returned by the ReadData() function of the
+ *        CMSIS flash driver when the data read contains an uncorrectable ECC
+ *        error.
+ */
+#define ITS_FLASH_NAND_ERROR_ECC (ARM_DRIVER_ERROR_SPECIFIC - 1)
+
+/**
+ * \struct its_flash_nand_page_t
+ *
+ * \brief Structure to store the state of a page in the write-back cache.
+ */
+struct its_flash_nand_page_t {
+    uint32_t block_id;  /**< Block ID of the page, or ITS_BLOCK_INVALID_ID if
+                         *   the cache entry is free
+                         */
+    uint32_t page;      /**< Page number in the block */
+    size_t num_written; /**< Number of bytes of the page written */
+    bool has_start;     /**< Indicates that the first byte of the block has
+                         *   been written
+                         */
+};
+
+/**
+ * \struct its_flash_nand_dev_t
+ *
+ * \brief Structure to store the state of a NAND flash device. It is pointed to
+ *        by the flash_dev field of the flash info structure.
+ */
+struct its_flash_nand_dev_t {
+    ARM_DRIVER_FLASH *driver;     /**< CMSIS flash driver of the device */
+    size_t page_size;             /**< Size of the device's physical program
+                                   *   unit
+                                   */
+    uint32_t num_cache_pages;     /**< Number of pages in the write-back
+                                   *   cache
+                                   */
+    struct its_flash_nand_page_t *cache; /**< Write-back cache entries */
+    uint8_t *cache_buf;           /**< Data of the write-back cache pages,
+                                   *   num_cache_pages * page_size bytes
+                                   */
+    uint8_t *page_buf;            /**< Buffer of page_size bytes used to copy
+                                   *   a bad block to its replacement
+                                   */
+    uint32_t num_spare_blocks;    /**< Number of spare blocks reserved to
+                                   *   replace bad blocks
+                                   */
+    uint32_t *spare_map;          /**< Block ID replaced by each spare block,
+                                   *   or ITS_BLOCK_INVALID_ID
+                                   */
+    uint32_t num_used_spares;     /**< Number of spare blocks used */
+    uint32_t bbt_next_page;       /**< Next free page of the bad block table */
+};
 
 /**
  * \brief Initialize the Flash Interface.
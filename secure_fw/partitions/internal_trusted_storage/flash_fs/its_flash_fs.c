@@ -22,44 +22,40 @@
 static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
                                             uint32_t del_file_idx);
 
-static psa_status_t its_flash_fs_file_write_aligned_data(
-                                      struct its_flash_fs_ctx_t *fs_ctx,
-                                      const struct its_block_meta_t *block_meta,
-                                      const struct its_file_meta_t *file_meta,
-                                      size_t offset,
-                                      size_t size,
-                                      const uint8_t *data)
+/**
+ * \brief Deletes all the files marked for deletion.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_delete_flagged(
+                                             struct its_flash_fs_ctx_t *fs_ctx)
 {
-#if (ITS_FLASH_MAX_ALIGNMENT != 1)
-    /* Check that the offset is aligned with the flash program unit */
-    if (!ITS_UTILS_IS_ALIGNED(offset, fs_ctx->flash_info->program_unit)) {
-        return PSA_ERROR_INVALID_ARGUMENT;
-    }
-
-    /* Set the size to be aligned with the flash program unit */
-    size = ITS_UTILS_ALIGN(size, fs_ctx->flash_info->program_unit);
-#endif
+    psa_status_t err;
+    uint32_t idx;
 
-    /* It is not permitted to create gaps in the file */
-    if (offset > file_meta->cur_size) {
-        return PSA_ERROR_INVALID_ARGUMENT;
-    }
+    for (;;) {
+        err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
+                                                    ITS_FLASH_FS_FLAG_DELETE,
+                                                    &idx);
+        if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            return PSA_SUCCESS;
+        } else if (err != PSA_SUCCESS) {
+            return err;
+        }
 
-    /* Check that the new data is contained within the file's max size */
-    if (its_utils_check_contained_in(file_meta->max_size, offset, size)
-        != PSA_SUCCESS) {
-        return PSA_ERROR_INVALID_ARGUMENT;
+        err = its_flash_fs_delete_idx(fs_ctx, idx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
     }
-
-    return its_flash_fs_dblock_write_file(fs_ctx, block_meta, file_meta, offset,
-                                          size, data);
 }
 
 psa_status_t its_flash_fs_prepare(struct its_flash_fs_ctx_t *fs_ctx,
                                   const struct its_flash_info_t *flash_info)
 {
     psa_status_t err;
-    uint32_t idx;
 
     /* Check for valid flash_info */
     if (!flash_info) {
@@ -75,18 +71,10 @@ psa_status_t its_flash_fs_prepare(struct its_flash_fs_ctx_t *fs_ctx,
         return err;
     }
 
-    /* Check if a file marked for deletion has been left behind by a power
-     * failure. If so, delete it.
+    /* Delete any files marked for deletion that have been left behind by a
+     * power failure. There can be several after a file replacement.
      */
-    err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
-                                                ITS_FLASH_FS_FLAG_DELETE, &idx);
-    if (err == PSA_SUCCESS) {
-        return its_flash_fs_delete_idx(fs_ctx, idx);
-    } else if (err != PSA_ERROR_DOES_NOT_EXIST) {
-        return err;
-    }
-
-    return PSA_SUCCESS;
+    return its_flash_fs_delete_flagged(fs_ctx);
 }
 
 psa_status_t its_flash_fs_wipe_all(struct its_flash_fs_ctx_t *fs_ctx)
@@ -119,7 +107,9 @@ psa_status_t its_flash_fs_file_get_info(struct its_flash_fs_ctx_t *fs_ctx,
 
     /* Get the meta data index */
     err = its_flash_fs_mblock_get_file_idx(fs_ctx, fid, &idx);
-    if (err != PSA_SUCCESS) {
+    if (err == PSA_ERROR_DATA_CORRUPT) {
+        return err;
+    } else if (err != PSA_SUCCESS) {
         return PSA_ERROR_DOES_NOT_EXIST;
     }
 
@@ -149,13 +139,29 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
                                      size_t offset,
                                      const uint8_t *data)
 {
-    struct its_block_meta_t block_meta;
-    struct its_file_meta_t file_meta;
-    uint32_t cur_phys_block;
     psa_status_t err;
-    uint32_t idx;
-    uint32_t old_idx = ITS_METADATA_INVALID_INDEX;
-    uint32_t new_idx = ITS_METADATA_INVALID_INDEX;
+
+    err = its_flash_fs_file_write_start(fs_ctx, fid, flags, max_size, offset);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_file_write_data(fs_ctx, data_size, data);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return its_flash_fs_file_write_end(fs_ctx);
+}
+
+psa_status_t its_flash_fs_file_write_start(struct its_flash_fs_ctx_t *fs_ctx,
+                                           const uint8_t *fid,
+                                           uint32_t flags,
+                                           size_t max_size,
+                                           size_t offset)
+{
+    struct its_flash_fs_write_t *write = &fs_ctx->write;
+    psa_status_t err;
     bool use_spare;
 
     /* Do not permit the user to pass filesystem-internal flags */
@@ -168,40 +174,47 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
     max_size = ITS_UTILS_ALIGN(max_size, fs_ctx->flash_info->program_unit);
 #endif
 
+    write->old_idx = ITS_METADATA_INVALID_INDEX;
+    write->new_idx = ITS_METADATA_INVALID_INDEX;
+    write->offset = offset;
+    write->data_started = false;
+    write->in_progress = false;
+
     /* Check if the file already exists */
-    err = its_flash_fs_mblock_get_file_idx(fs_ctx, fid, &old_idx);
+    err = its_flash_fs_mblock_get_file_idx(fs_ctx, fid, &write->old_idx);
     if (err == PSA_SUCCESS) {
         /* Read existing file metadata */
-        err = its_flash_fs_mblock_read_file_meta(fs_ctx, old_idx, &file_meta);
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, write->old_idx,
+                                                 &write->file_meta);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_DOES_NOT_EXIST;
         }
 
         if (flags & ITS_FLASH_FS_FLAG_TRUNCATE) {
-            if (file_meta.max_size == max_size) {
+            if (write->file_meta.max_size == max_size) {
                 /* Truncate and reuse the existing file, which is already the
                  * correct size.
                  */
-                file_meta.cur_size = 0;
-                file_meta.flags = flags;
-                new_idx = old_idx;
+                write->file_meta.cur_size = 0;
+                write->file_meta.flags = flags;
+                write->new_idx = write->old_idx;
             } else {
                 /* Mark the existing file to be deleted in this block update. It
                  * will be deleted in a second block update, and if there is a
                  * power failure before that block update completes, then
                  * deletion will be re-attempted based on this flag.
                  */
-                file_meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
+                write->file_meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
                 err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx,
-                                                                   old_idx,
-                                                                   &file_meta);
+                                                             write->old_idx,
+                                                             &write->file_meta);
                 if (err != PSA_SUCCESS) {
                     return PSA_ERROR_GENERIC_ERROR;
                 }
             }
         } else {
             /* Write to existing file */
-            new_idx = old_idx;
+            write->new_idx = write->old_idx;
         }
     } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
         /* The create flag must be supplied to create a new file */
@@ -213,68 +226,151 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
     }
 
     /* If the existing file was not reused, then a new one must be reserved */
-    if (new_idx == ITS_METADATA_INVALID_INDEX) {
+    if (write->new_idx == ITS_METADATA_INVALID_INDEX) {
         /* Check that the file's maximum size is valid */
         if (max_size > fs_ctx->flash_info->max_file_size) {
             return PSA_ERROR_INVALID_ARGUMENT;
         }
 
         /* Only use the spare file if there is an old file to be deleted */
-        use_spare = (old_idx != ITS_METADATA_INVALID_INDEX);
+        use_spare = (write->old_idx != ITS_METADATA_INVALID_INDEX);
 
         /* Try to reserve a new file based on the input parameters */
         err = its_flash_fs_mblock_reserve_file(fs_ctx, fid, use_spare,
-                                               max_size, flags, &new_idx,
-                                               &file_meta, &block_meta);
+                                               max_size, flags,
+                                               &write->new_idx,
+                                               &write->file_meta,
+                                               &write->block_meta);
         if (err != PSA_SUCCESS) {
             return err;
         }
     } else {
         /* Read existing block metadata */
-        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, file_meta.lblock,
-                                                      &block_meta);
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
+                                                      write->file_meta.lblock,
+                                                      &write->block_meta);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
         }
     }
 
-    if (data_size != 0) {
-        /* Write the content into scratch data block */
-        err = its_flash_fs_file_write_aligned_data(fs_ctx, &block_meta,
-                                                   &file_meta, offset,
-                                                   data_size, data);
+    write->in_progress = true;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_file_write_data(struct its_flash_fs_ctx_t *fs_ctx,
+                                          size_t data_size,
+                                          const uint8_t *data)
+{
+    struct its_flash_fs_write_t *write = &fs_ctx->write;
+    struct its_file_meta_t *file_meta = &write->file_meta;
+    size_t size = data_size;
+    psa_status_t err;
+
+    if (!write->in_progress) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (data_size == 0) {
+        return PSA_SUCCESS;
+    }
+
+    /* The write is cancelled if the data cannot be written */
+    write->in_progress = false;
+
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+    /* Check that the offset is aligned with the flash program unit */
+    if (!ITS_UTILS_IS_ALIGNED(write->offset,
+                              fs_ctx->flash_info->program_unit)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Set the size to be aligned with the flash program unit */
+    size = ITS_UTILS_ALIGN(size, fs_ctx->flash_info->program_unit);
+#endif
+
+    /* It is not permitted to create gaps in the file */
+    if (write->offset > file_meta->cur_size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check that the new data is contained within the file's max size */
+    if (its_utils_check_contained_in(file_meta->max_size, write->offset, size)
+        != PSA_SUCCESS) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!write->data_started) {
+        /* Copy the block data before the file data into the scratch block */
+        err = its_flash_fs_dblock_write_file_start(fs_ctx, &write->block_meta,
+                                                   file_meta, write->offset);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
         }
 
-        /* Update the file's current size if required */
-        if (offset + data_size > file_meta.cur_size) {
-            /* Update the file metadata */
-            file_meta.cur_size = offset + data_size;
-        }
+        write->data_started = true;
+    }
 
-        cur_phys_block = block_meta.phy_id;
+    /* Write the content into scratch data block */
+    err = its_flash_fs_dblock_write_file_data(fs_ctx, file_meta, write->offset,
+                                              size, data);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
 
-        /* Cur scratch block become the active datablock */
-        block_meta.phy_id =
-            its_flash_fs_mblock_cur_data_scratch_id(fs_ctx, file_meta.lblock);
+    write->offset += data_size;
 
-        /* Swap the scratch data block */
-        its_flash_fs_mblock_set_data_scratch(fs_ctx, cur_phys_block,
-                                             file_meta.lblock);
+    /* Update the file's current size if required */
+    if (write->offset > file_meta->cur_size) {
+        file_meta->cur_size = write->offset;
+    }
+
+    write->in_progress = true;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_file_write_end(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_flash_fs_write_t *write = &fs_ctx->write;
+    struct its_block_meta_t *block_meta = &write->block_meta;
+    struct its_file_meta_t *file_meta = &write->file_meta;
+    psa_status_t err;
+    uint32_t idx;
+    uint32_t old_idx = write->old_idx;
+    uint32_t new_idx = write->new_idx;
+
+    if (!write->in_progress) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    write->in_progress = false;
+
+    if (write->data_started) {
+        /* Copy the block data after the file into the scratch block */
+        err = its_flash_fs_dblock_write_file_end(fs_ctx, block_meta,
+                                                 file_meta);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        /* Cur scratch block become the active datablock */
+        its_flash_fs_mblock_swap_data_scratch(fs_ctx, file_meta->lblock,
+                                              block_meta);
     }
 
     /* Update block metadata in scratch metadata block */
     err = its_flash_fs_mblock_update_scratch_block_meta(fs_ctx,
-                                                        file_meta.lblock,
-                                                        &block_meta);
+                                                        file_meta->lblock,
+                                                        block_meta);
     if (err != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
     /* Write file metadata in the scratch metadata block */
     err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx, new_idx,
-                                                       &file_meta);
+                                                       file_meta);
     if (err != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
@@ -314,7 +410,7 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
      * located in the logical block 0, that copy has been done while processing
      * the file data.
      */
-    if ((file_meta.lblock != ITS_LOGICAL_DBLOCK0) || (data_size == 0)) {
+    if ((file_meta->lblock != ITS_LOGICAL_DBLOCK0) || !write->data_started) {
         err = its_flash_fs_mblock_migrate_lb0_data_to_scratch(fs_ctx);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
@@ -394,9 +490,11 @@ static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
         if ((file_meta.lblock == del_file_lblock) &&
             (its_utils_validate_fid(file_meta.id) == PSA_SUCCESS)) {
             /* If a file is located after the data to delete, this
-             * needs to be moved.
+             * needs to be moved. A deleted file with no data can share its
+             * data index with the following file.
              */
-            if (file_meta.data_idx > del_file_data_idx) {
+            if (file_meta.data_idx >= (del_file_data_idx +
+                                       del_file_max_size)) {
                 /* Check if this is the position after the deleted
                  * data. This will be the first file data to move.
                  */
@@ -466,6 +564,101 @@ psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
     return its_flash_fs_delete_idx(fs_ctx, del_file_idx);
 }
 
+psa_status_t its_flash_fs_file_replace(struct its_flash_fs_ctx_t *fs_ctx,
+                                       const struct its_flash_fs_replace_t *ops,
+                                       uint32_t num_ops)
+{
+    psa_status_t err;
+    uint32_t i;
+    uint32_t idx;
+    struct its_file_meta_t file_meta;
+    struct its_block_meta_t block_meta;
+
+    /* Any write in progress would be lost by this block update */
+    fs_ctx->write.in_progress = false;
+
+    /* Check that all the replacement files exist before changing anything */
+    for (i = 0; i < num_ops; i++) {
+        if (ops[i].src_fid != NULL) {
+            err = its_flash_fs_mblock_get_file_idx(fs_ctx, ops[i].src_fid,
+                                                   &idx);
+            if (err != PSA_SUCCESS) {
+                return PSA_ERROR_DOES_NOT_EXIST;
+            }
+        }
+    }
+
+    /* Rename the files in the scratch metadata block. A replaced file takes
+     * the ID of its replacement, so that file IDs remain unique, and is marked
+     * to be deleted once the block update has completed.
+     */
+    for (idx = 0; idx < fs_ctx->flash_info->max_num_files; idx++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, idx, &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if ((its_utils_validate_fid(file_meta.id) == PSA_SUCCESS) &&
+            !(file_meta.flags & ITS_FLASH_FS_FLAG_DELETE)) {
+            for (i = 0; i < num_ops; i++) {
+                if (tfm_memcmp(file_meta.id, ops[i].fid,
+                               ITS_FILE_ID_SIZE) == 0) {
+                    if (ops[i].src_fid != NULL) {
+                        tfm_memcpy(file_meta.id, ops[i].src_fid,
+                                   ITS_FILE_ID_SIZE);
+                    }
+                    file_meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
+                    break;
+                }
+
+                if ((ops[i].src_fid != NULL) &&
+                    (tfm_memcmp(file_meta.id, ops[i].src_fid,
+                                ITS_FILE_ID_SIZE) == 0)) {
+                    tfm_memcpy(file_meta.id, ops[i].fid, ITS_FILE_ID_SIZE);
+                    break;
+                }
+            }
+        }
+
+        err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx, idx,
+                                                           &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* The block metadata is unchanged, so copy it to the scratch metadata
+     * block.
+     */
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                                  &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_mblock_update_scratch_block_meta(fs_ctx,
+                                                        ITS_LOGICAL_DBLOCK0,
+                                                        &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Copy the file data in the logical block 0 to the scratch block */
+    err = its_flash_fs_mblock_migrate_lb0_data_to_scratch(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Write metadata header, swap metadata blocks and erase scratch blocks */
+    err = its_flash_fs_mblock_meta_update_finalize(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Delete the replaced files in further block updates */
+    return its_flash_fs_delete_flagged(fs_ctx);
+}
+
 psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
                                     const uint8_t *fid,
                                     size_t size,
@@ -478,13 +671,19 @@ psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
 
     /* Get the file index */
     err = its_flash_fs_mblock_get_file_idx(fs_ctx, fid, &idx);
-    if (err != PSA_SUCCESS) {
+    if (err == PSA_ERROR_DATA_CORRUPT) {
+        return err;
+    } else if (err != PSA_SUCCESS) {
         return PSA_ERROR_DOES_NOT_EXIST;
     }
 
-    /* Read file metadata */
+    /* Read file metadata, reporting uncorrectable errors of the flash
+     * device to the caller
+     */
     err = its_flash_fs_mblock_read_file_meta(fs_ctx, idx, &tmp_metadata);
-    if (err != PSA_SUCCESS) {
+    if (err == PSA_ERROR_DATA_CORRUPT) {
+        return err;
+    } else if (err != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
@@ -502,7 +701,9 @@ psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
     /* Read the file from flash */
     err = its_flash_fs_dblock_read_file(fs_ctx, &tmp_metadata, offset, size,
                                         data);
-    if (err != PSA_SUCCESS) {
+    if (err == PSA_ERROR_DATA_CORRUPT) {
+        return err;
+    } else if (err != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
@@ -570,6 +771,15 @@ psa_status_t its_flash_fs_validate_params(const struct its_flash_info_t *info)
         ret = PSA_ERROR_STORAGE_FAILURE;
     }
 
+    /* The space of the metadata block header is left erased in the dedicated
+     * data blocks.
+     */
+    if ((info->num_blocks > 2) &&
+        (info->max_file_size > info->block_size
+                               - sizeof(struct its_metadata_block_header_t))) {
+        ret = PSA_ERROR_STORAGE_FAILURE;
+    }
+
     /* Metadata must fit in a flash block */
     if (its_flash_fs_all_metadata_size(info) > info->block_size) {
         ret = PSA_ERROR_STORAGE_FAILURE;
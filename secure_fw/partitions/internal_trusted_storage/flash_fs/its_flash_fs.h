@@ -64,6 +64,20 @@ struct its_file_info_t {
     uint32_t flags;      /*!< Flags set when the file was created */
 };
 
+/*!
+ * \struct its_flash_fs_replace_t
+ *
+ * \brief Structure to describe one file change of a file replacement.
+ */
+struct its_flash_fs_replace_t {
+    const uint8_t *fid;     /*!< ID of the file to replace or delete. It is
+                             *   not required to exist.
+                             */
+    const uint8_t *src_fid; /*!< ID of the existing file which takes the ID
+                             *   fid, or NULL to delete the file fid.
+                             */
+};
+
 /**
  * \brief Prepares the filesystem to accept operations on the files.
  *
@@ -72,7 +86,9 @@ struct its_file_info_t {
  * \param[in]     flash_info  Struct containing information about the flash
  *                            device to associate with the context.
  *
- * \return Returns error code as specified in \ref psa_status_t
+ * \return Returns error code as specified in \ref psa_status_t. Returns
+ *         PSA_ERROR_NOT_SUPPORTED if the flash holds a filesystem of the
+ *         previous layout, which must not be wiped.
  */
 psa_status_t its_flash_fs_prepare(its_flash_fs_ctx_t *fs_ctx,
                                   const struct its_flash_info_t *flash_info);
@@ -137,6 +153,59 @@ psa_status_t its_flash_fs_file_write(its_flash_fs_ctx_t *fs_ctx,
                                      size_t offset,
                                      const uint8_t *data);
 
+/**
+ * \brief Starts writing data to a file, in one or more chunks which are
+ *        committed together by \ref its_flash_fs_file_write_end.
+ *
+ * \details The chunks are written in the scratch data block and the file
+ *          metadata is updated once, so that the write costs a single metadata
+ *          block swap whatever the number of chunks.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     fid       File ID
+ * \param[in]     flags     Flags of the file
+ * \param[in]     max_size  Maximum size of the file to be created. Ignored if
+ *                          the file is not being created.
+ * \param[in]     offset    Offset in the file where the first chunk is
+ *                          written. Must be less than or equal to the current
+ *                          file size.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_file_write_start(its_flash_fs_ctx_t *fs_ctx,
+                                           const uint8_t *fid,
+                                           uint32_t flags,
+                                           size_t max_size,
+                                           size_t offset);
+
+/**
+ * \brief Writes a chunk of data to the file being written, following the
+ *        previous chunk.
+ *
+ * \note The file write is cancelled if an error is returned.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     data_size  Size of the incoming write data. All chunks, except
+ *                           the last one, must be a multiple of the flash
+ *                           program unit.
+ * \param[in]     data       Pointer to buffer containing data to be written
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_file_write_data(its_flash_fs_ctx_t *fs_ctx,
+                                          size_t data_size,
+                                          const uint8_t *data);
+
+/**
+ * \brief Ends the file write by committing the data written to the file
+ *        metadata.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_file_write_end(its_flash_fs_ctx_t *fs_ctx);
+
 /**
  * \brief Reads data from an existing file.
  *
@@ -165,6 +234,26 @@ psa_status_t its_flash_fs_file_read(its_flash_fs_ctx_t *fs_ctx,
 psa_status_t its_flash_fs_file_delete(its_flash_fs_ctx_t *fs_ctx,
                                       const uint8_t *fid);
 
+/**
+ * \brief Replaces and deletes a set of files atomically.
+ *
+ * \details All the files are renamed in a single metadata block update, so
+ *          after a power failure either all or none of the changes have been
+ *          made. The replaced and deleted files are then removed from the
+ *          filesystem, one block update per file. Files left behind by a power
+ *          failure are removed by \ref its_flash_fs_prepare.
+ *
+ * \param[in,out] fs_ctx   Filesystem context
+ * \param[in]     ops      Array of file changes. Each file ID must appear at
+ *                         most once in the array.
+ * \param[in]     num_ops  Number of entries in the ops array
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_file_replace(its_flash_fs_ctx_t *fs_ctx,
+                                       const struct its_flash_fs_replace_t *ops,
+                                       uint32_t num_ops);
+
 /**
  * \brief Validates the configuration of the flash filesystem.
  *
@@ -86,17 +86,14 @@ psa_status_t its_flash_fs_dblock_compact_block(
      * to compact so that deleted file is left in scratch and erased as part
      * of finalization.
      */
-    its_flash_fs_mblock_set_data_scratch(fs_ctx, block_meta.phy_id, lblock);
-
-    /* Set scratch block ID as the one which contains the new data block */
-    block_meta.phy_id = scratch_id;
+    its_flash_fs_mblock_swap_data_scratch(fs_ctx, lblock, &block_meta);
 
     /* Update block metadata in scratch metadata block */
     err = its_flash_fs_mblock_update_scratch_block_meta(fs_ctx, lblock,
                                                         &block_meta);
     if (err != PSA_SUCCESS) {
         /* Swap back the data block as there was an issue in the process */
-        its_flash_fs_mblock_set_data_scratch(fs_ctx, scratch_id, lblock);
+        its_flash_fs_mblock_swap_data_scratch(fs_ctx, lblock, &block_meta);
         return err;
     }
 
@@ -132,18 +129,14 @@ psa_status_t its_flash_fs_dblock_read_file(
                                     size);
 }
 
-psa_status_t its_flash_fs_dblock_write_file(
+psa_status_t its_flash_fs_dblock_write_file_start(
                                       struct its_flash_fs_ctx_t *fs_ctx,
                                       const struct its_block_meta_t *block_meta,
                                       const struct its_file_meta_t *file_meta,
-                                      size_t offset,
-                                      size_t size,
-                                      const uint8_t *data)
+                                      size_t offset)
 {
-    psa_status_t err;
     uint32_t scratch_id;
     size_t pos;
-    size_t num_bytes;
 
     scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
                                                          file_meta->lblock);
@@ -152,22 +145,43 @@ psa_status_t its_flash_fs_dblock_write_file(
     pos = file_meta->data_idx + offset;
 
     /* Move data up to the new file data position */
-    err = its_flash_block_to_block_move(fs_ctx->flash_info,
-                                        scratch_id,
-                                        block_meta->data_start,
-                                        block_meta->phy_id,
-                                        block_meta->data_start,
-                                        pos - block_meta->data_start);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
+    return its_flash_block_to_block_move(fs_ctx->flash_info,
+                                         scratch_id,
+                                         block_meta->data_start,
+                                         block_meta->phy_id,
+                                         block_meta->data_start,
+                                         pos - block_meta->data_start);
+}
+
+psa_status_t its_flash_fs_dblock_write_file_data(
+                                        struct its_flash_fs_ctx_t *fs_ctx,
+                                        const struct its_file_meta_t *file_meta,
+                                        size_t offset,
+                                        size_t size,
+                                        const uint8_t *data)
+{
+    uint32_t scratch_id;
+
+    scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                         file_meta->lblock);
 
     /* Write the new file data */
-    err = fs_ctx->flash_info->write(fs_ctx->flash_info, scratch_id, data, pos,
-                                    size);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
+    return fs_ctx->flash_info->write(fs_ctx->flash_info, scratch_id, data,
+                                     file_meta->data_idx + offset, size);
+}
+
+psa_status_t its_flash_fs_dblock_write_file_end(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_block_meta_t *block_meta,
+                                      const struct its_file_meta_t *file_meta)
+{
+    psa_status_t err;
+    uint32_t scratch_id;
+    size_t pos;
+    size_t num_bytes;
+
+    scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                         file_meta->lblock);
 
     /* Calculate the position of the end of the file */
     pos = file_meta->data_idx + file_meta->max_size;
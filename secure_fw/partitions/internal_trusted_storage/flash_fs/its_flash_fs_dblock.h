@@ -59,27 +59,58 @@ psa_status_t its_flash_fs_dblock_read_file(
                                         uint8_t *buf);
 
 /**
- * \brief Writes scratch data block content with requested data and the rest of
- *        the data from the given logical block.
+ * \brief Starts writing a file in the scratch data block, by copying the data
+ *        of the given logical block which is before the incoming data.
  *
  * \param[in,out] fs_ctx      Filesystem context
  * \param[in]     block_meta  Block metadata
  * \param[in]     file_meta   File metadata
- * \param[in]     offset      Offset in the scratch data block where to start
- *                            the copy of the incoming data
- * \param[in]     size        Size of the incoming data
- * \param[in]     data        Pointer to data buffer to copy in the scratch data
- *                            block
+ * \param[in]     offset      Offset in the file where the incoming data starts
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-psa_status_t its_flash_fs_dblock_write_file(
+psa_status_t its_flash_fs_dblock_write_file_start(
                                       struct its_flash_fs_ctx_t *fs_ctx,
                                       const struct its_block_meta_t *block_meta,
                                       const struct its_file_meta_t *file_meta,
-                                      size_t offset,
-                                      size_t size,
-                                      const uint8_t *data);
+                                      size_t offset);
+
+/**
+ * \brief Writes incoming file data in the scratch data block.
+ *
+ * \note The data must follow the data written since the write of the file
+ *       started, as the scratch data block is only programmed once.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     file_meta  File metadata
+ * \param[in]     offset     Offset in the file where to write the data
+ * \param[in]     size       Size of the incoming data
+ * \param[in]     data       Pointer to data buffer to copy in the scratch data
+ *                           block
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_dblock_write_file_data(
+                                        struct its_flash_fs_ctx_t *fs_ctx,
+                                        const struct its_file_meta_t *file_meta,
+                                        size_t offset,
+                                        size_t size,
+                                        const uint8_t *data);
+
+/**
+ * \brief Ends writing a file in the scratch data block, by copying the data of
+ *        the given logical block which is after the file.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     block_meta  Block metadata
+ * \param[in]     file_meta   File metadata
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_dblock_write_file_end(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_block_meta_t *block_meta,
+                                      const struct its_file_meta_t *file_meta);
 
 #ifdef __cplusplus
 }
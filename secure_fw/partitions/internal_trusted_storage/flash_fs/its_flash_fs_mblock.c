@@ -10,26 +10,35 @@
 #include "psa/storage_common.h"
 #include "tfm_memory_utils.h"
 
-/* Physical ID of the two metadata blocks */
+/* Physical ID of the two metadata blocks when the filesystem is created */
 /* NOTE: the earmarked area may not always start at block number 0.
  *       However, the flash interface can always add the required offset.
  */
 #define ITS_METADATA_BLOCK0  0
 #define ITS_METADATA_BLOCK1  1
 
-/*!
- * \def ITS_OTHER_META_BLOCK
- *
- * \brief Macro to get the the swap metadata block.
- */
-#define ITS_OTHER_META_BLOCK(metablock) \
-(((metablock) == ITS_METADATA_BLOCK0) ? \
-(ITS_METADATA_BLOCK1) : (ITS_METADATA_BLOCK0))
-
 #define ITS_BLOCK_META_HEADER_SIZE  sizeof(struct its_metadata_block_header_t)
 #define ITS_BLOCK_METADATA_SIZE     sizeof(struct its_block_meta_t)
 #define ITS_FILE_METADATA_SIZE      sizeof(struct its_file_meta_t)
 
+/* Offset of the data in the dedicated data blocks. The metadata blocks move
+ * across all the blocks, so the space of the metadata block header is left
+ * erased in the data blocks to never find a valid header in them.
+ */
+#define ITS_DBLOCK_DATA_START       ITS_BLOCK_META_HEADER_SIZE
+
+/* Version of the filesystem layout with the metadata blocks fixed at
+ * ITS_METADATA_BLOCK0 and ITS_METADATA_BLOCK1.
+ */
+#define ITS_FIXED_MBLOCK_VERSION    0x01
+
+/* Leading fields of the metadata block header of that layout */
+struct its_fixed_mblock_header_t {
+    uint32_t scratch_dblock;
+    uint8_t fs_version;
+    uint8_t active_swap_count;
+};
+
 /* FIXME: Precompute these for each context */
 /**
  * \brief Gets the physical block ID of the initial position of the scratch
@@ -130,6 +139,95 @@ static size_t its_mblock_file_meta_offset(struct its_flash_fs_ctx_t *fs_ctx,
            + (idx * ITS_FILE_METADATA_SIZE);
 }
 
+/* Flag set in the key of a metadata cache entry which holds block metadata */
+#define ITS_META_CACHE_BLOCK_META  (1U << 31)
+
+/**
+ * \brief Invalidates all the entries of the metadata cache.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_meta_cache_invalidate(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    (void)tfm_memset(&fs_ctx->meta_cache, 0, sizeof(fs_ctx->meta_cache));
+}
+
+/**
+ * \brief Gets a metadata entry of the active metadata block from the metadata
+ *        cache.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     key     Key of the metadata entry
+ * \param[out]    meta    Buffer to store the metadata entry
+ * \param[in]     size    Size of the metadata entry
+ *
+ * \return true if the metadata entry is in the cache, false otherwise
+ */
+static bool its_meta_cache_get(struct its_flash_fs_ctx_t *fs_ctx, uint32_t key,
+                               void *meta, size_t size)
+{
+#if (ITS_METADATA_CACHE_ENTRIES > 0)
+    struct its_meta_cache_t *cache = &fs_ctx->meta_cache;
+    uint32_t i;
+
+    for (i = 0; i < ITS_METADATA_CACHE_ENTRIES; i++) {
+        if (cache->entry[i].valid && (cache->entry[i].key == key)) {
+            cache->entry[i].last_use = ++cache->use_count;
+            (void)tfm_memcpy(meta, &cache->entry[i].meta, size);
+            return true;
+        }
+    }
+#else
+    (void)fs_ctx;
+    (void)key;
+    (void)meta;
+    (void)size;
+#endif
+
+    return false;
+}
+
+/**
+ * \brief Stores a metadata entry read from the active metadata block in the
+ *        metadata cache, replacing the least recently used entry if the cache
+ *        is full.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     key     Key of the metadata entry
+ * \param[in]     meta    Metadata entry
+ * \param[in]     size    Size of the metadata entry
+ */
+static void its_meta_cache_put(struct its_flash_fs_ctx_t *fs_ctx, uint32_t key,
+                               const void *meta, size_t size)
+{
+#if (ITS_METADATA_CACHE_ENTRIES > 0)
+    struct its_meta_cache_t *cache = &fs_ctx->meta_cache;
+    struct its_meta_cache_entry_t *victim = &cache->entry[0];
+    uint32_t i;
+
+    for (i = 0; i < ITS_METADATA_CACHE_ENTRIES; i++) {
+        if (!cache->entry[i].valid) {
+            victim = &cache->entry[i];
+            break;
+        }
+
+        if (cache->entry[i].last_use < victim->last_use) {
+            victim = &cache->entry[i];
+        }
+    }
+
+    victim->key = key;
+    victim->last_use = ++cache->use_count;
+    victim->valid = true;
+    (void)tfm_memcpy(&victim->meta, meta, size);
+#else
+    (void)fs_ctx;
+    (void)key;
+    (void)meta;
+    (void)size;
+#endif
+}
+
 /**
  * \brief Swaps metablocks. Scratch becomes active and active becomes scratch.
  *
@@ -142,23 +240,25 @@ static void its_mblock_swap_metablocks(struct its_flash_fs_ctx_t *fs_ctx)
     tmp_block = fs_ctx->scratch_metablock;
     fs_ctx->scratch_metablock = fs_ctx->active_metablock;
     fs_ctx->active_metablock = tmp_block;
+
+    /* The cached metadata belongs to the previous active metadata block */
+    its_meta_cache_invalidate(fs_ctx);
 }
 
 /**
- * \brief Finds the potential most recent valid metablock.
+ * \brief Checks if a metadata block header is more recent than another one.
  *
- * \param[in] h_meta0  Header metadata of meta block 0
- * \param[in] h_meta1  Header metadata of meta block 1
+ * \param[in] h_meta  Header metadata of the metadata block to check
+ * \param[in] h_cur   Header metadata of the most recent metadata block so far
  *
- * \return most recent metablock
+ * \return true if h_meta is the most recent, false otherwise
  */
-static uint8_t its_mblock_latest_meta_block(
-                              const struct its_metadata_block_header_t *h_meta0,
-                              const struct its_metadata_block_header_t *h_meta1)
+static bool its_mblock_is_later_meta_block(
+                               const struct its_metadata_block_header_t *h_meta,
+                               const struct its_metadata_block_header_t *h_cur)
 {
-    uint8_t cur_meta;
-    uint8_t meta0_swap_count = h_meta0->active_swap_count;
-    uint8_t meta1_swap_count = h_meta1->active_swap_count;
+    uint8_t meta_swap_count = h_meta->active_swap_count;
+    uint8_t cur_swap_count = h_cur->active_swap_count;
 
     /* Logic: if the swap count is 0, then it has rolled over. The metadata
      * block with a swap count of 0 is the latest one, unless the other block
@@ -166,32 +266,18 @@ static uint8_t its_mblock_latest_meta_block(
      * previous update. In all other cases, the block with the highest swap
      * count is the latest one.
      */
-    if ((meta1_swap_count == 0) && (meta0_swap_count != 1)) {
-        /* Metadata block 1 swap count has rolled over and metadata block 0
-         * swap count has not, so block 1 is the latest.
-         */
-        cur_meta = ITS_METADATA_BLOCK1;
-
-    } else if ((meta0_swap_count == 0) && (meta1_swap_count != 1)) {
-        /* Metadata block 0 swap count has rolled over and metadata block 1
-         * swap count has not, so block 0 is the latest.
-         */
-        cur_meta = ITS_METADATA_BLOCK0;
-
-    } else if (meta1_swap_count > meta0_swap_count) {
-        /* Neither swap count has just rolled over and metadata block 1 has a
-         * higher swap count, so block 1 is the latest.
-         */
-        cur_meta = ITS_METADATA_BLOCK1;
-
-    } else {
-        /* Neither swap count has just rolled over and metadata block 0 has a
-         * higher or equal swap count, so block 0 is the latest.
-         */
-        cur_meta = ITS_METADATA_BLOCK0;
+    if ((meta_swap_count == 0) && (cur_swap_count != 1)) {
+        /* The swap count has rolled over and the other one has not */
+        return true;
+    } else if ((cur_swap_count == 0) && (meta_swap_count != 1)) {
+        /* The other swap count has rolled over and this one has not */
+        return false;
     }
 
-    return cur_meta;
+    /* Neither swap count has just rolled over, so the block with a higher
+     * swap count is the latest.
+     */
+    return meta_swap_count > cur_swap_count;
 }
 
 #ifdef ITS_VALIDATE_METADATA_FROM_FLASH
@@ -261,6 +347,7 @@ static inline psa_status_t its_mblock_validate_file_meta(
  *        access.
  *
  * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number
  * \param[in]     block_meta  Pointer to block meta structure
  *
  * \return Returns error code as specified in \ref psa_status_t
@@ -268,11 +355,12 @@ static inline psa_status_t its_mblock_validate_file_meta(
 __attribute__((always_inline))
 static inline psa_status_t its_mblock_validate_block_meta(
                                       struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
                                       const struct its_block_meta_t *block_meta)
 {
     psa_status_t err;
-    /* Data block's data start at position 0 */
-    size_t valid_data_start_value = 0;
+    /* Data block's data start after the space of the metadata block header */
+    size_t valid_data_start_value = ITS_DBLOCK_DATA_START;
 
     if (block_meta->phy_id >= fs_ctx->flash_info->num_blocks) {
         return PSA_ERROR_DATA_CORRUPT;
@@ -288,8 +376,7 @@ static inline psa_status_t its_mblock_validate_block_meta(
         return PSA_ERROR_DATA_CORRUPT;
     }
 
-    if (block_meta->phy_id == ITS_METADATA_BLOCK0 ||
-        block_meta->phy_id == ITS_METADATA_BLOCK1) {
+    if (lblock == ITS_LOGICAL_DBLOCK0) {
 
         /* For metadata + data block, data index must start after the
          * metadata area.
@@ -306,6 +393,269 @@ static inline psa_status_t its_mblock_validate_block_meta(
 }
 #endif /* ITS_VALIDATE_METADATA_FROM_FLASH */
 
+/* Value of an empty slot in the file index hash table */
+#define ITS_FILE_INDEX_EMPTY_SLOT  0
+
+/**
+ * \brief Gets the hash table slot where the search of a file ID starts.
+ *
+ * \param[in] fid  File ID
+ *
+ * \return Slot position in the file index hash table
+ */
+static uint32_t its_file_index_hash(const uint8_t *fid)
+{
+    /* FNV-1a hash of the file ID */
+    uint32_t hash = 2166136261U;
+    uint32_t i;
+
+    for (i = 0; i < ITS_FILE_ID_SIZE; i++) {
+        hash = (hash ^ fid[i]) * 16777619U;
+    }
+
+    return hash % ITS_FILE_INDEX_SLOTS;
+}
+
+/**
+ * \brief Finds the hash table slot of a file ID.
+ *
+ * \param[in] index  File index
+ * \param[in] fid    File ID
+ *
+ * \return Slot position holding the file ID if it is in the index, otherwise
+ *         the empty slot position where it would be added
+ */
+static uint32_t its_file_index_find_slot(const struct its_file_index_t *index,
+                                         const uint8_t *fid)
+{
+    uint32_t pos = its_file_index_hash(fid);
+
+    while (index->slot[pos] != ITS_FILE_INDEX_EMPTY_SLOT) {
+        if (!tfm_memcmp(index->fid[index->slot[pos] - 1], fid,
+                        ITS_FILE_ID_SIZE)) {
+            break;
+        }
+        pos = (pos + 1) % ITS_FILE_INDEX_SLOTS;
+    }
+
+    return pos;
+}
+
+/**
+ * \brief Removes a hash table slot, moving back the following slots of the
+ *        probe sequence so that no lookup stops at the removed slot.
+ *
+ * \param[in,out] index  File index
+ * \param[in]     pos    Slot position to remove
+ */
+static void its_file_index_remove_slot(struct its_file_index_t *index,
+                                       uint32_t pos)
+{
+    uint32_t next = pos;
+    uint32_t home;
+
+    for (;;) {
+        next = (next + 1) % ITS_FILE_INDEX_SLOTS;
+        if (index->slot[next] == ITS_FILE_INDEX_EMPTY_SLOT) {
+            break;
+        }
+
+        /* The slot can move back if its home position is not in the cyclic
+         * range (pos, next].
+         */
+        home = its_file_index_hash(index->fid[index->slot[next] - 1]);
+        if ((pos < next) ? ((home <= pos) || (home > next)) :
+                           ((home <= pos) && (home > next))) {
+            index->slot[pos] = index->slot[next];
+            pos = next;
+        }
+    }
+
+    index->slot[pos] = ITS_FILE_INDEX_EMPTY_SLOT;
+}
+
+/**
+ * \brief Sets the file ID of a file metadata entry in the file index.
+ *
+ * \note While a file is replaced, the old and the new file metadata entries
+ *       have the same file ID. As in the file metadata table, the entry with
+ *       the lowest index is the one found.
+ *
+ * \param[in,out] index  File index
+ * \param[in]     idx    File metadata entry index
+ * \param[in]     fid    File ID, or an invalid file ID if the entry is free
+ */
+static void its_file_index_set(struct its_file_index_t *index, uint32_t idx,
+                               const uint8_t *fid)
+{
+    uint8_t old_fid[ITS_FILE_ID_SIZE];
+    bool removed = false;
+    uint32_t pos;
+    uint32_t i;
+
+    (void)tfm_memcpy(old_fid, index->fid[idx], ITS_FILE_ID_SIZE);
+
+    if (its_utils_validate_fid(old_fid) == PSA_SUCCESS) {
+        pos = its_file_index_find_slot(index, old_fid);
+        if (index->slot[pos] == idx + 1) {
+            its_file_index_remove_slot(index, pos);
+            removed = true;
+        }
+    }
+
+    (void)tfm_memcpy(index->fid[idx], fid, ITS_FILE_ID_SIZE);
+
+    if (removed) {
+        /* Find another entry with the same file ID */
+        for (i = 0; i < ITS_FILE_INDEX_MAX_FILES; i++) {
+            if (!tfm_memcmp(index->fid[i], old_fid, ITS_FILE_ID_SIZE)) {
+                pos = its_file_index_find_slot(index, old_fid);
+                index->slot[pos] = (uint16_t)(i + 1);
+                break;
+            }
+        }
+    }
+
+    if (its_utils_validate_fid(fid) == PSA_SUCCESS) {
+        pos = its_file_index_find_slot(index, fid);
+        if ((index->slot[pos] == ITS_FILE_INDEX_EMPTY_SLOT) ||
+            (index->slot[pos] > idx + 1)) {
+            index->slot[pos] = (uint16_t)(idx + 1);
+        }
+        index->free_map[idx / 32] &= ~(1U << (idx % 32));
+    } else {
+        index->free_map[idx / 32] |= (1U << (idx % 32));
+    }
+}
+
+/**
+ * \brief Sets all file metadata entries of the file index as free.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_file_index_reset(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    uint32_t i;
+
+    (void)tfm_memset(index, 0, sizeof(*index));
+
+    if (fs_ctx->flash_info->max_num_files > ITS_FILE_INDEX_MAX_FILES) {
+        /* The files are looked up in flash */
+        return;
+    }
+
+    for (i = 0; i < fs_ctx->flash_info->max_num_files; i++) {
+        index->free_map[i / 32] |= (1U << (i % 32));
+    }
+
+    index->valid = true;
+}
+
+/**
+ * \brief Builds the file index from the file metadata in the active metadata
+ *        block.
+ *
+ * \note If a file metadata entry cannot be read, the index is left invalid and
+ *       the files are looked up in flash.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_file_index_build(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_meta_t tmp_metadata;
+    uint32_t i;
+
+    its_file_index_reset(fs_ctx);
+    if (!fs_ctx->file_index.valid) {
+        return;
+    }
+
+    for (i = 0; i < fs_ctx->flash_info->max_num_files; i++) {
+        if (its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata)
+            != PSA_SUCCESS) {
+            fs_ctx->file_index.valid = false;
+            return;
+        }
+
+        its_file_index_set(&fs_ctx->file_index, i, tmp_metadata.id);
+    }
+}
+
+/**
+ * \brief Records the file ID written in the scratch metadata block for a file
+ *        metadata entry, if it is different from the one in the file index.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     idx     File metadata entry index
+ * \param[in]     fid     File ID written in the scratch metadata block
+ */
+static void its_file_index_add_pending(struct its_flash_fs_ctx_t *fs_ctx,
+                                       uint32_t idx, const uint8_t *fid)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    uint32_t i;
+
+    if (!index->valid) {
+        return;
+    }
+
+    for (i = 0; i < index->num_pending; i++) {
+        if (index->pending_idx[i] == idx) {
+            break;
+        }
+    }
+
+    if (i == index->num_pending) {
+        if (!tfm_memcmp(index->fid[idx], fid, ITS_FILE_ID_SIZE)) {
+            /* No change */
+            return;
+        }
+
+        if (index->num_pending == ITS_FILE_INDEX_PENDING) {
+            /* Rebuild the index at the next lookup */
+            index->valid = false;
+            return;
+        }
+
+        index->num_pending++;
+    }
+
+    index->pending_idx[i] = idx;
+    (void)tfm_memcpy(index->pending_fid[i], fid, ITS_FILE_ID_SIZE);
+}
+
+/**
+ * \brief Applies the pending file ID changes to the file index, once the
+ *        scratch metadata block became the active one.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_file_index_apply_pending(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    struct its_file_meta_t tmp_metadata;
+    uint32_t i;
+
+    for (i = 0; (i < index->num_pending) && index->valid; i++) {
+        /* Check the change against the active metadata block, in case it was
+         * left by an update which failed before being finalized.
+         */
+        if ((its_flash_fs_mblock_read_file_meta(fs_ctx, index->pending_idx[i],
+                                                &tmp_metadata) != PSA_SUCCESS)
+            || tfm_memcmp(tmp_metadata.id, index->pending_fid[i],
+                          ITS_FILE_ID_SIZE)) {
+            index->valid = false;
+            break;
+        }
+
+        its_file_index_set(index, index->pending_idx[i],
+                           index->pending_fid[i]);
+    }
+
+    index->num_pending = 0;
+}
+
 /**
  * \brief Gets a free file metadata table entry.
  *
@@ -320,7 +670,35 @@ static uint32_t its_get_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
 {
     psa_status_t err;
     uint32_t i;
+    uint32_t word;
     struct its_file_meta_t tmp_metadata;
+    const struct its_file_index_t *index = &fs_ctx->file_index;
+
+    if (!index->valid) {
+        its_file_index_build(fs_ctx);
+    }
+
+    if (index->valid) {
+        for (i = 0; i < ITS_FILE_INDEX_MAP_WORDS; i++) {
+            word = index->free_map[i];
+            if ((word != 0) && !use_spare) {
+                /* Keep the first free file index as a spare */
+                word &= word - 1;
+                use_spare = true;
+            }
+            if (word != 0) {
+                /* Found, at the lowest bit set */
+                i *= 32;
+                while (!(word & 1U)) {
+                    word >>= 1;
+                    i++;
+                }
+                return i;
+            }
+        }
+
+        return ITS_METADATA_INVALID_INDEX;
+    }
 
     for (i = 0; i < fs_ctx->flash_info->max_num_files; i++) {
         err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
@@ -372,17 +750,21 @@ static psa_status_t its_mblock_erase_scratch_blocks(
 
     /* If the number of blocks is bigger than 2, the code needs to erase the
      * scratch block used to process any change in the data block which contains
-     * only data. Otherwise, if the number of blocks is equal to 2, it means
-     * that all data is stored in the metadata block.
+     * only data, unless it has not been written since it was last erased.
+     * Otherwise, if the number of blocks is equal to 2, it means that all data
+     * is stored in the metadata block.
      */
-    if (fs_ctx->flash_info->num_blocks > 2) {
-        scratch_datablock =
-            its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
-                                                    (ITS_LOGICAL_DBLOCK0 + 1));
+    if ((fs_ctx->flash_info->num_blocks > 2) && fs_ctx->scratch_dblock_dirty) {
+        scratch_datablock = fs_ctx->meta_block_header.scratch_dblock;
         err = fs_ctx->flash_info->erase(fs_ctx->flash_info, scratch_datablock);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        fs_ctx->scratch_dblock_dirty = false;
     }
 
-    return err;
+    return PSA_SUCCESS;
 }
 
 /**
@@ -448,10 +830,12 @@ static psa_status_t its_mblock_copy_remaining_block_meta(
             return PSA_ERROR_GENERIC_ERROR;
         }
 
-        /* Update physical ID for logical block 0 to match with the
-         * metadata block physical ID.
+        /* Update physical ID and erase count for logical block 0 to match
+         * with the metadata block physical ID.
          */
         block_meta.phy_id = scratch_block;
+        block_meta.erase_count =
+                        fs_ctx->meta_block_header.scratch_mblock_erase_count;
         err = its_mblock_update_scratch_block_meta(fs_ctx, ITS_LOGICAL_DBLOCK0,
                                                    &block_meta);
         if (err != PSA_SUCCESS) {
@@ -554,6 +938,15 @@ static psa_status_t its_mblock_validate_header_meta(
         err = its_mblock_validate_swap_count(fs_ctx, h_meta->active_swap_count);
     }
 
+    /* The scratch blocks are erased at initialization, so their physical
+     * block IDs must be valid.
+     */
+    if ((err == PSA_SUCCESS) &&
+        ((h_meta->scratch_dblock >= fs_ctx->flash_info->num_blocks) ||
+         (h_meta->scratch_mblock >= fs_ctx->flash_info->num_blocks))) {
+        err = PSA_ERROR_GENERIC_ERROR;
+    }
+
     return err;
 }
 
@@ -611,6 +1004,12 @@ static psa_status_t its_mblock_read_meta_header(
 /**
  * \brief Reserves space for an file.
  *
+ * \note The file is reserved in the logical data block 0 if it fits, as that
+ *       block is rewritten with the metadata in any case. Otherwise, it is
+ *       reserved in the data block with the lowest erase count among those
+ *       with enough free space, as the physical block of the data block is
+ *       erased each time the file is written.
+ *
  * \param[in,out] fs_ctx      Filesystem context
  * \param[in]     fid         File ID
  * \param[in]     size        Size of the file for which space is reserve
@@ -626,33 +1025,75 @@ static psa_status_t its_mblock_reserve_file(struct its_flash_fs_ctx_t *fs_ctx,
                                             struct its_file_meta_t *file_meta,
                                             struct its_block_meta_t *block_meta)
 {
+    struct its_block_meta_t tmp_block_meta;
+    uint32_t lblock = ITS_BLOCK_INVALID_ID;
     psa_status_t err;
     uint32_t i;
 
     for (i = 0; i < its_num_active_dblocks(fs_ctx); i++) {
-        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i, block_meta);
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i,
+                                                      &tmp_block_meta);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
         }
 
-        if (block_meta->free_size >= size) {
-            /* Set file metadata */
-            file_meta->lblock = i;
-            file_meta->data_idx = fs_ctx->flash_info->block_size
-                                  - block_meta->free_size;
-            file_meta->max_size = size;
-            tfm_memcpy(file_meta->id, fid, ITS_FILE_ID_SIZE);
-            file_meta->cur_size = 0;
-            file_meta->flags = flags;
-
-            /* Update block metadata */
-            block_meta->free_size -= size;
-            return PSA_SUCCESS;
+        if ((tmp_block_meta.free_size >= size) &&
+            ((lblock == ITS_BLOCK_INVALID_ID) ||
+             (tmp_block_meta.erase_count < block_meta->erase_count))) {
+            lblock = i;
+            *block_meta = tmp_block_meta;
+
+            if (lblock == ITS_LOGICAL_DBLOCK0) {
+                break;
+            }
         }
     }
 
-    /* No block has large enough space to fit the requested file */
-    return PSA_ERROR_INSUFFICIENT_STORAGE;
+    if (lblock == ITS_BLOCK_INVALID_ID) {
+        /* No block has large enough space to fit the requested file */
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    /* Set file metadata */
+    file_meta->lblock = lblock;
+    file_meta->data_idx = fs_ctx->flash_info->block_size
+                          - block_meta->free_size;
+    file_meta->max_size = size;
+    tfm_memcpy(file_meta->id, fid, ITS_FILE_ID_SIZE);
+    file_meta->cur_size = 0;
+    file_meta->flags = flags;
+
+    /* Update block metadata */
+    block_meta->free_size -= size;
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Checks if the flash holds a filesystem of the layout with fixed
+ *        metadata blocks, which this version cannot read.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns true if a valid header of that layout is found
+ */
+static bool its_mblock_is_fixed_layout(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_fixed_mblock_header_t h_meta;
+    uint32_t i;
+
+    for (i = ITS_METADATA_BLOCK0; i <= ITS_METADATA_BLOCK1; i++) {
+        if ((fs_ctx->flash_info->read(fs_ctx->flash_info, i,
+                                      (uint8_t *)&h_meta, 0,
+                                      sizeof(h_meta)) == PSA_SUCCESS) &&
+            (h_meta.fs_version == ITS_FIXED_MBLOCK_VERSION) &&
+            (its_mblock_validate_swap_count(fs_ctx, h_meta.active_swap_count)
+             == PSA_SUCCESS) &&
+            (h_meta.scratch_dblock < fs_ctx->flash_info->num_blocks)) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 /**
@@ -667,52 +1108,212 @@ static psa_status_t its_init_get_active_metablock(
 {
     uint32_t cur_meta_block = ITS_BLOCK_INVALID_ID;
     psa_status_t err;
-    struct its_metadata_block_header_t h_meta0;
-    struct its_metadata_block_header_t h_meta1;
-    uint8_t num_valid_meta_blocks = 0;
-
-    /* First two blocks are reserved for metadata */
+    struct its_metadata_block_header_t h_meta;
+    struct its_metadata_block_header_t h_cur = {0};
+    uint32_t i;
 
-    /* Read the header of both the metdata blocks. If the read succeeds, then
-     * attempt to validate the metadata header, otherwise assume that the block
-     * update was incomplete
+    /* The metadata blocks can be any of the blocks, so read the header of all
+     * the blocks. If the read succeeds, then attempt to validate the metadata
+     * header, otherwise assume that the block update was incomplete. The data
+     * blocks never contain a valid header, as its space is left erased.
      */
-    err = fs_ctx->flash_info->read(fs_ctx->flash_info, ITS_METADATA_BLOCK0,
-                                   (uint8_t *)&h_meta0, 0,
-                                   ITS_BLOCK_META_HEADER_SIZE);
-    if (err == PSA_SUCCESS) {
-        if (its_mblock_validate_header_meta(fs_ctx, &h_meta0) == PSA_SUCCESS) {
-            num_valid_meta_blocks++;
-            cur_meta_block = ITS_METADATA_BLOCK0;
+    for (i = 0; i < fs_ctx->flash_info->num_blocks; i++) {
+        err = fs_ctx->flash_info->read(fs_ctx->flash_info, i,
+                                       (uint8_t *)&h_meta, 0,
+                                       ITS_BLOCK_META_HEADER_SIZE);
+        if ((err != PSA_SUCCESS) ||
+            (its_mblock_validate_header_meta(fs_ctx, &h_meta) != PSA_SUCCESS) ||
+            (h_meta.scratch_mblock == i)) {
+            continue;
         }
-    }
 
-    err = fs_ctx->flash_info->read(fs_ctx->flash_info, ITS_METADATA_BLOCK1,
-                                   (uint8_t *)&h_meta1, 0,
-                                   ITS_BLOCK_META_HEADER_SIZE);
-    if (err == PSA_SUCCESS) {
-        if (its_mblock_validate_header_meta(fs_ctx, &h_meta1) == PSA_SUCCESS) {
-            num_valid_meta_blocks++;
-            cur_meta_block = ITS_METADATA_BLOCK1;
+        /* If there are more than 1 potential metablocks, the previous
+         * update operation was interrupted by power failure. In which case,
+         * need to find out which one is potentially latest metablock.
+         */
+        if ((cur_meta_block == ITS_BLOCK_INVALID_ID) ||
+            its_mblock_is_later_meta_block(&h_meta, &h_cur)) {
+            cur_meta_block = i;
+            h_cur = h_meta;
         }
     }
 
-    /* If there are more than 1 potential metablocks, the previous
-     * update operation was interrupted by power failure. In which case,
-     * need to find out which one is potentially latest metablock.
-     */
-    if (num_valid_meta_blocks > 1) {
-        cur_meta_block = its_mblock_latest_meta_block(&h_meta0, &h_meta1);
-    } else if (num_valid_meta_blocks == 0) {
+    if (cur_meta_block == ITS_BLOCK_INVALID_ID) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
     fs_ctx->active_metablock = cur_meta_block;
-    fs_ctx->scratch_metablock = ITS_OTHER_META_BLOCK(cur_meta_block);
+    fs_ctx->scratch_metablock = h_cur.scratch_mblock;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Commits the scratch metadata block, which becomes the active metadata
+ *        block, and erases the scratch blocks.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_commit_scratch(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_metadata_block_header_t *h_meta = &fs_ctx->meta_block_header;
+    struct its_block_meta_t block_meta;
+    uint32_t tmp;
+    psa_status_t err;
+
+    /* The active metadata block becomes the scratch metadata block and is
+     * erased once the update is committed, so its erase count is the one of
+     * the logical data block 0 plus that erase. The same applies to the scratch
+     * data block, if it has been written.
+     */
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                                  &block_meta);
+    if (err != PSA_SUCCESS) {
+        fs_ctx->file_index.num_pending = 0;
+        return err;
+    }
+
+    h_meta->scratch_mblock = fs_ctx->active_metablock;
+    h_meta->scratch_mblock_erase_count = block_meta.erase_count + 1;
+    if ((fs_ctx->flash_info->num_blocks > 2) && fs_ctx->scratch_dblock_dirty) {
+        h_meta->scratch_dblock_erase_count += 1;
+    }
+
+    /* Write the metadata block header to flash */
+    err = its_mblock_write_scratch_meta_header(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        fs_ctx->file_index.num_pending = 0;
+        return err;
+    }
+
+    /* Commit metadata block modifications to flash */
+    err = fs_ctx->flash_info->flush(fs_ctx->flash_info);
+    if (err != PSA_SUCCESS) {
+        fs_ctx->file_index.num_pending = 0;
+        return err;
+    }
+
+    /* Update the running context */
+    its_mblock_swap_metablocks(fs_ctx);
+    its_file_index_apply_pending(fs_ctx);
+
+    /* Erase meta block and current scratch block */
+    err = its_mblock_erase_scratch_blocks(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Both scratch blocks are erased, so their roles can be exchanged. The
+     * metadata block is erased in every update, so use the least erased one
+     * for the metadata. The header of the active metadata block still refers
+     * to both as scratch blocks, so no update is required.
+     */
+    if ((fs_ctx->flash_info->num_blocks > 2) &&
+        (h_meta->scratch_dblock_erase_count <
+         h_meta->scratch_mblock_erase_count)) {
+        tmp = h_meta->scratch_dblock;
+        h_meta->scratch_dblock = h_meta->scratch_mblock;
+        h_meta->scratch_mblock = tmp;
+        fs_ctx->scratch_metablock = tmp;
+
+        tmp = h_meta->scratch_dblock_erase_count;
+        h_meta->scratch_dblock_erase_count = h_meta->scratch_mblock_erase_count;
+        h_meta->scratch_mblock_erase_count = tmp;
+    }
 
     return PSA_SUCCESS;
 }
 
+/**
+ * \brief Moves the data block with the lowest erase count to the scratch data
+ *        block, if the scratch data block has been erased more times by at
+ *        least ITS_WEAR_LEVEL_THRESHOLD. The physical block of a data block
+ *        which is never written is then reused for the scratch blocks.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_level_wear(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_block_meta_t block_meta;
+    struct its_block_meta_t cold_meta;
+    uint32_t cold_lblock = ITS_BLOCK_INVALID_ID;
+    uint32_t scratch_count;
+    uint32_t scratch_id;
+    psa_status_t err;
+    size_t size;
+    uint32_t i;
+
+    if (ITS_WEAR_LEVEL_THRESHOLD == 0) {
+        return PSA_SUCCESS;
+    }
+
+    scratch_count = fs_ctx->meta_block_header.scratch_dblock_erase_count;
+
+    for (i = ITS_LOGICAL_DBLOCK0 + 1; i < its_num_active_dblocks(fs_ctx); i++) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if ((block_meta.erase_count < scratch_count) &&
+            (scratch_count - block_meta.erase_count >=
+             ITS_WEAR_LEVEL_THRESHOLD) &&
+            ((cold_lblock == ITS_BLOCK_INVALID_ID) ||
+             (block_meta.erase_count < cold_meta.erase_count))) {
+            cold_lblock = i;
+            cold_meta = block_meta;
+        }
+    }
+
+    if (cold_lblock == ITS_BLOCK_INVALID_ID) {
+        return PSA_SUCCESS;
+    }
+
+    /* Copy the data of the block into the scratch data block */
+    scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx, cold_lblock);
+    size = (fs_ctx->flash_info->block_size - cold_meta.data_start)
+           - cold_meta.free_size;
+
+    err = its_flash_block_to_block_move(fs_ctx->flash_info, scratch_id,
+                                        cold_meta.data_start, cold_meta.phy_id,
+                                        cold_meta.data_start, size);
+    if (err != PSA_SUCCESS) {
+        (void)its_mblock_erase_scratch_blocks(fs_ctx);
+        return err;
+    }
+
+    /* Update the block metadata and copy the rest of the metadata unchanged */
+    its_flash_fs_mblock_swap_data_scratch(fs_ctx, cold_lblock, &cold_meta);
+
+    err = its_flash_fs_mblock_update_scratch_block_meta(fs_ctx, cold_lblock,
+                                                        &cold_meta);
+    if (err == PSA_SUCCESS) {
+        err = fs_ctx->flash_info->flush(fs_ctx->flash_info);
+    }
+
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_mblock_cp_file_meta(fs_ctx, 0,
+                                             fs_ctx->flash_info->max_num_files);
+    }
+
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_mblock_migrate_lb0_data_to_scratch(fs_ctx);
+    }
+
+    if (err != PSA_SUCCESS) {
+        /* Swap back the data block, as the active metadata is unchanged */
+        its_flash_fs_mblock_swap_data_scratch(fs_ctx, cold_lblock, &cold_meta);
+        (void)its_mblock_erase_scratch_blocks(fs_ctx);
+        return err;
+    }
+
+    return its_mblock_commit_scratch(fs_ctx);
+}
+
 psa_status_t its_flash_fs_mblock_cp_file_meta(struct its_flash_fs_ctx_t *fs_ctx,
                                               uint32_t idx_start,
                                               uint32_t idx_end)
@@ -739,6 +1340,8 @@ uint32_t its_flash_fs_mblock_cur_data_scratch_id(
         return fs_ctx->scratch_metablock;
     }
 
+    fs_ctx->scratch_dblock_dirty = true;
+
     return fs_ctx->meta_block_header.scratch_dblock;
 }
 
@@ -748,11 +1351,29 @@ psa_status_t its_flash_fs_mblock_get_file_idx(struct its_flash_fs_ctx_t *fs_ctx,
 {
     psa_status_t err;
     uint32_t i;
+    uint32_t pos;
     struct its_file_meta_t tmp_metadata;
+    const struct its_file_index_t *index = &fs_ctx->file_index;
+
+    if (!index->valid) {
+        its_file_index_build(fs_ctx);
+    }
+
+    if (index->valid) {
+        pos = its_file_index_find_slot(index, fid);
+        if (index->slot[pos] == ITS_FILE_INDEX_EMPTY_SLOT) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+
+        *idx = index->slot[pos] - 1;
+        return PSA_SUCCESS;
+    }
 
     for (i = 0; i < fs_ctx->flash_info->max_num_files; i++) {
         err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
-        if (err != PSA_SUCCESS) {
+        if (err == PSA_ERROR_DATA_CORRUPT) {
+            return err;
+        } else if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
         }
 
@@ -802,9 +1423,15 @@ psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx)
         return err;
     }
 
+    its_meta_cache_invalidate(fs_ctx);
+
     err = its_init_get_active_metablock(fs_ctx);
     if (err != PSA_SUCCESS) {
-        return PSA_ERROR_GENERIC_ERROR;
+        /* Distinguish a filesystem of the previous layout from a corrupt one,
+         * so that the caller does not wipe the files it contains.
+         */
+        return its_mblock_is_fixed_layout(fs_ctx) ? PSA_ERROR_NOT_SUPPORTED
+                                                  : PSA_ERROR_GENERIC_ERROR;
     }
 
     err = its_mblock_read_meta_header(fs_ctx);
@@ -812,7 +1439,13 @@ psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx)
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    /* Erase the other scratch metadata block */
+    /* Build the file index from the active metadata block */
+    its_file_index_build(fs_ctx);
+
+    /* Erase the other scratch metadata block and the scratch data block, which
+     * may have been written by an incomplete update.
+     */
+    fs_ctx->scratch_dblock_dirty = true;
     return its_mblock_erase_scratch_blocks(fs_ctx);
 }
 
@@ -821,23 +1454,17 @@ psa_status_t its_flash_fs_mblock_meta_update_finalize(
 {
     psa_status_t err;
 
-    /* Write the metadata block header to flash */
-    err = its_mblock_write_scratch_meta_header(fs_ctx);
+    err = its_mblock_commit_scratch(fs_ctx);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    /* Commit metadata block modifications to flash */
-    err = fs_ctx->flash_info->flush(fs_ctx->flash_info);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
-
-    /* Update the running context */
-    its_mblock_swap_metablocks(fs_ctx);
+    /* The update is committed, so a failure to move a data block is not
+     * reported. The data block is moved in a later update instead.
+     */
+    (void)its_mblock_level_wear(fs_ctx);
 
-    /* Erase meta block and current scratch block */
-    return its_mblock_erase_scratch_blocks(fs_ctx);
+    return PSA_SUCCESS;
 }
 
 psa_status_t its_flash_fs_mblock_migrate_lb0_data_to_scratch(
@@ -873,6 +1500,11 @@ psa_status_t its_flash_fs_mblock_read_file_meta(
     psa_status_t err;
     size_t offset;
 
+    /* The cached metadata was validated when it was read from flash */
+    if (its_meta_cache_get(fs_ctx, idx, file_meta, ITS_FILE_METADATA_SIZE)) {
+        return PSA_SUCCESS;
+    }
+
     offset = its_mblock_file_meta_offset(fs_ctx, idx);
     err = fs_ctx->flash_info->read(fs_ctx->flash_info, fs_ctx->active_metablock,
                                    (uint8_t *)file_meta, offset,
@@ -884,6 +1516,10 @@ psa_status_t its_flash_fs_mblock_read_file_meta(
     }
 #endif
 
+    if (err == PSA_SUCCESS) {
+        its_meta_cache_put(fs_ctx, idx, file_meta, ITS_FILE_METADATA_SIZE);
+    }
+
     return err;
 }
 
@@ -895,6 +1531,12 @@ psa_status_t its_flash_fs_mblock_read_block_metadata(
     psa_status_t err;
     size_t pos;
 
+    /* The cached metadata was validated when it was read from flash */
+    if (its_meta_cache_get(fs_ctx, lblock | ITS_META_CACHE_BLOCK_META,
+                           block_meta, ITS_BLOCK_METADATA_SIZE)) {
+        return PSA_SUCCESS;
+    }
+
     pos = its_mblock_block_meta_offset(lblock);
     err = fs_ctx->flash_info->read(fs_ctx->flash_info, fs_ctx->active_metablock,
                                    (uint8_t *)block_meta, pos,
@@ -902,10 +1544,15 @@ psa_status_t its_flash_fs_mblock_read_block_metadata(
 
 #ifdef ITS_VALIDATE_METADATA_FROM_FLASH
     if (err == PSA_SUCCESS) {
-        err = its_mblock_validate_block_meta(fs_ctx, block_meta);
+        err = its_mblock_validate_block_meta(fs_ctx, lblock, block_meta);
     }
 #endif
 
+    if (err == PSA_SUCCESS) {
+        its_meta_cache_put(fs_ctx, lblock | ITS_META_CACHE_BLOCK_META,
+                           block_meta, ITS_BLOCK_METADATA_SIZE);
+    }
+
     return err;
 }
 
@@ -937,36 +1584,62 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
                                               struct its_flash_fs_ctx_t *fs_ctx)
 {
     struct its_block_meta_t block_meta;
-    psa_status_t err;
+    psa_status_t err = PSA_SUCCESS;
     uint32_t i;
-    uint32_t metablock_to_erase_first = ITS_METADATA_BLOCK0;
+    bool found_metablock = false;
     struct its_file_meta_t file_metadata;
 
-    /* Erase both metadata blocks. If at least one metadata block is valid,
-     * ensure that the active metadata block is erased last to prevent rollback
-     * in the case of a power failure between the two erases.
+    /* Erase all the blocks. If at least one metadata block is valid, ensure
+     * that the active metadata block is erased last among the metadata blocks
+     * to prevent rollback in the case of a power failure between the erases.
      */
     if (its_init_get_active_metablock(fs_ctx) == PSA_SUCCESS) {
-        metablock_to_erase_first = fs_ctx->scratch_metablock;
+        found_metablock = true;
+
+        err = fs_ctx->flash_info->erase(fs_ctx->flash_info,
+                                        fs_ctx->scratch_metablock);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = fs_ctx->flash_info->erase(fs_ctx->flash_info,
+                                        fs_ctx->active_metablock);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
     }
 
-    err = fs_ctx->flash_info->erase(fs_ctx->flash_info,
-                                    metablock_to_erase_first);
-    if (err != PSA_SUCCESS) {
-        return err;
+    for (i = 0; i < fs_ctx->flash_info->num_blocks; i++) {
+        if (found_metablock && ((i == fs_ctx->active_metablock) ||
+                                (i == fs_ctx->scratch_metablock))) {
+            continue;
+        }
+
+        /* If a flash error is detected, the code erases the rest
+         * of the blocks anyway to remove all data stored in them.
+         */
+        err |= fs_ctx->flash_info->erase(fs_ctx->flash_info, i);
     }
 
-    err = fs_ctx->flash_info->erase(fs_ctx->flash_info,
-                                ITS_OTHER_META_BLOCK(metablock_to_erase_first));
+    /* If an error is detected while erasing the flash, then return a
+     * system error to abort core wipe process.
+     */
     if (err != PSA_SUCCESS) {
-        return err;
+        return PSA_ERROR_STORAGE_FAILURE;
     }
 
+    /* The erase counts restart from 0 */
     fs_ctx->meta_block_header.active_swap_count = 0;
     fs_ctx->meta_block_header.scratch_dblock = its_init_scratch_dblock(fs_ctx);
+    fs_ctx->meta_block_header.scratch_mblock = ITS_METADATA_BLOCK0;
+    fs_ctx->meta_block_header.scratch_dblock_erase_count = 0;
+    fs_ctx->meta_block_header.scratch_mblock_erase_count = 0;
     fs_ctx->meta_block_header.fs_version = ITS_SUPPORTED_VERSION;
     fs_ctx->scratch_metablock = ITS_METADATA_BLOCK1;
     fs_ctx->active_metablock = ITS_METADATA_BLOCK0;
+    fs_ctx->scratch_dblock_dirty = false;
+    its_meta_cache_invalidate(fs_ctx);
+    block_meta.erase_count = 0;
 
     /* Fill the block metadata for logical datablock 0, which has the physical
      * id of the active metadata block. For this datablock, the space available
@@ -976,7 +1649,7 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
         its_mblock_file_meta_offset(fs_ctx, fs_ctx->flash_info->max_num_files);
     block_meta.free_size = fs_ctx->flash_info->block_size
                            - block_meta.data_start;
-    block_meta.phy_id = ITS_METADATA_BLOCK0;
+    block_meta.phy_id = fs_ctx->scratch_metablock;
     err = its_mblock_update_scratch_block_meta(fs_ctx, ITS_LOGICAL_DBLOCK0,
                                                &block_meta);
     if (err != PSA_SUCCESS) {
@@ -986,25 +1659,11 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
     /* Fill the block metadata for the dedicated datablocks, which have logical
      * ids beginning from 1 and physical ids initially beginning from
      * ITS_INIT_DBLOCK_START. For these datablocks, the space available for
-     * data is the entire block.
+     * data is the entire block, except the space of the metadata block header.
      */
-    block_meta.data_start = 0;
-    block_meta.free_size = fs_ctx->flash_info->block_size;
-    for (i = 0; i < its_num_dedicated_dblocks(fs_ctx); i++) {
-        /* If a flash error is detected, the code erases the rest
-         * of the blocks anyway to remove all data stored in them.
-         */
-        err |= fs_ctx->flash_info->erase(fs_ctx->flash_info,
-                                         i + its_init_dblock_start(fs_ctx));
-    }
-
-    /* If an error is detected while erasing the flash, then return a
-     * system error to abort core wipe process.
-     */
-    if (err != PSA_SUCCESS) {
-        return PSA_ERROR_STORAGE_FAILURE;
-    }
-
+    block_meta.data_start = ITS_DBLOCK_DATA_START;
+    block_meta.free_size = fs_ctx->flash_info->block_size
+                           - block_meta.data_start;
     for (i = 0; i < its_num_dedicated_dblocks(fs_ctx); i++) {
         block_meta.phy_id = i + its_init_dblock_start(fs_ctx);
         err = its_mblock_update_scratch_block_meta(fs_ctx, i + 1, &block_meta);
@@ -1040,15 +1699,33 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
     /* Swap active and scratch metablocks */
     its_mblock_swap_metablocks(fs_ctx);
 
+    /* All the file metadata entries are free */
+    its_file_index_reset(fs_ctx);
+
     return PSA_SUCCESS;
 }
 
-void its_flash_fs_mblock_set_data_scratch(struct its_flash_fs_ctx_t *fs_ctx,
-                                          uint32_t phy_id, uint32_t lblock)
+void its_flash_fs_mblock_swap_data_scratch(struct its_flash_fs_ctx_t *fs_ctx,
+                                           uint32_t lblock,
+                                           struct its_block_meta_t *block_meta)
 {
-    if (lblock != ITS_LOGICAL_DBLOCK0) {
-        fs_ctx->meta_block_header.scratch_dblock = phy_id;
+    struct its_metadata_block_header_t *h_meta = &fs_ctx->meta_block_header;
+    uint32_t tmp;
+
+    if (lblock == ITS_LOGICAL_DBLOCK0) {
+        return;
     }
+
+    tmp = block_meta->phy_id;
+    block_meta->phy_id = h_meta->scratch_dblock;
+    h_meta->scratch_dblock = tmp;
+
+    tmp = block_meta->erase_count;
+    block_meta->erase_count = h_meta->scratch_dblock_erase_count;
+    h_meta->scratch_dblock_erase_count = tmp;
+
+    /* The previous data of the logical block must be erased */
+    fs_ctx->scratch_dblock_dirty = true;
 }
 
 psa_status_t its_flash_fs_mblock_update_scratch_block_meta(
@@ -1058,12 +1735,14 @@ psa_status_t its_flash_fs_mblock_update_scratch_block_meta(
 {
     psa_status_t err;
 
-    /* If the file is the logical block 0, then update the physical ID to the
-     * current scratch metadata block so that it is correct after the metadata
-     * blocks are swapped.
+    /* If the file is the logical block 0, then update the physical ID and the
+     * erase count to the current scratch metadata block so that they are
+     * correct after the metadata blocks are swapped.
      */
     if (lblock == ITS_LOGICAL_DBLOCK0) {
         block_meta->phy_id = fs_ctx->scratch_metablock;
+        block_meta->erase_count =
+                        fs_ctx->meta_block_header.scratch_mblock_erase_count;
     }
 
     err = its_mblock_update_scratch_block_meta(fs_ctx, lblock, block_meta);
@@ -1079,12 +1758,21 @@ psa_status_t its_flash_fs_mblock_update_scratch_file_meta(
                                         uint32_t idx,
                                         const struct its_file_meta_t *file_meta)
 {
+    psa_status_t err;
     size_t pos;
 
     /* Calculate the position */
     pos = its_mblock_file_meta_offset(fs_ctx, idx);
-    return fs_ctx->flash_info->write(fs_ctx->flash_info,
-                                     fs_ctx->scratch_metablock,
-                                     (const uint8_t *)file_meta, pos,
-                                     ITS_FILE_METADATA_SIZE);
+    err = fs_ctx->flash_info->write(fs_ctx->flash_info,
+                                    fs_ctx->scratch_metablock,
+                                    (const uint8_t *)file_meta, pos,
+                                    ITS_FILE_METADATA_SIZE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The file index is updated once the metadata update is finalized */
+    its_file_index_add_pending(fs_ctx, idx, file_meta->id);
+
+    return PSA_SUCCESS;
 }
@@ -14,6 +14,7 @@
 
 #include "flash/its_flash.h"
 #include "its_utils.h"
+#include "ps_object_defs.h"
 #include "psa/error.h"
 
 #ifdef __cplusplus
@@ -25,7 +26,7 @@ extern "C" {
  *
  * \brief Defines the supported version.
  */
-#define ITS_SUPPORTED_VERSION  0x01
+#define ITS_SUPPORTED_VERSION  0x02
 
 /*!
  * \def ITS_METADATA_INVALID_INDEX
@@ -41,6 +42,49 @@ extern "C" {
  */
 #define ITS_LOGICAL_DBLOCK0  0
 
+/*!
+ * \def ITS_WEAR_LEVEL_THRESHOLD
+ *
+ * \brief Defines the difference of erase counts between the scratch data block
+ *        and the least erased data block above which the data block is moved
+ *        to the scratch data block, so that its physical block is reused.
+ */
+#ifndef ITS_WEAR_LEVEL_THRESHOLD
+#define ITS_WEAR_LEVEL_THRESHOLD 32
+#endif
+
+/*!
+ * \def ITS_FILE_INDEX_MAX_FILES
+ *
+ * \brief Defines the maximum number of files held in the file index in RAM.
+ *        The files of a file system with more files are looked up in flash.
+ */
+#ifndef ITS_FILE_INDEX_MAX_FILES
+#define ITS_FILE_INDEX_MAX_FILES ITS_UTILS_MAX(ITS_NUM_ASSETS + 1, \
+                                               PS_MAX_NUM_OBJECTS)
+#endif
+
+/*!
+ * \def ITS_METADATA_CACHE_ENTRIES
+ *
+ * \brief Defines the number of file and block metadata entries of the active
+ *        metadata block cached in RAM. 0 disables the cache.
+ */
+#ifndef ITS_METADATA_CACHE_ENTRIES
+#define ITS_METADATA_CACHE_ENTRIES 8
+#endif
+
+/* Number of hash slots in the file index, so that at most half are used */
+#define ITS_FILE_INDEX_SLOTS  (2 * (ITS_FILE_INDEX_MAX_FILES) + 1)
+
+/* Number of words in the bitmap of free file metadata entries */
+#define ITS_FILE_INDEX_MAP_WORDS  (((ITS_FILE_INDEX_MAX_FILES) + 31) / 32)
+
+/* Number of file ID changes in the scratch metadata block applied to the file
+ * index when the metadata update is finalized.
+ */
+#define ITS_FILE_INDEX_PENDING  2
+
 /*!
  * \struct its_metadata_block_header_t
  *
@@ -56,6 +100,15 @@ extern "C" {
     uint32_t scratch_dblock;    /*!< Physical block ID of the data \
                                  *   section's scratch block \
                                  */ \
+    uint32_t scratch_mblock;    /*!< Physical block ID of the scratch \
+                                 *   metadata block \
+                                 */ \
+    uint32_t scratch_dblock_erase_count; /*!< Erase count of the scratch \
+                                          *   data block \
+                                          */ \
+    uint32_t scratch_mblock_erase_count; /*!< Erase count of the scratch \
+                                          *   metadata block \
+                                          */ \
     uint8_t fs_version;         /*!< ITS system version */ \
     uint8_t active_swap_count;  /*!< Physical block ID of the data */
 
@@ -83,7 +136,10 @@ struct its_metadata_block_header_t {
                          */ \
     size_t free_size;   /*!< Number of bytes free at end of block (set during \
                          *   block compaction for gap reuse) \
-                         */
+                         */ \
+    uint32_t erase_count; /*!< Number of times the physical block has been \
+                           *   erased \
+                           */
 
 struct its_block_meta_t {
     _T2
@@ -123,6 +179,90 @@ struct its_file_meta_t {
 };
 #undef _T3
 
+/**
+ * \struct its_file_index_t
+ *
+ * \brief Structure to store the index of the files in the active metadata
+ *        block, to find a file metadata entry without reading the flash.
+ */
+struct its_file_index_t {
+    uint8_t fid[ITS_FILE_INDEX_MAX_FILES][ITS_FILE_ID_SIZE]; /**< File ID of
+                                                              *   each file
+                                                              *   metadata entry
+                                                              */
+    uint16_t slot[ITS_FILE_INDEX_SLOTS]; /**< Hash table of file metadata entry
+                                          *   indexes plus one, 0 when empty
+                                          */
+    uint32_t free_map[ITS_FILE_INDEX_MAP_WORDS]; /**< Bitmap of the free file
+                                                  *   metadata entries
+                                                  */
+    uint32_t pending_idx[ITS_FILE_INDEX_PENDING]; /**< Entries which have a
+                                                   *   new file ID in the
+                                                   *   scratch metadata block
+                                                   */
+    uint8_t pending_fid[ITS_FILE_INDEX_PENDING][ITS_FILE_ID_SIZE]; /**< New
+                                                                    *   file IDs
+                                                                    */
+    uint32_t num_pending; /**< Number of pending file ID changes */
+    bool valid;           /**< True if the index matches the active metadata
+                           *   block
+                           */
+};
+
+/**
+ * \struct its_meta_cache_entry_t
+ *
+ * \brief Structure to store a metadata entry of the active metadata block in
+ *        the metadata cache.
+ */
+struct its_meta_cache_entry_t {
+    union {
+        struct its_file_meta_t file_meta;   /**< File metadata */
+        struct its_block_meta_t block_meta; /**< Block metadata */
+    } meta;
+    uint32_t key;      /**< Index of the metadata entry, with the top bit set
+                        *   for block metadata
+                        */
+    uint32_t last_use; /**< Value of the use counter when last accessed */
+    bool valid;        /**< True if the entry holds metadata */
+};
+
+/**
+ * \struct its_meta_cache_t
+ *
+ * \brief Structure to store the metadata cache, which holds metadata entries
+ *        read from the active metadata block. It is invalidated when the
+ *        metadata blocks are swapped.
+ */
+struct its_meta_cache_t {
+#if (ITS_METADATA_CACHE_ENTRIES > 0)
+    struct its_meta_cache_entry_t entry[ITS_METADATA_CACHE_ENTRIES]; /**< Cached
+                                                                      *   entries
+                                                                      */
+#endif
+    uint32_t use_count; /**< Counter of the cache accesses, to find the least
+                         *   recently used entry
+                         */
+};
+
+/**
+ * \struct its_flash_fs_write_t
+ *
+ * \brief Structure to store the state of a file write in progress, between the
+ *        start of the write and the metadata update which commits it.
+ */
+struct its_flash_fs_write_t {
+    struct its_file_meta_t file_meta;   /**< Metadata of the file written */
+    struct its_block_meta_t block_meta; /**< Metadata of the file's block */
+    uint32_t old_idx;     /**< File metadata entry of the existing file */
+    uint32_t new_idx;     /**< File metadata entry of the file written */
+    size_t offset;        /**< Offset in the file of the next data */
+    bool data_started;    /**< True if data was written in the scratch data
+                           *   block
+                           */
+    bool in_progress;     /**< True if a file write is in progress */
+};
+
 /**
  * \struct its_flash_fs_ctx_t
  *
@@ -135,6 +275,13 @@ struct its_flash_fs_ctx_t {
                                                            */
     uint32_t active_metablock;  /**< Active metadata block */
     uint32_t scratch_metablock; /**< Scratch metadata block */
+    bool scratch_dblock_dirty;  /**< True if the scratch data block must be
+                                 *   erased when the metadata update is
+                                 *   finalized
+                                 */
+    struct its_file_index_t file_index; /**< Index of the files */
+    struct its_meta_cache_t meta_cache; /**< Cache of the metadata */
+    struct its_flash_fs_write_t write;  /**< File write in progress */
 };
 
 /**
@@ -142,7 +289,9 @@ struct its_flash_fs_ctx_t {
  *
  * \param[in,out] fs_ctx  Filesystem context
  *
- * \return Returns value as specified in \ref psa_status_t
+ * \return Returns value as specified in \ref psa_status_t. Returns
+ *         PSA_ERROR_NOT_SUPPORTED if the flash holds a filesystem of the
+ *         previous layout, with the metadata blocks at fixed positions.
  */
 psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx);
 
@@ -163,6 +312,9 @@ psa_status_t its_flash_fs_mblock_cp_file_meta(struct its_flash_fs_ctx_t *fs_ctx,
 /**
  * \brief Gets current scratch datablock physical ID.
  *
+ * \note The scratch data block is expected to be written, so it is erased when
+ *       the metadata update is finalized.
+ *
  * \param[in,out] fs_ctx  Filesystem context
  * \param[in]     lblock  Logical block number
  *
@@ -175,6 +327,9 @@ uint32_t its_flash_fs_mblock_cur_data_scratch_id(
 /**
  * \brief Gets file metadata entry index.
  *
+ * \note The file is found in the file index held in RAM, without reading the
+ *       file metadata from flash, unless the file index could not be built.
+ *
  * \param[in,out] fs_ctx  Filesystem context
  * \param[in]     fid     ID of the file
  * \param[out]    idx     Index of the file metadata in the file system
@@ -291,14 +446,19 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
                                              struct its_flash_fs_ctx_t *fs_ctx);
 
 /**
- * \brief Sets current data scratch block
+ * \brief Swaps the physical block of a logical data block with the scratch data
+ *        block, which then holds the previous data of the logical block.
  *
- * \param[in,out] fs_ctx  Filesystem context
- * \param[in]     phy_id  Physical ID of scratch data block
- * \param[in]     lblock  Logical block number
+ * \note Logical data block 0 is swapped with the metadata blocks, so it is left
+ *       unchanged.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number
+ * \param[in,out] block_meta  Block metadata of the logical block
  */
-void its_flash_fs_mblock_set_data_scratch(struct its_flash_fs_ctx_t *fs_ctx,
-                                          uint32_t phy_id, uint32_t lblock);
+void its_flash_fs_mblock_swap_data_scratch(struct its_flash_fs_ctx_t *fs_ctx,
+                                           uint32_t lblock,
+                                           struct its_block_meta_t *block_meta);
 
 /**
  * \brief Puts logical block's metadata in scratch metadata block
@@ -7,6 +7,8 @@
 
 #include "tfm_internal_trusted_storage.h"
 
+#include <stdbool.h>
+
 #include "flash/its_flash.h"
 #include "flash_fs/its_flash_fs.h"
 #include "psa_manifest/pid.h"
@@ -22,6 +24,15 @@
 #define ITS_BUF_SIZE ITS_MAX_ASSET_SIZE
 #endif
 
+#ifndef ITS_TRANSACTION_MAX_OPS
+#define ITS_TRANSACTION_MAX_OPS 10
+#endif
+
+/* Client ID of the files which hold the data staged by a transaction. Each
+ * staged file uses the index of its transaction slot, plus one, as uid.
+ */
+#define ITS_TRANSACTION_CLIENT_ID 0
+
 /* Buffer to store asset data from the caller.
  * Note: size must be aligned to the max flash program unit to meet the
  * alignment requirement of the filesystem.
@@ -32,6 +43,26 @@ static uint8_t asset_data[ITS_UTILS_ALIGN(ITS_BUF_SIZE,
 static uint8_t g_fid[ITS_FILE_ID_SIZE];
 static struct its_file_info_t g_file_info;
 
+/*!
+ * \struct its_transaction_t
+ *
+ * \brief Changes staged by the transaction in progress.
+ */
+struct its_transaction_t {
+    bool in_progress;                 /*!< A transaction has begun */
+    int32_t client_id;                /*!< Owner of the transaction */
+    struct {
+        psa_storage_uid_t uid;        /*!< Asset changed, invalid if unused */
+        bool remove;                  /*!< The asset is removed rather than
+                                       *   replaced by the staged file
+                                       */
+    } ops[ITS_TRANSACTION_MAX_OPS];   /*!< Staged changes */
+};
+
+static struct its_transaction_t g_transaction;
+static uint8_t g_transaction_fids[2][ITS_TRANSACTION_MAX_OPS][ITS_FILE_ID_SIZE];
+static struct its_flash_fs_replace_t g_replace[ITS_TRANSACTION_MAX_OPS];
+
 static its_flash_fs_ctx_t fs_ctx_its;
 static its_flash_fs_ctx_t fs_ctx_ps;
 
@@ -55,6 +86,179 @@ static void tfm_its_get_fid(int32_t client_id,
     tfm_memcpy(fid + sizeof(client_id), (const void *)&uid, sizeof(uid));
 }
 
+/**
+ * \brief Maps a transaction slot to the ID of the file holding its staged data.
+ *
+ * \param[in]  slot  Index of the transaction slot
+ * \param[out] fid   Identifier of the file
+ */
+static void tfm_its_get_transaction_fid(uint32_t slot, uint8_t *fid)
+{
+    tfm_its_get_fid(ITS_TRANSACTION_CLIENT_ID, (psa_storage_uid_t)slot + 1,
+                    fid);
+}
+
+/**
+ * \brief Checks that an asset, if it exists, can be modified.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ * \param[in] fid     Identifier of the asset's file
+ *
+ * \return Returns PSA_SUCCESS if the asset exists and can be modified,
+ *         PSA_ERROR_DOES_NOT_EXIST if it does not exist, or another error code
+ *         as specified in \ref psa_status_t
+ */
+static psa_status_t its_check_modifiable(its_flash_fs_ctx_t *fs_ctx,
+                                         const uint8_t *fid)
+{
+    psa_status_t status;
+
+    status = its_flash_fs_file_get_info(fs_ctx, fid, &g_file_info);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* If the object exists and has the write once flag set, then it
+     * cannot be modified.
+     */
+    if (g_file_info.flags & PSA_STORAGE_FLAG_WRITE_ONCE) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes the data read from the caller to a file, replacing any
+ *        existing file.
+ *
+ * \param[in,out] fs_ctx       Filesystem context
+ * \param[in]     fid          Identifier of the file
+ * \param[in]     flags        Flags of the file
+ * \param[in]     data_length  Size of the data to read from the caller
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_write_file(its_flash_fs_ctx_t *fs_ctx,
+                                   const uint8_t *fid,
+                                   uint32_t flags,
+                                   size_t data_length)
+{
+    psa_status_t status;
+    size_t write_size;
+
+    flags |= ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
+
+    /* Start writing the file, which is committed once all the data has been
+     * written.
+     */
+    status = its_flash_fs_file_write_start(fs_ctx, fid, flags, data_length, 0);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Iteratively read data from the caller and write it to the filesystem, in
+     * chunks no larger than the size of the asset_data buffer.
+     */
+    while (data_length > 0) {
+        /* Write as much of the data as will fit in the asset_data buffer */
+        write_size = ITS_UTILS_MIN(data_length, sizeof(asset_data));
+
+        /* Read asset data from the caller */
+        (void)its_req_mngr_read(asset_data, write_size);
+
+        /* Write to the file in the file system */
+        status = its_flash_fs_file_write_data(fs_ctx, write_size, asset_data);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        data_length -= write_size;
+    }
+
+    /* Commit the file data in a single metadata update */
+    return its_flash_fs_file_write_end(fs_ctx);
+}
+
+/**
+ * \brief Deletes the files staged by the transaction in progress and ends it.
+ */
+static void its_transaction_discard(void)
+{
+    its_flash_fs_ctx_t *fs_ctx = get_fs_ctx(g_transaction.client_id);
+    uint32_t slot;
+
+    for (slot = 0; slot < ITS_TRANSACTION_MAX_OPS; slot++) {
+        if (g_transaction.ops[slot].uid != TFM_ITS_INVALID_UID &&
+            !g_transaction.ops[slot].remove) {
+            tfm_its_get_transaction_fid(slot, g_fid);
+            (void)its_flash_fs_file_delete(fs_ctx, g_fid);
+        }
+    }
+
+    g_transaction = (struct its_transaction_t){0};
+}
+
+/**
+ * \brief Deletes any staged files left behind by a transaction which did not
+ *        complete before a reset.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_transaction_recover(its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t status;
+    uint32_t slot;
+
+    for (slot = 0; slot < ITS_TRANSACTION_MAX_OPS; slot++) {
+        tfm_its_get_transaction_fid(slot, g_fid);
+        status = its_flash_fs_file_delete(fs_ctx, g_fid);
+        if (status != PSA_SUCCESS && status != PSA_ERROR_DOES_NOT_EXIST) {
+            return status;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Gets the transaction slot of an asset, allocating a free slot if the
+ *        asset has not been changed by the transaction.
+ *
+ * \param[in]  uid   Identifier of the asset
+ * \param[out] slot  Index of the transaction slot
+ *
+ * \return Returns PSA_ERROR_INSUFFICIENT_STORAGE if there is no free slot
+ */
+static psa_status_t its_transaction_get_slot(psa_storage_uid_t uid,
+                                             uint32_t *slot)
+{
+    uint32_t free_slot = ITS_TRANSACTION_MAX_OPS;
+    uint32_t i;
+
+    for (i = 0; i < ITS_TRANSACTION_MAX_OPS; i++) {
+        if (g_transaction.ops[i].uid == uid) {
+            *slot = i;
+            return PSA_SUCCESS;
+        }
+
+        if (g_transaction.ops[i].uid == TFM_ITS_INVALID_UID &&
+            free_slot == ITS_TRANSACTION_MAX_OPS) {
+            free_slot = i;
+        }
+    }
+
+    if (free_slot == ITS_TRANSACTION_MAX_OPS) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    *slot = free_slot;
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t tfm_its_init(void)
 {
     psa_status_t status;
@@ -73,8 +277,10 @@ psa_status_t tfm_its_init(void)
      * memory without a previous valid ITS flash layout in it. That is the case
      * when it is the first time in the device life that the ITS service is
      * executed.
+     * A filesystem of the previous layout is not wiped, as it still holds the
+     * assets of the device.
      */
-     if (status != PSA_SUCCESS) {
+     if ((status != PSA_SUCCESS) && (status != PSA_ERROR_NOT_SUPPORTED)) {
         /* Remove all data in the ITS memory area and create a valid ITS flash
          * layout in that area.
          */
@@ -89,6 +295,14 @@ psa_status_t tfm_its_init(void)
     }
 #endif /* ITS_CREATE_FLASH_LAYOUT */
 
+    if (status == PSA_SUCCESS) {
+        status = its_transaction_recover(&fs_ctx_its);
+    }
+
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
 #ifdef TFM_PARTITION_PROTECTED_STORAGE
     /* Initialise the PS context */
     status = its_flash_fs_prepare(&fs_ctx_ps,
@@ -104,8 +318,10 @@ psa_status_t tfm_its_init(void)
      * memory without a previous valid PS flash layout in it. That is the case
      * when it is the first time in the device life that the PS service is
      * executed.
+     * A filesystem of the previous layout is not wiped, as it still holds the
+     * assets of the device.
      */
-     if (status != PSA_SUCCESS) {
+     if ((status != PSA_SUCCESS) && (status != PSA_ERROR_NOT_SUPPORTED)) {
         /* Remove all data in the PS memory area and create a valid PS flash
          * layout in that area.
          */
@@ -120,6 +336,10 @@ psa_status_t tfm_its_init(void)
     }
 #endif /* PS_CREATE_FLASH_LAYOUT */
 
+    if (status == PSA_SUCCESS) {
+        status = its_transaction_recover(&fs_ctx_ps);
+    }
+
 #endif /* TFM_PARTITION_PROTECTED_STORAGE */
 
     return status;
@@ -131,9 +351,6 @@ psa_status_t tfm_its_set(int32_t client_id,
                          psa_storage_create_flags_t create_flags)
 {
     psa_status_t status;
-    size_t write_size;
-    size_t offset;
-    uint32_t flags;
 
     /* Check that the UID is valid */
     if (uid == TFM_ITS_INVALID_UID) {
@@ -150,53 +367,16 @@ psa_status_t tfm_its_set(int32_t client_id,
     /* Set file id */
     tfm_its_get_fid(client_id, uid, g_fid);
 
-    /* Read file info */
-    status = its_flash_fs_file_get_info(get_fs_ctx(client_id), g_fid,
-                                        &g_file_info);
-    if (status == PSA_SUCCESS) {
-        /* If the object exists and has the write once flag set, then it
-         * cannot be modified.
-         */
-        if (g_file_info.flags & PSA_STORAGE_FLAG_WRITE_ONCE) {
-            return PSA_ERROR_NOT_PERMITTED;
-        }
-    } else if (status != PSA_ERROR_DOES_NOT_EXIST) {
-        /* If the file does not exist, then do nothing.
-         * If other error occurred, return it
-         */
+    /* If the file does not exist, then do nothing.
+     * If other error occurred, return it
+     */
+    status = its_check_modifiable(get_fs_ctx(client_id), g_fid);
+    if (status != PSA_SUCCESS && status != PSA_ERROR_DOES_NOT_EXIST) {
         return status;
     }
 
-    offset = 0;
-    flags = (uint32_t)create_flags |
-            ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
-
-    /* Iteratively read data from the caller and write it to the filesystem, in
-     * chunks no larger than the size of the asset_data buffer.
-     */
-    do {
-        /* Write as much of the data as will fit in the asset_data buffer */
-        write_size = ITS_UTILS_MIN(data_length, sizeof(asset_data));
-
-        /* Read asset data from the caller */
-        (void)its_req_mngr_read(asset_data, write_size);
-
-        /* Write to the file in the file system */
-        status = its_flash_fs_file_write(get_fs_ctx(client_id), g_fid, flags,
-                                         data_length, write_size, offset,
-                                         asset_data);
-        if (status != PSA_SUCCESS) {
-            return status;
-        }
-
-        /* Do not create or truncate after the first iteration */
-        flags &= ~(ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE);
-
-        offset += write_size;
-        data_length -= write_size;
-    } while (data_length > 0);
-
-    return PSA_SUCCESS;
+    return its_write_file(get_fs_ctx(client_id), g_fid, (uint32_t)create_flags,
+                          data_length);
 }
 
 psa_status_t tfm_its_get(int32_t client_id,
@@ -334,3 +514,181 @@ psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid)
     /* Delete old file from the persistent area */
     return its_flash_fs_file_delete(get_fs_ctx(client_id), g_fid);
 }
+
+psa_status_t tfm_its_transaction_begin(int32_t client_id)
+{
+    if (g_transaction.in_progress) {
+        /* Only one transaction can be in progress at a time */
+        if (g_transaction.client_id != client_id) {
+            return PSA_ERROR_BAD_STATE;
+        }
+
+        /* The owner left its transaction unfinished, so discard it */
+        its_transaction_discard();
+    }
+
+    g_transaction.in_progress = true;
+    g_transaction.client_id = client_id;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_transaction_set(int32_t client_id,
+                                     psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+    uint32_t slot;
+
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* Check that the UID is valid */
+    if (uid == TFM_ITS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check that the create_flags does not contain any unsupported flags */
+    if (create_flags & ~(PSA_STORAGE_FLAG_WRITE_ONCE |
+                         PSA_STORAGE_FLAG_NO_CONFIDENTIALITY |
+                         PSA_STORAGE_FLAG_NO_REPLAY_PROTECTION)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    tfm_its_get_fid(client_id, uid, g_fid);
+
+    status = its_check_modifiable(get_fs_ctx(client_id), g_fid);
+    if (status != PSA_SUCCESS && status != PSA_ERROR_DOES_NOT_EXIST) {
+        return status;
+    }
+
+    status = its_transaction_get_slot(uid, &slot);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Stage the data in the slot's file, replacing any data staged before */
+    tfm_its_get_transaction_fid(slot, g_fid);
+    status = its_write_file(get_fs_ctx(client_id), g_fid,
+                            (uint32_t)create_flags, data_length);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    g_transaction.ops[slot].uid = uid;
+    g_transaction.ops[slot].remove = false;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_transaction_remove(int32_t client_id,
+                                        psa_storage_uid_t uid)
+{
+    psa_status_t status;
+    psa_status_t exists;
+    uint32_t slot;
+
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* Check that the UID is valid */
+    if (uid == TFM_ITS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    tfm_its_get_fid(client_id, uid, g_fid);
+
+    exists = its_check_modifiable(get_fs_ctx(client_id), g_fid);
+    if (exists != PSA_SUCCESS && exists != PSA_ERROR_DOES_NOT_EXIST) {
+        return exists;
+    }
+
+    status = its_transaction_get_slot(uid, &slot);
+    if (status != PSA_SUCCESS) {
+        return (exists == PSA_SUCCESS) ? status : exists;
+    }
+
+    if (g_transaction.ops[slot].uid == uid &&
+        !g_transaction.ops[slot].remove) {
+        /* Drop the data staged for the asset */
+        tfm_its_get_transaction_fid(slot, g_fid);
+        status = its_flash_fs_file_delete(get_fs_ctx(client_id), g_fid);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        g_transaction.ops[slot].uid = TFM_ITS_INVALID_UID;
+    } else if (exists != PSA_SUCCESS) {
+        return exists;
+    }
+
+    if (exists == PSA_SUCCESS) {
+        g_transaction.ops[slot].uid = uid;
+        g_transaction.ops[slot].remove = true;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_transaction_commit(int32_t client_id)
+{
+    psa_status_t status = PSA_SUCCESS;
+    uint32_t num_ops = 0;
+    uint32_t slot;
+
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    for (slot = 0; slot < ITS_TRANSACTION_MAX_OPS; slot++) {
+        if (g_transaction.ops[slot].uid == TFM_ITS_INVALID_UID) {
+            continue;
+        }
+
+        tfm_its_get_fid(client_id, g_transaction.ops[slot].uid,
+                        g_transaction_fids[0][num_ops]);
+
+        /* An asset made write once since it was staged cannot be changed */
+        status = its_check_modifiable(get_fs_ctx(client_id),
+                                      g_transaction_fids[0][num_ops]);
+        if (status != PSA_SUCCESS && status != PSA_ERROR_DOES_NOT_EXIST) {
+            break;
+        }
+        status = PSA_SUCCESS;
+
+        g_replace[num_ops].fid = g_transaction_fids[0][num_ops];
+        g_replace[num_ops].src_fid = NULL;
+
+        if (!g_transaction.ops[slot].remove) {
+            tfm_its_get_transaction_fid(slot, g_transaction_fids[1][num_ops]);
+            g_replace[num_ops].src_fid = g_transaction_fids[1][num_ops];
+        }
+
+        num_ops++;
+    }
+
+    /* Apply all the changes in a single metadata block update */
+    if (status == PSA_SUCCESS && num_ops > 0) {
+        status = its_flash_fs_file_replace(get_fs_ctx(client_id), g_replace,
+                                           num_ops);
+    }
+
+    /* Delete any staged files which have not been committed */
+    its_transaction_discard();
+
+    return status;
+}
+
+psa_status_t tfm_its_transaction_abort(int32_t client_id)
+{
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    its_transaction_discard();
+
+    return PSA_SUCCESS;
+}
@@ -163,6 +163,100 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
  */
 psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid);
 
+/**
+ * \brief Begins a transaction, which groups set and remove operations so that
+ *        they are applied atomically.
+ *
+ * If the client already has a transaction in progress, its staged changes are
+ * discarded first.
+ *
+ * \param[in] client_id  Identifier of the transaction's owner (client)
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS          The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE  The operation failed because another client has
+ *                              a transaction in progress
+ */
+psa_status_t tfm_its_transaction_begin(int32_t client_id);
+
+/**
+ * \brief Stages the setting of an asset in the transaction in progress.
+ *
+ * The data is read from the caller and written to storage, but the asset is
+ * only replaced when the transaction is committed.
+ *
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] uid           The identifier for the data
+ * \param[in] data_length   The size in bytes of the data in `p_data`
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return A status indicating the success/failure of the operation, as for
+ *         \ref tfm_its_set
+ *
+ * \retval PSA_ERROR_BAD_STATE             The client has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The transaction already changes the
+ *                                         maximum number of assets, or there
+ *                                         is no space to stage the data
+ */
+psa_status_t tfm_its_transaction_set(int32_t client_id,
+                                     psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Stages the removal of an asset in the transaction in progress.
+ *
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ * \param[in] uid        The `uid` value
+ *
+ * \return A status indicating the success/failure of the operation, as for
+ *         \ref tfm_its_remove
+ *
+ * \retval PSA_ERROR_BAD_STATE             The client has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The transaction already changes the
+ *                                         maximum number of assets
+ */
+psa_status_t tfm_its_transaction_remove(int32_t client_id,
+                                        psa_storage_uid_t uid);
+
+/**
+ * \brief Applies the changes staged in the transaction in progress and ends
+ *        the transaction.
+ *
+ * All the changes are applied in a single filesystem metadata update, so
+ * either all or none of them are applied, even after a power failure.
+ *
+ * \param[in] client_id  Identifier of the transaction's owner (client)
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The client has no transaction in progress
+ * \retval PSA_ERROR_NOT_PERMITTED    The operation failed because one of the
+ *                                    assets has been created with
+ *                                    PSA_STORAGE_FLAG_WRITE_ONCE since its
+ *                                    change was staged
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ */
+psa_status_t tfm_its_transaction_commit(int32_t client_id);
+
+/**
+ * \brief Discards the changes staged in the transaction in progress and ends
+ *        the transaction.
+ *
+ * \param[in] client_id  Identifier of the transaction's owner (client)
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS          The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE  The client has no transaction in progress
+ */
+psa_status_t tfm_its_transaction_abort(int32_t client_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,7 @@
 #include "tfm_internal_trusted_storage.h"
 #include "its_utils.h"
 #include "ps_object_defs.h"
+#include "tfm_its_defs.h"
 
 #ifdef TFM_PSA_API
 #include "psa/service.h"
@@ -24,6 +25,38 @@
 #include "tfm_api.h"
 #endif
 
+/**
+ * \brief Performs an operation of the transaction service.
+ *
+ * \param[in] client_id    Identifier of the caller
+ * \param[in] args         Arguments of the operation
+ * \param[in] data_length  Size of the data of a set operation
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ */
+static psa_status_t its_transaction(
+                                  int32_t client_id,
+                                  const struct tfm_its_transaction_args_t *args,
+                                  size_t data_length)
+{
+    switch (args->op) {
+    case TFM_ITS_TRANSACTION_BEGIN:
+        return tfm_its_transaction_begin(client_id);
+    case TFM_ITS_TRANSACTION_SET:
+        return tfm_its_transaction_set(client_id, args->uid, data_length,
+                                       args->create_flags);
+    case TFM_ITS_TRANSACTION_REMOVE:
+        return tfm_its_transaction_remove(client_id, args->uid);
+    case TFM_ITS_TRANSACTION_COMMIT:
+        return tfm_its_transaction_commit(client_id);
+    case TFM_ITS_TRANSACTION_ABORT:
+        return tfm_its_transaction_abort(client_id);
+    default:
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+}
+
 #ifndef TFM_PSA_API
 static uint8_t *p_data;
 
@@ -179,6 +212,44 @@ psa_status_t tfm_its_remove_req(psa_invec *in_vec, size_t in_len,
     return tfm_its_remove(client_id, uid);
 }
 
+psa_status_t tfm_its_transaction_req(psa_invec *in_vec, size_t in_len,
+                                     psa_outvec *out_vec, size_t out_len)
+{
+    struct tfm_its_transaction_args_t args;
+    size_t data_length = 0;
+    int32_t client_id;
+
+    (void)out_vec;
+
+    if (!its_is_init) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    if ((in_len < 1) || (in_len > 2) || (out_len != 0)) {
+        /* The number of arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    if (in_vec[0].len != sizeof(args)) {
+        /* The input argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    args = *((struct tfm_its_transaction_args_t *)in_vec[0].base);
+
+    if (in_len == 2) {
+        p_data = (uint8_t *)in_vec[1].base;
+        data_length = in_vec[1].len;
+    }
+
+    /* Get the caller's client ID */
+    if (tfm_core_get_caller_client_id(&client_id) != (int32_t)TFM_SUCCESS) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return its_transaction(client_id, &args, data_length);
+}
+
 #else /* !defined(TFM_PSA_API) */
 typedef psa_status_t (*its_func_t)(void);
 static psa_msg_t msg;
@@ -285,6 +356,24 @@ static psa_status_t tfm_its_remove_ipc(void)
     return tfm_its_remove(msg.client_id, uid);
 }
 
+static psa_status_t tfm_its_transaction_ipc(void)
+{
+    struct tfm_its_transaction_args_t args;
+    size_t num;
+
+    if (msg.in_size[0] != sizeof(args)) {
+        /* The input argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &args, sizeof(args));
+    if (num != sizeof(args)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return its_transaction(msg.client_id, &args, msg.in_size[1]);
+}
+
 /*
  * Fixme: Temporarily implement abort as infinite loop,
  * will replace it later.
@@ -340,6 +429,9 @@ psa_status_t tfm_its_req_mngr_init(void)
             its_signal_handle(TFM_ITS_GET_INFO_SIGNAL, tfm_its_get_info_ipc);
         } else if (signals & TFM_ITS_REMOVE_SIGNAL) {
             its_signal_handle(TFM_ITS_REMOVE_SIGNAL, tfm_its_remove_ipc);
+        } else if (signals & TFM_ITS_TRANSACTION_SIGNAL) {
+            its_signal_handle(TFM_ITS_TRANSACTION_SIGNAL,
+                              tfm_its_transaction_ipc);
         } else {
             tfm_abort();
         }
@@ -9,6 +9,7 @@
 
 #include <stdbool.h>
 
+#include "tfm_attest_hal.h"
 #include "tfm_crypto_defs.h"
 #include "psa/crypto.h"
 #include "tfm_memory_utils.h"
@@ -17,6 +18,13 @@
 #define PS_CRYPTO_AEAD_ALG PSA_ALG_GCM
 #endif
 
+#ifndef PS_CRYPTO_KEY_EPOCH
+/* The number of uses of the storage key after which it is derived again. 0
+ * derives it once per boot.
+ */
+#define PS_CRYPTO_KEY_EPOCH 0
+#endif
+
 /* The PSA key type used by this implementation */
 #define PS_KEY_TYPE PSA_KEY_TYPE_AES
 /* The PSA key usage required by this implementation */
@@ -39,11 +47,47 @@ static const uint8_t ps_key_label[] = "storage_key";
 static psa_key_handle_t ps_key_handle;
 static uint8_t ps_crypto_iv_buf[PS_IV_LEN_BYTES];
 
+/* The storage key is derived from the HUK on first use and then cached until
+ * it is flushed, the key epoch ends or the security lifecycle changes.
+ */
+static bool ps_key_valid;
+static uint32_t ps_key_uses;
+static enum tfm_security_lifecycle_t ps_key_lifecycle;
+
 psa_status_t ps_crypto_init(void)
 {
-    /* Currently, no initialisation is required. This may change if key
-     * handling is changed.
-     */
+    /* The storage key is derived on first use. */
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_flush_key(void)
+{
+    psa_status_t status;
+
+    if (!ps_key_valid) {
+        return PSA_SUCCESS;
+    }
+
+    ps_key_valid = false;
+    ps_key_uses = 0;
+
+    /* Destroying the volatile key zeroizes the key material */
+    status = psa_destroy_key(ps_key_handle);
+    if (status != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_check_lifecycle(void)
+{
+    /* A key derived in another lifecycle state must not be kept any more */
+    if (ps_key_valid &&
+        (tfm_attest_hal_get_security_lifecycle() != ps_key_lifecycle)) {
+        return ps_crypto_flush_key();
+    }
+
     return PSA_SUCCESS;
 }
 
@@ -53,6 +97,24 @@ psa_status_t ps_crypto_setkey(void)
     psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
     psa_key_derivation_operation_t op = PSA_KEY_DERIVATION_OPERATION_INIT;
 
+    status = ps_crypto_check_lifecycle();
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (ps_key_valid) {
+        if ((PS_CRYPTO_KEY_EPOCH == 0) ||
+            (ps_key_uses < PS_CRYPTO_KEY_EPOCH)) {
+            ps_key_uses++;
+            return PSA_SUCCESS;
+        }
+
+        status = ps_crypto_flush_key();
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+
     /* Set the key attributes for the storage key */
     psa_set_key_usage_flags(&attributes, PS_KEY_USAGE);
     psa_set_key_algorithm(&attributes, PS_CRYPTO_ALG);
@@ -85,6 +147,10 @@ psa_status_t ps_crypto_setkey(void)
         goto err_release_key;
     }
 
+    ps_key_valid = true;
+    ps_key_uses = 1;
+    ps_key_lifecycle = tfm_attest_hal_get_security_lifecycle();
+
     return PSA_SUCCESS;
 
 err_release_key:
@@ -98,14 +164,9 @@ err_release_op:
 
 psa_status_t ps_crypto_destroykey(void)
 {
-    psa_status_t status;
-
-    /* Destroy the transient key */
-    status = psa_destroy_key(ps_key_handle);
-    if (status != PSA_SUCCESS) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
+    /* The key is kept for the next operation. It is destroyed by
+     * ps_crypto_flush_key(), or when ps_crypto_setkey() finds it expired.
+     */
     return PSA_SUCCESS;
 }
 
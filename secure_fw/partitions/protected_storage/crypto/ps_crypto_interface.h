@@ -42,17 +42,40 @@ psa_status_t ps_crypto_init(void);
 /**
  * \brief Sets the key to use for crypto operations for the current client.
  *
+ * \details The storage key is derived from the HUK on first use and cached
+ *          for the next operations. It is derived again after
+ *          PS_CRYPTO_KEY_EPOCH uses, if not 0, or when the security lifecycle
+ *          of the device has changed.
+ *
  * \return Returns values as described in \ref psa_status_t
  */
 psa_status_t ps_crypto_setkey(void);
 
 /**
- * \brief Destroys the transient key used for crypto operations.
+ * \brief Releases the key used for crypto operations.
+ *
+ * \details The key stays cached, use \ref ps_crypto_flush_key to destroy it.
  *
  * \return Returns values as described in \ref psa_status_t
  */
 psa_status_t ps_crypto_destroykey(void);
 
+/**
+ * \brief Destroys the cached storage key, so that it is derived again on next
+ *        use.
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_flush_key(void);
+
+/**
+ * \brief Destroys the cached storage key if the security lifecycle of the
+ *        device has changed since it was derived.
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_check_lifecycle(void);
+
 /**
  * \brief Encrypts and tags the given plaintext data.
  *
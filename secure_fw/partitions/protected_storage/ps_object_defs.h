@@ -65,9 +65,11 @@ struct ps_object_t {
  * \def PS_MAX_NUM_OBJECTS
  *
  * \brief Specifies the maximum number of objects in the system, which is the
- *        number of defined assets, the object table and 2 temporary objects to
- *        store the temporary object table and temporary updated object.
+ *        number of defined assets, the object table, the object table journal
+ *        and 2 temporary objects to store the temporary object table and
+ *        temporary updated object, plus the spare file which the filesystem
+ *        keeps free for replacing an existing file.
  */
-#define PS_MAX_NUM_OBJECTS (PS_NUM_ASSETS + 3)
+#define PS_MAX_NUM_OBJECTS (PS_NUM_ASSETS + 5)
 
 #endif /* __PS_OBJECT_DEFS_H__ */
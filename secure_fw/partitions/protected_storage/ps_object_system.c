@@ -30,6 +30,18 @@
 static struct ps_object_t g_ps_object;
 static struct ps_obj_table_info_t g_obj_tbl_info;
 
+/* Changes staged by the transaction in progress, kept contiguous. A staged
+ * object is written to a reserved file ID and added to the table on commit.
+ */
+static struct ps_obj_table_change_t g_staged[PS_TRANSACTION_MAX_OPS];
+#ifdef PS_ENCRYPTION
+static uint8_t g_staged_tags[PS_TRANSACTION_MAX_OPS][PS_TAG_LEN_BYTES];
+#endif
+static uint32_t g_num_staged;
+
+/* File IDs of the objects replaced by the committed changes */
+static uint32_t g_replaced_fids[PS_TRANSACTION_MAX_OPS];
+
 /**
  * \brief Initialize g_ps_object based on the input parameters and empty data.
  *
@@ -154,6 +166,99 @@ static psa_status_t ps_write_object(uint32_t wrt_size)
 
 #endif /* !PS_ENCRYPTION */
 
+/**
+ * \brief Reads the header of an object to check that it can be modified. On
+ *        success, g_obj_tbl_info and g_ps_object contain the object.
+ *
+ * \param[in] uid        Unique identifier for the data
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ *
+ * \return Returns PSA_ERROR_NOT_PERMITTED if the object has the write once
+ *         flag set. Otherwise, it returns error code as specified in
+ *         \ref psa_status_t
+ */
+static psa_status_t ps_object_check_modifiable(psa_storage_uid_t uid,
+                                               int32_t client_id)
+{
+    psa_status_t err;
+
+    err = ps_object_table_get_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+#ifdef PS_ENCRYPTION
+    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+#else
+    err = ps_read_object(READ_HEADER_ONLY);
+#endif
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (g_ps_object.header.info.create_flags & PSA_STORAGE_FLAG_WRITE_ONCE) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Gets the index of the change staged for an object.
+ *
+ * \param[in] uid        Unique identifier for the data
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ *
+ * \return Returns the index of the staged change, or g_num_staged if no
+ *         change is staged for the object.
+ */
+static uint32_t ps_object_staged_idx(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t i;
+
+    for (i = 0; i < g_num_staged; i++) {
+        if (g_staged[i].uid == uid && g_staged[i].client_id == client_id) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * \brief Deletes the object written by a staged change, if any, and releases
+ *        its file ID.
+ *
+ * \param[in] i  Index of the staged change
+ */
+static void ps_object_discard_staged_data(uint32_t i)
+{
+    if (g_staged[i].info.fid != PS_INVALID_FID) {
+        (void)psa_its_remove(g_staged[i].info.fid);
+        ps_object_table_release_fid(g_staged[i].info.fid);
+        g_staged[i].info.fid = PS_INVALID_FID;
+    }
+}
+
+/**
+ * \brief Drops a staged change, moving the last staged change in its place.
+ *
+ * \param[in] i  Index of the staged change
+ */
+static void ps_object_unstage(uint32_t i)
+{
+    ps_object_discard_staged_data(i);
+
+    g_num_staged--;
+    if (i != g_num_staged) {
+        g_staged[i] = g_staged[g_num_staged];
+#ifdef PS_ENCRYPTION
+        (void)tfm_memcpy(g_staged_tags[i], g_staged_tags[g_num_staged],
+                         PS_TAG_LEN_BYTES);
+#endif
+    }
+}
+
 psa_status_t ps_system_prepare(void)
 {
     psa_status_t err;
@@ -519,6 +624,222 @@ clear_data_and_return:
     return err;
 }
 
+psa_status_t ps_object_stage_create(psa_storage_uid_t uid, int32_t client_id,
+                                    psa_storage_create_flags_t create_flags,
+                                    uint32_t size)
+{
+    psa_status_t err;
+    uint32_t i;
+    uint32_t fid_am_reserved = 1;
+
+#ifndef PS_ENCRYPTION
+    uint32_t wrt_size;
+#endif
+
+    /* Boundary check the incoming request */
+    if (size > PS_MAX_ASSET_SIZE) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    i = ps_object_staged_idx(uid, client_id);
+    if (i == PS_TRANSACTION_MAX_OPS) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    err = ps_object_check_modifiable(uid, client_id);
+    if (err == PSA_SUCCESS) {
+        /* Update the create flags and max object size */
+        g_ps_object.header.info.create_flags = create_flags;
+        g_ps_object.header.info.max_size = size;
+    } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
+        /* If the object does not exist, then initialize it based on the input
+         * arguments and empty content. Requests 2 FIDs to prevent exhaustion.
+         */
+        fid_am_reserved = 2;
+        ps_init_empty_object(create_flags, size, &g_ps_object);
+    } else {
+        goto clear_data_and_return;
+    }
+
+    /* Update the object data */
+    err = ps_req_mngr_read_asset_data(g_ps_object.data, size);
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+    /* Update the current object size */
+    g_ps_object.header.info.current_size = size;
+
+    /* Get a new file ID, kept until the transaction ends */
+    err = ps_object_table_reserve_fid(fid_am_reserved, &g_obj_tbl_info.fid);
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+#ifdef PS_ENCRYPTION
+    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object);
+#else
+    wrt_size = PS_OBJECT_SIZE(g_ps_object.header.info.current_size);
+
+    /* Write g_ps_object */
+    err = ps_write_object(wrt_size);
+#endif
+    if (err != PSA_SUCCESS) {
+        (void)psa_its_remove(g_obj_tbl_info.fid);
+        ps_object_table_release_fid(g_obj_tbl_info.fid);
+
+        goto clear_data_and_return;
+    }
+
+    /* Replace the change staged before for the object, if any */
+    if (i < g_num_staged) {
+        ps_object_discard_staged_data(i);
+    } else {
+        g_num_staged++;
+    }
+
+    g_staged[i].uid = uid;
+    g_staged[i].client_id = client_id;
+    g_staged[i].info.fid = g_obj_tbl_info.fid;
+#ifdef PS_ENCRYPTION
+    (void)tfm_memcpy(g_staged_tags[i], g_obj_tbl_info.tag, PS_TAG_LEN_BYTES);
+#else
+    g_staged[i].info.version = g_obj_tbl_info.version;
+#endif
+
+clear_data_and_return:
+    /* Remove data stored in the object before leaving the function */
+    (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
+                     PS_MAX_OBJECT_SIZE);
+
+    return err;
+}
+
+psa_status_t ps_object_stage_delete(psa_storage_uid_t uid, int32_t client_id)
+{
+    psa_status_t err;
+    uint32_t i;
+
+    i = ps_object_staged_idx(uid, client_id);
+
+    err = ps_object_check_modifiable(uid, client_id);
+    if (err == PSA_ERROR_DOES_NOT_EXIST) {
+        if (i < g_num_staged && g_staged[i].info.fid != PS_INVALID_FID) {
+            /* The object is only staged for creation, so drop it */
+            ps_object_unstage(i);
+            err = PSA_SUCCESS;
+        }
+
+        goto clear_data_and_return;
+    } else if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+    if (i < g_num_staged) {
+        ps_object_discard_staged_data(i);
+    } else if (i == PS_TRANSACTION_MAX_OPS) {
+        err = PSA_ERROR_INSUFFICIENT_STORAGE;
+        goto clear_data_and_return;
+    } else {
+        g_num_staged++;
+    }
+
+    g_staged[i].uid = uid;
+    g_staged[i].client_id = client_id;
+    g_staged[i].info.fid = PS_INVALID_FID;
+
+clear_data_and_return:
+    /* Remove data stored in the object before leaving the function */
+    (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
+                     PS_MAX_OBJECT_SIZE);
+
+    return err;
+}
+
+psa_status_t ps_object_commit(void)
+{
+    psa_status_t err = PSA_SUCCESS;
+    psa_status_t status;
+    uint32_t num_changes;
+    uint32_t i = 0;
+
+    while (i < g_num_staged) {
+        /* An object made write once since it was staged cannot be changed */
+        err = ps_object_check_modifiable(g_staged[i].uid,
+                                         g_staged[i].client_id);
+        if (err == PSA_SUCCESS) {
+            g_replaced_fids[i] = g_obj_tbl_info.fid;
+        } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            if (g_staged[i].info.fid == PS_INVALID_FID) {
+                /* The object to delete has already been deleted */
+                ps_object_unstage(i);
+                continue;
+            }
+
+            g_replaced_fids[i] = PS_INVALID_FID;
+        } else {
+            goto discard_and_return;
+        }
+
+#ifdef PS_ENCRYPTION
+        g_staged[i].info.tag = g_staged_tags[i];
+#endif
+        i++;
+    }
+
+    err = PSA_SUCCESS;
+    if (g_num_staged == 0) {
+        goto clear_data_and_return;
+    }
+
+    /* Update the table with all the staged changes, and store it in the
+     * persistent area.
+     */
+    err = ps_object_table_set_obj_tbl_infos(g_staged, g_num_staged);
+    if (err != PSA_SUCCESS) {
+        goto discard_and_return;
+    }
+
+    /* The staged objects are now in the table */
+    num_changes = g_num_staged;
+    for (i = 0; i < num_changes; i++) {
+        if (g_staged[i].info.fid != PS_INVALID_FID) {
+            ps_object_table_release_fid(g_staged[i].info.fid);
+        }
+    }
+    g_num_staged = 0;
+
+    /* Delete old object table and the replaced objects */
+    err = ps_object_table_delete_old_table();
+    for (i = 0; i < num_changes; i++) {
+        if (g_replaced_fids[i] != PS_INVALID_FID) {
+            status = psa_its_remove(g_replaced_fids[i]);
+            if (err == PSA_SUCCESS) {
+                err = status;
+            }
+        }
+    }
+
+    goto clear_data_and_return;
+
+discard_and_return:
+    ps_object_discard();
+
+clear_data_and_return:
+    /* Remove data stored in the object before leaving the function */
+    (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
+                     PS_MAX_OBJECT_SIZE);
+
+    return err;
+}
+
+void ps_object_discard(void)
+{
+    while (g_num_staged > 0) {
+        ps_object_unstage(g_num_staged - 1);
+    }
+}
+
 psa_status_t ps_system_wipe_all(void)
 {
     /* This function may get called as a corrective action
@@ -92,6 +92,46 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id);
 psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
                                 struct psa_storage_info_t *info);
 
+/**
+ * \brief Stages the creation or replacement of the object with the provided
+ *        UID and client ID. The object is written to the file system, but it
+ *        is only added to the object table by \ref ps_object_commit.
+ *
+ * \param[in] uid           Unique identifier for the data
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] create_flags  Flags indicating the properties of the data
+ * \param[in] size          Size of the contents of `data` in bytes
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_object_stage_create(psa_storage_uid_t uid, int32_t client_id,
+                                    psa_storage_create_flags_t create_flags,
+                                    uint32_t size);
+
+/**
+ * \brief Stages the deletion of the object with the provided UID and client
+ *        ID, or drops the creation staged for it.
+ *
+ * \param[in] uid        Unique identifier for the data
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_object_stage_delete(psa_storage_uid_t uid, int32_t client_id);
+
+/**
+ * \brief Applies all the staged changes with a single object table update.
+ *        The staged changes are discarded if they cannot be applied.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_object_commit(void);
+
+/**
+ * \brief Discards all the staged changes.
+ */
+void ps_object_discard(void);
+
 /**
  * \brief Wipes the protected storage system and all object data.
  *
@@ -7,6 +7,7 @@
 
 #include "ps_object_table.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "cmsis_compiler.h"
@@ -26,7 +27,23 @@
  *
  * \brief Current object system version.
  */
-#define PS_OBJECT_SYSTEM_VERSION  0x01
+#define PS_OBJECT_SYSTEM_VERSION  0x02
+
+/*!
+ * \def PS_OBJECT_SYSTEM_PREV_VERSION
+ *
+ * \brief Previous object system version, without the object table journal.
+ *        Its object tables are converted to the current version at
+ *        initialization.
+ */
+#define PS_OBJECT_SYSTEM_PREV_VERSION  0x01
+
+#ifndef PS_OBJ_TABLE_JOURNAL_RECORDS
+/* The number of table changes recorded in the journal before the whole table
+ * is written again.
+ */
+#define PS_OBJ_TABLE_JOURNAL_RECORDS 8
+#endif
 
 /*!
  * \struct ps_obj_table_info_t
@@ -67,11 +84,67 @@ struct ps_obj_table_t {
                                   */
 #endif /* PS_ROLLBACK_PROTECTION */
 
+  uint32_t generation;           /*!< Incremented each time the table is
+                                  *   saved, to match the journal records.
+                                  */
+
+#ifdef PS_ROLLBACK_PROTECTION
+  uint32_t nv_counter;           /*!< Value of PS NV counter 1 when the table
+                                  *   was saved.
+                                  */
+#endif /* PS_ROLLBACK_PROTECTION */
+
   struct ps_obj_table_entry_t obj_db[PS_OBJ_TABLE_ENTRIES]; /*!< Table's
                                                              *   entries
                                                              */
 };
 
+/*!
+ * \struct ps_obj_table_prev_t
+ *
+ * \brief Object table structure of the previous object system version.
+ */
+struct ps_obj_table_prev_t {
+#ifdef PS_ENCRYPTION
+  union ps_crypto_t crypto;      /*!< Crypto metadata. */
+#endif
+
+  uint8_t version;               /*!< PS object system version. */
+
+#ifndef PS_ROLLBACK_PROTECTION
+  uint8_t swap_count;            /*!< Swap counter to distinguish 2 different
+                                  *   object tables.
+                                  */
+#endif /* PS_ROLLBACK_PROTECTION */
+
+  struct ps_obj_table_entry_t obj_db[PS_OBJ_TABLE_ENTRIES]; /*!< Table's
+                                                             *   entries
+                                                             */
+};
+
+/*!
+ * \struct ps_obj_table_record_t
+ *
+ * \brief Object table journal record structure. A record holds the new
+ *        content of one table entry, so that a change in the table does not
+ *        require the whole table to be saved.
+ */
+struct ps_obj_table_record_t {
+#ifdef PS_ENCRYPTION
+    union ps_crypto_t crypto;          /*!< Crypto metadata of the record */
+#endif
+    uint32_t generation;               /*!< Generation of the table the
+                                        *   record applies to
+                                        */
+#ifdef PS_ROLLBACK_PROTECTION
+    uint32_t nv_counter;               /*!< Value of PS NV counter 1 when the
+                                        *   record was saved
+                                        */
+#endif
+    uint32_t idx;                      /*!< Index of the entry in the table */
+    struct ps_obj_table_entry_t entry; /*!< New content of the entry */
+};
+
 /* Object table indexes */
 #define PS_OBJ_TABLE_IDX_0 0
 #define PS_OBJ_TABLE_IDX_1 1
@@ -117,6 +190,14 @@ struct ps_obj_table_t {
 #define PS_OBJECT_FS_ID_TO_IDX(fid) ((fid - 1) - \
                                       PS_TABLE_FS_ID(PS_OBJ_TABLE_IDX_1))
 
+/*!
+ * \def PS_OBJ_TABLE_JOURNAL_FS_ID
+ *
+ * \brief File ID to be used in order to store the object table journal in the
+ *        file system.
+ */
+#define PS_OBJ_TABLE_JOURNAL_FS_ID PS_OBJECT_FS_ID(PS_OBJ_TABLE_ENTRIES)
+
 /*!
  * \struct ps_obj_table_ctx_t
  *
@@ -126,14 +207,33 @@ struct ps_obj_table_ctx_t {
     struct ps_obj_table_t obj_table;  /*!< Object tables */
     uint8_t active_table;             /*!< Active object table */
     uint8_t scratch_table;            /*!< Scratch object table */
+    uint32_t journal_len;             /*!< Number of journal records */
+    struct ps_obj_table_record_t journal[PS_OBJ_TABLE_JOURNAL_RECORDS];
+                                      /*!< Journal of the active table */
+    bool reserved[PS_OBJ_TABLE_ENTRIES];
+                                      /*!< Free entries reserved for objects
+                                       *   not yet added to the table
+                                       */
 };
 
 /* Object table context */
 static struct ps_obj_table_ctx_t ps_obj_table_ctx;
 
+/* Maximum number of entries changed by ps_object_table_set_obj_tbl_infos */
+#define PS_OBJ_TABLE_MAX_CHANGED (2 * PS_TRANSACTION_MAX_OPS)
+
+/* Indexes and backup copies of the entries changed by
+ * ps_object_table_set_obj_tbl_infos, to rollback the changes on failure.
+ */
+static uint32_t ps_changed_idxs[PS_OBJ_TABLE_MAX_CHANGED];
+static struct ps_obj_table_entry_t ps_backup_entries[PS_OBJ_TABLE_MAX_CHANGED];
+
 /* Object table size */
 #define PS_OBJ_TABLE_SIZE            sizeof(struct ps_obj_table_t)
 
+/* Object table size of the previous object system version */
+#define PS_OBJ_TABLE_PREV_SIZE       sizeof(struct ps_obj_table_prev_t)
+
 /* Object table entry size */
 #define PS_OBJECTS_TABLE_ENTRY_SIZE  sizeof(struct ps_obj_table_entry_t)
 
@@ -158,13 +258,54 @@ struct ps_crypto_assoc_data_t {
 
 #define PS_CRYPTO_ASSOCIATED_DATA_LEN  sizeof(struct ps_crypto_assoc_data_t)
 
+/* Associated data of an object table of the previous object system version */
+struct ps_crypto_prev_assoc_data_t {
+    uint8_t  obj_table_data[PS_OBJ_TABLE_PREV_SIZE -
+                            PS_NON_AUTH_OBJ_TABLE_SIZE];
+    uint32_t nv_counter;
+};
+
 #else
 
 /* The associated data is the header, minus the the tag data */
 #define PS_CRYPTO_ASSOCIATED_DATA_LEN (PS_OBJ_TABLE_SIZE - \
                                        PS_NON_AUTH_OBJ_TABLE_SIZE)
+
+/* Associated data length of an object table of the previous object system
+ * version
+ */
+#define PS_CRYPTO_PREV_ASSOCIATED_DATA_LEN (PS_OBJ_TABLE_PREV_SIZE - \
+                                            PS_NON_AUTH_OBJ_TABLE_SIZE)
 #endif /* PS_ROLLBACK_PROTECTION */
 
+/* Journal record size */
+#define PS_OBJ_TABLE_RECORD_SIZE     sizeof(struct ps_obj_table_record_t)
+
+/* The associated data of a journal record is the record, minus the crypto
+ * data, and its position in the journal so that the records cannot be
+ * reordered.
+ */
+struct ps_record_assoc_data_t {
+    uint8_t  record_data[PS_OBJ_TABLE_RECORD_SIZE -
+                         PS_NON_AUTH_OBJ_TABLE_SIZE];
+    uint32_t position;
+};
+
+/* The journal file is written again with each change, as the file system has
+ * no partial writes. So the journal is compacted into the table before it
+ * holds more than PS_OBJ_TABLE_JOURNAL_RECORDS records, or before it gets
+ * larger than the table, which would make a change cost more than saving the
+ * whole table.
+ */
+#define PS_OBJ_TABLE_JOURNAL_FITS(len) \
+    (((len) <= PS_OBJ_TABLE_JOURNAL_RECORDS) && \
+     (((len) * PS_OBJ_TABLE_RECORD_SIZE) <= PS_OBJ_TABLE_SIZE))
+
+/* Check at compilation time if the journal fits in a file */
+PS_UTILS_BOUND_CHECK(OBJ_TABLE_JOURNAL_NOT_FIT_IN_FILE,
+                     PS_OBJ_TABLE_JOURNAL_RECORDS * PS_OBJ_TABLE_RECORD_SIZE,
+                     PS_MAX_ASSET_SIZE);
+
 /* The ps_object_table_init function uses the static memory allocated for
  * the object data manipulation, in ps_object_table.c (g_ps_object), to load a
  * temporary object table to be validated at that stage.
@@ -202,12 +343,37 @@ struct ps_obj_table_init_ctx_t {
                                                              *   table X is
                                                              *   valid
                                                              */
+    uint32_t journal_len[PS_NUM_OBJ_TABLES]; /*!< Number of journal records
+                                              *   of object table X
+                                              */
+    bool prev_version[PS_NUM_OBJ_TABLES]; /*!< Indicates if object table X
+                                           *   is of the previous object
+                                           *   system version
+                                           */
 #ifdef PS_ROLLBACK_PROTECTION
     uint32_t nvc_1;        /*!< Non-volatile counter value 1 */
     uint32_t nvc_3;        /*!< Non-volatile counter value 3 */
 #endif /* PS_ROLLBACK_PROTECTION */
 };
 
+/**
+ * \brief Checks if an object table read from persistent memory is of the
+ *        previous object system version.
+ *
+ * \param[in] p_table      Pointer to the object table
+ * \param[in] data_length  Size of the object table file
+ *
+ * \return Returns true if the table is of the previous version
+ */
+__attribute__ ((always_inline))
+__STATIC_INLINE bool ps_object_table_is_prev_version(
+                                          const struct ps_obj_table_t *p_table,
+                                          size_t data_length)
+{
+    return (data_length == PS_OBJ_TABLE_PREV_SIZE) &&
+           (p_table->version == PS_OBJECT_SYSTEM_PREV_VERSION);
+}
+
 /**
  * \brief Reads object table from persistent memory.
  *
@@ -230,6 +396,11 @@ __STATIC_INLINE void ps_object_table_fs_read_table(
                       &data_length);
     if (err != PSA_SUCCESS) {
         init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
+    } else {
+        init_ctx->prev_version[PS_OBJ_TABLE_IDX_0] =
+                               ps_object_table_is_prev_version(
+                                   init_ctx->p_table[PS_OBJ_TABLE_IDX_0],
+                                   data_length);
     }
 
     /* Read file with the table 1 data */
@@ -240,7 +411,24 @@ __STATIC_INLINE void ps_object_table_fs_read_table(
                       &data_length);
     if (err != PSA_SUCCESS) {
         init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
+    } else {
+        init_ctx->prev_version[PS_OBJ_TABLE_IDX_1] =
+                               ps_object_table_is_prev_version(
+                                   init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
+                                   data_length);
     }
+
+    /* Read file with the journal records */
+    err = psa_its_get(PS_OBJ_TABLE_JOURNAL_FS_ID,
+                      PS_OBJECT_TABLE_OBJECT_OFFSET,
+                      sizeof(ps_obj_table_ctx.journal),
+                      (void *)ps_obj_table_ctx.journal,
+                      &data_length);
+    if (err != PSA_SUCCESS) {
+        data_length = 0;
+    }
+
+    ps_obj_table_ctx.journal_len = data_length / PS_OBJ_TABLE_RECORD_SIZE;
 }
 
 /**
@@ -349,27 +537,29 @@ __STATIC_INLINE psa_status_t ps_object_table_nvc_generate_auth_tag(
 }
 
 /**
- * \brief Authenticates table of objects.
+ * \brief Authenticates table of objects of the previous object system version.
  *
  * \param[in]     table_idx  Table index in the init context
  * \param[in,out] init_ctx   Pointer to the object table to authenticate
  *
  */
-static void ps_object_table_authenticate(uint8_t table_idx,
+static void ps_object_table_prev_authenticate(uint8_t table_idx,
                                        struct ps_obj_table_init_ctx_t *init_ctx)
 {
-    struct ps_crypto_assoc_data_t assoc_data;
+    struct ps_crypto_prev_assoc_data_t assoc_data;
     union ps_crypto_t *crypto = &init_ctx->p_table[table_idx]->crypto;
     psa_status_t err;
 
-    /* Init associated data with NVC 1 */
+    /* The previous version authenticates the table with the latest NVC 1
+     * value, or with the NVC 3 value after a power failure.
+     */
     assoc_data.nv_counter = init_ctx->nvc_1;
     (void)tfm_memcpy(assoc_data.obj_table_data,
                      PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                     PS_OBJ_TABLE_AUTH_DATA_SIZE);
+                     sizeof(assoc_data.obj_table_data));
 
     err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
-                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
+                                 sizeof(assoc_data));
     if (err == PSA_SUCCESS) {
         init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_1_VALID;
         return;
@@ -384,7 +574,7 @@ static void ps_object_table_authenticate(uint8_t table_idx,
     assoc_data.nv_counter = init_ctx->nvc_3;
 
     err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
-                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
+                                 sizeof(assoc_data));
     if (err != PSA_SUCCESS) {
         init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
     } else {
@@ -392,6 +582,41 @@ static void ps_object_table_authenticate(uint8_t table_idx,
     }
 }
 
+/**
+ * \brief Authenticates table of objects.
+ *
+ * \param[in]     table_idx  Table index in the init context
+ * \param[in,out] init_ctx   Pointer to the object table to authenticate
+ *
+ */
+static void ps_object_table_authenticate(uint8_t table_idx,
+                                       struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    struct ps_crypto_assoc_data_t assoc_data;
+    union ps_crypto_t *crypto = &init_ctx->p_table[table_idx]->crypto;
+    psa_status_t err;
+
+    if (init_ctx->prev_version[table_idx]) {
+        ps_object_table_prev_authenticate(table_idx, init_ctx);
+        return;
+    }
+
+    /* Init associated data with the NVC 1 value the table was saved with.
+     * Whether that value is the latest one is checked against the NV
+     * counters once the journal records of the table are validated.
+     */
+    assoc_data.nv_counter = init_ctx->p_table[table_idx]->nv_counter;
+    (void)tfm_memcpy(assoc_data.obj_table_data,
+                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                     PS_OBJ_TABLE_AUTH_DATA_SIZE);
+
+    err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
+                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
+    if (err != PSA_SUCCESS) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
+    }
+}
+
 /**
  * \brief Authenticates tables of objects.
  *
@@ -486,6 +711,8 @@ __STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
     if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] != PS_OBJ_TABLE_INVALID) {
         err = ps_crypto_authenticate(crypto,
                                      PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                 init_ctx->prev_version[PS_OBJ_TABLE_IDX_0] ?
+                                     PS_CRYPTO_PREV_ASSOCIATED_DATA_LEN :
                                      PS_CRYPTO_ASSOCIATED_DATA_LEN);
         if (err != PSA_SUCCESS) {
             init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
@@ -498,6 +725,8 @@ __STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
 
         err = ps_crypto_authenticate(crypto,
                                      PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                 init_ctx->prev_version[PS_OBJ_TABLE_IDX_1] ?
+                                     PS_CRYPTO_PREV_ASSOCIATED_DATA_LEN :
                                      PS_CRYPTO_ASSOCIATED_DATA_LEN);
         if (err != PSA_SUCCESS) {
             init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
@@ -505,8 +734,120 @@ __STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
     }
 }
 #endif /* PS_ROLLBACK_PROTECTION */
+
+/**
+ * \brief Generates journal record authentication tag.
+ *
+ * \param[in,out] record    Pointer to the journal record
+ * \param[in]     position  Position of the record in the journal
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_record_generate_auth_tag(
+                                          struct ps_obj_table_record_t *record,
+                                          uint32_t position)
+{
+    struct ps_record_assoc_data_t assoc_data;
+    union ps_crypto_t *crypto = &record->crypto;
+
+    /* Get new IV */
+    ps_crypto_get_iv(crypto);
+
+    assoc_data.position = position;
+    (void)tfm_memcpy(assoc_data.record_data,
+                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                     sizeof(assoc_data.record_data));
+
+    return ps_crypto_generate_auth_tag(crypto, (const uint8_t *)&assoc_data,
+                                       sizeof(assoc_data));
+}
+
+/**
+ * \brief Authenticates journal record.
+ *
+ * \param[in] record    Pointer to the journal record
+ * \param[in] position  Position of the record in the journal
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_record_authenticate(
+                                    const struct ps_obj_table_record_t *record,
+                                    uint32_t position)
+{
+    struct ps_record_assoc_data_t assoc_data;
+    const union ps_crypto_t *crypto = &record->crypto;
+
+    assoc_data.position = position;
+    (void)tfm_memcpy(assoc_data.record_data,
+                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                     sizeof(assoc_data.record_data));
+
+    return ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
+                                  sizeof(assoc_data));
+}
 #endif /* PS_ENCRYPTION */
 
+/**
+ * \brief Validates the journal records which apply to an object table.
+ *
+ * \details The valid records are the leading records of the journal with the
+ *          generation of the table. With rollback protection, the table or its
+ *          last record must also carry the latest NV counter value.
+ *
+ * \param[in]     table_idx  Table index in the init context
+ * \param[in,out] init_ctx   Pointer to the init object table context
+ *
+ */
+static void ps_object_table_validate_journal(uint8_t table_idx,
+                                       struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    const struct ps_obj_table_t *p_table = init_ctx->p_table[table_idx];
+    const struct ps_obj_table_record_t *record;
+    uint32_t num;
+#ifdef PS_ROLLBACK_PROTECTION
+    uint32_t last_nvc = p_table->nv_counter;
+#endif
+
+    for (num = 0; num < ps_obj_table_ctx.journal_len; num++) {
+        record = &ps_obj_table_ctx.journal[num];
+
+        if ((record->generation != p_table->generation) ||
+            (record->idx >= PS_OBJ_TABLE_ENTRIES)) {
+            break;
+        }
+
+#ifdef PS_ENCRYPTION
+        if (ps_object_table_record_authenticate(record, num) != PSA_SUCCESS) {
+            break;
+        }
+#endif
+
+#ifdef PS_ROLLBACK_PROTECTION
+        /* The records saved together share the NV counter value, which is
+         * higher than the one of the previous records and of the table.
+         */
+        if ((record->nv_counter < last_nvc) ||
+            ((num == 0) && (record->nv_counter == last_nvc))) {
+            break;
+        }
+        last_nvc = record->nv_counter;
+#endif
+    }
+
+    init_ctx->journal_len[table_idx] = num;
+
+#ifdef PS_ROLLBACK_PROTECTION
+    if (last_nvc == init_ctx->nvc_1) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_1_VALID;
+    } else if ((init_ctx->nvc_3 != PS_INVALID_NVC_VALUE) &&
+               (last_nvc == init_ctx->nvc_3)) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_3_VALID;
+    } else {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
+    }
+#endif
+}
+
 /**
  * \brief Saves object table in the persistent memory.
  *
@@ -556,6 +897,7 @@ static psa_status_t ps_object_table_save_table(
     /* Generate authentication tag from the current table content and PS
      * NV counter 1.
      */
+    obj_table->nv_counter = nvc_1;
     err = ps_object_table_nvc_generate_auth_tag(nvc_1, obj_table);
 #else
     /* Generate authentication tag from the current table content */
@@ -587,6 +929,136 @@ static psa_status_t ps_object_table_save_table(
     return err;
 }
 
+/**
+ * \brief Appends records with the given table entries to the journal and
+ *        stores it in the persistent memory.
+ *
+ * \param[in] idxs  Indexes of the table entries which changed
+ * \param[in] num   Number of table entries which changed
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_journal_append(const uint32_t *idxs,
+                                                   uint32_t num)
+{
+    psa_status_t err;
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    struct ps_obj_table_record_t *record;
+    uint32_t pos = ps_obj_table_ctx.journal_len;
+    uint32_t i;
+
+#ifdef PS_ROLLBACK_PROTECTION
+    uint32_t nvc_1 = 0;
+
+    err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_1);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_1, &nvc_1);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif /* PS_ROLLBACK_PROTECTION */
+
+#ifdef PS_ENCRYPTION
+    /* Set object table key */
+    err = ps_crypto_setkey();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif /* PS_ENCRYPTION */
+
+    for (i = 0; i < num; i++) {
+        record = &ps_obj_table_ctx.journal[pos + i];
+        record->generation = p_table->generation;
+        record->idx = idxs[i];
+        (void)tfm_memcpy(&record->entry, &p_table->obj_db[idxs[i]],
+                         PS_OBJECTS_TABLE_ENTRY_SIZE);
+#ifdef PS_ROLLBACK_PROTECTION
+        record->nv_counter = nvc_1;
+#endif
+
+#ifdef PS_ENCRYPTION
+        err = ps_object_table_record_generate_auth_tag(record, pos + i);
+        if (err != PSA_SUCCESS) {
+            (void)ps_crypto_destroykey();
+            return err;
+        }
+#endif /* PS_ENCRYPTION */
+    }
+
+#ifdef PS_ENCRYPTION
+    err = ps_crypto_destroykey();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif /* PS_ENCRYPTION */
+
+    /* The file system has no partial writes, so the journal file is written
+     * again with the new records. It is never larger than the table, see
+     * PS_OBJ_TABLE_JOURNAL_FITS.
+     */
+    err = psa_its_set(PS_OBJ_TABLE_JOURNAL_FS_ID,
+                      (pos + num) * PS_OBJ_TABLE_RECORD_SIZE,
+                      (const void *)ps_obj_table_ctx.journal,
+                      PSA_STORAGE_FLAG_NONE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    ps_obj_table_ctx.journal_len = pos + num;
+
+#ifdef PS_ROLLBACK_PROTECTION
+    /* Align PS NV counters to have the same value */
+    err = ps_object_table_align_nv_counters(nvc_1);
+#endif /* PS_ROLLBACK_PROTECTION */
+
+    return err;
+}
+
+/**
+ * \brief Stores the changes of the given table entries in the persistent
+ *        memory.
+ *
+ * \details The changes are appended to the journal. When the journal is full,
+ *          the whole table is saved instead with a new generation, which
+ *          discards the journal records.
+ *
+ * \param[in] idxs  Indexes of the table entries which changed
+ * \param[in] num   Number of table entries which changed
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_save_entries(const uint32_t *idxs,
+                                                 uint32_t num)
+{
+    psa_status_t err;
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+
+    if (PS_OBJ_TABLE_JOURNAL_FITS(ps_obj_table_ctx.journal_len + num)) {
+        return ps_object_table_journal_append(idxs, num);
+    }
+
+    /* Compact the journal into the table */
+    p_table->generation++;
+
+    err = ps_object_table_save_table(p_table);
+    if (err != PSA_SUCCESS) {
+        p_table->generation--;
+        return err;
+    }
+
+    ps_obj_table_ctx.journal_len = 0;
+
+    /* The records left in the file belong to the previous generation and are
+     * ignored, so failing to remove them is not an error.
+     */
+    (void)psa_its_remove(PS_OBJ_TABLE_JOURNAL_FS_ID);
+
+    return PSA_SUCCESS;
+}
+
 /**
  * \brief Checks the validity of the table version.
  *
@@ -611,6 +1083,49 @@ __STATIC_INLINE void ps_object_table_validate_version(
     }
 }
 
+/**
+ * \brief Converts an object table of the previous object system version to
+ *        the current version, in place.
+ *
+ * \details The table has no journal records, so it keeps generation 0. With
+ *          rollback protection, it takes the NV counter value it was
+ *          authenticated with.
+ *
+ * \param[in]     table_idx  Table index in the init context
+ * \param[in,out] init_ctx   Pointer to the init object table context
+ *
+ */
+static void ps_object_table_convert_prev(uint8_t table_idx,
+                                       struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    struct ps_obj_table_t *p_table = init_ctx->p_table[table_idx];
+    const struct ps_obj_table_prev_t *p_prev =
+                                  (const struct ps_obj_table_prev_t *)p_table;
+    struct ps_obj_table_entry_t entry;
+    uint32_t idx;
+
+    /* The entries move towards the end of the table to make room for the
+     * new fields, so they are moved from the last one.
+     */
+    for (idx = PS_OBJ_TABLE_ENTRIES; idx > 0; idx--) {
+        (void)tfm_memcpy(&entry, &p_prev->obj_db[idx - 1],
+                         PS_OBJECTS_TABLE_ENTRY_SIZE);
+        (void)tfm_memcpy(&p_table->obj_db[idx - 1], &entry,
+                         PS_OBJECTS_TABLE_ENTRY_SIZE);
+    }
+
+    p_table->version = PS_OBJECT_SYSTEM_VERSION;
+    p_table->generation = 0;
+
+#ifdef PS_ROLLBACK_PROTECTION
+    if (init_ctx->table_state[table_idx] == PS_OBJ_TABLE_NVC_3_VALID) {
+        p_table->nv_counter = init_ctx->nvc_3;
+    } else {
+        p_table->nv_counter = init_ctx->nvc_1;
+    }
+#endif /* PS_ROLLBACK_PROTECTION */
+}
+
 /**
  * \brief Sets the active object table based on the swap count and validity of
  *        the object table data.
@@ -761,7 +1276,8 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
  *                     1 index.
  * \param[out] idx     Pointer to store the free index
  *
- * \note The table is dimensioned to fit PS_NUM_ASSETS + 1
+ * \note The table is dimensioned to fit PS_NUM_ASSETS + 1. Reserved entries
+ *       are not free.
  *
  * \return Returns PSA_SUCCESS and a table index if idx_num free indices are
  *         available. Otherwise, it returns PSA_ERROR_INSUFFICIENT_STORAGE.
@@ -779,7 +1295,8 @@ __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
     }
 
     for (i = 0; i < PS_OBJ_TABLE_ENTRIES && idx_num > 0; i++) {
-        if (p_table->obj_db[i].uid == TFM_PS_INVALID_UID) {
+        if (p_table->obj_db[i].uid == TFM_PS_INVALID_UID
+            && !ps_obj_table_ctx.reserved[i]) {
             last_free = i;
             idx_num--;
         }
@@ -806,8 +1323,49 @@ static void ps_table_delete_entry(uint32_t idx)
                      PS_DEFAULT_EMPTY_BUFF_VAL, PS_OBJECTS_TABLE_ENTRY_SIZE);
 }
 
+/**
+ * \brief Applies the journal records to the active table.
+ *
+ * \param[in] num  Number of valid journal records of the active table
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_apply_journal(uint32_t num)
+{
+    psa_status_t err = PSA_SUCCESS;
+    const struct ps_obj_table_record_t *record;
+    uint32_t i;
+
+    for (i = 0; i < num; i++) {
+        record = &ps_obj_table_ctx.journal[i];
+        (void)tfm_memcpy(&ps_obj_table_ctx.obj_table.obj_db[record->idx],
+                         &record->entry, PS_OBJECTS_TABLE_ENTRY_SIZE);
+    }
+
+    if (num == ps_obj_table_ctx.journal_len) {
+        return PSA_SUCCESS;
+    }
+
+    /* Drop the records which do not apply to the active table, for example
+     * the ones left by a power failure while the table was compacted.
+     */
+    if (num == 0) {
+        err = psa_its_remove(PS_OBJ_TABLE_JOURNAL_FS_ID);
+    } else {
+        err = psa_its_set(PS_OBJ_TABLE_JOURNAL_FS_ID,
+                          num * PS_OBJ_TABLE_RECORD_SIZE,
+                          (const void *)ps_obj_table_ctx.journal,
+                          PSA_STORAGE_FLAG_NONE);
+    }
+
+    ps_obj_table_ctx.journal_len = num;
+
+    return err;
+}
+
 psa_status_t ps_object_table_create(void)
 {
+    psa_status_t err;
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
 
     /* Initialize object structure */
@@ -822,6 +1380,12 @@ psa_status_t ps_object_table_create(void)
 
     p_table->version = PS_OBJECT_SYSTEM_VERSION;
 
+    /* Remove the journal of a previous object table */
+    err = psa_its_remove(PS_OBJ_TABLE_JOURNAL_FS_ID);
+    if (err != PSA_SUCCESS && err != PSA_ERROR_DOES_NOT_EXIST) {
+        return err;
+    }
+
     /* Save object table contents */
     return ps_object_table_save_table(p_table);
 }
@@ -860,7 +1424,28 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
 #else
     ps_object_table_authenticate_ctx_tables(&init_ctx);
 #endif /* PS_ROLLBACK_PROTECTION */
+#endif /* PS_ENCRYPTION */
+
+    /* Convert the tables of the previous version, which have no journal, and
+     * find the journal records of the other tables.
+     */
+    if (init_ctx.table_state[PS_OBJ_TABLE_IDX_0] != PS_OBJ_TABLE_INVALID) {
+        if (init_ctx.prev_version[PS_OBJ_TABLE_IDX_0]) {
+            ps_object_table_convert_prev(PS_OBJ_TABLE_IDX_0, &init_ctx);
+        } else {
+            ps_object_table_validate_journal(PS_OBJ_TABLE_IDX_0, &init_ctx);
+        }
+    }
 
+    if (init_ctx.table_state[PS_OBJ_TABLE_IDX_1] != PS_OBJ_TABLE_INVALID) {
+        if (init_ctx.prev_version[PS_OBJ_TABLE_IDX_1]) {
+            ps_object_table_convert_prev(PS_OBJ_TABLE_IDX_1, &init_ctx);
+        } else {
+            ps_object_table_validate_journal(PS_OBJ_TABLE_IDX_1, &init_ctx);
+        }
+    }
+
+#ifdef PS_ENCRYPTION
     err = ps_crypto_destroykey();
     if (err != PSA_SUCCESS) {
         return err;
@@ -882,18 +1467,49 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
         return err;
     }
 
-#ifdef PS_ROLLBACK_PROTECTION
-    /* Align PS NV counters */
-    err = ps_object_table_align_nv_counters(init_ctx.nvc_1);
+    /* Apply the journal records of the active table */
+    err = ps_object_table_apply_journal(
+                       init_ctx.journal_len[ps_obj_table_ctx.active_table]);
     if (err != PSA_SUCCESS) {
         return err;
     }
+
+#ifdef PS_ROLLBACK_PROTECTION
+    /* Align PS NV counters, unless the active table is only valid with NVC 3
+     * because of a power failure before it was saved. Aligning them then
+     * would invalidate the table at the next boot if it is not saved before.
+     */
+    if (init_ctx.table_state[ps_obj_table_ctx.active_table] ==
+                                                    PS_OBJ_TABLE_NVC_1_VALID) {
+        err = ps_object_table_align_nv_counters(init_ctx.nvc_1);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
 #endif /* PS_ROLLBACK_PROTECTION */
 
 #ifdef PS_ENCRYPTION
-    ps_crypto_set_iv(&ps_obj_table_ctx.obj_table.crypto);
+    /* The last record saved has the latest IV */
+    if (ps_obj_table_ctx.journal_len != 0) {
+        ps_crypto_set_iv(
+           &ps_obj_table_ctx.journal[ps_obj_table_ctx.journal_len - 1].crypto);
+    } else {
+        ps_crypto_set_iv(&ps_obj_table_ctx.obj_table.crypto);
+    }
 #endif
 
+    if (init_ctx.prev_version[ps_obj_table_ctx.active_table]) {
+        /* Save the table converted from the previous version. Until then, it
+         * is converted again at each initialization.
+         */
+        err = ps_object_table_save_table(&ps_obj_table_ctx.obj_table);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        return ps_object_table_delete_old_table();
+    }
+
     return PSA_SUCCESS;
 }
 
@@ -936,57 +1552,106 @@ psa_status_t ps_object_table_get_free_fid(uint32_t fid_num,
     return PSA_SUCCESS;
 }
 
+psa_status_t ps_object_table_reserve_fid(uint32_t fid_num, uint32_t *p_fid)
+{
+    psa_status_t err;
+
+    err = ps_object_table_get_free_fid(fid_num, p_fid);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    ps_obj_table_ctx.reserved[PS_OBJECT_FS_ID_TO_IDX(*p_fid)] = true;
+
+    return PSA_SUCCESS;
+}
+
+void ps_object_table_release_fid(uint32_t fid)
+{
+    ps_obj_table_ctx.reserved[PS_OBJECT_FS_ID_TO_IDX(fid)] = false;
+}
+
 psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
                                               int32_t client_id,
                                 const struct ps_obj_table_info_t *obj_tbl_info)
 {
-    psa_status_t err;
-    uint32_t idx = 0;
-    uint32_t backup_idx = 0;
-    struct ps_obj_table_entry_t backup_entry = {
-#ifdef PS_ENCRYPTION
-        .tag = {0U},
-#else
-        .version = 0U,
-#endif /* PS_ENCRYPTION */
-        .uid = TFM_PS_INVALID_UID,
-        .client_id = 0,
+    struct ps_obj_table_change_t change = {
+        .uid = uid,
+        .client_id = client_id,
+        .info = *obj_tbl_info,
     };
-    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
 
-    err = ps_get_object_entry_idx(uid, client_id, &backup_idx);
-    if (err == PSA_SUCCESS) {
-        /* If an entry exists for this UID, it creates a backup copy in case
-         * an error happens while updating the new table in the filesystem.
-         */
-        (void)tfm_memcpy(&backup_entry, &p_table->obj_db[backup_idx],
-                         PS_OBJECTS_TABLE_ENTRY_SIZE);
+    return ps_object_table_set_obj_tbl_infos(&change, 1);
+}
+
+psa_status_t ps_object_table_set_obj_tbl_infos(
+                                    const struct ps_obj_table_change_t *changes,
+                                    uint32_t num)
+{
+    psa_status_t err = PSA_SUCCESS;
+    uint32_t i;
+    uint32_t idx;
+    uint32_t num_changed = 0;
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
 
-        /* Deletes old object information if it exist in the table */
-        ps_table_delete_entry(backup_idx);
+    if (num > PS_TRANSACTION_MAX_OPS) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    idx = PS_OBJECT_FS_ID_TO_IDX(obj_tbl_info->fid);
-    p_table->obj_db[idx].uid = uid;
-    p_table->obj_db[idx].client_id = client_id;
+    for (i = 0; i < num; i++) {
+        err = ps_get_object_entry_idx(changes[i].uid, changes[i].client_id,
+                                      &idx);
+        if (err == PSA_SUCCESS) {
+            /* If an entry exists for this UID, it creates a backup copy in
+             * case an error happens while updating the new table in the
+             * filesystem, and deletes the old object information.
+             */
+            (void)tfm_memcpy(&ps_backup_entries[num_changed],
+                             &p_table->obj_db[idx],
+                             PS_OBJECTS_TABLE_ENTRY_SIZE);
+            ps_changed_idxs[num_changed++] = idx;
+            ps_table_delete_entry(idx);
+        } else if (changes[i].info.fid == PS_INVALID_FID) {
+            /* If the object to delete is not present in the table, it returns
+             * an error to not generate a new file where the table content is
+             * the same. Otherwise, that could be used by an attacker to get
+             * the encryption key.
+             */
+            goto rollback;
+        }
+
+        if (changes[i].info.fid == PS_INVALID_FID) {
+            continue;
+        }
+
+        idx = PS_OBJECT_FS_ID_TO_IDX(changes[i].info.fid);
+        (void)tfm_memcpy(&ps_backup_entries[num_changed],
+                         &p_table->obj_db[idx], PS_OBJECTS_TABLE_ENTRY_SIZE);
+        ps_changed_idxs[num_changed++] = idx;
+        p_table->obj_db[idx].uid = changes[i].uid;
+        p_table->obj_db[idx].client_id = changes[i].client_id;
 
-    /* Add new object information */
+        /* Add new object information */
 #ifdef PS_ENCRYPTION
-    (void)tfm_memcpy(p_table->obj_db[idx].tag, obj_tbl_info->tag,
-                     PS_TAG_LEN_BYTES);
+        (void)tfm_memcpy(p_table->obj_db[idx].tag, changes[i].info.tag,
+                         PS_TAG_LEN_BYTES);
 #else
-    p_table->obj_db[idx].version = obj_tbl_info->version;
+        p_table->obj_db[idx].version = changes[i].info.version;
 #endif
+    }
 
-    err = ps_object_table_save_table(p_table);
-    if (err != PSA_SUCCESS) {
-        if (backup_entry.uid != TFM_PS_INVALID_UID) {
-            /* Rollback the change in the table */
-            (void)tfm_memcpy(&p_table->obj_db[backup_idx], &backup_entry,
-                             PS_OBJECTS_TABLE_ENTRY_SIZE);
-        }
+    err = ps_object_table_save_entries(ps_changed_idxs, num_changed);
+    if (err == PSA_SUCCESS) {
+        return PSA_SUCCESS;
+    }
 
-        ps_table_delete_entry(idx);
+rollback:
+    /* Rollback the changes in the table, in reverse order */
+    while (num_changed > 0) {
+        num_changed--;
+        (void)tfm_memcpy(&p_table->obj_db[ps_changed_idxs[num_changed]],
+                         &ps_backup_entries[num_changed],
+                         PS_OBJECTS_TABLE_ENTRY_SIZE);
     }
 
     return err;
@@ -1020,42 +1685,27 @@ psa_status_t ps_object_table_get_obj_tbl_info(psa_storage_uid_t uid,
 psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
                                            int32_t client_id)
 {
-    uint32_t backup_idx = 0;
-    struct ps_obj_table_entry_t backup_entry;
-    psa_status_t err;
-    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
-
-    /* Create a backup copy in case an error happens while updating the new
-     * table in the filesystem.
-     */
-    err = ps_get_object_entry_idx(uid, client_id, &backup_idx);
-    if (err != PSA_SUCCESS) {
-        /* If the object is not present in the table, it returns an error
-         * to not generate a new file where the table content is the same.
-         * Otherwise, that could be used by an attacker to get the encryption
-         * key.
-         */
-        return err;
-    }
-
-    (void)tfm_memcpy(&backup_entry, &p_table->obj_db[backup_idx],
-                     PS_OBJECTS_TABLE_ENTRY_SIZE);
-
-    ps_table_delete_entry(backup_idx);
-
-    err = ps_object_table_save_table(p_table);
-    if (err != PSA_SUCCESS) {
-       /* Rollback the change in the table */
-       (void)tfm_memcpy(&p_table->obj_db[backup_idx], &backup_entry,
-                        PS_OBJECTS_TABLE_ENTRY_SIZE);
-    }
+    struct ps_obj_table_change_t change = {
+        .uid = uid,
+        .client_id = client_id,
+        .info = {
+            .fid = PS_INVALID_FID,
+        },
+    };
 
-    return err;
+    return ps_object_table_set_obj_tbl_infos(&change, 1);
 }
 
 psa_status_t ps_object_table_delete_old_table(void)
 {
+    psa_status_t err;
     uint32_t table_id = PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table);
 
-    return psa_its_remove(table_id);
+    /* There is no old table when the change was saved in the journal */
+    err = psa_its_remove(table_id);
+    if (err == PSA_ERROR_DOES_NOT_EXIST) {
+        return PSA_SUCCESS;
+    }
+
+    return err;
 }
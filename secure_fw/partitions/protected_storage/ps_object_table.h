@@ -30,6 +30,25 @@ struct ps_obj_table_info_t {
 #endif
 };
 
+#ifndef PS_TRANSACTION_MAX_OPS
+/* The maximum number of objects changed together by a transaction */
+#define PS_TRANSACTION_MAX_OPS 10
+#endif
+
+/*!
+ * \struct ps_obj_table_change_t
+ *
+ * \brief Change of one object in the object table.
+ */
+struct ps_obj_table_change_t {
+    psa_storage_uid_t uid;            /*!< Object UID */
+    int32_t client_id;                /*!< Client ID */
+    struct ps_obj_table_info_t info;  /*!< New object table information. The
+                                       *   object is deleted if the file ID is
+                                       *   PS_INVALID_FID.
+                                       */
+};
+
 /**
  * \brief Creates object table.
  *
@@ -78,6 +97,26 @@ psa_status_t ps_object_table_obj_exist(psa_storage_uid_t uid,
  */
 psa_status_t ps_object_table_get_free_fid(uint32_t fid_num, uint32_t *p_fid);
 
+/**
+ * \brief Gets a not in use file ID and reserves it, so that it is not returned
+ *        again until it is released. The object written to that file ID is
+ *        added to the table later by \ref ps_object_table_set_obj_tbl_infos.
+ *
+ * \param[in]  fid_num  Amount of file IDs that the function will check are
+ *                      free, as for \ref ps_object_table_get_free_fid
+ * \param[out] p_fid    Pointer to the location to store the file ID
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t ps_object_table_reserve_fid(uint32_t fid_num, uint32_t *p_fid);
+
+/**
+ * \brief Releases a file ID reserved by \ref ps_object_table_reserve_fid.
+ *
+ * \param[in] fid  File ID to release
+ */
+void ps_object_table_release_fid(uint32_t fid);
+
 /**
  * \brief Sets object table information in the object table and stores it
  *        persistently, for the provided UID and client ID pair.
@@ -96,6 +135,22 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
                                               int32_t client_id,
                                 const struct ps_obj_table_info_t *obj_tbl_info);
 
+/**
+ * \brief Applies several object changes to the object table and stores them
+ *        persistently with a single table update, so that either all or none
+ *        of the changes are applied.
+ *
+ * \param[in] changes  Array of changes \ref ps_obj_table_change_t, with at
+ *                     most one change per UID and client ID pair
+ * \param[in] num      Number of changes, at most PS_TRANSACTION_MAX_OPS
+ *
+ * \return Returns error code as specified in \ref psa_status_t. It returns
+ *         PSA_ERROR_DOES_NOT_EXIST if an object to delete is not in the table.
+ */
+psa_status_t ps_object_table_set_obj_tbl_infos(
+                                    const struct ps_obj_table_change_t *changes,
+                                    uint32_t num);
+
 /**
  * \brief Gets object table information from the object table for the provided
  *        UID and client ID pair.
@@ -6,8 +6,27 @@
  */
 
 #include "tfm_protected_storage.h"
+
+#include <stdbool.h>
+
 #include "ps_object_system.h"
 #include "tfm_ps_defs.h"
+#ifdef PS_ENCRYPTION
+#include "crypto/ps_crypto_interface.h"
+#endif
+
+/*!
+ * \struct ps_transaction_t
+ *
+ * \brief Transaction in progress. The changes it stages are held by the
+ *        object system.
+ */
+struct ps_transaction_t {
+    bool in_progress;   /*!< A transaction has begun */
+    int32_t client_id;  /*!< Owner of the transaction */
+};
+
+static struct ps_transaction_t g_transaction;
 
 psa_status_t tfm_ps_init(void)
 {
@@ -115,6 +134,108 @@ psa_status_t tfm_ps_remove(int32_t client_id, psa_storage_uid_t uid)
     return err;
 }
 
+psa_status_t tfm_ps_transaction_begin(int32_t client_id)
+{
+    if (g_transaction.in_progress) {
+        /* Only one transaction can be in progress at a time */
+        if (g_transaction.client_id != client_id) {
+            return PSA_ERROR_BAD_STATE;
+        }
+
+        /* The owner left its transaction unfinished, so discard it */
+        ps_object_discard();
+    }
+
+    g_transaction.in_progress = true;
+    g_transaction.client_id = client_id;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_ps_transaction_set(int32_t client_id,
+                                    psa_storage_uid_t uid,
+                                    uint32_t data_length,
+                                    psa_storage_create_flags_t create_flags)
+{
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* Check that the UID is valid */
+    if (uid == TFM_PS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check that the create_flags does not contain any unsupported flags */
+    if (create_flags & ~(PSA_STORAGE_FLAG_WRITE_ONCE |
+                         PSA_STORAGE_FLAG_NO_CONFIDENTIALITY |
+                         PSA_STORAGE_FLAG_NO_REPLAY_PROTECTION)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    /* Write the object, to be added to the object table on commit */
+    return ps_object_stage_create(uid, client_id, create_flags, data_length);
+}
+
+psa_status_t tfm_ps_transaction_remove(int32_t client_id,
+                                       psa_storage_uid_t uid)
+{
+    psa_status_t err;
+
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* Check that the UID is valid */
+    if (uid == TFM_PS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    err = ps_object_stage_delete(uid, client_id);
+
+    /* PSA_ERROR_INVALID_SIGNATURE is not supported by psa_ps_remove
+     * specification, as for tfm_ps_remove.
+     */
+    if (err == PSA_ERROR_INVALID_SIGNATURE) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return err;
+}
+
+psa_status_t tfm_ps_transaction_commit(int32_t client_id)
+{
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    g_transaction.in_progress = false;
+
+    return ps_object_commit();
+}
+
+psa_status_t tfm_ps_transaction_abort(int32_t client_id)
+{
+    if (!g_transaction.in_progress || g_transaction.client_id != client_id) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    g_transaction.in_progress = false;
+
+    ps_object_discard();
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_ps_check_lifecycle(void)
+{
+#ifdef PS_ENCRYPTION
+    return ps_crypto_check_lifecycle();
+#else
+    return PSA_SUCCESS;
+#endif
+}
+
 uint32_t tfm_ps_get_support(void)
 {
     /*
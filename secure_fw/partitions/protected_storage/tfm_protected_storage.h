@@ -164,6 +164,112 @@ psa_status_t tfm_ps_get_info(int32_t client_id, psa_storage_uid_t uid,
  */
 psa_status_t tfm_ps_remove(int32_t client_id, psa_storage_uid_t uid);
 
+/**
+ * \brief Begins a transaction, which groups set and remove operations so that
+ *        they are applied atomically.
+ *
+ * If the client already has a transaction in progress, its staged changes are
+ * discarded first.
+ *
+ * \param[in] client_id  Identifier of the transaction's owner (client)
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS          The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE  The operation failed because another client has
+ *                              a transaction in progress
+ */
+psa_status_t tfm_ps_transaction_begin(int32_t client_id);
+
+/**
+ * \brief Stages the setting of an asset in the transaction in progress.
+ *
+ * The data is read from the caller and the object is written to storage, but
+ * it is only added to the object table when the transaction is committed.
+ *
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] uid           Unique identifier for the data
+ * \param[in] data_length   The size in bytes of the data in `p_data`
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return A status indicating the success/failure of the operation, as for
+ *         \ref tfm_ps_set
+ *
+ * \retval PSA_ERROR_BAD_STATE             The client has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The transaction already changes the
+ *                                         maximum number of assets, or there
+ *                                         is no free object to stage the data
+ */
+psa_status_t tfm_ps_transaction_set(int32_t client_id,
+                                    psa_storage_uid_t uid,
+                                    uint32_t data_length,
+                                    psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Stages the removal of an asset in the transaction in progress.
+ *
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ * \param[in] uid        Unique identifier for the data
+ *
+ * \return A status indicating the success/failure of the operation, as for
+ *         \ref tfm_ps_remove
+ *
+ * \retval PSA_ERROR_BAD_STATE             The client has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The transaction already changes the
+ *                                         maximum number of assets
+ */
+psa_status_t tfm_ps_transaction_remove(int32_t client_id,
+                                       psa_storage_uid_t uid);
+
+/**
+ * \brief Applies the changes staged in the transaction in progress and ends
+ *        the transaction.
+ *
+ * All the changes are applied in a single object table update, so either all
+ * or none of them are applied, even after a power failure.
+ *
+ * \param[in] client_id  Identifier of the transaction's owner (client)
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The client has no transaction in progress
+ * \retval PSA_ERROR_NOT_PERMITTED    The operation failed because one of the
+ *                                    assets has been created with
+ *                                    PSA_STORAGE_FLAG_WRITE_ONCE since its
+ *                                    change was staged
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ */
+psa_status_t tfm_ps_transaction_commit(int32_t client_id);
+
+/**
+ * \brief Discards the changes staged in the transaction in progress and ends
+ *        the transaction.
+ *
+ * \param[in] client_id  Identifier of the transaction's owner (client)
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS          The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE  The client has no transaction in progress
+ */
+psa_status_t tfm_ps_transaction_abort(int32_t client_id);
+
+/**
+ * \brief Destroys the cached storage key if the security lifecycle of the
+ *        device has changed since it was derived.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_GENERIC_ERROR  The operation failed because the key could
+ *                                  not be destroyed
+ */
+psa_status_t tfm_ps_check_lifecycle(void);
+
 /**
  * \brief Gets a bitmask with flags set for all of the optional features
  *        supported by the implementation.
@@ -14,12 +14,44 @@
 #include "tfm_secure_api.h"
 #include "tfm_api.h"
 #include "tfm_protected_storage.h"
+#include "tfm_ps_defs.h"
 #ifdef TFM_PSA_API
 #include "psa/service.h"
 #include "psa_manifest/tfm_protected_storage.h"
 #include "flash_layout.h"
 #endif
 
+/**
+ * \brief Dispatches a transaction request to the transaction operation.
+ *
+ * \param[in] client_id    Identifier of the caller
+ * \param[in] args         Transaction request arguments
+ * \param[in] data_length  Size of the data to set, if any
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ */
+static psa_status_t ps_transaction(int32_t client_id,
+                                   const struct tfm_ps_transaction_args_t *args,
+                                   uint32_t data_length)
+{
+    switch (args->op) {
+    case TFM_PS_TRANSACTION_BEGIN:
+        return tfm_ps_transaction_begin(client_id);
+    case TFM_PS_TRANSACTION_SET:
+        return tfm_ps_transaction_set(client_id, args->uid, data_length,
+                                      args->create_flags);
+    case TFM_PS_TRANSACTION_REMOVE:
+        return tfm_ps_transaction_remove(client_id, args->uid);
+    case TFM_PS_TRANSACTION_COMMIT:
+        return tfm_ps_transaction_commit(client_id);
+    case TFM_PS_TRANSACTION_ABORT:
+        return tfm_ps_transaction_abort(client_id);
+    default:
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+}
+
 #ifndef TFM_PSA_API
 #include "tfm_memory_utils.h"
 
@@ -31,7 +63,8 @@ static void *p_data;
 static bool ps_is_init = false;
 
 /*
- * \brief Initialises PS, if not already initialised.
+ * \brief Initialises PS, if not already initialised, and flushes the storage
+ *        key if the security lifecycle has changed since it was derived.
  *
  * \note In library mode, initialisation is delayed until the first secure
  *       function call, as calls to the Crypto service are required for
@@ -49,6 +82,10 @@ static psa_status_t ps_check_init(void)
         ps_is_init = true;
     }
 
+    if (tfm_ps_check_lifecycle() != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
     return PSA_SUCCESS;
 }
 
@@ -240,6 +277,46 @@ psa_status_t tfm_ps_get_support_req(psa_invec *in_vec, size_t in_len,
     return PSA_SUCCESS;
 }
 
+psa_status_t tfm_ps_transaction_req(psa_invec *in_vec, size_t in_len,
+                                    psa_outvec *out_vec, size_t out_len)
+{
+    struct tfm_ps_transaction_args_t args;
+    uint32_t data_length = 0;
+    int32_t client_id;
+    int32_t tfm_status;
+
+    (void)out_vec;
+
+    if (ps_check_init() != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    if ((in_len < 1) || (in_len > 2) || (out_len != 0)) {
+        /* The number of arguments are incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    if (in_vec[0].len != sizeof(args)) {
+        /* The input argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    args = *((struct tfm_ps_transaction_args_t *)in_vec[0].base);
+
+    if (in_len == 2) {
+        p_data = (void *)in_vec[1].base;
+        data_length = in_vec[1].len;
+    }
+
+    /* Get the caller's client ID */
+    tfm_status = tfm_core_get_caller_client_id(&client_id);
+    if (tfm_status != (int32_t)TFM_SUCCESS) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return ps_transaction(client_id, &args, data_length);
+}
+
 #else /* !defined(TFM_PSA_API) */
 typedef psa_status_t (*ps_func_t)(void);
 static psa_msg_t msg;
@@ -360,6 +437,24 @@ static psa_status_t tfm_ps_get_support_ipc(void)
     return PSA_SUCCESS;
 }
 
+static psa_status_t tfm_ps_transaction_ipc(void)
+{
+    struct tfm_ps_transaction_args_t args;
+    size_t num = 0;
+
+    if (msg.in_size[0] != sizeof(args)) {
+        /* The size of one of the arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &args, msg.in_size[0]);
+    if (num != msg.in_size[0]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return ps_transaction(msg.client_id, &args, msg.in_size[1]);
+}
+
 /*
  * Fixme: Temporarily implement abort as infinite loop,
  * will replace it later.
@@ -380,7 +475,13 @@ static void ps_signal_handle(psa_signal_t signal, ps_func_t pfn)
         psa_reply(msg.handle, PSA_SUCCESS);
         break;
     case PSA_IPC_CALL:
-        status = pfn();
+        /* A storage key derived in another lifecycle state is flushed before
+         * any request is served.
+         */
+        status = tfm_ps_check_lifecycle();
+        if (status == PSA_SUCCESS) {
+            status = pfn();
+        }
         psa_reply(msg.handle, status);
         break;
     case PSA_IPC_DISCONNECT:
@@ -414,6 +515,9 @@ psa_status_t tfm_ps_req_mngr_init(void)
         } else if (signals & TFM_PS_GET_SUPPORT_SIGNAL) {
             ps_signal_handle(TFM_PS_GET_SUPPORT_SIGNAL,
                              tfm_ps_get_support_ipc);
+        } else if (signals & TFM_PS_TRANSACTION_SIGNAL) {
+            ps_signal_handle(TFM_PS_TRANSACTION_SIGNAL,
+                             tfm_ps_transaction_ipc);
         } else {
             tfm_abort();
         }
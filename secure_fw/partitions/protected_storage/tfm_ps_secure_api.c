@@ -6,6 +6,7 @@
  */
 
 #include "psa/protected_storage.h"
+#include "tfm_ps_defs.h"
 #include "tfm_veneers.h"
 #ifdef TFM_PSA_API
 #include "psa_manifest/sid.h"
@@ -235,3 +236,92 @@ uint32_t psa_ps_get_support(void)
 
     return support_flags;
 }
+
+/**
+ * \brief Sends a request to the PS transaction service.
+ *
+ * \param[in] op            Transaction operation
+ * \param[in] uid           Asset to set or remove
+ * \param[in] data_length   Size of the data of a set operation
+ * \param[in] p_data        Data of a set operation
+ * \param[in] create_flags  Flags of the asset to set
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+static psa_status_t ps_transaction(uint32_t op,
+                                   psa_storage_uid_t uid,
+                                   size_t data_length,
+                                   const void *p_data,
+                                   psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+#ifdef TFM_PSA_API
+    psa_handle_t handle;
+#endif
+
+    struct tfm_ps_transaction_args_t args = {
+        .uid = uid,
+        .create_flags = create_flags,
+        .op = op
+    };
+
+    psa_invec in_vec[] = {
+        { .base = &args, .len = sizeof(args) },
+        { .base = p_data, .len = data_length }
+    };
+
+    /* Only a set operation passes data */
+    uint32_t in_len = (op == TFM_PS_TRANSACTION_SET) ? IOVEC_LEN(in_vec) : 1;
+
+#ifdef TFM_PSA_API
+    handle = psa_connect(TFM_PS_TRANSACTION_SID, TFM_PS_TRANSACTION_VERSION);
+    if (!PSA_HANDLE_IS_VALID(handle)) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    status = psa_call(handle, PSA_IPC_CALL, in_vec, in_len, NULL, 0);
+
+    psa_close(handle);
+#else
+    status = tfm_tfm_ps_transaction_req_veneer(in_vec, in_len, NULL, 0);
+#endif
+
+    if (status == (psa_status_t)TFM_ERROR_INVALID_PARAMETER) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return status;
+}
+
+psa_status_t psa_ps_transaction_begin(void)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_BEGIN, TFM_PS_INVALID_UID, 0,
+                          NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_ps_transaction_set(psa_storage_uid_t uid,
+                                    size_t data_length,
+                                    const void *p_data,
+                                    psa_storage_create_flags_t create_flags)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_SET, uid, data_length, p_data,
+                          create_flags);
+}
+
+psa_status_t psa_ps_transaction_remove(psa_storage_uid_t uid)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_REMOVE, uid, 0, NULL,
+                          PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_ps_transaction_commit(void)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_COMMIT, TFM_PS_INVALID_UID, 0,
+                          NULL, PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t psa_ps_transaction_abort(void)
+{
+    return ps_transaction(TFM_PS_TRANSACTION_ABORT, TFM_PS_INVALID_UID, 0,
+                          NULL, PSA_STORAGE_FLAG_NONE);
+}
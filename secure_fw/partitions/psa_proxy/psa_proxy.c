@@ -139,6 +139,10 @@ static void get_sid_and_version_for_signal(psa_signal_t signal, uint32_t *sid,
         *sid = TFM_ITS_REMOVE_SID;
         *version = TFM_ITS_REMOVE_VERSION;
         break;
+    case TFM_ITS_TRANSACTION_SIGNAL:
+        *sid = TFM_ITS_TRANSACTION_SID;
+        *version = TFM_ITS_TRANSACTION_VERSION;
+        break;
     case TFM_SP_PLATFORM_SYSTEM_RESET_SIGNAL:
         *sid = TFM_SP_PLATFORM_SYSTEM_RESET_SID;
         *version = TFM_SP_PLATFORM_SYSTEM_RESET_VERSION;
@@ -171,6 +175,10 @@ static void get_sid_and_version_for_signal(psa_signal_t signal, uint32_t *sid,
         *sid = TFM_PS_GET_SUPPORT_SID;
         *version = TFM_PS_GET_SUPPORT_VERSION;
         break;
+    case TFM_PS_TRANSACTION_SIGNAL:
+        *sid = TFM_PS_TRANSACTION_SID;
+        *version = TFM_PS_TRANSACTION_VERSION;
+        break;
     default:
         psa_panic();
         break;
@@ -27,6 +27,7 @@
 #include "tfm_list.h"
 #include "tfm_hal_isolation.h"
 #include "tfm_pools.h"
+#include "tfm_spm_log.h"
 #include "region.h"
 #include "region_defs.h"
 #include "spm_partition_defs.h"
@@ -145,6 +146,16 @@ struct tfm_conn_handle_t *tfm_spm_create_conn_handle(
     /* Get buffer for handle list structure from handle pool */
     p_handle = (struct tfm_conn_handle_t *)tfm_pool_alloc(conn_handle_pool);
     if (!p_handle) {
+#if (TFM_SPM_LOG_LEVEL == TFM_SPM_LOG_LEVEL_DEBUG)
+        struct tfm_pool_stats_t stats;
+
+        /* Report the pool usage, to help sizing TFM_CONN_HANDLE_MAX_NUM */
+        tfm_pool_get_stats(conn_handle_pool, &stats);
+        SPMLOG_DBGMSGVAL("[SPM] Connection handles exhausted, in use: ",
+                         stats.in_use);
+        SPMLOG_DBGMSGVAL("[SPM] Failed handle allocations: ",
+                         stats.alloc_failures);
+#endif
         return NULL;
     }
 
@@ -230,37 +241,47 @@ static void *tfm_spm_get_rhandle(struct tfm_spm_service_t *service,
 
 /* Partition management functions */
 
+/* Returns the bit number of a signal which has exactly one bit set */
+static uint32_t tfm_spm_signal_bit(psa_signal_t signal)
+{
+    return (TFM_SIGNAL_BITS - 1) - __CLZ(signal);
+}
+
 struct tfm_msg_body_t *tfm_spm_get_msg_by_signal(struct partition_t *partition,
                                                  psa_signal_t signal)
 {
     struct tfm_list_node_t *node, *head;
-    struct tfm_msg_body_t *tmp_msg, *msg = NULL;
+    struct tfm_spm_service_t *service;
 
     TFM_CORE_ASSERT(partition);
 
-    head = &partition->msg_list;
+    if (!tfm_is_one_bit_set(signal)) {
+        return NULL;
+    }
+
+    service = partition->signal_services[tfm_spm_signal_bit(signal)];
+    if (!service) {
+        return NULL;
+    }
+
+    head = &service->msg_list;
 
     if (tfm_list_is_empty(head)) {
         return NULL;
     }
 
     /*
-     * There may be multiple messages for this RoT Service signal, do not clear
-     * partition mask until no remaining message. Search may be optimized.
+     * Messages of a RoT Service are queued in arrival order. Do not clear the
+     * signal until no message remains for the service.
      */
-    TFM_LIST_FOR_EACH(node, head) {
-        tmp_msg = TFM_GET_CONTAINER_PTR(node, struct tfm_msg_body_t, msg_node);
-        if (tmp_msg->service->service_db->signal == signal && msg) {
-            return msg;
-        } else if (tmp_msg->service->service_db->signal == signal) {
-            msg = tmp_msg;
-            tfm_list_del_node(node);
-        }
-    }
+    node = tfm_list_first_node(head);
+    tfm_list_del_node(node);
 
-    partition->signals_asserted &= ~signal;
+    if (tfm_list_is_empty(head)) {
+        partition->signals_asserted &= ~signal;
+    }
 
-    return msg;
+    return TFM_GET_CONTAINER_PTR(node, struct tfm_msg_body_t, msg_node);
 }
 
 /**
@@ -273,16 +294,23 @@ struct tfm_msg_body_t *tfm_spm_get_msg_by_signal(struct partition_t *partition,
  */
 static uint32_t get_partition_idx(uint32_t partition_id)
 {
-    uint32_t i;
+    uint32_t low = 0, high = g_spm_partition_db.partition_count, mid;
+    uint32_t mid_id;
 
     if (partition_id == INVALID_PARTITION_ID) {
         return SPM_INVALID_PARTITION_IDX;
     }
 
-    for (i = 0; i < g_spm_partition_db.partition_count; ++i) {
-        if (g_spm_partition_db.partitions[i].static_data->partition_id ==
-            partition_id) {
-            return i;
+    /* The partitions are sorted by partition ID */
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        mid_id = g_spm_partition_db.partitions[mid].static_data->partition_id;
+        if (mid_id == partition_id) {
+            return mid;
+        } else if (mid_id < partition_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
     return SPM_INVALID_PARTITION_IDX;
@@ -350,12 +378,19 @@ bool tfm_is_partition_privileged(uint32_t partition_idx)
 
 struct tfm_spm_service_t *tfm_spm_get_service_by_sid(uint32_t sid)
 {
-    uint32_t i, num;
+    uint32_t low = 0, high, mid;
 
-    num = sizeof(service) / sizeof(struct tfm_spm_service_t);
-    for (i = 0; i < num; i++) {
-        if (service[i].service_db->sid == sid) {
-            return &service[i];
+    high = sizeof(service) / sizeof(struct tfm_spm_service_t);
+
+    /* The services are sorted by SID */
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (service_db[mid].sid == sid) {
+            return &service[mid];
+        } else if (service_db[mid].sid < sid) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
 
@@ -561,8 +596,8 @@ int32_t tfm_spm_send_event(struct tfm_spm_service_t *service,
     TFM_CORE_ASSERT(service);
     TFM_CORE_ASSERT(msg);
 
-    /* Add message to partition message list tail */
-    tfm_list_add_tail(&partition->msg_list, &msg->msg_node);
+    /* Add message to service message queue tail */
+    tfm_list_add_tail(&service->msg_list, &msg->msg_node);
 
     /* Messages put. Update signals */
     partition->signals_asserted |= service->service_db->signal;
@@ -695,7 +730,6 @@ uint32_t tfm_spm_init(void)
         }
 
         tfm_event_init(&partition->event);
-        tfm_list_init(&partition->msg_list);
 
         pth = &partition->sp_thread;
         if (!pth) {
@@ -714,6 +748,8 @@ uint32_t tfm_spm_init(void)
         if (partition->static_data->partition_id == TFM_SP_NON_SECURE_ID) {
             p_ns_entry_thread = pth;
             pth->param = (void *)tfm_spm_hal_get_ns_entry_point();
+            /* Schedule the non-secure thread below all the secure threads */
+            tfm_core_thrd_set_secure(pth, THRD_ATTR_NON_SECURE);
         }
 
         /* Kick off */
@@ -725,6 +761,11 @@ uint32_t tfm_spm_init(void)
     /* Init Service */
     num = sizeof(service) / sizeof(struct tfm_spm_service_t);
     for (i = 0; i < num; i++) {
+        /* Service lookups rely on the SIDs being unique and sorted */
+        if ((i > 0) && (service_db[i].sid <= service_db[i - 1].sid)) {
+            tfm_core_panic();
+        }
+
         service[i].service_db = &service_db[i];
         partition =
             tfm_spm_get_partition_by_id(service[i].service_db->partition_id);
@@ -734,7 +775,18 @@ uint32_t tfm_spm_init(void)
         service[i].partition = partition;
         partition->signals_allowed |= service[i].service_db->signal;
 
+        /* Each RoT Service of a partition must have a distinct signal bit */
+        if (!tfm_is_one_bit_set(service[i].service_db->signal)) {
+            tfm_core_panic();
+        }
+        j = tfm_spm_signal_bit(service[i].service_db->signal);
+        if (partition->signal_services[j]) {
+            tfm_core_panic();
+        }
+        partition->signal_services[j] = &service[i];
+
         tfm_list_init(&service[i].handle_list);
+        tfm_list_init(&service[i].msg_list);
     }
 
     /*
@@ -1032,6 +1084,11 @@ enum spm_err_t tfm_spm_db_init(void)
     /* This function initialises partition db */
 
     for (i = 0; i < g_spm_partition_db.partition_count; i++) {
+        /* Partition lookups rely on the IDs being unique and sorted */
+        if ((i > 0) && (static_data_list[i].partition_id <=
+                        static_data_list[i - 1].partition_id)) {
+            return SPM_ERR_INVALID_CONFIG;
+        }
         g_spm_partition_db.partitions[i].static_data = &static_data_list[i];
         g_spm_partition_db.partitions[i].platform_data_list =
                                                      platform_data_list_list[i];
@@ -31,6 +31,9 @@
 
 #define SPM_INVALID_PARTITION_IDX     (~0U)
 
+/* Number of bits of a psa_signal_t */
+#define TFM_SIGNAL_BITS                 32
+
 /* Privileged definitions for partition thread mode */
 #define TFM_PARTITION_UNPRIVILEGED_MODE 0
 #define TFM_PARTITION_PRIVILEGED_MODE   1
@@ -67,6 +70,14 @@ struct tfm_msg_body_t {
                                         * Save caller outvec pointer for
                                         * write length update
                                         */
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    uint8_t iovec_mapped;              /* Vectors mapped by the service  */
+    uint8_t iovec_unmapped;            /* Mapped vectors unmapped again  */
+    uint8_t iovec_accessed;            /*
+                                        * Vectors read, skipped or written
+                                        * by copy
+                                        */
+#endif
 #ifdef TFM_MULTI_CORE_TOPOLOGY
     const void *caller_data;           /*
                                         * Pointer to the private data of the
@@ -107,7 +118,8 @@ struct partition_t {
     void *p_metadata;
     struct tfm_core_thread_t sp_thread;
     struct tfm_event_t event;
-    struct tfm_list_node_t msg_list;
+    /** RoT Services of the partition, indexed by the bit of their signal */
+    struct tfm_spm_service_t *signal_services[TFM_SIGNAL_BITS];
     uint32_t signals_allowed;
     uint32_t signals_waiting;
     uint32_t signals_asserted;
@@ -141,6 +153,7 @@ struct tfm_spm_service_t {
                                               * data
                                               */
     struct tfm_list_node_t handle_list;      /* Service handle list          */
+    struct tfm_list_node_t msg_list;         /* Pending message queue        */
     struct tfm_list_node_t list;             /* For list operation           */
 };
 
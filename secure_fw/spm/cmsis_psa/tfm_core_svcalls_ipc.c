@@ -81,6 +81,18 @@ static int32_t SVC_Handler_IPC(tfm_svc_number_t svc_num, uint32_t *ctx,
     case TFM_SVC_PSA_WRITE:
         tfm_spm_psa_write(ctx);
         break;
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    case TFM_SVC_PSA_MAP_INVEC:
+        return (int32_t)tfm_spm_psa_map_invec(ctx);
+    case TFM_SVC_PSA_UNMAP_INVEC:
+        tfm_spm_psa_unmap_invec(ctx);
+        break;
+    case TFM_SVC_PSA_MAP_OUTVEC:
+        return (int32_t)tfm_spm_psa_map_outvec(ctx);
+    case TFM_SVC_PSA_UNMAP_OUTVEC:
+        tfm_spm_psa_unmap_outvec(ctx);
+        break;
+#endif
     case TFM_SVC_PSA_REPLY:
         tfm_spm_psa_reply(ctx);
         break;
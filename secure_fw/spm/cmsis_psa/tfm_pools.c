@@ -14,18 +14,79 @@
 #include "tfm_internal_defines.h"
 #include "cmsis_compiler.h"
 #include "utilities.h"
-#include "tfm_list.h"
 #include "tfm_pools.h"
 #include "tfm_memory_utils.h"
 #include "tfm_core_utils.h"
 
+/*
+ * Use exclusive accesses to update the pool where the architecture provides
+ * them. Otherwise, mask the interrupts during the update.
+ */
+#if ((defined(__ARM_ARCH_7M__) && (__ARM_ARCH_7M__ == 1)) || \
+     (defined(__ARM_ARCH_7EM__) && (__ARM_ARCH_7EM__ == 1)) || \
+     (defined(__ARM_ARCH_8M_MAIN__) && (__ARM_ARCH_8M_MAIN__ == 1)) || \
+     (defined(__ARM_ARCH_8M_BASE__) && (__ARM_ARCH_8M_BASE__ == 1)))
+#define TFM_POOL_EXCLUSIVE_ACCESS 1
+#else
+#define TFM_POOL_EXCLUSIVE_ACCESS 0
+#endif
+
+/*
+ * Atomically replace the value at addr with desired, if it is expected.
+ * Returns true if the value was replaced. The caller retries on failure.
+ */
+static bool pool_cas(volatile uint32_t *addr, uint32_t expected,
+                     uint32_t desired)
+{
+#if TFM_POOL_EXCLUSIVE_ACCESS
+    if (__LDREXW(addr) != expected) {
+        __CLREX();
+        return false;
+    }
+
+    return (__STREXW(desired, addr) == 0);
+#else
+    uint32_t primask = __get_PRIMASK();
+    bool ret = false;
+
+    __disable_irq();
+    if (*addr == expected) {
+        *addr = desired;
+        ret = true;
+    }
+    __set_PRIMASK(primask);
+
+    return ret;
+#endif
+}
+
+/* Atomically add val to the value at addr and return the new value */
+static uint32_t pool_atomic_add(volatile uint32_t *addr, uint32_t val)
+{
+    uint32_t old;
+
+    do {
+        old = *addr;
+    } while (!pool_cas(addr, old, old + val));
+
+    return old + val;
+}
+
+static struct tfm_pool_chunk_t *pool_get_chunk(
+                                        struct tfm_pool_instance_t *pool,
+                                        uint32_t index)
+{
+    return (struct tfm_pool_chunk_t *)((uint8_t *)pool->chunks +
+           (pool->chunksz + sizeof(struct tfm_pool_chunk_t)) * index);
+}
+
 int32_t tfm_pool_init(struct tfm_pool_instance_t *pool, size_t poolsz,
                       size_t chunksz, size_t num)
 {
     struct tfm_pool_chunk_t *pchunk;
     size_t i;
 
-    if (!pool || num == 0) {
+    if (!pool || num == 0 || num >= TFM_POOL_INDEX_NONE) {
         return IPC_ERROR_BAD_PARAMETERS;
     }
 
@@ -38,41 +99,50 @@ int32_t tfm_pool_init(struct tfm_pool_instance_t *pool, size_t poolsz,
     /* Buffer should be BSS cleared but clear it again */
     spm_memset(pool, 0, poolsz);
 
-    /* Chain pool chunks */
-    tfm_list_init(&pool->chunks_list);
+    /* Prepare instance */
+    pool->chunksz = chunksz;
+    pool->chunk_count = num;
 
-    pchunk = (struct tfm_pool_chunk_t *)pool->chunks;
+    /* Stack pool chunks, first chunk on top */
     for (i = 0; i < num; i++) {
+        pchunk = pool_get_chunk(pool, i);
         pchunk->pool = pool;
-        tfm_list_add_tail(&pool->chunks_list, &pchunk->list);
-        pchunk = (struct tfm_pool_chunk_t *)&pchunk->data[chunksz];
+        pchunk->index = i;
+        pchunk->next = (i + 1 < num) ? (i + 1) : TFM_POOL_INDEX_NONE;
     }
-
-    /* Prepare instance and insert to pool list */
-    pool->chunksz = chunksz;
-    pool->chunk_count = num;
+    pool->free_head = 0;
 
     return IPC_SUCCESS;
 }
 
 void *tfm_pool_alloc(struct tfm_pool_instance_t *pool)
 {
-    struct tfm_list_node_t *node;
     struct tfm_pool_chunk_t *pchunk;
+    uint32_t head, index, in_use, max_in_use;
 
     if (!pool) {
         return NULL;
     }
 
-    if (tfm_list_is_empty(&pool->chunks_list)) {
-        return NULL;
-    }
-
-    node = tfm_list_first_node(&pool->chunks_list);
-    pchunk = TFM_GET_CONTAINER_PTR(node, struct tfm_pool_chunk_t, list);
-
-    /* Remove node from list node, it will be added when pool free */
-    tfm_list_del_node(node);
+    /* Pop the chunk on top of the free stack */
+    do {
+        head = pool->free_head;
+        index = head & TFM_POOL_INDEX_MASK;
+        if (index == TFM_POOL_INDEX_NONE) {
+            (void)pool_atomic_add(&pool->alloc_failures, 1);
+            return NULL;
+        }
+        pchunk = pool_get_chunk(pool, index);
+    } while (!pool_cas(&pool->free_head, head,
+                       ((head + TFM_POOL_TAG_INC) & ~TFM_POOL_INDEX_MASK) |
+                       pchunk->next));
+
+    /* Update the statistics */
+    in_use = pool_atomic_add(&pool->in_use, 1);
+    do {
+        max_in_use = pool->max_in_use;
+    } while ((in_use > max_in_use) &&
+             !pool_cas(&pool->max_in_use, max_in_use, in_use));
 
     return &pchunk->data;
 }
@@ -81,10 +151,29 @@ void tfm_pool_free(void *ptr)
 {
     struct tfm_pool_chunk_t *pchunk;
     struct tfm_pool_instance_t *pool;
+    uint32_t head;
 
     pchunk = TFM_GET_CONTAINER_PTR(ptr, struct tfm_pool_chunk_t, data);
     pool = (struct tfm_pool_instance_t *)pchunk->pool;
-    tfm_list_add_tail(&pool->chunks_list, &pchunk->list);
+
+    /* Push the chunk on top of the free stack, to be allocated next */
+    do {
+        head = pool->free_head;
+        pchunk->next = head & TFM_POOL_INDEX_MASK;
+    } while (!pool_cas(&pool->free_head, head,
+                       ((head + TFM_POOL_TAG_INC) & ~TFM_POOL_INDEX_MASK) |
+                       pchunk->index));
+
+    (void)pool_atomic_add(&pool->in_use, (uint32_t)-1);
+}
+
+void tfm_pool_get_stats(struct tfm_pool_instance_t *pool,
+                        struct tfm_pool_stats_t *stats)
+{
+    stats->chunk_count = pool->chunk_count;
+    stats->in_use = pool->in_use;
+    stats->max_in_use = pool->max_in_use;
+    stats->alloc_failures = pool->alloc_failures;
 }
 
 bool is_valid_chunk_data_in_pool(struct tfm_pool_instance_t *pool,
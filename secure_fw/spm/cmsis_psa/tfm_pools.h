@@ -8,8 +8,8 @@
 #define __TFM_POOLS_H__
 
 #include <stdbool.h>
-
-#include "tfm_list.h"
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,10 +23,20 @@ extern "C" {
 /*
  * Pool Instance:
  *  [ Pool Instance ] + N * [ Pool Chunks ]
+ *
+ * Free chunks are kept in a stack linked by chunk index. The stack head holds
+ * the index of the top chunk in its low half and a tag, incremented by each
+ * update, in its high half, so that a chunk freed and allocated again between
+ * the read and the update of the head is detected.
  */
+#define TFM_POOL_INDEX_MASK      0xFFFFu         /* Chunk index of a head   */
+#define TFM_POOL_INDEX_NONE      TFM_POOL_INDEX_MASK /* Empty stack         */
+#define TFM_POOL_TAG_INC         0x10000u        /* Tag increment of a head */
+
 struct tfm_pool_chunk_t {
-    struct tfm_list_node_t list;        /* Chunk list                     */
     void *pool;                         /* Point to the parent pool       */
+    uint32_t index;                     /* Index of the chunk in the pool */
+    uint32_t next;                      /* Next free chunk index          */
     uint8_t data[0];                    /* Data indicator                 */
 };
 
@@ -35,14 +45,26 @@ struct tfm_pool_chunk_t {
  * required for standards compliant C
  */
 struct tfm_pool_chunk_s_t {
-    struct tfm_list_node_t list;        /* Chunk list                     */
     void *pool;                         /* Point to the parent pool       */
+    uint32_t index;                     /* Index of the chunk in the pool */
+    uint32_t next;                      /* Next free chunk index          */
+};
+
+/* Usage statistics of a pool */
+struct tfm_pool_stats_t {
+    uint32_t chunk_count;               /* A number of chunks in the pool */
+    uint32_t in_use;                    /* Chunks currently allocated     */
+    uint32_t max_in_use;                /* High-water mark of in_use      */
+    uint32_t alloc_failures;            /* Allocations from empty pool    */
 };
 
 struct tfm_pool_instance_t {
     size_t chunksz;                     /* Chunks size of pool member     */
     size_t chunk_count;                 /* A number of chunks in the pool */
-    struct tfm_list_node_t chunks_list; /* Chunk list head in pool        */
+    volatile uint32_t free_head;        /* Free chunk stack head          */
+    volatile uint32_t in_use;           /* Chunks currently allocated     */
+    volatile uint32_t max_in_use;       /* High-water mark of in_use      */
+    volatile uint32_t alloc_failures;   /* Allocations from empty pool    */
     struct tfm_pool_chunk_s_t chunks[0]; /* Data indicator                */
 };
 
@@ -90,6 +112,10 @@ int32_t tfm_pool_init(struct tfm_pool_instance_t *pool, size_t poolsz,
  *
  * \retval buffer pointer       Success.
  * \retval NULL                 Failed.
+ *
+ * \note The most recently freed chunk is allocated first. It is safe to call
+ *       this function and \ref tfm_pool_free from exception handlers which
+ *       preempt each other.
  */
 void *tfm_pool_alloc(struct tfm_pool_instance_t *pool);
 
@@ -100,6 +126,16 @@ void *tfm_pool_alloc(struct tfm_pool_instance_t *pool);
  */
 void tfm_pool_free(void *ptr);
 
+/**
+ * \brief Get the usage statistics of a pool.
+ *
+ * \param[in]  pool             Pointer to memory pool declared by
+ *                              \ref TFM_POOL_DECLARE.
+ * \param[out] stats            Statistics of the pool.
+ */
+void tfm_pool_get_stats(struct tfm_pool_instance_t *pool,
+                        struct tfm_pool_stats_t *stats);
+
 /**
  * \brief Checks whether a pointer points to a chunk data in the pool.
  *
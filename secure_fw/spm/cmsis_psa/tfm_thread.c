@@ -13,72 +13,97 @@
 #include "tfm_core_utils.h"
 
 /* Force ZERO in case ZI(bss) clear is missing */
-static struct tfm_core_thread_t *p_thrd_head = NULL;
-static struct tfm_core_thread_t *p_runn_head = NULL;
+static struct tfm_core_thread_t *p_rdy_head[THRD_PRIOR_LEVELS] = {NULL};
+static struct tfm_core_thread_t *p_rdy_tail[THRD_PRIOR_LEVELS] = {NULL};
+static uint32_t rdy_bitmap = 0;
 static struct tfm_core_thread_t *p_curr_thrd = NULL;
 
 /* Define Macro to fetch global to support future expansion (PERCPU e.g.) */
-#define LIST_HEAD   p_thrd_head
-#define RUNN_HEAD   p_runn_head
+#define RDY_HEAD    p_rdy_head
+#define RDY_TAIL    p_rdy_tail
+#define RDY_BITMAP  rdy_bitmap
 #define CURR_THRD   p_curr_thrd
 
-static struct tfm_core_thread_t *find_next_running_thread(
-                                                struct tfm_core_thread_t *pth)
+/*
+ * Level 0 is the highest priority. It is held by the most significant bit of
+ * the ready bitmap, so that the highest ready level is the count of leading
+ * zeros of the bitmap.
+ */
+#define LEVEL_BIT(level)    ((1UL << (THRD_PRIOR_LEVELS - 1)) >> (level))
+
+static uint32_t prior_to_level(uint32_t prior)
 {
-    while (pth && pth->state != THRD_STATE_RUNNING) {
-        pth = pth->next;
+    uint32_t level = (prior & THRD_PRIOR_MASK) >> THRD_PRIOR_LEVEL_SHIFT;
+
+    /* Non-secure threads are below all the secure threads */
+    if (prior & THRD_ATTR_NON_SECURE) {
+        level += THRD_PRIOR_LEVELS / 2;
     }
 
-    return pth;
+    return level;
 }
 
-/* To get next running thread for scheduler */
-struct tfm_core_thread_t *tfm_core_thrd_get_next_thread(void)
+/* Append a thread to the ready queue of its priority level */
+static void rdy_enqueue(struct tfm_core_thread_t *pth)
 {
-    /*
-     * First RUNNING thread has highest priority since threads are sorted with
-     * priority.
-     */
-    return find_next_running_thread(RUNN_HEAD);
-}
+    uint32_t level = prior_to_level(pth->prior);
 
-/* To get current thread for caller */
-struct tfm_core_thread_t *tfm_core_thrd_get_curr_thread(void)
-{
-    return CURR_THRD;
+    pth->level = level;
+    pth->next = NULL;
+    pth->prev = RDY_TAIL[level];
+
+    if (RDY_TAIL[level]) {
+        RDY_TAIL[level]->next = pth;
+    } else {
+        RDY_HEAD[level] = pth;
+        RDY_BITMAP |= LEVEL_BIT(level);
+    }
+    RDY_TAIL[level] = pth;
 }
 
-/* Insert a new thread into list by descending priority (Highest at head) */
-static void insert_by_prior(struct tfm_core_thread_t **head,
-                            struct tfm_core_thread_t *node)
+/* Remove a thread from the ready queue it is in */
+static void rdy_dequeue(struct tfm_core_thread_t *pth)
 {
-    if (*head == NULL || (node->prior <= (*head)->prior)) {
-        node->next = *head;
-        *head = node;
+    uint32_t level = pth->level;
+
+    if (pth->prev) {
+        pth->prev->next = pth->next;
     } else {
-        struct tfm_core_thread_t *iter = *head;
+        RDY_HEAD[level] = pth->next;
+    }
 
-        while (iter->next && (node->prior > iter->next->prior)) {
-            iter = iter->next;
-        }
-        node->next = iter->next;
-        iter->next = node;
+    if (pth->next) {
+        pth->next->prev = pth->prev;
+    } else {
+        RDY_TAIL[level] = pth->prev;
     }
+
+    if (!RDY_HEAD[level]) {
+        RDY_BITMAP &= ~LEVEL_BIT(level);
+    }
+
+    pth->next = NULL;
+    pth->prev = NULL;
 }
 
-/*
- * Set first running thread as head to reduce enumerate
- * depth while searching for a first running thread.
- */
-static void update_running_head(struct tfm_core_thread_t **runn,
-                                struct tfm_core_thread_t *node)
+/* To get next running thread for scheduler */
+struct tfm_core_thread_t *tfm_core_thrd_get_next_thread(void)
 {
-    if ((node->state == THRD_STATE_RUNNING) &&
-        (*runn == NULL || (node->prior < (*runn)->prior))) {
-        *runn = node;
-    } else {
-        *runn = LIST_HEAD;
+    if (RDY_BITMAP == 0) {
+        return NULL;
     }
+
+    /*
+     * The first thread of the highest ready level has been RUNNING for the
+     * longest time among the threads of its level.
+     */
+    return RDY_HEAD[__CLZ(RDY_BITMAP)];
+}
+
+/* To get current thread for caller */
+struct tfm_core_thread_t *tfm_core_thrd_get_curr_thread(void)
+{
+    return CURR_THRD;
 }
 
 /* Set context members only. No validation here */
@@ -108,10 +133,7 @@ uint32_t tfm_core_thrd_start(struct tfm_core_thread_t *pth)
     tfm_arch_init_context(&pth->arch_ctx, pth->param, (uintptr_t)pth->pfn,
                           pth->stk_btm, pth->stk_top);
 
-    /* Insert a new thread with priority */
-    insert_by_prior(&LIST_HEAD, pth);
-
-    /* Mark it as RUNNING after insertion */
+    /* Mark it as RUNNING, which inserts it into the ready queue */
     tfm_core_thrd_set_state(pth, THRD_STATE_RUNNING);
 
     return THRD_SUCCESS;
@@ -121,8 +143,16 @@ void tfm_core_thrd_set_state(struct tfm_core_thread_t *pth, uint32_t new_state)
 {
     TFM_CORE_ASSERT(pth != NULL && new_state < THRD_STATE_INVALID);
 
+    /* Only RUNNING threads are in the ready queues */
+    if ((pth->state == THRD_STATE_RUNNING) &&
+        (new_state != THRD_STATE_RUNNING)) {
+        rdy_dequeue(pth);
+    } else if ((pth->state != THRD_STATE_RUNNING) &&
+               (new_state == THRD_STATE_RUNNING)) {
+        rdy_enqueue(pth);
+    }
+
     pth->state = new_state;
-    update_running_head(&RUNN_HEAD, pth);
 }
 
 /* Scheduling won't happen immediately but after the exception returns */
@@ -30,6 +30,14 @@
 #define THRD_PRIOR_MEDIUM         0x7F
 #define THRD_PRIOR_LOWEST         0xFF
 
+/*
+ * Number of scheduling levels. The priority values are grouped into 16 levels
+ * for secure threads, followed by 16 levels for non-secure threads. Threads at
+ * the same level are scheduled in the order they became RUNNING.
+ */
+#define THRD_PRIOR_LEVELS         32
+#define THRD_PRIOR_LEVEL_SHIFT    4
+
 /* Error code */
 #define THRD_SUCCESS              0
 #define THRD_ERR_INVALID_PARAM    1
@@ -45,9 +53,11 @@ struct tfm_core_thread_t {
     uintptr_t       stk_top;            /* stack top    (higher address)*/
     uint32_t        prior;              /* priority                     */
     uint32_t        state;              /* state                        */
+    uint32_t        level;              /* ready queue level            */
 
     struct tfm_arch_ctx_t    arch_ctx;  /* State context                */
-    struct tfm_core_thread_t *next;     /* next thread in list          */
+    struct tfm_core_thread_t *next;     /* next in ready queue          */
+    struct tfm_core_thread_t *prev;     /* prev in ready queue          */
 };
 
 /*
@@ -77,7 +87,8 @@ void tfm_core_thrd_init(struct tfm_core_thread_t *pth,
  *
  * Notes :
  *  Set thread priority. Priority is set to THRD_PRIOR_MEDIUM in
- *  tfm_core_thrd_init().
+ *  tfm_core_thrd_init(). The priority of a RUNNING thread takes effect the
+ *  next time it becomes RUNNING.
  */
 void __STATIC_INLINE tfm_core_thrd_set_priority(struct tfm_core_thread_t *pth,
                                                 uint32_t prior)
@@ -176,7 +187,8 @@ struct tfm_core_thread_t *tfm_core_thrd_get_curr_thread(void);
  * Get next running thread in list.
  *
  * Return :
- *  Pointer of next thread to be run.
+ *  Pointer of next thread to be run, the first RUNNING thread of the highest
+ *  priority level. NULL if no thread is RUNNING.
  */
 struct tfm_core_thread_t *tfm_core_thrd_get_next_thread(void);
 
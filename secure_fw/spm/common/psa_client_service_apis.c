@@ -19,6 +19,12 @@
 #include "tfm_rpc.h"
 #include "tfm_spm_hal.h"
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+/* Bits of the input and output vectors in the iovec masks of a message */
+#define TFM_INVEC_BIT(idx)      (1U << (idx))
+#define TFM_OUTVEC_BIT(idx)     (1U << (PSA_MAX_IOVEC + (idx)))
+#endif
+
 /*********************** SPM functions for PSA Client APIs *******************/
 
 uint32_t tfm_spm_get_lifecycle_state(void)
@@ -304,6 +310,17 @@ size_t tfm_spm_psa_read(uint32_t *args)
         tfm_core_panic();
     }
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    /*
+     * It is a fatal error if the input vector has already been mapped using
+     * psa_map_invec().
+     */
+    if (msg->iovec_mapped & TFM_INVEC_BIT(invec_idx)) {
+        tfm_core_panic();
+    }
+    msg->iovec_accessed |= TFM_INVEC_BIT(invec_idx);
+#endif
+
     /* There was no remaining data in this input vector */
     if (msg->msg.in_size[invec_idx] == 0) {
         return 0;
@@ -364,6 +381,17 @@ size_t tfm_spm_psa_skip(uint32_t *args)
         tfm_core_panic();
     }
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    /*
+     * It is a fatal error if the input vector has already been mapped using
+     * psa_map_invec().
+     */
+    if (msg->iovec_mapped & TFM_INVEC_BIT(invec_idx)) {
+        tfm_core_panic();
+    }
+    msg->iovec_accessed |= TFM_INVEC_BIT(invec_idx);
+#endif
+
     /* There was no remaining data in this input vector */
     if (msg->msg.in_size[invec_idx] == 0) {
         return 0;
@@ -427,6 +455,17 @@ void tfm_spm_psa_write(uint32_t *args)
         tfm_core_panic();
     }
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+    /*
+     * It is a fatal error if the output vector has already been mapped using
+     * psa_map_outvec().
+     */
+    if (msg->iovec_mapped & TFM_OUTVEC_BIT(outvec_idx)) {
+        tfm_core_panic();
+    }
+    msg->iovec_accessed |= TFM_OUTVEC_BIT(outvec_idx);
+#endif
+
     /*
      * It is a fatal error if the call attempts to write data past the end of
      * the client output vector
@@ -452,6 +491,230 @@ void tfm_spm_psa_write(uint32_t *args)
     msg->outvec[outvec_idx].len += num_bytes;
 }
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+/*
+ * The RoT Service accesses a mapped vector without the help of the SPM, which
+ * is only possible if its partition can reach the client memory. This is the
+ * case for every partition in isolation level 1, and for the privileged ones
+ * otherwise.
+ */
+static void tfm_spm_check_iovec_mappable(struct tfm_msg_body_t *msg)
+{
+#if TFM_LVL != 1
+    struct partition_t *partition = msg->service->partition;
+
+    if (tfm_spm_partition_get_privileged_mode(
+            partition->static_data->partition_flags) !=
+        TFM_PARTITION_PRIVILEGED_MODE) {
+        tfm_core_panic();
+    }
+#else
+    (void)msg;
+#endif
+}
+
+/*
+ * Returns the request message of the handle, or panics if the handle is not
+ * a valid request message handle.
+ */
+static struct tfm_msg_body_t *tfm_spm_get_request_msg(psa_handle_t msg_handle)
+{
+    struct tfm_msg_body_t *msg = NULL;
+
+    /* It is a fatal error if message handle is invalid */
+    msg = tfm_spm_get_msg_from_handle(msg_handle);
+    if (!msg) {
+        tfm_core_panic();
+    }
+
+    /*
+     * It is a fatal error if message handle does not refer to a request
+     * message
+     */
+    if (msg->msg.type < PSA_IPC_CALL) {
+        tfm_core_panic();
+    }
+
+    return msg;
+}
+
+const void *tfm_spm_psa_map_invec(uint32_t *args)
+{
+    psa_handle_t msg_handle;
+    uint32_t invec_idx;
+    struct tfm_msg_body_t *msg = NULL;
+
+    TFM_CORE_ASSERT(args != NULL);
+    msg_handle = (psa_handle_t)args[0];
+    invec_idx = args[1];
+
+    msg = tfm_spm_get_request_msg(msg_handle);
+    tfm_spm_check_iovec_mappable(msg);
+
+    /*
+     * It is a fatal error if invec_idx is equal to or greater than
+     * PSA_MAX_IOVEC
+     */
+    if (invec_idx >= PSA_MAX_IOVEC) {
+        tfm_core_panic();
+    }
+
+    /* It is a fatal error if the input vector has length zero */
+    if (msg->msg.in_size[invec_idx] == 0) {
+        tfm_core_panic();
+    }
+
+    /*
+     * It is a fatal error if the input vector has already been mapped, or
+     * accessed using psa_read() or psa_skip().
+     */
+    if ((msg->iovec_mapped | msg->iovec_accessed) &
+        TFM_INVEC_BIT(invec_idx)) {
+        tfm_core_panic();
+    }
+
+    /* The client memory was checked by psa_call() */
+    msg->iovec_mapped |= TFM_INVEC_BIT(invec_idx);
+
+    return msg->invec[invec_idx].base;
+}
+
+void tfm_spm_psa_unmap_invec(uint32_t *args)
+{
+    psa_handle_t msg_handle;
+    uint32_t invec_idx;
+    struct tfm_msg_body_t *msg = NULL;
+
+    TFM_CORE_ASSERT(args != NULL);
+    msg_handle = (psa_handle_t)args[0];
+    invec_idx = args[1];
+
+    msg = tfm_spm_get_request_msg(msg_handle);
+
+    /*
+     * It is a fatal error if invec_idx is equal to or greater than
+     * PSA_MAX_IOVEC
+     */
+    if (invec_idx >= PSA_MAX_IOVEC) {
+        tfm_core_panic();
+    }
+
+    /*
+     * It is a fatal error if the input vector has not been mapped, or has
+     * already been unmapped.
+     */
+    if (!(msg->iovec_mapped & TFM_INVEC_BIT(invec_idx)) ||
+        (msg->iovec_unmapped & TFM_INVEC_BIT(invec_idx))) {
+        tfm_core_panic();
+    }
+
+    msg->iovec_unmapped |= TFM_INVEC_BIT(invec_idx);
+}
+
+void *tfm_spm_psa_map_outvec(uint32_t *args)
+{
+    psa_handle_t msg_handle;
+    uint32_t outvec_idx;
+    struct tfm_msg_body_t *msg = NULL;
+
+    TFM_CORE_ASSERT(args != NULL);
+    msg_handle = (psa_handle_t)args[0];
+    outvec_idx = args[1];
+
+    msg = tfm_spm_get_request_msg(msg_handle);
+    tfm_spm_check_iovec_mappable(msg);
+
+    /*
+     * It is a fatal error if outvec_idx is equal to or greater than
+     * PSA_MAX_IOVEC
+     */
+    if (outvec_idx >= PSA_MAX_IOVEC) {
+        tfm_core_panic();
+    }
+
+    /* It is a fatal error if the output vector has length zero */
+    if (msg->msg.out_size[outvec_idx] == 0) {
+        tfm_core_panic();
+    }
+
+    /*
+     * It is a fatal error if the output vector has already been mapped, or
+     * accessed using psa_write().
+     */
+    if ((msg->iovec_mapped | msg->iovec_accessed) &
+        TFM_OUTVEC_BIT(outvec_idx)) {
+        tfm_core_panic();
+    }
+
+    /* The client memory was checked by psa_call() */
+    msg->iovec_mapped |= TFM_OUTVEC_BIT(outvec_idx);
+
+    return msg->outvec[outvec_idx].base;
+}
+
+void tfm_spm_psa_unmap_outvec(uint32_t *args)
+{
+    psa_handle_t msg_handle;
+    uint32_t outvec_idx;
+    size_t len;
+    struct tfm_msg_body_t *msg = NULL;
+
+    TFM_CORE_ASSERT(args != NULL);
+    msg_handle = (psa_handle_t)args[0];
+    outvec_idx = args[1];
+    len = (size_t)args[2];
+
+    msg = tfm_spm_get_request_msg(msg_handle);
+
+    /*
+     * It is a fatal error if outvec_idx is equal to or greater than
+     * PSA_MAX_IOVEC
+     */
+    if (outvec_idx >= PSA_MAX_IOVEC) {
+        tfm_core_panic();
+    }
+
+    /*
+     * It is a fatal error if the output vector has not been mapped, or has
+     * already been unmapped.
+     */
+    if (!(msg->iovec_mapped & TFM_OUTVEC_BIT(outvec_idx)) ||
+        (msg->iovec_unmapped & TFM_OUTVEC_BIT(outvec_idx))) {
+        tfm_core_panic();
+    }
+
+    /*
+     * It is a fatal error if len is greater than the size of the output
+     * vector
+     */
+    if (len > msg->msg.out_size[outvec_idx]) {
+        tfm_core_panic();
+    }
+
+    msg->iovec_unmapped |= TFM_OUTVEC_BIT(outvec_idx);
+
+    /* Update the write number */
+    msg->outvec[outvec_idx].len = len;
+}
+
+/*
+ * Unmaps the vectors of a request message which the RoT Service left mapped
+ * when replying. Nothing is reported written to such an output vector.
+ */
+static void tfm_spm_unmap_iovecs(struct tfm_msg_body_t *msg)
+{
+    uint32_t i;
+
+    for (i = 0; i < PSA_MAX_IOVEC; i++) {
+        if ((msg->iovec_mapped & ~msg->iovec_unmapped) & TFM_OUTVEC_BIT(i)) {
+            msg->outvec[i].len = 0;
+        }
+    }
+
+    msg->iovec_unmapped = msg->iovec_mapped;
+}
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
+
 void tfm_spm_psa_reply(uint32_t *args)
 {
     psa_handle_t msg_handle;
@@ -519,6 +782,9 @@ void tfm_spm_psa_reply(uint32_t *args)
         if (msg->msg.type >= PSA_IPC_CALL) {
             /* Reply to a request message. Return values are based on status */
             ret = status;
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+            tfm_spm_unmap_iovecs(msg);
+#endif
             /*
              * The total number of bytes written to a single parameter must be
              * reported to the client by updating the len member of the
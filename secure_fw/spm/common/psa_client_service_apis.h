@@ -208,6 +208,92 @@ size_t tfm_spm_psa_skip(uint32_t *args);
  */
 void tfm_spm_psa_write(uint32_t *args);
 
+#ifdef PSA_FRAMEWORK_HAS_MM_IOVEC
+/**
+ * \brief SVC handler for \ref psa_map_invec.
+ *
+ * \param[in] args              Include all input arguments:
+ *                              msg_handle, invec_idx.
+ *
+ * \retval                      A pointer to the input vector data.
+ * \retval "Does not return"    The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           invec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The input vector has length zero.
+ * \arg                           The input vector has already been mapped
+ *                                or accessed.
+ * \arg                           The Secure Partition cannot access the
+ *                                client memory directly.
+ */
+const void *tfm_spm_psa_map_invec(uint32_t *args);
+
+/**
+ * \brief SVC handler for \ref psa_unmap_invec.
+ *
+ * \param[in] args              Include all input arguments:
+ *                              msg_handle, invec_idx.
+ *
+ * \retval void                 Success.
+ * \retval "Does not return"    The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           invec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The input vector is not mapped, or has
+ *                                already been unmapped.
+ */
+void tfm_spm_psa_unmap_invec(uint32_t *args);
+
+/**
+ * \brief SVC handler for \ref psa_map_outvec.
+ *
+ * \param[in] args              Include all input arguments:
+ *                              msg_handle, outvec_idx.
+ *
+ * \retval                      A pointer to the output vector buffer.
+ * \retval "Does not return"    The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           outvec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The output vector has length zero.
+ * \arg                           The output vector has already been mapped
+ *                                or written.
+ * \arg                           The Secure Partition cannot access the
+ *                                client memory directly.
+ */
+void *tfm_spm_psa_map_outvec(uint32_t *args);
+
+/**
+ * \brief SVC handler for \ref psa_unmap_outvec.
+ *
+ * \param[in] args              Include all input arguments:
+ *                              msg_handle, outvec_idx, len.
+ *
+ * \retval void                 Success.
+ * \retval "Does not return"    The call is invalid, one or more of the
+ *                              following are true:
+ * \arg                           msg_handle is invalid.
+ * \arg                           msg_handle does not refer to a request
+ *                                message.
+ * \arg                           outvec_idx is equal to or greater than
+ *                                \ref PSA_MAX_IOVEC.
+ * \arg                           The output vector is not mapped, or has
+ *                                already been unmapped.
+ * \arg                           len is greater than the size of the output
+ *                                vector.
+ */
+void tfm_spm_psa_unmap_outvec(uint32_t *args);
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
+
 /**
  * \brief SVC handler for \ref psa_reply.
  *
@@ -164,6 +164,7 @@ extern "C" {
 /* Firmware Update specific macros */
 #define SET_FWU_MINOR(sw_module, claim) (((sw_module) << 6) | (claim))
 #define GET_FWU_CLAIM(tlv_type)  (GET_MINOR(tlv_type)  & CLAIM_MASK)
+#define GET_FWU_MODULE(tlv_type) (GET_MINOR(tlv_type) >> MODULE_POS)
 
 /* Magic value which marks the beginning of shared data area in memory */
 #define SHARED_DATA_TLV_INFO_MAGIC    0x2016
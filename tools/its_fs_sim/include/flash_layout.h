@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __FLASH_LAYOUT_H__
+#define __FLASH_LAYOUT_H__
+
+/* Flash layout of the host simulator. Both storage areas are emulated in RAM,
+ * so the flash device names are not used. The geometry can be overridden from
+ * the make command line.
+ */
+
+#define ITS_FLASH_DEV_NAME Driver_FLASH0
+
+#ifndef ITS_SECTOR_SIZE
+#define ITS_SECTOR_SIZE 0x1000
+#endif
+#ifndef ITS_SECTORS_PER_BLOCK
+#define ITS_SECTORS_PER_BLOCK 1
+#endif
+#ifndef ITS_FLASH_PROGRAM_UNIT
+#define ITS_FLASH_PROGRAM_UNIT 1
+#endif
+#ifndef ITS_NUM_BLOCKS
+#define ITS_NUM_BLOCKS 4
+#endif
+#define ITS_RAM_FS_SIZE (ITS_NUM_BLOCKS * ITS_SECTORS_PER_BLOCK * \
+                         ITS_SECTOR_SIZE)
+
+#define PS_FLASH_DEV_NAME Driver_FLASH0
+
+#ifndef PS_SECTOR_SIZE
+#define PS_SECTOR_SIZE 0x1000
+#endif
+#ifndef PS_SECTORS_PER_BLOCK
+#define PS_SECTORS_PER_BLOCK 1
+#endif
+#ifndef PS_FLASH_PROGRAM_UNIT
+#define PS_FLASH_PROGRAM_UNIT 1
+#endif
+#ifndef PS_NUM_BLOCKS
+#define PS_NUM_BLOCKS 8
+#endif
+#define PS_RAM_FS_SIZE (PS_NUM_BLOCKS * PS_SECTORS_PER_BLOCK * PS_SECTOR_SIZE)
+
+#endif /* __FLASH_LAYOUT_H__ */
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PSA_MANIFEST_PID_H__
+#define __PSA_MANIFEST_PID_H__
+
+/* Partition IDs used by the storage services in the host simulator */
+#define TFM_SP_PS  256
+#define TFM_SP_ITS 257
+
+#endif /* __PSA_MANIFEST_PID_H__ */
@@ -0,0 +1,821 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Host simulator of the ITS and PS services. It runs a randomised workload
+ * against the services built on flash emulated in RAM and reports their
+ * throughput, the flash wear they cause and their worst-case latency. Power
+ * cuts can be injected into the flash operations, after which the simulator
+ * boots the services again and checks that every asset holds either its value
+ * before or after the interrupted request. The assets changed by an interrupted
+ * transaction must all hold either their values before or after it.
+ *
+ * Each boot runs in a child process, so that the state kept in RAM by the
+ * services is lost at a power cut. The flash contents and the simulator's
+ * records are kept in memory shared with the parent process.
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "its_fs_sim.h"
+
+#include "flash_layout.h"
+#include "psa/storage_common.h"
+#include "tfm_internal_trusted_storage.h"
+#include "tfm_protected_storage.h"
+
+/* Client ID of the requests, as if made by the non-secure client */
+#define SIM_CLIENT_ID (-1)
+
+#define SIM_MAX_ASSETS ((ITS_NUM_ASSETS > PS_NUM_ASSETS) ? ITS_NUM_ASSETS : \
+                                                           PS_NUM_ASSETS)
+#define SIM_MAX_ASSET_SIZE ((ITS_MAX_ASSET_SIZE > PS_MAX_ASSET_SIZE) ? \
+                            ITS_MAX_ASSET_SIZE : PS_MAX_ASSET_SIZE)
+#define SIM_MAX_TRANSACTION_OPS \
+    ((ITS_TRANSACTION_MAX_OPS > PS_TRANSACTION_MAX_OPS) ? \
+     ITS_TRANSACTION_MAX_OPS : PS_TRANSACTION_MAX_OPS)
+
+enum sim_backend_t {
+    SIM_BACKEND_ITS = 0,
+    SIM_BACKEND_PS,
+};
+
+enum sim_op_t {
+    SIM_OP_SET = 0,
+    SIM_OP_GET,
+    SIM_OP_REMOVE,
+    SIM_OP_TRANSACTION,
+    SIM_NUM_OPS,
+};
+
+/* Workload parameters */
+struct sim_config_t {
+    enum sim_backend_t backend;
+    uint32_t num_assets;
+    uint32_t min_size;
+    uint32_t max_size;
+    uint32_t update_pct;
+    uint32_t remove_pct;
+    uint32_t transaction_pct;
+    uint64_t num_ops;
+    uint64_t power_cut_interval;
+    bool commit_cuts;
+    uint32_t seed;
+    bool fail_on_full;
+};
+
+/* Expected state of an asset. The contents are derived from the UID and the
+ * version.
+ */
+struct sim_asset_t {
+    bool exists;
+    uint32_t size;
+    uint32_t version;
+};
+
+/* Measurements of the workload, excluding the boots */
+struct sim_stats_t {
+    uint64_t num_ops[SIM_NUM_OPS];
+    uint64_t num_full;
+    uint64_t num_power_cuts;
+    uint64_t num_boots;
+    uint64_t op_time_ns;
+    uint64_t logical_written;
+    uint64_t logical_read;
+    uint64_t prog_bytes;
+    uint64_t erase_bytes;
+    uint64_t read_bytes;
+    uint64_t max_op_ns[SIM_NUM_OPS];
+    uint64_t max_boot_ns;
+    uint64_t max_op_erases;
+    uint64_t max_op_prog_bytes;
+};
+
+/* Everything which survives a simulated power cut */
+struct sim_shared_t {
+    struct sim_persistent_t persistent;
+    struct sim_stats_t stats;
+    uint64_t ops_done;
+    struct sim_asset_t assets[SIM_MAX_ASSETS + 1];
+    bool pending;                       /*!< A request was interrupted */
+    uint32_t num_pending;               /*!< Number of assets modified by the
+                                         *   request
+                                         */
+    uint32_t pending_uids[SIM_MAX_TRANSACTION_OPS]; /*!< UIDs modified by the
+                                                     *   request
+                                                     */
+    struct sim_asset_t pending_assets[SIM_MAX_TRANSACTION_OPS]; /*!< State of
+                                         *   the assets after the request
+                                         *   completes
+                                         */
+    uint64_t commit_cut_step;           /*!< Flash operation of the next
+                                         *   transaction commit to cut the
+                                         *   power at
+                                         */
+};
+
+struct sim_persistent_t *sim_state;
+
+static struct sim_config_t cfg;
+static struct sim_shared_t *shared;
+
+static uint8_t data_buf[SIM_MAX_ASSET_SIZE];
+static uint8_t expect_buf[SIM_MAX_ASSET_SIZE];
+
+uint32_t sim_rand(void)
+{
+    /* xorshift32 */
+    uint32_t x = sim_state->rand_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim_state->rand_state = x;
+
+    return x;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+static void fill_data(uint8_t *buf, uint32_t uid, const struct sim_asset_t *a)
+{
+    uint32_t x = (uid * 2654435761U) ^ (a->version * 40503U) ^ 0x5A5A5A5AU;
+    uint32_t i;
+
+    for (i = 0; i < a->size; i++) {
+        x = (x * 1103515245U) + 12345U;
+        buf[i] = (uint8_t)(x >> 16);
+    }
+}
+
+static void fail(const char *msg, uint32_t uid, psa_status_t status)
+{
+    (void)printf("FAIL: %s (uid %u, status %d, after %llu operations)\n", msg,
+                 uid, (int)status, (unsigned long long)shared->ops_done);
+    (void)fflush(stdout);
+    _exit(1);
+}
+
+static psa_status_t service_init(void)
+{
+    psa_status_t status;
+
+    status = tfm_its_init();
+    if (status == PSA_SUCCESS && cfg.backend == SIM_BACKEND_PS) {
+        status = tfm_ps_init();
+    }
+
+    return status;
+}
+
+static psa_status_t service_set(uint32_t uid, uint32_t size)
+{
+    sim_req_set_source(data_buf);
+
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_set(SIM_CLIENT_ID, uid, size, PSA_STORAGE_FLAG_NONE);
+    }
+    return tfm_its_set(SIM_CLIENT_ID, uid, size, PSA_STORAGE_FLAG_NONE);
+}
+
+static psa_status_t service_get(uint32_t uid, size_t *size)
+{
+    sim_req_set_dest(data_buf);
+
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_get(SIM_CLIENT_ID, uid, 0, sizeof(data_buf), size);
+    }
+    return tfm_its_get(SIM_CLIENT_ID, uid, 0, sizeof(data_buf), size);
+}
+
+static psa_status_t service_remove(uint32_t uid)
+{
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_remove(SIM_CLIENT_ID, uid);
+    }
+    return tfm_its_remove(SIM_CLIENT_ID, uid);
+}
+
+static psa_status_t service_transaction_begin(void)
+{
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_transaction_begin(SIM_CLIENT_ID);
+    }
+    return tfm_its_transaction_begin(SIM_CLIENT_ID);
+}
+
+static psa_status_t service_transaction_set(uint32_t uid, uint32_t size)
+{
+    sim_req_set_source(data_buf);
+
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_transaction_set(SIM_CLIENT_ID, uid, size,
+                                      PSA_STORAGE_FLAG_NONE);
+    }
+    return tfm_its_transaction_set(SIM_CLIENT_ID, uid, size,
+                                   PSA_STORAGE_FLAG_NONE);
+}
+
+static psa_status_t service_transaction_remove(uint32_t uid)
+{
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_transaction_remove(SIM_CLIENT_ID, uid);
+    }
+    return tfm_its_transaction_remove(SIM_CLIENT_ID, uid);
+}
+
+static psa_status_t service_transaction_commit(void)
+{
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_transaction_commit(SIM_CLIENT_ID);
+    }
+    return tfm_its_transaction_commit(SIM_CLIENT_ID);
+}
+
+static psa_status_t service_transaction_abort(void)
+{
+    if (cfg.backend == SIM_BACKEND_PS) {
+        return tfm_ps_transaction_abort(SIM_CLIENT_ID);
+    }
+    return tfm_its_transaction_abort(SIM_CLIENT_ID);
+}
+
+static uint32_t service_transaction_max_ops(void)
+{
+    return (cfg.backend == SIM_BACKEND_PS) ? PS_TRANSACTION_MAX_OPS :
+                                             ITS_TRANSACTION_MAX_OPS;
+}
+
+/**
+ * \brief Checks that the asset stored by the service matches the given state.
+ *
+ * \return Returns true if it matches, false otherwise.
+ */
+static bool asset_matches(uint32_t uid, const struct sim_asset_t *a)
+{
+    psa_status_t status;
+    size_t size = 0;
+
+    status = service_get(uid, &size);
+    if (!a->exists) {
+        return (status == PSA_ERROR_DOES_NOT_EXIST);
+    }
+
+    if (status != PSA_SUCCESS || size != a->size) {
+        return false;
+    }
+
+    fill_data(expect_buf, uid, a);
+
+    return (memcmp(data_buf, expect_buf, size) == 0);
+}
+
+/**
+ * \brief Checks the stored assets after a boot. The assets modified by an
+ *        interrupted request may all hold either their old or their new state.
+ */
+static void check_assets(void)
+{
+    bool applied = true;
+    uint32_t uid;
+    uint32_t i;
+
+    if (shared->pending) {
+        for (i = 0; i < shared->num_pending && applied; i++) {
+            applied = asset_matches(shared->pending_uids[i],
+                                    &shared->pending_assets[i]);
+        }
+        /* Otherwise, all the assets must hold their old state */
+        if (applied) {
+            for (i = 0; i < shared->num_pending; i++) {
+                shared->assets[shared->pending_uids[i]] =
+                    shared->pending_assets[i];
+            }
+        }
+        shared->pending = false;
+    }
+
+    for (uid = 1; uid <= cfg.num_assets; uid++) {
+        if (!asset_matches(uid, &shared->assets[uid])) {
+            fail("asset lost or corrupted after boot", uid, PSA_SUCCESS);
+        }
+    }
+}
+
+/* Draws the new state of an asset which is set */
+static void next_set_state(const struct sim_asset_t *a,
+                           struct sim_asset_t *next)
+{
+    next->exists = true;
+    next->size = cfg.min_size +
+                 (sim_rand() % (cfg.max_size - cfg.min_size + 1));
+    next->version = a->version + 1;
+}
+
+/**
+ * \brief Prepares a transaction changing consecutive assets, recording their
+ *        state after the commit as pending. An asset is removed if it exists
+ *        and the draw selects a removal, otherwise it is set.
+ */
+static void prepare_transaction(uint32_t first_uid)
+{
+    uint32_t max_ops = service_transaction_max_ops();
+    uint32_t num, i, uid;
+    struct sim_asset_t *a;
+    struct sim_asset_t *next;
+
+    if (max_ops > cfg.num_assets) {
+        max_ops = cfg.num_assets;
+    }
+    num = (max_ops > 1) ? 2 + (sim_rand() % (max_ops - 1)) : 1;
+    if (num > max_ops) {
+        num = max_ops;
+    }
+
+    for (i = 0; i < num; i++) {
+        uid = 1 + ((first_uid - 1 + i) % cfg.num_assets);
+        a = &shared->assets[uid];
+        next = &shared->pending_assets[i];
+
+        if (a->exists && (cfg.update_pct + cfg.remove_pct != 0) &&
+            (sim_rand() % (cfg.update_pct + cfg.remove_pct)) >=
+                cfg.update_pct) {
+            *next = *a;
+            next->exists = false;
+        } else {
+            next_set_state(a, next);
+        }
+        shared->pending_uids[i] = uid;
+    }
+
+    shared->num_pending = num;
+}
+
+/**
+ * \brief Runs the pending transaction, cutting the power at the next flash
+ *        operation of its commit in turn if requested.
+ *
+ * \return Returns the status of the first request which failed
+ */
+static psa_status_t run_transaction(void)
+{
+    const struct sim_asset_t *next;
+    psa_status_t status;
+    uint32_t i, uid;
+
+    status = service_transaction_begin();
+
+    for (i = 0; i < shared->num_pending && status == PSA_SUCCESS; i++) {
+        uid = shared->pending_uids[i];
+        next = &shared->pending_assets[i];
+        if (next->exists) {
+            fill_data(data_buf, uid, next);
+            status = service_transaction_set(uid, next->size);
+        } else {
+            status = service_transaction_remove(uid);
+        }
+    }
+
+    if (status != PSA_SUCCESS) {
+        (void)service_transaction_abort();
+        return status;
+    }
+
+    if (cfg.commit_cuts) {
+        shared->commit_cut_step++;
+        sim_state->power_cut_countdown = shared->commit_cut_step;
+    }
+
+    status = service_transaction_commit();
+
+    /* The commit completed before the flash operation to cut at, so start
+     * again from the first one with the next transaction.
+     */
+    if (cfg.commit_cuts) {
+        shared->commit_cut_step = 0;
+        sim_state->power_cut_countdown = 0;
+    }
+
+    return status;
+}
+
+static void run_op(void)
+{
+    struct sim_stats_t *stats = &shared->stats;
+    struct sim_flash_stats_t before[2];
+    struct sim_asset_t *a;
+    struct sim_asset_t next;
+    enum sim_op_t op;
+    psa_status_t status;
+    uint64_t start, elapsed, prog, erases;
+    uint32_t uid, r, i;
+    size_t size = 0;
+
+    uid = 1 + (sim_rand() % cfg.num_assets);
+    a = &shared->assets[uid];
+    r = sim_rand() % 100;
+
+    if (r < cfg.transaction_pct) {
+        op = SIM_OP_TRANSACTION;
+        next = *a;
+        prepare_transaction(uid);
+    } else if (r < cfg.transaction_pct + cfg.update_pct) {
+        op = SIM_OP_SET;
+        next_set_state(a, &next);
+        fill_data(data_buf, uid, &next);
+    } else if (r < cfg.transaction_pct + cfg.update_pct + cfg.remove_pct) {
+        op = SIM_OP_REMOVE;
+        next = *a;
+        next.exists = false;
+    } else {
+        op = SIM_OP_GET;
+        next = *a;
+    }
+
+    /* Record the expected state in case the request is interrupted */
+    if (op != SIM_OP_TRANSACTION) {
+        shared->num_pending = 1;
+        shared->pending_uids[0] = uid;
+        shared->pending_assets[0] = next;
+    }
+    shared->pending = (op != SIM_OP_GET);
+
+    (void)memcpy(before, sim_state->flash, sizeof(before));
+    start = now_ns();
+
+    switch (op) {
+    case SIM_OP_SET:
+        status = service_set(uid, next.size);
+        break;
+    case SIM_OP_REMOVE:
+        status = service_remove(uid);
+        break;
+    case SIM_OP_TRANSACTION:
+        status = run_transaction();
+        break;
+    default:
+        status = service_get(uid, &size);
+        break;
+    }
+
+    elapsed = now_ns() - start;
+    shared->pending = false;
+
+    /* Check the result against the expected state */
+    switch (op) {
+    case SIM_OP_TRANSACTION:
+        if (status == PSA_ERROR_INSUFFICIENT_STORAGE && !cfg.fail_on_full) {
+            stats->num_full++;
+        } else if (status != PSA_SUCCESS) {
+            fail("transaction failed", uid, status);
+        } else {
+            for (i = 0; i < shared->num_pending; i++) {
+                shared->assets[shared->pending_uids[i]] =
+                    shared->pending_assets[i];
+                if (shared->pending_assets[i].exists) {
+                    stats->logical_written += shared->pending_assets[i].size;
+                }
+            }
+        }
+        break;
+    case SIM_OP_SET:
+        if (status == PSA_ERROR_INSUFFICIENT_STORAGE && !cfg.fail_on_full) {
+            stats->num_full++;
+        } else if (status != PSA_SUCCESS) {
+            fail("set failed", uid, status);
+        } else {
+            *a = next;
+            stats->logical_written += next.size;
+        }
+        break;
+    case SIM_OP_REMOVE:
+        if (status != (a->exists ? PSA_SUCCESS : PSA_ERROR_DOES_NOT_EXIST)) {
+            fail("unexpected remove status", uid, status);
+        }
+        *a = next;
+        break;
+    default:
+        if (a->exists) {
+            fill_data(expect_buf, uid, a);
+            if (status != PSA_SUCCESS || size != a->size ||
+                memcmp(data_buf, expect_buf, size) != 0) {
+                fail("get returned wrong data", uid, status);
+            }
+            stats->logical_read += size;
+        } else if (status != PSA_ERROR_DOES_NOT_EXIST) {
+            fail("get of removed asset did not fail", uid, status);
+        }
+        break;
+    }
+
+    /* Account the flash operations of the request */
+    prog = 0;
+    erases = 0;
+    for (r = 0; r < 2; r++) {
+        prog += sim_state->flash[r].prog_bytes - before[r].prog_bytes;
+        erases += sim_state->flash[r].num_erases - before[r].num_erases;
+        stats->erase_bytes += sim_state->flash[r].erase_bytes -
+                              before[r].erase_bytes;
+        stats->read_bytes += sim_state->flash[r].read_bytes -
+                             before[r].read_bytes;
+    }
+    stats->prog_bytes += prog;
+
+    stats->num_ops[op]++;
+    stats->op_time_ns += elapsed;
+    if (elapsed > stats->max_op_ns[op]) {
+        stats->max_op_ns[op] = elapsed;
+    }
+    if (prog > stats->max_op_prog_bytes) {
+        stats->max_op_prog_bytes = prog;
+    }
+    if (erases > stats->max_op_erases) {
+        stats->max_op_erases = erases;
+    }
+
+    shared->ops_done++;
+}
+
+/**
+ * \brief Runs one boot of the services, until the end of the workload or a
+ *        power cut. Called in a child process.
+ */
+static void run_boot(void)
+{
+    struct sim_stats_t *stats = &shared->stats;
+    psa_status_t status;
+    uint64_t start, elapsed;
+
+    /* Schedule the next power cut, which may also hit the boot itself */
+    if (cfg.power_cut_interval != 0) {
+        sim_state->power_cut_countdown =
+            1 + (sim_rand() % (2 * cfg.power_cut_interval));
+    }
+
+    start = now_ns();
+    status = service_init();
+    elapsed = now_ns() - start;
+    if (status != PSA_SUCCESS) {
+        fail("boot failed", 0, status);
+    }
+
+    stats->num_boots++;
+    if (elapsed > stats->max_boot_ns) {
+        stats->max_boot_ns = elapsed;
+    }
+
+    check_assets();
+
+    while (shared->ops_done < cfg.num_ops) {
+        run_op();
+    }
+
+    /* Check the final state without interruption */
+    sim_state->power_cut_countdown = 0;
+    check_assets();
+
+    _exit(0);
+}
+
+static void print_report(void)
+{
+    const struct sim_stats_t *stats = &shared->stats;
+    uint64_t total = 0;
+    int op;
+
+    for (op = 0; op < SIM_NUM_OPS; op++) {
+        total += stats->num_ops[op];
+    }
+
+    (void)printf("backend %s, %u assets of %u to %u bytes, "
+                 "%u%% set, %u%% remove, %u%% transaction, seed %u\n",
+                 (cfg.backend == SIM_BACKEND_PS) ? "ps" : "its",
+                 cfg.num_assets, cfg.min_size, cfg.max_size, cfg.update_pct,
+                 cfg.remove_pct, cfg.transaction_pct, cfg.seed);
+    (void)printf("operations:          %llu (%llu set, %llu get, "
+                 "%llu remove, %llu transaction), %llu failed with no "
+                 "space\n",
+                 (unsigned long long)total,
+                 (unsigned long long)stats->num_ops[SIM_OP_SET],
+                 (unsigned long long)stats->num_ops[SIM_OP_GET],
+                 (unsigned long long)stats->num_ops[SIM_OP_REMOVE],
+                 (unsigned long long)stats->num_ops[SIM_OP_TRANSACTION],
+                 (unsigned long long)stats->num_full);
+    (void)printf("power cuts:          %llu, all assets recovered\n",
+                 (unsigned long long)stats->num_power_cuts);
+    (void)printf("throughput:          %.0f ops/s\n",
+                 (stats->op_time_ns != 0) ?
+                 (double)total * 1e9 / (double)stats->op_time_ns : 0.0);
+    (void)printf("programmed/written:  %.2f bytes per logical byte\n",
+                 (stats->logical_written != 0) ?
+                 (double)stats->prog_bytes / (double)stats->logical_written :
+                 0.0);
+    (void)printf("erased/written:      %.2f bytes per logical byte\n",
+                 (stats->logical_written != 0) ?
+                 (double)stats->erase_bytes / (double)stats->logical_written :
+                 0.0);
+    (void)printf("read/read:           %.2f bytes per logical byte\n",
+                 (stats->logical_read != 0) ?
+                 (double)stats->read_bytes / (double)stats->logical_read :
+                 0.0);
+    (void)printf("worst-case latency:  set %.1f us, get %.1f us, "
+                 "remove %.1f us, transaction %.1f us, boot %.1f us\n",
+                 (double)stats->max_op_ns[SIM_OP_SET] / 1e3,
+                 (double)stats->max_op_ns[SIM_OP_GET] / 1e3,
+                 (double)stats->max_op_ns[SIM_OP_REMOVE] / 1e3,
+                 (double)stats->max_op_ns[SIM_OP_TRANSACTION] / 1e3,
+                 (double)stats->max_boot_ns / 1e3);
+    (void)printf("worst-case flash:    %llu erases, %llu bytes programmed "
+                 "in one operation\n",
+                 (unsigned long long)stats->max_op_erases,
+                 (unsigned long long)stats->max_op_prog_bytes);
+}
+
+static void usage(const char *prog)
+{
+    (void)fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -b its|ps   service to run the workload against (default its)\n"
+        "  -a N        number of assets (default the service maximum)\n"
+        "  -s MIN:MAX  range of asset sizes in bytes (default 1:maximum)\n"
+        "  -u PCT      percentage of set operations (default 50)\n"
+        "  -d PCT      percentage of remove operations (default 0)\n"
+        "  -t PCT      percentage of transactions (default 0)\n"
+        "  -n N        number of operations (default 10000)\n"
+        "  -c N        mean number of flash program and erase operations\n"
+        "              between power cuts, which must exceed the number of\n"
+        "              operations of a request (default 0, no power cuts)\n"
+        "  -k          cut the power at each flash operation of the\n"
+        "              transaction commits in turn, instead of -c\n"
+        "  -r SEED     seed of the workload (default 1)\n"
+        "  -f          fail when a set runs out of space, for workloads\n"
+        "              which fit in the storage\n",
+        prog);
+    exit(2);
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    uint32_t max_assets, max_size;
+    int opt;
+
+    cfg.backend = SIM_BACKEND_ITS;
+    cfg.num_assets = 0;
+    cfg.min_size = 1;
+    cfg.max_size = 0;
+    cfg.update_pct = 50;
+    cfg.remove_pct = 0;
+    cfg.transaction_pct = 0;
+    cfg.num_ops = 10000;
+    cfg.power_cut_interval = 0;
+    cfg.commit_cuts = false;
+    cfg.seed = 1;
+    cfg.fail_on_full = false;
+
+    while ((opt = getopt(argc, argv, "b:a:s:u:d:t:n:c:kr:fh")) != -1) {
+        switch (opt) {
+        case 'b':
+            if (strcmp(optarg, "its") == 0) {
+                cfg.backend = SIM_BACKEND_ITS;
+            } else if (strcmp(optarg, "ps") == 0) {
+                cfg.backend = SIM_BACKEND_PS;
+            } else {
+                usage(argv[0]);
+            }
+            break;
+        case 'a':
+            cfg.num_assets = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            if (sscanf(optarg, "%u:%u", &cfg.min_size, &cfg.max_size) != 2) {
+                usage(argv[0]);
+            }
+            break;
+        case 'u':
+            cfg.update_pct = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            cfg.remove_pct = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            cfg.transaction_pct = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            cfg.num_ops = strtoull(optarg, NULL, 0);
+            break;
+        case 'c':
+            cfg.power_cut_interval = strtoull(optarg, NULL, 0);
+            break;
+        case 'k':
+            cfg.commit_cuts = true;
+            break;
+        case 'r':
+            cfg.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            cfg.fail_on_full = true;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (cfg.backend == SIM_BACKEND_PS) {
+        max_assets = PS_NUM_ASSETS;
+        max_size = PS_MAX_ASSET_SIZE;
+    } else {
+        max_assets = ITS_NUM_ASSETS;
+        max_size = ITS_MAX_ASSET_SIZE;
+    }
+
+    if (cfg.num_assets == 0) {
+        cfg.num_assets = max_assets;
+    }
+    if (cfg.max_size == 0) {
+        cfg.max_size = max_size;
+    }
+
+    if (cfg.num_assets > max_assets || cfg.max_size > max_size ||
+        cfg.min_size > cfg.max_size ||
+        cfg.update_pct + cfg.remove_pct + cfg.transaction_pct > 100 ||
+        (cfg.commit_cuts && cfg.power_cut_interval != 0) || cfg.seed == 0) {
+        (void)fprintf(stderr, "Invalid workload: at most %u assets of at most "
+                      "%u bytes, percentages adding up to at most 100, -k "
+                      "without -c and a non-zero seed\n", max_assets,
+                      max_size);
+        exit(2);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t *flash_mem;
+    pid_t pid;
+    int wstatus;
+
+    parse_args(argc, argv);
+
+    shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    flash_mem = mmap(NULL, sim_flash_mem_size(), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED || flash_mem == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    (void)memset(shared, 0, sizeof(*shared));
+    (void)memset(flash_mem, 0xFF, sim_flash_mem_size());
+    sim_state = &shared->persistent;
+    sim_state->rand_state = cfg.seed;
+    sim_flash_setup(flash_mem);
+
+    for (;;) {
+        (void)fflush(stdout);
+        pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            run_boot();
+        }
+
+        if (waitpid(pid, &wstatus, 0) < 0 || !WIFEXITED(wstatus)) {
+            (void)printf("FAIL: simulated boot terminated abnormally\n");
+            return 1;
+        }
+
+        if (WEXITSTATUS(wstatus) == SIM_EXIT_POWER_CUT) {
+            shared->stats.num_power_cuts++;
+            sim_state->power_cut_countdown = 0;
+            continue;
+        }
+        if (WEXITSTATUS(wstatus) != 0) {
+            return 1;
+        }
+        break;
+    }
+
+    print_report();
+
+    return 0;
+}
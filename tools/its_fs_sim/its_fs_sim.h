@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __ITS_FS_SIM_H__
+#define __ITS_FS_SIM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "flash/its_flash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exit status of a simulated boot cut short by a power failure */
+#define SIM_EXIT_POWER_CUT 3
+
+/* Number of PS NV counters emulated by the simulator */
+#define SIM_NUM_NV_COUNTERS 3
+
+/* Flash operation counters of one emulated flash device */
+struct sim_flash_stats_t {
+    uint64_t read_bytes;    /*!< Number of bytes read */
+    uint64_t prog_bytes;    /*!< Number of bytes programmed */
+    uint64_t erase_bytes;   /*!< Number of bytes erased */
+    uint64_t num_progs;     /*!< Number of program operations */
+    uint64_t num_erases;    /*!< Number of erase operations */
+};
+
+/* State which survives a simulated power cut. It is placed in memory shared
+ * between the simulator process and the child process of each boot.
+ */
+struct sim_persistent_t {
+    struct sim_flash_stats_t flash[2];   /*!< Counters of each flash device,
+                                          *   indexed by its_flash_id_t
+                                          */
+    uint64_t power_cut_countdown;        /*!< Number of program and erase
+                                          *   operations before the next power
+                                          *   cut, 0 if none is scheduled
+                                          */
+    uint32_t rand_state;                 /*!< State of the simulator's random
+                                          *   number generator
+                                          */
+    uint32_t nv_counters[SIM_NUM_NV_COUNTERS]; /*!< PS NV counters */
+};
+
+extern struct sim_persistent_t *sim_state;
+
+/**
+ * \brief Returns the next value of the simulator's random number generator.
+ *
+ * \return Pseudo-random 32-bit value
+ */
+uint32_t sim_rand(void);
+
+/**
+ * \brief Places the emulated flash devices in the given memory, which must be
+ *        large enough for both flash areas, and installs the counting and
+ *        power cut hooks in their flash interfaces.
+ *
+ * \param[in] mem  Memory holding the contents of the flash areas
+ */
+void sim_flash_setup(uint8_t *mem);
+
+/**
+ * \brief Returns the size of the memory required by sim_flash_setup().
+ *
+ * \return Size in bytes of both flash areas
+ */
+size_t sim_flash_mem_size(void);
+
+/**
+ * \brief Sets the source of the data written by the next ITS or PS request.
+ *
+ * \param[in] data  Pointer to the asset data
+ */
+void sim_req_set_source(const uint8_t *data);
+
+/**
+ * \brief Sets the destination of the data read by the next ITS or PS request.
+ *
+ * \param[out] data  Pointer to the buffer for the asset data
+ */
+void sim_req_set_dest(uint8_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ITS_FS_SIM_H__ */
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "its_fs_sim.h"
+
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "flash_layout.h"
+
+extern struct its_flash_info_t its_flash_info_internal;
+extern struct its_flash_info_t its_flash_info_external;
+
+/* Flash interface functions of the emulated flash devices, called by the
+ * counting hooks.
+ */
+struct sim_flash_ops_t {
+    psa_status_t (*read)(const struct its_flash_info_t *info,
+                         uint32_t block_id, uint8_t *buff, size_t offset,
+                         size_t size);
+    psa_status_t (*write)(const struct its_flash_info_t *info,
+                          uint32_t block_id, const uint8_t *buff,
+                          size_t offset, size_t size);
+    psa_status_t (*erase)(const struct its_flash_info_t *info,
+                          uint32_t block_id);
+};
+
+static struct sim_flash_ops_t flash_ops[2];
+
+static enum its_flash_id_t get_flash_id(const struct its_flash_info_t *info)
+{
+    return (info == &its_flash_info_internal) ? ITS_FLASH_ID_INTERNAL :
+                                                ITS_FLASH_ID_EXTERNAL;
+}
+
+/**
+ * \brief Counts down to the next scheduled power cut.
+ *
+ * \return Returns true if the power is lost during the current program or
+ *         erase operation, false otherwise.
+ */
+static bool power_cut_due(void)
+{
+    if (sim_state->power_cut_countdown == 0) {
+        return false;
+    }
+
+    return (--sim_state->power_cut_countdown == 0);
+}
+
+static psa_status_t sim_flash_read(const struct its_flash_info_t *info,
+                                   uint32_t block_id, uint8_t *buff,
+                                   size_t offset, size_t size)
+{
+    enum its_flash_id_t id = get_flash_id(info);
+
+    sim_state->flash[id].read_bytes += size;
+
+    return flash_ops[id].read(info, block_id, buff, offset, size);
+}
+
+static psa_status_t sim_flash_write(const struct its_flash_info_t *info,
+                                    uint32_t block_id, const uint8_t *buff,
+                                    size_t offset, size_t size)
+{
+    enum its_flash_id_t id = get_flash_id(info);
+
+    sim_state->flash[id].prog_bytes += size;
+    sim_state->flash[id].num_progs++;
+
+    if (power_cut_due()) {
+        /* Only a part of the data is programmed before the power is lost */
+        (void)flash_ops[id].write(info, block_id, buff, offset,
+                                  sim_rand() % (size + 1));
+        _exit(SIM_EXIT_POWER_CUT);
+    }
+
+    return flash_ops[id].write(info, block_id, buff, offset, size);
+}
+
+static psa_status_t sim_flash_erase(const struct its_flash_info_t *info,
+                                    uint32_t block_id)
+{
+    enum its_flash_id_t id = get_flash_id(info);
+
+    sim_state->flash[id].erase_bytes += info->block_size;
+    sim_state->flash[id].num_erases++;
+
+    if (power_cut_due()) {
+        /* The erase either completes or leaves the block untouched */
+        if (sim_rand() & 1U) {
+            (void)flash_ops[id].erase(info, block_id);
+        }
+        _exit(SIM_EXIT_POWER_CUT);
+    }
+
+    return flash_ops[id].erase(info, block_id);
+}
+
+static void hook_flash(struct its_flash_info_t *info, uint8_t *mem)
+{
+    enum its_flash_id_t id = get_flash_id(info);
+
+    flash_ops[id].read = info->read;
+    flash_ops[id].write = info->write;
+    flash_ops[id].erase = info->erase;
+
+    info->read = sim_flash_read;
+    info->write = sim_flash_write;
+    info->erase = sim_flash_erase;
+    info->flash_dev = mem;
+}
+
+size_t sim_flash_mem_size(void)
+{
+    return ITS_RAM_FS_SIZE + PS_RAM_FS_SIZE;
+}
+
+void sim_flash_setup(uint8_t *mem)
+{
+    hook_flash(&its_flash_info_internal, mem);
+    hook_flash(&its_flash_info_external, mem + ITS_RAM_FS_SIZE);
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2021, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Host replacements for the platform, IPC and crypto services which the ITS
+ * and PS partitions depend on in a TF-M build.
+ */
+
+#include <string.h>
+
+#include "its_fs_sim.h"
+
+#include "crypto/ps_crypto_interface.h"
+#include "flash_layout.h"
+#include "nv_counters/ps_nv_counters.h"
+#include "psa/internal_trusted_storage.h"
+#include "psa_manifest/pid.h"
+#include "tfm_hal_its.h"
+#include "tfm_hal_ps.h"
+#include "tfm_internal_trusted_storage.h"
+#include "tfm_its_req_mngr.h"
+#include "tfm_ps_req_mngr.h"
+
+/* Caller buffers of the request being served by each service. PS makes ITS
+ * requests of its own while serving a request.
+ */
+static const uint8_t *its_req_source;
+static uint8_t *its_req_dest;
+static const uint8_t *ps_req_source;
+static uint8_t *ps_req_dest;
+
+/* IV counter of the stub crypto backend */
+static uint32_t crypto_iv;
+
+void sim_req_set_source(const uint8_t *data)
+{
+    its_req_source = data;
+    ps_req_source = data;
+}
+
+void sim_req_set_dest(uint8_t *data)
+{
+    its_req_dest = data;
+    ps_req_dest = data;
+}
+
+/* Platform HAL */
+
+void tfm_hal_its_fs_info(uint32_t *flash_area_addr, size_t *flash_area_size)
+{
+    *flash_area_addr = 0;
+    *flash_area_size = ITS_RAM_FS_SIZE;
+}
+
+void tfm_hal_ps_fs_info(uint32_t *flash_area_addr, size_t *flash_area_size)
+{
+    *flash_area_addr = 0;
+    *flash_area_size = PS_RAM_FS_SIZE;
+}
+
+/* Request managers. The caller buffers are consumed in order, as the services
+ * transfer the asset data in chunks.
+ */
+
+size_t its_req_mngr_read(uint8_t *buf, size_t num_bytes)
+{
+    (void)memcpy(buf, its_req_source, num_bytes);
+    its_req_source += num_bytes;
+
+    return num_bytes;
+}
+
+void its_req_mngr_write(const uint8_t *buf, size_t num_bytes)
+{
+    (void)memcpy(its_req_dest, buf, num_bytes);
+    its_req_dest += num_bytes;
+}
+
+psa_status_t ps_req_mngr_read_asset_data(uint8_t *out_data, uint32_t size)
+{
+    (void)memcpy(out_data, ps_req_source, size);
+    ps_req_source += size;
+
+    return PSA_SUCCESS;
+}
+
+void ps_req_mngr_write_asset_data(const uint8_t *in_data, uint32_t size)
+{
+    (void)memcpy(ps_req_dest, in_data, size);
+    ps_req_dest += size;
+}
+
+/* ITS client API used by PS, calling the ITS service directly */
+
+psa_status_t psa_its_set(psa_storage_uid_t uid,
+                         size_t data_length,
+                         const void *p_data,
+                         psa_storage_create_flags_t create_flags)
+{
+    its_req_source = p_data;
+
+    return tfm_its_set(TFM_SP_PS, uid, data_length, create_flags);
+}
+
+psa_status_t psa_its_get(psa_storage_uid_t uid,
+                         size_t data_offset,
+                         size_t data_size,
+                         void *p_data,
+                         size_t *p_data_length)
+{
+    its_req_dest = p_data;
+
+    return tfm_its_get(TFM_SP_PS, uid, data_offset, data_size, p_data_length);
+}
+
+psa_status_t psa_its_get_info(psa_storage_uid_t uid,
+                              struct psa_storage_info_t *p_info)
+{
+    return tfm_its_get_info(TFM_SP_PS, uid, p_info);
+}
+
+psa_status_t psa_its_remove(psa_storage_uid_t uid)
+{
+    return tfm_its_remove(TFM_SP_PS, uid);
+}
+
+/* NV counters, which are kept across simulated power cuts */
+
+psa_status_t ps_read_nv_counter(enum tfm_nv_counter_t counter_id,
+                                uint32_t *val)
+{
+    if ((uint32_t)counter_id >= SIM_NUM_NV_COUNTERS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    *val = sim_state->nv_counters[counter_id];
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_increment_nv_counter(enum tfm_nv_counter_t counter_id)
+{
+    if ((uint32_t)counter_id >= SIM_NUM_NV_COUNTERS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    sim_state->nv_counters[counter_id]++;
+
+    return PSA_SUCCESS;
+}
+
+/* Stub crypto backend. The data is stored in the clear and the tag is a
+ * checksum of the associated data and the data, so that the PS integrity
+ * checks still detect torn writes. It provides no security.
+ */
+
+static uint32_t checksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+    size_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < len; i++) {
+        sum = (sum ^ data[i]) * 16777619U;
+    }
+
+    return sum;
+}
+
+static void compute_tag(const union ps_crypto_t *crypto, const uint8_t *add,
+                        size_t add_len, const uint8_t *data, size_t data_len,
+                        uint8_t *tag)
+{
+    uint32_t sum = 2166136261U;
+
+    sum = checksum(sum, crypto->ref.iv, PS_IV_LEN_BYTES);
+    sum = checksum(sum, add, add_len);
+    sum = checksum(sum, data, data_len);
+
+    (void)memset(tag, 0, PS_TAG_LEN_BYTES);
+    (void)memcpy(tag, &sum, sizeof(sum));
+}
+
+psa_status_t ps_crypto_init(void)
+{
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_setkey(void)
+{
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_destroykey(void)
+{
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_flush_key(void)
+{
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_check_lifecycle(void)
+{
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_encrypt_and_tag(union ps_crypto_t *crypto,
+                                       const uint8_t *add,
+                                       size_t add_len,
+                                       const uint8_t *in,
+                                       size_t in_len,
+                                       uint8_t *out,
+                                       size_t out_size,
+                                       size_t *out_len)
+{
+    if (in_len > out_size) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    (void)memmove(out, in, in_len);
+    compute_tag(crypto, add, add_len, out, in_len, crypto->ref.tag);
+    *out_len = in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_auth_and_decrypt(const union ps_crypto_t *crypto,
+                                        const uint8_t *add,
+                                        size_t add_len,
+                                        uint8_t *in,
+                                        size_t in_len,
+                                        uint8_t *out,
+                                        size_t out_size,
+                                        size_t *out_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    if (in_len > out_size) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    compute_tag(crypto, add, add_len, in, in_len, tag);
+    if (memcmp(tag, crypto->ref.tag, PS_TAG_LEN_BYTES) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    (void)memmove(out, in, in_len);
+    *out_len = in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
+                                         const uint8_t *add,
+                                         uint32_t add_len)
+{
+    compute_tag(crypto, add, add_len, NULL, 0, crypto->ref.tag);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
+                                    const uint8_t *add,
+                                    uint32_t add_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    compute_tag(crypto, add, add_len, NULL, 0, tag);
+    if (memcmp(tag, crypto->ref.tag, PS_TAG_LEN_BYTES) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    return PSA_SUCCESS;
+}
+
+void ps_crypto_set_iv(const union ps_crypto_t *crypto)
+{
+    (void)memcpy(&crypto_iv, crypto->ref.iv, sizeof(crypto_iv));
+}
+
+void ps_crypto_get_iv(union ps_crypto_t *crypto)
+{
+    crypto_iv++;
+    (void)memset(crypto->ref.iv, 0, PS_IV_LEN_BYTES);
+    (void)memcpy(crypto->ref.iv, &crypto_iv, sizeof(crypto_iv));
+}
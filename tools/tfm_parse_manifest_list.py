@@ -135,6 +135,38 @@ def process_manifest(manifest_list_files):
 
     return db
 
+def sort_services(db):
+    """
+    Collect the services of the IPC partitions in ascending SID order, so that
+    the SPM can look them up with a binary search. Partitions which are not
+    built together, like the PSA Proxy and the partitions it stands for, may
+    have services with the same SID.
+
+    Parameters
+    ----------
+    db:
+        The data base returned by process_manifest.
+
+    Returns
+    -------
+    The list of services, each with the manifest and attributes of its
+    partition.
+    """
+
+    services = []
+
+    for manifest in db:
+        if not manifest["attr"].get("tfm_partition_ipc"):
+            continue
+        for service in manifest["manifest"].get("services", []):
+            services.append({"manifest": manifest["manifest"],
+                             "attr": manifest["attr"],
+                             "service": service})
+
+    services.sort(key=lambda item: int(str(item["service"]["sid"]), 0))
+
+    return services
+
 def gen_files(context, gen_file_lists):
     """
     Generate files according to the gen_file_list
@@ -248,12 +280,26 @@ def main():
 
     db = process_manifest(manifest_list)
 
+    """
+    Keep the partitions in ascending partition ID order, so that the SPM can
+    look them up with a binary search. The partitions of extra manifest lists
+    may have any partition ID.
+    """
+    db.sort(key=lambda manifest: manifest["attr"]["pid"])
+
+    for prev, manifest in zip(db, db[1:]):
+        if prev["attr"]["pid"] == manifest["attr"]["pid"]:
+            print("Partitions " + prev["manifest"]["name"] + " and " +
+                  manifest["manifest"]["name"] + " have the same partition ID")
+            exit(1)
+
     utilities = {}
     context = {}
 
     utilities['donotedit_warning']=donotedit_warning
 
     context['manifests'] = db
+    context['services'] = sort_services(db)
     context['utilities'] = utilities
 
     gen_files(context, gen_file_list)